@@ -14,57 +14,84 @@
 //
 // SPDX-License-Identifier: Apache-2.0
 
+#include "../common/netlist_index.h"
+#include "kernel/ff.h"
+#include "kernel/ffinit.h"
 #include "kernel/yosys.h"
 
 USING_YOSYS_NAMESPACE
-#include <iostream>
+PRIVATE_NAMESPACE_BEGIN
+
 struct CLK_Gating_Pass : public Pass {
 
+    // Clock gating cell inserted for each register bank
+    struct GateCell {
+        RTLIL::IdString type;
+        RTLIL::IdString clk_port;
+        RTLIL::IdString gate_port;
+        RTLIL::IdString gclk_port;
+    };
+
+    // Flip-flops sharing a clock and an enable, gated with a single cell
+    struct Bank {
+        RTLIL::SigBit clk;
+        RTLIL::SigBit enable;
+        bool enable_polarity;
+        std::vector<RTLIL::Cell *> flops;
+    };
+
     CLK_Gating_Pass() : Pass("reg_clock_gating", "performs flipflop clock gating") {}
 
     void help() override
     {
         //   |---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|---v---|
         log("\n");
-        log("     reg_clock_gating [-map CG_map_filename] [selection]\n");
+        log("     reg_clock_gating -gate <type> <clk> <gate> <gclk> [selection]\n");
+        log("     reg_clock_gating -map CG_map_filename [selection]\n");
+        log("     reg_clock_gating CG_map_filename [selection]\n");
         log("\n");
+        log("Replaces the enables of the selected flip-flops with gated clocks.\n");
+        log("\n");
+        log("    -gate type clk gate gclk\n");
+        log("        the clock gating cell type and the names of its clock input,\n");
+        log("        gate (enable) input and gated clock output ports.\n");
+        log("        flip-flops sharing a clock and an enable form a register bank, a\n");
+        log("        single clock gating cell is inserted for each bank. existing\n");
+        log("        clock gating cells of the type are reused.\n");
         log("\n");
         log("    -map filename\n");
         log("        the mapfile for clock gating cells implementations to be used.\n");
         log("        maps from enable-flipflops to clock gated flipflops.\n");
-        log("        without this parameter a builtin library is used that\n");
-        log("        transforms the internal RTL cells to the internal gate\n");
-        log("        library.\n");
-        log("        check techmap command for mare details.\n");
+        log("        check techmap command for more details.\n");
+        log("        without -map and -gate the first argument is taken as the\n");
+        log("        map file.\n");
+        log("\n");
         log("     selection\n");
         log("        this option is used to specify the flipflops to be clockgated.\n");
+        log("        flip-flops are selected either directly or by their outputs.\n");
         log("        for example:.\n");
         log("        put the following attribute in you design: \n");
-        log("        (* clock gating *).\n");
+        log("        (* clock_gate *).\n");
         log("        and use the following command: .\n");
         log("        reg_clock_gating -map CG_map_filename.v a:clock_gate.\n");
         log("\n");
-        log("This pass calls the following passes to perform technology mapping \n");
-        log("of enabled flip_flops to clock-gated flipflops.\n");
+        log("Processes and memories of the selected modules are converted to flip-flops\n");
+        log("first with the following passes, other modules are left untouched.\n");
         log("\n");
-        log("    procs\n");
-        log("    opt;;\n");
+        log("    proc\n");
         log("    memory_collect\n");
         log("    memory_map\n");
-        log("    opt;; \n");
-        log("    techmap -map [-map CG_map_filename] [selection]\n");
-        log("    opt;;\n");
+        log("    opt_expr; opt_merge; opt_dff; opt_clean\n");
+        log("\n");
+        log("Only flip-flops with a positive edge clock are gated. Flip-flops with a\n");
+        log("synchronous reset taking priority over the enable are left as they are.\n");
         log("\n");
     }
 
-    virtual void execute(std::vector<std::string> args, RTLIL::Design *design)
+    void execute(std::vector<std::string> args, RTLIL::Design *design) override
     {
-
-        if (args.size() < 2) {
-            log_error("Incorrect number of arguments \nClock gating map file is required \n");
-        }
-
-        string map_file = "";
+        std::string map_file;
+        GateCell gate;
 
         size_t argidx;
         for (argidx = 1; argidx < args.size(); argidx++) {
@@ -72,36 +99,203 @@ struct CLK_Gating_Pass : public Pass {
                 map_file = args[++argidx];
                 continue;
             }
+            if (args[argidx] == "-gate" && argidx + 4 < args.size()) {
+                gate.type = RTLIL::escape_id(args[++argidx]);
+                gate.clk_port = RTLIL::escape_id(args[++argidx]);
+                gate.gate_port = RTLIL::escape_id(args[++argidx]);
+                gate.gclk_port = RTLIL::escape_id(args[++argidx]);
+                continue;
+            }
             break;
         }
-        int x = 0;
-        std::stringstream selection_string_stream;
-        for (unsigned long i = argidx; i < args.size(); i++) {
-            if (x != 0)
-                selection_string_stream << " ";
-            selection_string_stream << args[i];
-            x++;
+        // Older scripts pass the map file without -map
+        if (map_file.empty() && gate.type.empty() && argidx < args.size() && args[argidx][0] != '-') {
+            map_file = args[argidx++];
         }
-        std::string selection = selection_string_stream.str();
+        extra_args(args, argidx, design);
 
-        std::cout << selection << "\n";
+        if (map_file.empty() == gate.type.empty()) {
+            log_cmd_error("Exactly one of -map and -gate is required.\n");
+        }
 
         log_header(design, "Executing Clock gating pass.\n");
         log_push();
 
-        Pass::call(design, "proc");
-        Pass::call(design, "opt;;");
-        Pass::call(design, "memory_collect " + selection);
-        Pass::call(design, "memory_map " + selection);
-        Pass::call(design, "opt;;");
-        Pass::call(design, "techmap -map " + map_file + " " + selection);
-        Pass::call(design, "opt;;");
+        // The lowering passes replace cells, so the selection is recorded by
+        // names up front. All flip-flops of wholly selected modules are
+        // considered, including the ones created by the lowering.
+        std::vector<RTLIL::Module *> modules = design->selected_modules();
+        pool<std::pair<RTLIL::IdString, RTLIL::IdString>> selected;
+        for (auto module : modules) {
+            if (design->selected_whole_module(module)) {
+                selected.insert(std::make_pair(module->name, RTLIL::IdString()));
+                continue;
+            }
+            for (auto cell : module->selected_cells()) {
+                selected.insert(std::make_pair(module->name, cell->name));
+            }
+            for (auto wire : module->selected_wires()) {
+                selected.insert(std::make_pair(module->name, wire->name));
+            }
+        }
+
+        RTLIL::Selection map_selection(false);
+        for (auto module : modules) {
+            lower_module(design, module);
 
-        design->optimize();
-        design->sort();
-        design->check();
+            SigMap sigmap(module);
+            FfInitVals initvals(&sigmap, module);
+            std::vector<Bank> banks = find_banks(module, sigmap, initvals, selected);
+
+            if (!map_file.empty()) {
+                for (auto &bank : banks) {
+                    for (auto cell : bank.flops) {
+                        map_selection.selected_members[module->name].insert(cell->name);
+                    }
+                }
+                continue;
+            }
+
+            NetlistIndex index(module);
+            int gated = 0;
+            for (auto &bank : banks) {
+                RTLIL::SigBit gclk = get_gated_clock(module, index, gate, bank);
+                for (auto cell : bank.flops) {
+                    FfData ff(&initvals, cell);
+                    ff.has_ce = false;
+                    ff.sig_clk = gclk;
+                    ff.emit();
+                }
+                gated += bank.flops.size();
+            }
+            log("Gated %d flip-flop(s) in %d register bank(s) of module %s.\n", gated, GetSize(banks), log_id(module));
+        }
+
+        if (!map_file.empty() && !map_selection.selected_members.empty()) {
+            Pass::call_on_selection(design, map_selection, "techmap -map " + map_file);
+        }
 
         log_header(design, "Finished Clock gating pass.\n");
         log_pop();
     }
+
+    // Converts processes and memories of the module to flip-flops and merges
+    // the enable multiplexers into them
+    void lower_module(RTLIL::Design *design, RTLIL::Module *module)
+    {
+        bool has_memories = !module->memories.empty();
+        for (auto cell : module->cells()) {
+            if (cell->type.in(ID($memrd), ID($memrd_v2), ID($memwr), ID($memwr_v2), ID($meminit), ID($meminit_v2), ID($mem), ID($mem_v2))) {
+                has_memories = true;
+                break;
+            }
+        }
+
+        if (!module->processes.empty()) {
+            Pass::call_on_module(design, module, "proc");
+        }
+        if (has_memories) {
+            Pass::call_on_module(design, module, "memory_collect");
+            Pass::call_on_module(design, module, "memory_map");
+        }
+        // Modules lowered before may still have their enables as $mux cells
+        Pass::call_on_module(design, module, "opt_expr; opt_merge; opt_dff; opt_clean");
+    }
+
+    // Groups the selected flip-flops with enables that can be gated by their
+    // clocks and enables
+    std::vector<Bank> find_banks(RTLIL::Module *module, const SigMap &sigmap, FfInitVals &initvals,
+                                 const pool<std::pair<RTLIL::IdString, RTLIL::IdString>> &selected)
+    {
+        std::vector<Bank> banks;
+        dict<std::tuple<RTLIL::SigBit, RTLIL::SigBit, bool>, int> bank_ids;
+
+        for (auto cell : module->cells()) {
+            if (!RTLIL::builtin_ff_cell_types().count(cell->type)) {
+                continue;
+            }
+
+            FfData ff(&initvals, cell);
+            if (!ff.has_clk || !ff.has_ce || !ff.pol_clk) {
+                continue;
+            }
+            // Gating the clock would block a reset that overrides the enable
+            if (ff.has_srst && !ff.ce_over_srst) {
+                continue;
+            }
+
+            RTLIL::SigBit clk = sigmap(ff.sig_clk[0]);
+            RTLIL::SigBit enable = sigmap(ff.sig_ce[0]);
+            if (!clk.wire || !enable.wire) {
+                continue;
+            }
+
+            if (!is_selected(module, cell, ff.sig_q, selected)) {
+                continue;
+            }
+
+            auto key = std::make_tuple(clk, enable, ff.pol_ce);
+            auto it = bank_ids.find(key);
+            if (it == bank_ids.end()) {
+                it = bank_ids.emplace(key, GetSize(banks)).first;
+                banks.push_back({clk, enable, ff.pol_ce, {}});
+            }
+            banks[it->second].flops.push_back(cell);
+        }
+
+        return banks;
+    }
+
+    // A flip-flop is selected with its module, directly or by any of its
+    // output wires
+    bool is_selected(RTLIL::Module *module, RTLIL::Cell *cell, const RTLIL::SigSpec &sig_q,
+                     const pool<std::pair<RTLIL::IdString, RTLIL::IdString>> &selected)
+    {
+        if (selected.count(std::make_pair(module->name, RTLIL::IdString())) || selected.count(std::make_pair(module->name, cell->name))) {
+            return true;
+        }
+        for (auto &chunk : sig_q.chunks()) {
+            if (chunk.wire && selected.count(std::make_pair(module->name, chunk.wire->name))) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Returns the output of a clock gating cell of the bank, reuses an existing
+    // cell driven by the same clock and enable
+    RTLIL::SigBit get_gated_clock(RTLIL::Module *module, const NetlistIndex &index, const GateCell &gate, const Bank &bank)
+    {
+        RTLIL::SigBit enable = bank.enable;
+        if (!bank.enable_polarity) {
+            enable = module->NotGate(NEW_ID, enable);
+        }
+
+        RTLIL::Cell *existing = nullptr;
+        if (bank.enable_polarity) {
+            index.ForEachSink(bank.clk, [&](const NetlistIndex::PortBit &pin) {
+                if (existing || pin.cell->type != gate.type || pin.port != gate.clk_port) {
+                    return;
+                }
+                if (!pin.cell->hasPort(gate.gate_port) || !pin.cell->hasPort(gate.gclk_port)) {
+                    return;
+                }
+                if (index.Canonical(pin.cell->getPort(gate.gate_port)[0]) == enable) {
+                    existing = pin.cell;
+                }
+            });
+        }
+        if (existing) {
+            return existing->getPort(gate.gclk_port)[0];
+        }
+
+        RTLIL::Cell *cell = module->addCell(NEW_ID, gate.type);
+        RTLIL::Wire *gclk = module->addWire(NEW_ID);
+        cell->setPort(gate.clk_port, bank.clk);
+        cell->setPort(gate.gate_port, enable);
+        cell->setPort(gate.gclk_port, gclk);
+        return gclk;
+    }
 } CLK_Gating_Pass;
+
+PRIVATE_NAMESPACE_END
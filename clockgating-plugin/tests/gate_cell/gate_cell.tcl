@@ -0,0 +1,19 @@
+yosys -import
+if { [info procs reg_clock_gating] == {} } { plugin -i clockgating }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+hierarchy -check -top top
+
+# Modules without processes or memories still get their enable muxes
+# merged into the flip-flops
+yosys proc lowered
+select -assert-none lowered/t:\$dffe
+select -assert-count 1 lowered/t:\$mux
+
+reg_clock_gating -gate sky130_fd_sc_hd__dlclkp_4 CLK GATE GCLK
+
+# All enables are replaced with gated clocks
+select -assert-none t:\$dffe t:\$adffe t:\$sdffce
+select -assert-min 1 t:sky130_fd_sc_hd__dlclkp_4
+select -assert-count 1 lowered/t:sky130_fd_sc_hd__dlclkp_4
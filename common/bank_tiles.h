@@ -18,15 +18,43 @@
  */
 #include "kernel/log.h"
 #include "libs/json11/json11.hpp"
+#include <fstream>
+#include <string>
+#include <sys/stat.h>
+#include <unordered_map>
 
 USING_YOSYS_NAMESPACE
 // Coordinates of HCLK_IOI tiles associated with a specified bank
 using BankTilesMap = std::unordered_map<int, std::string>;
 
+// Parsed part JSON files cached for the whole Yosys session. Yosys loads
+// plugins with RTLD_LOCAL, so every plugin including this header has a cache
+// of its own.
+// An entry is valid as long as the file's modification time and size are unchanged.
+struct PartJsonCacheEntry {
+    time_t mtime;
+    off_t size;
+    BankTilesMap bank_tiles;
+};
+
+inline std::unordered_map<std::string, PartJsonCacheEntry> &part_json_cache()
+{
+    static std::unordered_map<std::string, PartJsonCacheEntry> cache;
+    return cache;
+}
+
 // Find the part's JSON file with information including the IO Banks
 // and extract the bank tiles.
-inline BankTilesMap get_bank_tiles(const std::string json_file_name)
+inline const BankTilesMap &get_bank_tiles(const std::string json_file_name)
 {
+    struct stat file_stat;
+    bool has_stat = stat(json_file_name.c_str(), &file_stat) == 0;
+    auto &cache = part_json_cache();
+    auto cached = cache.find(json_file_name);
+    if (has_stat && cached != cache.end() && cached->second.mtime == file_stat.st_mtime && cached->second.size == file_stat.st_size) {
+        return cached->second.bank_tiles;
+    }
+
     BankTilesMap bank_tiles;
     std::ifstream json_file(json_file_name);
     if (!json_file.good()) {
@@ -48,5 +76,9 @@ inline BankTilesMap get_bank_tiles(const std::string json_file_name)
         bank_tiles.emplace(std::atoi(iobank.first.c_str()), iobank.second.string_value());
     }
 
-    return bank_tiles;
+    auto &entry = cache[json_file_name];
+    entry.mtime = has_stat ? file_stat.st_mtime : 0;
+    entry.size = has_stat ? file_stat.st_size : -1;
+    entry.bank_tiles = std::move(bank_tiles);
+    return entry.bank_tiles;
 }
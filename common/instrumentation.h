@@ -0,0 +1,237 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#ifndef _INSTRUMENTATION_H_
+#define _INSTRUMENTATION_H_
+
+#include "kernel/rtlil.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <map>
+#include <mutex>
+#include <string>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#endif
+
+USING_YOSYS_NAMESPACE
+
+// Scoped timers, named counters and peak memory samples shared by the
+// plugins. Collection is off by default. It is switched on by setting the
+// "instrumentation.report" scratchpad key of the design to a file name:
+//
+//   scratchpad -set instrumentation.report report.jsonl
+//
+// The switch is read by the timers taking a design, which are placed at the
+// start of the instrumented passes. When Yosys exits the collected data is
+// written to the file as one JSON object per timer, counter and memory
+// sample. Names are prefixed with the plugin ("sdc.propagate_clocks"). Every
+// plugin library appends its own records, so the report of a run covers the
+// whole plugin stack.
+//
+// All functions are thread safe. When collection is off they cost a single
+// atomic load.
+namespace instrumentation
+{
+
+class Registry
+{
+  public:
+    ~Registry() { write(); }
+
+    // Returns peak resident set size of the process in KiB, or 0 if not available
+    static long peak_rss()
+    {
+#if defined(__APPLE__)
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0)
+            return usage.ru_maxrss / 1024;
+#elif !defined(_WIN32)
+        struct rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0)
+            return usage.ru_maxrss;
+#endif
+        return 0;
+    }
+
+    bool enabled() const { return enabled_flag.load(std::memory_order_relaxed); }
+
+    // Reads the switch from the scratchpad of the design. The first library
+    // that sees a new report file truncates it, the others append to it.
+    void configure(RTLIL::Design *design)
+    {
+        const std::string file = design->scratchpad_get_string("instrumentation.report");
+        std::lock_guard<std::mutex> lock(mutex);
+        if (!file.empty() && file != report_file) {
+            write_locked();
+            if (design->scratchpad_get_string("instrumentation.started") != file) {
+                std::ofstream truncate(file, std::ios::trunc);
+                design->scratchpad_set_string("instrumentation.started", file);
+            }
+            report_file = file;
+        }
+        enabled_flag = !file.empty();
+    }
+
+    void add_time(const std::string &name, double wall_time, long peak_rss_delta)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        Timer &timer = timers[name];
+        timer.count++;
+        timer.wall_time += wall_time;
+        timer.peak_rss_delta += peak_rss_delta;
+    }
+
+    void add_count(const std::string &name, uint64_t value)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        counters[name] += value;
+    }
+
+    void sample_memory(const std::string &name)
+    {
+        const long rss = peak_rss();
+        std::lock_guard<std::mutex> lock(mutex);
+        long &sample = memory_samples[name];
+        sample = std::max(sample, rss);
+    }
+
+    // Appends the collected data to the report file and starts over
+    void write()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        write_locked();
+    }
+
+  private:
+    struct Timer {
+        unsigned count = 0;
+        // Cumulative wall time, in seconds
+        double wall_time = 0;
+        // Cumulative growth of the peak resident set size, in KiB
+        long peak_rss_delta = 0;
+    };
+
+    static std::string escape_json(const std::string &str)
+    {
+        std::string escaped;
+        escaped.reserve(str.size());
+        for (char c : str) {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    void write_locked()
+    {
+        if (report_file.empty() || (timers.empty() && counters.empty() && memory_samples.empty()))
+            return;
+
+        std::ofstream report(report_file, std::ios::app);
+        for (const auto &it : timers) {
+            report << "{\"type\": \"timer\", \"name\": \"" << escape_json(it.first) << "\", \"count\": " << it.second.count
+                   << ", \"wall_time\": " << it.second.wall_time << ", \"peak_rss_delta\": " << it.second.peak_rss_delta << "}\n";
+        }
+        for (const auto &it : counters)
+            report << "{\"type\": \"counter\", \"name\": \"" << escape_json(it.first) << "\", \"value\": " << it.second << "}\n";
+        for (const auto &it : memory_samples)
+            report << "{\"type\": \"memory\", \"name\": \"" << escape_json(it.first) << "\", \"peak_rss\": " << it.second << "}\n";
+
+        timers.clear();
+        counters.clear();
+        memory_samples.clear();
+    }
+
+    std::atomic<bool> enabled_flag{false};
+    std::mutex mutex;
+    std::string report_file;
+    std::map<std::string, Timer> timers;
+    std::map<std::string, uint64_t> counters;
+    std::map<std::string, long> memory_samples;
+};
+
+inline Registry &registry()
+{
+    static Registry instance;
+    return instance;
+}
+
+// Measures wall time and peak RSS growth for the lifetime of the object
+class ScopedTimer
+{
+  public:
+    // Reads the switch from the design first, for the timer at the start of a pass
+    ScopedTimer(RTLIL::Design *design, const std::string &name)
+    {
+        registry().configure(design);
+        start(name);
+    }
+
+    explicit ScopedTimer(const std::string &name) { start(name); }
+
+    ~ScopedTimer()
+    {
+        if (!active)
+            return;
+        const std::chrono::duration<double> wall_time = std::chrono::steady_clock::now() - wall_start;
+        registry().add_time(name, wall_time.count(), Registry::peak_rss() - peak_rss_start);
+    }
+
+    ScopedTimer(const ScopedTimer &) = delete;
+    ScopedTimer &operator=(const ScopedTimer &) = delete;
+
+  private:
+    void start(const std::string &name)
+    {
+        active = registry().enabled();
+        if (!active)
+            return;
+        this->name = name;
+        wall_start = std::chrono::steady_clock::now();
+        peak_rss_start = Registry::peak_rss();
+    }
+
+    bool active = false;
+    std::string name;
+    std::chrono::steady_clock::time_point wall_start;
+    long peak_rss_start = 0;
+};
+
+// Adds the value to the named counter
+inline void count(const std::string &name, uint64_t value = 1)
+{
+    if (registry().enabled())
+        registry().add_count(name, value);
+}
+
+// Records the peak RSS of the process at a named point, keeping the largest sample
+inline void sample_memory(const std::string &name)
+{
+    if (registry().enabled())
+        registry().sample_memory(name);
+}
+
+} // namespace instrumentation
+
+#endif // _INSTRUMENTATION_H_
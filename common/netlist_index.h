@@ -0,0 +1,355 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#ifndef _NETLIST_INDEX_H_
+#define _NETLIST_INDEX_H_
+
+#include "kernel/rtlil.h"
+#include "kernel/sigtools.h"
+#include <algorithm>
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+// Driver and sink pins of the nets of a single module. Nets are the bits
+// canonicalized with SigMap and numbered with dense ids. The pins of all
+// nets are stored in flat arrays indexed by per-net offsets (CSR), so
+// building the index allocates a handful of vectors rather than a vector
+// per net.
+//
+// Cell port changes can be applied incrementally with UpdatePort, or
+// automatically by registering the index as a monitor of the module.
+// Changed ports are kept in a small overlay over the flat arrays until the
+// next Rebuild. Module level connections change the SigMap itself, they
+// mark the index as stale and require a Rebuild.
+//
+// Ports of cells of unknown types have no direction, such ports are
+// considered both drivers and sinks.
+class NetlistIndex : public RTLIL::Monitor
+{
+  public:
+    struct PortBit {
+        RTLIL::Cell *cell;
+        RTLIL::IdString port;
+        int offset;
+
+        PortBit(RTLIL::Cell *cell, const RTLIL::IdString &port, int offset) : cell(cell), port(port), offset(offset) {}
+    };
+
+    // With track_changes the index registers itself as a monitor of the
+    // module and follows all setPort calls and cell removals
+    explicit NetlistIndex(RTLIL::Module *module, bool track_changes = false) : module_(module), track_changes_(track_changes)
+    {
+        Rebuild();
+        if (track_changes_) {
+            module_->monitors.insert(this);
+        }
+    }
+
+    ~NetlistIndex()
+    {
+        if (track_changes_) {
+            module_->monitors.erase(this);
+        }
+    }
+
+    NetlistIndex(const NetlistIndex &) = delete;
+    NetlistIndex &operator=(const NetlistIndex &) = delete;
+
+    RTLIL::Module *GetModule() const { return module_; }
+    const SigMap &GetSigMap() const { return sigmap_; }
+
+    // Canonical bit of the net
+    RTLIL::SigBit Canonical(const RTLIL::SigBit &bit) const { return sigmap_(bit); }
+
+    // Dense id of the net of the bit, -1 if the net is neither connected to
+    // a cell nor to a module port
+    int NetId(const RTLIL::SigBit &bit) const
+    {
+        auto it = net_ids_.find(sigmap_(bit));
+        return it == net_ids_.end() ? -1 : it->second;
+    }
+
+    size_t NetCount() const { return net_ids_.size(); }
+
+    // Calls f(const PortBit &) for every cell pin driving the net
+    template <typename F> void ForEachDriver(const RTLIL::SigBit &bit, F f) const
+    {
+        ForEach(NetId(bit), driver_offsets_, drivers_, extra_drivers_, f);
+    }
+
+    // Calls f(const PortBit &) for every cell pin driven by the net
+    template <typename F> void ForEachSink(const RTLIL::SigBit &bit, F f) const { ForEach(NetId(bit), sink_offsets_, sinks_, extra_sinks_, f); }
+
+    std::vector<PortBit> Drivers(const RTLIL::SigBit &bit) const
+    {
+        std::vector<PortBit> drivers;
+        ForEachDriver(bit, [&drivers](const PortBit &pin) { drivers.push_back(pin); });
+        return drivers;
+    }
+
+    std::vector<PortBit> Sinks(const RTLIL::SigBit &bit) const
+    {
+        std::vector<PortBit> sinks;
+        ForEachSink(bit, [&sinks](const PortBit &pin) { sinks.push_back(pin); });
+        return sinks;
+    }
+
+    size_t SinkCount(const RTLIL::SigBit &bit) const
+    {
+        size_t count = 0;
+        ForEachSink(bit, [&count](const PortBit &) { count++; });
+        return count;
+    }
+
+    // The net is connected to a port of the module itself
+    bool IsModulePort(const RTLIL::SigBit &bit) const
+    {
+        int id = NetId(bit);
+        return id >= 0 && id < (int)module_ports_.size() && module_ports_[id];
+    }
+
+    // Records the new signal of a cell port, an empty signal removes the
+    // port. Call it right after setPort or unsetPort, or before removing a
+    // cell for each of its ports. With track_changes this is done
+    // automatically.
+    void UpdatePort(RTLIL::Cell *cell, const RTLIL::IdString &port, const RTLIL::SigSpec &sig)
+    {
+        auto key = std::make_pair(cell, port);
+        auto overlay = overlay_nets_.find(key);
+        if (overlay != overlay_nets_.end()) {
+            for (int id : overlay->second) {
+                EraseOverlayPin(extra_drivers_, id, cell, port);
+                EraseOverlayPin(extra_sinks_, id, cell, port);
+            }
+            overlay->second.clear();
+        }
+        changed_ports_.insert(key);
+        auto &nets = overlay_nets_[key];
+        bool driver = IsDriver(cell, port);
+        bool sink = IsSink(cell, port);
+        for (int offset = 0; offset < GetSize(sig); offset++) {
+            RTLIL::SigBit bit = sigmap_(sig[offset]);
+            if (!bit.wire) {
+                continue;
+            }
+            int id = AddNet(bit);
+            if (driver) {
+                extra_drivers_[id].emplace_back(cell, port, offset);
+            }
+            if (sink) {
+                extra_sinks_[id].emplace_back(cell, port, offset);
+            }
+            nets.push_back(id);
+        }
+    }
+
+    // Removes all pins of the cell, call it before removing the cell
+    void RemoveCell(RTLIL::Cell *cell)
+    {
+        for (auto &conn : cell->connections()) {
+            UpdatePort(cell, conn.first, RTLIL::SigSpec());
+        }
+    }
+
+    // Module level connections were made since the last Rebuild
+    bool IsStale() const { return stale_; }
+
+    // Number of cell ports changed since the last Rebuild
+    size_t ChangedPorts() const { return changed_ports_.size(); }
+
+    // Rebuilds the index from the current state of the module
+    void Rebuild()
+    {
+        sigmap_.set(module_);
+        net_ids_.clear();
+        module_ports_.clear();
+        changed_ports_.clear();
+        overlay_nets_.clear();
+        extra_drivers_.clear();
+        extra_sinks_.clear();
+        stale_ = false;
+
+        for (auto wire : module_->wires()) {
+            if (!wire->port_input && !wire->port_output) {
+                continue;
+            }
+            for (auto bit : sigmap_(wire)) {
+                if (!bit.wire) {
+                    continue;
+                }
+                int id = AddNet(bit);
+                if ((size_t)id >= module_ports_.size()) {
+                    module_ports_.resize(id + 1, false);
+                }
+                module_ports_[id] = true;
+            }
+        }
+
+        // Count the pins of every net first, then fill the flat arrays
+        std::vector<int> driver_counts, sink_counts;
+        ForEachCellPin([&](RTLIL::Cell *, const RTLIL::IdString &, int, int id, bool driver, bool sink) {
+            if ((size_t)id >= driver_counts.size()) {
+                driver_counts.resize(id + 1, 0);
+                sink_counts.resize(id + 1, 0);
+            }
+            driver_counts[id] += driver;
+            sink_counts[id] += sink;
+        });
+        driver_counts.resize(net_ids_.size(), 0);
+        sink_counts.resize(net_ids_.size(), 0);
+        base_nets_ = net_ids_.size();
+        Offsets(driver_counts, driver_offsets_);
+        Offsets(sink_counts, sink_offsets_);
+
+        drivers_.clear();
+        sinks_.clear();
+        drivers_.reserve(driver_offsets_.back());
+        sinks_.reserve(sink_offsets_.back());
+        std::vector<int> driver_fill(driver_offsets_.begin(), driver_offsets_.end() - 1);
+        std::vector<int> sink_fill(sink_offsets_.begin(), sink_offsets_.end() - 1);
+        drivers_.resize(driver_offsets_.back(), PortBit(nullptr, RTLIL::IdString(), 0));
+        sinks_.resize(sink_offsets_.back(), PortBit(nullptr, RTLIL::IdString(), 0));
+        ForEachCellPin([&](RTLIL::Cell *cell, const RTLIL::IdString &port, int offset, int id, bool driver, bool sink) {
+            if (driver) {
+                drivers_[driver_fill[id]++] = PortBit(cell, port, offset);
+            }
+            if (sink) {
+                sinks_[sink_fill[id]++] = PortBit(cell, port, offset);
+            }
+        });
+    }
+
+    // Rebuilds the index if it is stale or the overlay of changed ports grew
+    // large compared to the module
+    void Refresh()
+    {
+        if (stale_ || changed_ports_.size() * 4 > module_->cells_.size() + 16) {
+            Rebuild();
+        }
+    }
+
+    // RTLIL::Monitor, the signal passed is the new one, the cell isn't
+    // updated yet when the notification arrives
+    void notify_connect(RTLIL::Cell *cell, const RTLIL::IdString &port, const RTLIL::SigSpec &, const RTLIL::SigSpec &sig) override
+    {
+        UpdatePort(cell, port, sig);
+    }
+
+    void notify_connect(RTLIL::Module *, const RTLIL::SigSig &) override { stale_ = true; }
+
+    void notify_connect(RTLIL::Module *, const std::vector<RTLIL::SigSig> &) override { stale_ = true; }
+
+    void notify_blackout(RTLIL::Module *) override { stale_ = true; }
+
+  private:
+    static bool IsDriver(RTLIL::Cell *cell, const RTLIL::IdString &port) { return cell->output(port) || !cell->input(port); }
+
+    static bool IsSink(RTLIL::Cell *cell, const RTLIL::IdString &port) { return cell->input(port) || !cell->output(port); }
+
+    int AddNet(const RTLIL::SigBit &bit)
+    {
+        auto it = net_ids_.find(bit);
+        if (it != net_ids_.end()) {
+            return it->second;
+        }
+        int id = net_ids_.size();
+        net_ids_[bit] = id;
+        return id;
+    }
+
+    // Calls f(cell, port, offset, net id, is driver, is sink) for all
+    // connected cell port bits, assigning ids to new nets
+    template <typename F> void ForEachCellPin(F f)
+    {
+        for (auto cell : module_->cells()) {
+            for (auto &conn : cell->connections()) {
+                bool driver = IsDriver(cell, conn.first);
+                bool sink = IsSink(cell, conn.first);
+                for (int offset = 0; offset < GetSize(conn.second); offset++) {
+                    RTLIL::SigBit bit = sigmap_(conn.second[offset]);
+                    if (bit.wire) {
+                        f(cell, conn.first, offset, AddNet(bit), driver, sink);
+                    }
+                }
+            }
+        }
+    }
+
+    static void Offsets(const std::vector<int> &counts, std::vector<int> &offsets)
+    {
+        offsets.assign(counts.size() + 1, 0);
+        for (size_t i = 0; i < counts.size(); i++) {
+            offsets[i + 1] = offsets[i] + counts[i];
+        }
+    }
+
+    static void EraseOverlayPin(dict<int, std::vector<PortBit>> &pins, int id, RTLIL::Cell *cell, const RTLIL::IdString &port)
+    {
+        auto it = pins.find(id);
+        if (it == pins.end()) {
+            return;
+        }
+        auto &net_pins = it->second;
+        net_pins.erase(std::remove_if(net_pins.begin(), net_pins.end(),
+                                      [cell, &port](const PortBit &pin) { return pin.cell == cell && pin.port == port; }),
+                       net_pins.end());
+    }
+
+    template <typename F>
+    void ForEach(int id, const std::vector<int> &offsets, const std::vector<PortBit> &pins, const dict<int, std::vector<PortBit>> &extra_pins,
+                 F f) const
+    {
+        if (id < 0) {
+            return;
+        }
+        if (id < base_nets_) {
+            for (int i = offsets[id]; i < offsets[id + 1]; i++) {
+                const PortBit &pin = pins[i];
+                if (changed_ports_.empty() || !changed_ports_.count(std::make_pair(pin.cell, pin.port))) {
+                    f(pin);
+                }
+            }
+        }
+        auto extra = extra_pins.find(id);
+        if (extra != extra_pins.end()) {
+            for (auto &pin : extra->second) {
+                f(pin);
+            }
+        }
+    }
+
+    RTLIL::Module *module_;
+    bool track_changes_;
+    bool stale_ = false;
+    SigMap sigmap_;
+    dict<RTLIL::SigBit, int> net_ids_;
+    // Nets with pins in the flat arrays
+    int base_nets_ = 0;
+    std::vector<bool> module_ports_;
+    // Pins of the nets [offsets[id], offsets[id + 1])
+    std::vector<int> driver_offsets_, sink_offsets_;
+    std::vector<PortBit> drivers_, sinks_;
+    // Ports whose entries in the flat arrays are outdated and the nets of
+    // their current connections
+    pool<std::pair<RTLIL::Cell *, RTLIL::IdString>> changed_ports_;
+    dict<std::pair<RTLIL::Cell *, RTLIL::IdString>, std::vector<int>> overlay_nets_;
+    dict<int, std::vector<PortBit>> extra_drivers_, extra_sinks_;
+};
+
+#endif // _NETLIST_INDEX_H_
@@ -0,0 +1,139 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#ifndef _TCL_COMMANDS_H_
+#define _TCL_COMMANDS_H_
+
+#include "kernel/log.h"
+#include "kernel/register.h"
+#include "kernel/rtlil.h"
+#include "kernel/yosys.h"
+#include <string>
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+// Registration of plugin passes as native commands of the Yosys Tcl
+// interpreter. Query and constraint passes (get_*, getparam, set_property,
+// ...) are called from Tcl scripts once per object, so the per-call overhead
+// of the Tcl side matters. A command registered here takes its arguments as
+// Tcl_Obj values and runs the pass directly, instead of going through a
+// `proc` that expands them into a string evaluation of the `yosys` command.
+// The pass sets the result of the command to native Tcl lists and dicts.
+//
+// The passes stay registered with Yosys, so they can still be used from
+// Yosys scripts.
+//
+// Passes on the hottest paths, like the SDC constraint commands, can also
+// provide their own Tcl implementation with register_native_command.
+namespace tcl_commands
+{
+
+// Arguments of a native Tcl command with the same interface as the argument
+// vector of a Yosys pass. Only the arguments that are read are converted to
+// strings.
+struct Args {
+    Args(int objc, Tcl_Obj *const objv[]) : objc_(objc), objv_(objv) {}
+
+    size_t size() const { return objc_; }
+
+    std::string operator[](size_t idx) const
+    {
+        int length;
+        const char *str = Tcl_GetStringFromObj(objv_[idx], &length);
+        return std::string(str, length);
+    }
+
+  private:
+    size_t objc_;
+    Tcl_Obj *const *objv_;
+};
+
+// Reports the error of a native Tcl command
+inline int error(Tcl_Interp *interp, const std::string &message)
+{
+    Tcl_SetObjResult(interp, Tcl_NewStringObj(message.c_str(), message.size()));
+    return TCL_ERROR;
+}
+
+// Runs the pass in client_data on the current design, like Pass::call
+inline int run_pass(ClientData client_data, Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
+{
+    Pass *pass = static_cast<Pass *>(client_data);
+    std::vector<std::string> args;
+    args.reserve(objc);
+    args.push_back(pass->pass_name);
+    for (int i = 1; i < objc; i++) {
+        int length;
+        const char *arg = Tcl_GetStringFromObj(objv[i], &length);
+        args.emplace_back(arg, length);
+    }
+
+    RTLIL::Design *design = yosys_get_design();
+    const size_t selection_stack_size = design->selection_stack.size();
+    // Report errors of the pass to the script instead of exiting
+    const bool saved_log_cmd_error_throw = log_cmd_error_throw;
+    log_cmd_error_throw = true;
+    Tcl_ResetResult(interp);
+
+    // Count the call like Pass::call does. The design introspection commands
+    // drop their cached results when the call counter of any other pass changes.
+    pass->call_counter++;
+
+    int status = TCL_OK;
+    auto state = pass->pre_execute();
+    try {
+        pass->execute(args, design);
+    } catch (const log_cmd_error_exception &) {
+        Tcl_SetObjResult(interp, Tcl_NewStringObj(log_last_error.c_str(), log_last_error.size()));
+        status = TCL_ERROR;
+    }
+    pass->post_execute(state);
+
+    log_cmd_error_throw = saved_log_cmd_error_throw;
+    while (design->selection_stack.size() > selection_stack_size)
+        design->selection_stack.pop_back();
+    return status;
+}
+
+// Registers the pass as a Tcl command of the same name
+inline void register_command(Pass *pass)
+{
+    Tcl_Interp *interp = yosys_get_tcl_interp();
+    Tcl_CreateObjCommand(interp, pass->pass_name.c_str(), run_pass, pass, nullptr);
+}
+
+// Runs the native Tcl implementation of the pass in client_data, counting
+// the call like run_pass
+template <typename T> int run_native_command(ClientData client_data, Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
+{
+    static_cast<T *>(client_data)->call_counter++;
+    return T::TclCommand(client_data, interp, objc, objv);
+}
+
+// Registers the native Tcl implementation of the pass, the static
+// T::TclCommand, as a Tcl command of the same name
+template <typename T> void register_native_command(T &pass)
+{
+    Tcl_Interp *interp = yosys_get_tcl_interp();
+    Tcl_CreateObjCommand(interp, pass.pass_name.c_str(), &run_native_command<T>, &pass, nullptr);
+}
+
+} // namespace tcl_commands
+
+#endif // _TCL_COMMANDS_H_
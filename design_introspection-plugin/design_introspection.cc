@@ -17,6 +17,7 @@
  *
  */
 
+#include "../common/tcl_commands.h"
 #include "get_cells.h"
 #include "get_count.h"
 #include "get_nets.h"
@@ -29,7 +30,15 @@ USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
 struct DesignIntrospection {
-    DesignIntrospection() {}
+    DesignIntrospection()
+    {
+        tcl_commands::register_command(&get_nets_cmd);
+        tcl_commands::register_command(&get_ports_cmd);
+        tcl_commands::register_command(&get_cells_cmd);
+        tcl_commands::register_command(&get_pins_cmd);
+        tcl_commands::register_command(&get_count_cmd);
+        tcl_commands::register_command(&selection_to_tcl_list_cmd);
+    }
     GetNets get_nets_cmd;
     GetPorts get_ports_cmd;
     GetCells get_cells_cmd;
@@ -0,0 +1,211 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#include "filter_expression.h"
+#include "kernel/log.h"
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+#include <iterator>
+
+USING_YOSYS_NAMESPACE
+
+// Recursive descent parser of:
+//   expression := conjunction { '||' conjunction }
+//   conjunction := term { '&&' term }
+//   term := '(' expression ')' | attribute ( '==' | '!=' | '=~' ) value
+// Attribute names and values are either quoted or bare words.
+class FilterExpression::Parser
+{
+  public:
+    Parser(const std::string &expression, std::vector<Node> &nodes) : expression_(expression), nodes_(nodes) {}
+
+    int Parse()
+    {
+        int node = ParseExpression();
+        SkipSpaces();
+        if (pos_ != expression_.size()) {
+            Error("unexpected '" + expression_.substr(pos_) + "'");
+        }
+        return node;
+    }
+
+  private:
+    void SkipSpaces()
+    {
+        while (pos_ < expression_.size() && isspace(expression_[pos_])) {
+            pos_++;
+        }
+    }
+
+    bool Accept(const char *token)
+    {
+        SkipSpaces();
+        if (expression_.compare(pos_, strlen(token), token) == 0) {
+            pos_ += strlen(token);
+            return true;
+        }
+        return false;
+    }
+
+    [[noreturn]] void Error(const std::string &message)
+    {
+        log_cmd_error("Incorrect filter expression: %s: %s\n", expression_.c_str(), message.c_str());
+    }
+
+    int AddNode(Kind kind, int left, int right, const std::string &attribute = "", const std::string &value = "")
+    {
+        RTLIL::IdString attribute_id = attribute.empty() ? RTLIL::IdString() : RTLIL::IdString(RTLIL::escape_id(attribute));
+        nodes_.push_back(Node{kind, attribute_id, value, left, right});
+        return nodes_.size() - 1;
+    }
+
+    int ParseExpression()
+    {
+        int node = ParseConjunction();
+        while (Accept("||")) {
+            node = AddNode(Kind::Or, node, ParseConjunction());
+        }
+        return node;
+    }
+
+    int ParseConjunction()
+    {
+        int node = ParseTerm();
+        while (Accept("&&")) {
+            node = AddNode(Kind::And, node, ParseTerm());
+        }
+        return node;
+    }
+
+    int ParseTerm()
+    {
+        if (Accept("(")) {
+            int node = ParseExpression();
+            if (!Accept(")")) {
+                Error("missing ')'");
+            }
+            return node;
+        }
+        std::string attribute = ParseWord();
+        Kind kind;
+        if (Accept("==")) {
+            kind = Kind::Equal;
+        } else if (Accept("!=")) {
+            kind = Kind::NotEqual;
+        } else if (Accept("=~")) {
+            kind = Kind::Match;
+        } else {
+            Error("expected '==', '!=' or '=~' after '" + attribute + "'");
+        }
+        return AddNode(kind, -1, -1, attribute, ParseWord());
+    }
+
+    std::string ParseWord()
+    {
+        SkipSpaces();
+        std::string word;
+        if (pos_ < expression_.size() && expression_[pos_] == '"') {
+            size_t end = expression_.find('"', pos_ + 1);
+            if (end == std::string::npos) {
+                Error("missing '\"'");
+            }
+            word = expression_.substr(pos_ + 1, end - pos_ - 1);
+            pos_ = end + 1;
+            return word;
+        }
+        while (pos_ < expression_.size() && !isspace(expression_[pos_]) && !strchr("()=!~&|\"", expression_[pos_])) {
+            word += expression_[pos_++];
+        }
+        if (word.empty()) {
+            Error(pos_ < expression_.size() ? "unexpected '" + expression_.substr(pos_) + "'" : "unexpected end of expression");
+        }
+        return word;
+    }
+
+    const std::string &expression_;
+    std::vector<Node> &nodes_;
+    size_t pos_ = 0;
+};
+
+FilterExpression FilterExpression::Compile(const std::string &expression)
+{
+    FilterExpression filter;
+    filter.root_ = Parser(expression, filter.nodes_).Parse();
+    return filter;
+}
+
+bool FilterExpression::Matches(const RTLIL::AttrObject *object) const { return Empty() || Evaluate(root_, object); }
+
+bool FilterExpression::Evaluate(int node, const RTLIL::AttrObject *object) const
+{
+    const Node &n = nodes_.at(node);
+    switch (n.kind) {
+    case Kind::And:
+        return Evaluate(n.left, object) && Evaluate(n.right, object);
+    case Kind::Or:
+        return Evaluate(n.left, object) || Evaluate(n.right, object);
+    case Kind::Equal:
+        return object->get_string_attribute(n.attribute) == n.value;
+    case Kind::NotEqual:
+        return object->get_string_attribute(n.attribute) != n.value;
+    case Kind::Match:
+        return patmatch(n.value.c_str(), object->get_string_attribute(n.attribute).c_str());
+    }
+    return false;
+}
+
+bool FilterExpression::Candidates(const AttributeLookup &lookup, std::vector<size_t> &positions) const
+{
+    return !Empty() && Candidates(root_, lookup, positions);
+}
+
+bool FilterExpression::Candidates(int node, const AttributeLookup &lookup, std::vector<size_t> &positions) const
+{
+    const Node &n = nodes_.at(node);
+    switch (n.kind) {
+    case Kind::Equal:
+        positions = lookup(n.attribute, n.value);
+        return true;
+    case Kind::And: {
+        // Either side narrows down the candidates of a conjunction
+        std::vector<size_t> left, right;
+        bool has_left = Candidates(n.left, lookup, left);
+        bool has_right = Candidates(n.right, lookup, right);
+        if (has_left && has_right) {
+            positions.clear();
+            std::set_intersection(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(positions));
+        } else if (has_left || has_right) {
+            positions = has_left ? std::move(left) : std::move(right);
+        }
+        return has_left || has_right;
+    }
+    case Kind::Or: {
+        // Both sides need to be indexed for a disjunction
+        std::vector<size_t> left, right;
+        if (!Candidates(n.left, lookup, left) || !Candidates(n.right, lookup, right)) {
+            return false;
+        }
+        positions.clear();
+        std::set_union(left.begin(), left.end(), right.begin(), right.end(), std::back_inserter(positions));
+        return true;
+    }
+    default:
+        return false;
+    }
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#ifndef _FILTER_EXPRESSION_H_
+#define _FILTER_EXPRESSION_H_
+
+#include "kernel/rtlil.h"
+#include <functional>
+#include <string>
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+// Compiled -filter expression of the get_* commands, e.g.
+// {IS_CLOCK == true && (mr_ff != true || src =~ "*.v:*")}
+//
+// Conditions compare the string value of an attribute of an object, a
+// missing attribute compares as an empty string. '=~' matches the value
+// against a glob pattern. '&&' binds stronger than '||'.
+class FilterExpression
+{
+  public:
+    // Positions of the objects (in the order of the module's iteration)
+    // whose attribute is equal to the value
+    using AttributeLookup = std::function<std::vector<size_t>(const RTLIL::IdString &attribute, const std::string &value)>;
+
+    // Empty filter matching all objects
+    FilterExpression() = default;
+
+    // Parses the expression, errors out on a syntax error
+    static FilterExpression Compile(const std::string &expression);
+
+    bool Empty() const { return nodes_.empty(); }
+
+    bool Matches(const RTLIL::AttrObject *object) const;
+
+    // Computes the positions of the objects which can match the filter
+    // from the attribute index. Returns false if the filter can't be
+    // narrowed down by the index and all objects need to be checked.
+    // The objects at the positions still need to be checked with Matches.
+    bool Candidates(const AttributeLookup &lookup, std::vector<size_t> &positions) const;
+
+  private:
+    enum class Kind { Equal, NotEqual, Match, And, Or };
+
+    struct Node {
+        Kind kind;
+        RTLIL::IdString attribute;
+        std::string value;
+        int left;
+        int right;
+    };
+
+    class Parser;
+
+    bool Evaluate(int node, const RTLIL::AttrObject *object) const;
+    bool Candidates(int node, const AttributeLookup &lookup, std::vector<size_t> &positions) const;
+
+    std::vector<Node> nodes_;
+    int root_ = -1;
+};
+
+#endif // _FILTER_EXPRESSION_H_
@@ -1,4 +1,6 @@
 #include "get_cmd.h"
+#include "../common/instrumentation.h"
+#include "name_index.h"
 
 USING_YOSYS_NAMESPACE
 
@@ -17,9 +19,10 @@ void GetCmd::help()
         "executed.\n");
     log("\n");
     log("    -filter\n");
-    log("        Name and value of attribute to be taken into "
-        "account.\n");
-    log("        e.g. -filter { attr == \"true\" }\n");
+    log("        Expression on the attributes of the objects. Conditions\n");
+    log("        compare an attribute with a value using ==, != or =~ (glob\n");
+    log("        match) and can be combined with &&, || and parentheses.\n");
+    log("        e.g. -filter { attr == \"true\" && src =~ \"*.v:*\" }\n");
     log("\n");
     log("    -quiet\n");
     log("        Don't print the result of the execution to stdout.\n");
@@ -31,18 +34,86 @@ void GetCmd::help()
     log("\n");
 }
 
-void GetCmd::ExecuteSelection(RTLIL::Design *design, const CommandArgs &args)
+// Removes the objects not matching the filter
+template <typename T> static void FilterObjects(std::vector<T *> &objects, const FilterExpression &filter)
 {
-    std::vector<std::string> selection_args;
-    // Add name of top module to selection string
-    std::transform(args.selection_objects.begin(), args.selection_objects.end(), std::back_inserter(selection_args),
-                   [&](const std::string &obj) { return RTLIL::unescape_id(design->top_module()->name) + "/" + SelectionType() + ":" + obj; });
-    extra_args(selection_args, 0, design);
-    if (design->selected_modules().empty()) {
-        if (!args.is_quiet) {
-            log_warning("Specified %s not found in design\n", TypeName().c_str());
+    objects.erase(std::remove_if(objects.begin(), objects.end(), [&filter](T *object) { return !filter.Matches(object); }), objects.end());
+}
+
+// Objects matching the filter, only the candidates given by the attribute
+// index are checked if the filter can be narrowed down by it
+template <typename T>
+static std::vector<T *> FilterIndexed(const std::vector<T *> &objects, const FilterExpression &filter,
+                                      const FilterExpression::AttributeLookup &lookup)
+{
+    std::vector<size_t> positions;
+    if (!filter.Candidates(lookup, positions)) {
+        std::vector<T *> filtered(objects);
+        FilterObjects(filtered, filter);
+        return filtered;
+    }
+    std::vector<T *> filtered;
+    for (auto position : positions) {
+        if (filter.Matches(objects.at(position))) {
+            filtered.push_back(objects.at(position));
         }
     }
+    return filtered;
+}
+
+// The name index covers the top module only
+static bool IsTopModuleSelected(RTLIL::Design *design)
+{
+    auto modules = design->selected_modules();
+    return modules.size() == 1 && modules.front() == design->top_module() && design->selected_whole_module(design->top_module()->name);
+}
+
+std::vector<RTLIL::Cell *> GetCmd::SelectCells(RTLIL::Design *design, const SelectionObjects &patterns, const CommandArgs &args)
+{
+    std::vector<RTLIL::Cell *> cells;
+    if (patterns.empty()) {
+        if (IsTopModuleSelected(design)) {
+            const NameIndex &index = NameIndex::Get(design);
+            auto lookup = [&index](const RTLIL::IdString &attribute, const std::string &value) { return index.CellsWithAttribute(attribute, value); };
+            return FilterIndexed(index.Cells(), args.filter, lookup);
+        }
+        for (auto module : design->selected_modules()) {
+            auto selected_cells = module->selected_cells();
+            cells.insert(cells.end(), selected_cells.begin(), selected_cells.end());
+        }
+        FilterObjects(cells, args.filter);
+        return cells;
+    }
+    cells = NameIndex::Get(design).MatchCells(patterns);
+    if (cells.empty() && !args.is_quiet) {
+        log_warning("Specified %s not found in design\n", TypeName().c_str());
+    }
+    FilterObjects(cells, args.filter);
+    return cells;
+}
+
+std::vector<RTLIL::Wire *> GetCmd::SelectWires(RTLIL::Design *design, const SelectionObjects &patterns, const CommandArgs &args)
+{
+    std::vector<RTLIL::Wire *> wires;
+    if (patterns.empty()) {
+        if (IsTopModuleSelected(design)) {
+            const NameIndex &index = NameIndex::Get(design);
+            auto lookup = [&index](const RTLIL::IdString &attribute, const std::string &value) { return index.WiresWithAttribute(attribute, value); };
+            return FilterIndexed(index.Wires(), args.filter, lookup);
+        }
+        for (auto module : design->selected_modules()) {
+            auto selected_wires = module->selected_wires();
+            wires.insert(wires.end(), selected_wires.begin(), selected_wires.end());
+        }
+        FilterObjects(wires, args.filter);
+        return wires;
+    }
+    wires = NameIndex::Get(design).MatchWires(patterns);
+    if (wires.empty() && !args.is_quiet) {
+        log_warning("Specified %s not found in design\n", TypeName().c_str());
+    }
+    FilterObjects(wires, args.filter);
+    return wires;
 }
 
 void GetCmd::PackToTcl(const SelectionObjects &objects)
@@ -62,7 +133,7 @@ void GetCmd::PackToTcl(const SelectionObjects &objects)
 
 GetCmd::CommandArgs GetCmd::ParseCommand(const std::vector<std::string> &args)
 {
-    CommandArgs parsed_args{.filters = Filters(), .is_quiet = false, .selection_objects = SelectionObjects()};
+    CommandArgs parsed_args{.filter = FilterExpression(), .is_quiet = false, .selection_objects = SelectionObjects()};
     size_t argidx(0);
     for (argidx = 1; argidx < args.size(); argidx++) {
         std::string arg = args[argidx];
@@ -72,36 +143,7 @@ GetCmd::CommandArgs GetCmd::ParseCommand(const std::vector<std::string> &args)
         }
 
         if (arg == "-filter" and argidx + 1 < args.size()) {
-            std::string filter_arg = args[++argidx];
-
-            // Remove spaces
-            filter_arg.erase(std::remove_if(filter_arg.begin(), filter_arg.end(), isspace), filter_arg.end());
-
-            // Parse filters
-            // TODO Add support for multiple condition expression
-            // Currently only a single == is supported
-            std::regex filter_attr_regex("(\\w+\\s?==\\s?\\w+)([(||)(&&)]*)");
-            std::regex_token_iterator<std::string::iterator> regex_end;
-            std::regex_token_iterator<std::string::iterator> matches(filter_arg.begin(), filter_arg.end(), filter_attr_regex, 1);
-            if (matches == regex_end) {
-                log_warning("Currently -filter switch supports only a single "
-                            "'equal(==)' condition expression, the rest will be "
-                            "ignored\n");
-            }
-
-            while (matches != regex_end) {
-                std::string filter(*matches++);
-                auto separator = filter.find("==");
-                if (separator == std::string::npos) {
-                    log_cmd_error("Incorrect filter expression: %s\n", args[argidx].c_str());
-                }
-                parsed_args.filters.emplace_back(filter.substr(0, separator), filter.substr(separator + 2));
-            }
-            if (parsed_args.filters.size() > 1) {
-                log_warning("Currently -filter switch supports only a single "
-                            "'equal(==)' condition expression, the rest will be "
-                            "ignored\n");
-            }
+            parsed_args.filter = FilterExpression::Compile(args[++argidx]);
             continue;
         }
 
@@ -115,13 +157,52 @@ GetCmd::CommandArgs GetCmd::ParseCommand(const std::vector<std::string> &args)
     return parsed_args;
 }
 
+// Results of the get_* queries since the last change of the design.
+// Constraint scripts tend to repeat the same queries many times.
+struct QueryCache {
+    // Upper bound on the number of queries kept
+    static constexpr size_t kMaxQueries = 1 << 14;
+
+    RTLIL::Design *design = nullptr;
+    uint64_t generation = 0;
+    dict<std::string, GetCmd::SelectionObjects> results;
+};
+
+static QueryCache query_cache;
+
 void GetCmd::execute(std::vector<std::string> args, RTLIL::Design *design)
 {
+    instrumentation::ScopedTimer timer(design, "design_introspection.get_cmd");
     if (design->top_module() == nullptr) {
         log_cmd_error("No top module detected\n");
     }
 
+    // The index is rebuilt on any design change, so its generation tells if
+    // the cached results are still valid
+    uint64_t generation = NameIndex::Get(design).Generation();
+    auto &cache = query_cache;
+    if (cache.design != design || cache.generation != generation || cache.results.size() >= QueryCache::kMaxQueries) {
+        cache.design = design;
+        cache.generation = generation;
+        cache.results.clear();
+    }
+    std::string key = TypeName();
+    for (size_t i = 1; i < args.size(); i++) {
+        key += '\0' + args[i];
+    }
+    auto cached = cache.results.find(key);
+    if (cached != cache.results.end()) {
+        instrumentation::count("design_introspection.get_cmd.cache_hits");
+        PackToTcl(cached->second);
+        return;
+    }
+    instrumentation::count("design_introspection.get_cmd.cache_misses");
+
     CommandArgs parsed_args(ParseCommand(args));
-    ExecuteSelection(design, parsed_args);
-    PackToTcl(ExtractSelection(design, parsed_args));
+    SelectionObjects objects(ExtractSelection(design, parsed_args));
+    // Empty results aren't cached so that their warnings are repeated
+    if (!objects.empty()) {
+        cache.results[key] = objects;
+    }
+    PackToTcl(objects);
 }
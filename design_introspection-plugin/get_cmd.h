@@ -19,16 +19,15 @@
 #ifndef _GET_CMD_H_
 #define _GET_CMD_H_
 
+#include "filter_expression.h"
 #include "kernel/register.h"
 
 USING_YOSYS_NAMESPACE
 
 struct GetCmd : public Pass {
-    using Filter = std::pair<std::string, std::string>;
-    using Filters = std::vector<Filter>;
     using SelectionObjects = std::vector<std::string>;
     struct CommandArgs {
-        Filters filters;
+        FilterExpression filter;
         bool is_quiet;
         SelectionObjects selection_objects;
     };
@@ -41,12 +40,16 @@ struct GetCmd : public Pass {
   protected:
     CommandArgs ParseCommand(const std::vector<std::string> &args);
     void PackToTcl(const SelectionObjects &objects);
+    // Cells or wires of the top module matching any of the patterns and the
+    // filter. Without patterns all selected objects of the selected modules
+    // matching the filter are returned.
+    std::vector<RTLIL::Cell *> SelectCells(RTLIL::Design *design, const SelectionObjects &patterns, const CommandArgs &args);
+    std::vector<RTLIL::Wire *> SelectWires(RTLIL::Design *design, const SelectionObjects &patterns, const CommandArgs &args);
 
   private:
     virtual std::string TypeName() = 0;
     virtual std::string SelectionType() = 0;
     virtual SelectionObjects ExtractSelection(RTLIL::Design *design, const CommandArgs &args) = 0;
-    virtual void ExecuteSelection(RTLIL::Design *design, const CommandArgs &args);
 };
 
 #endif // GET_CMD_H_
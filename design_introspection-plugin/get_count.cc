@@ -69,30 +69,40 @@ void GetCount::execute(std::vector<std::string> a_Args, RTLIL::Design *a_Design)
     // Get the TCL interpreter
     Tcl_Interp *tclInterp = yosys_get_tcl_interp();
 
-    // Count objects
-    size_t moduleCount = 0;
-    size_t cellCount = 0;
-    size_t wireCount = 0;
-
-    moduleCount += a_Design->selected_modules().size();
-    for (auto module : a_Design->selected_modules()) {
-        cellCount += module->selected_cells().size();
-        wireCount += module->selected_wires().size();
-    }
-
+    // Count objects without materializing the selected object lists.
+    // Members of a fully selected module don't need to be checked one by one.
+    // Blackboxes are skipped like selected_modules() does.
     size_t count = 0;
-    switch (type) {
-    case ObjectType::MODULE:
-        count = moduleCount;
-        break;
-    case ObjectType::CELL:
-        count = cellCount;
-        break;
-    case ObjectType::WIRE:
-        count = wireCount;
-        break;
-    default:
-        log_assert(false);
+    for (auto module : a_Design->modules()) {
+        if (!a_Design->selected_module(module->name) || module->get_blackbox_attribute()) {
+            continue;
+        }
+        bool whole_module = a_Design->selected_whole_module(module->name);
+        switch (type) {
+        case ObjectType::MODULE:
+            count++;
+            break;
+        case ObjectType::CELL:
+            if (whole_module) {
+                count += module->cells_.size();
+            } else {
+                for (auto &it : module->cells_) {
+                    count += a_Design->selected_member(module->name, it.first);
+                }
+            }
+            break;
+        case ObjectType::WIRE:
+            if (whole_module) {
+                count += module->wires_.size();
+            } else {
+                for (auto &it : module->wires_) {
+                    count += a_Design->selected_member(module->name, it.first);
+                }
+            }
+            break;
+        default:
+            log_assert(false);
+        }
     }
 
     // Return the value as string to the TCL interpreter
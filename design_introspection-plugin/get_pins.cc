@@ -17,6 +17,10 @@
  *
  */
 #include "get_pins.h"
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <thread>
 
 USING_YOSYS_NAMESPACE
 
@@ -24,12 +28,6 @@ std::string GetPins::TypeName() { return "pin"; }
 
 std::string GetPins::SelectionType() { return "c"; }
 
-void GetPins::ExecuteSelection(RTLIL::Design *design, const CommandArgs &args)
-{
-    (void)design;
-    (void)args;
-}
-
 GetPins::SelectionObjects GetPins::ExtractSelection(RTLIL::Design *design, const CommandArgs &args)
 {
     SelectionObjects selected_objects;
@@ -37,9 +35,7 @@ GetPins::SelectionObjects GetPins::ExtractSelection(RTLIL::Design *design, const
         size_t port_separator = obj.find_last_of('/');
         std::string cell = obj.substr(0, port_separator);
         std::string port = obj.substr(port_separator + 1);
-        SelectionObjects selection{RTLIL::unescape_id(design->top_module()->name) + "/" + SelectionType() + ":" + cell};
-        extra_args(selection, 0, design);
-        ExtractSingleSelection(selected_objects, design, port, args);
+        ExtractSingleSelection(selected_objects, design, cell, port, args);
     }
     if (selected_objects.size() == 0 and !args.is_quiet) {
         log_warning("Couldn't find matching pin.\n");
@@ -47,27 +43,76 @@ GetPins::SelectionObjects GetPins::ExtractSelection(RTLIL::Design *design, const
     return selected_objects;
 }
 
-void GetPins::ExtractSingleSelection(SelectionObjects &objects, RTLIL::Design *design, const std::string &port_name, const CommandArgs &args)
+void GetPins::ExtractSingleSelection(SelectionObjects &objects, RTLIL::Design *design, const std::string &cell_pattern, const std::string &port_name,
+                                     const CommandArgs &args)
 {
-    if (design->selected_modules().empty()) {
-        if (!args.is_quiet) {
-            log_warning("Specified %s not found in design\n", TypeName().c_str());
+    std::vector<RTLIL::Cell *> cells = SelectCells(design, {cell_pattern}, args);
+    RTLIL::IdString port_id(RTLIL::escape_id(port_name));
+    bool port_pattern = port_name.find_first_of("*?[") != std::string::npos;
+
+    if (!port_pattern) {
+        for (auto cell : cells) {
+            if (cell->hasPort(port_id)) {
+                objects.push_back(RTLIL::unescape_id(cell->name) + "/" + port_name);
+            }
         }
+        return;
     }
-    for (auto module : design->selected_modules()) {
-        for (auto cell : module->selected_cells()) {
-            if (!cell->hasPort(RTLIL::escape_id(port_name))) {
-                continue;
-            }
-            if (args.filters.size() > 0) {
-                Filter filter = args.filters.at(0);
-                std::string attr_value = cell->get_string_attribute(RTLIL::IdString(RTLIL::escape_id(filter.first)));
-                if (attr_value.compare(filter.second)) {
-                    continue;
+
+    // Copying IdStrings isn't thread safe, so the cell and port names are
+    // resolved to strings here. The port names of cell i are
+    // port_names[port_offsets[i], port_offsets[i + 1]).
+    std::vector<std::string> cell_names;
+    std::vector<std::string> port_names;
+    std::vector<size_t> port_offsets;
+    cell_names.reserve(cells.size());
+    port_offsets.reserve(cells.size() + 1);
+    port_offsets.push_back(0);
+    for (auto cell : cells) {
+        cell_names.push_back(cell->name.str());
+        for (auto &conn : cell->connections()) {
+            port_names.push_back(conn.first.str());
+        }
+        port_offsets.push_back(port_names.size());
+    }
+
+    // Pin names of a chunk of the cells, appended to the worker's own buffer
+    auto expand = [&](size_t begin, size_t end, SelectionObjects &pins) {
+        for (size_t i = begin; i < end; i++) {
+            std::string cell_name(RTLIL::unescape_id(cell_names[i]) + "/");
+            for (size_t port = port_offsets[i]; port < port_offsets[i + 1]; port++) {
+                std::string pin(RTLIL::unescape_id(port_names[port]));
+                if (patmatch(port_name.c_str(), pin.c_str())) {
+                    pins.push_back(cell_name + pin);
                 }
             }
-            std::string pin_name(RTLIL::unescape_id(cell->name) + "/" + port_name);
-            objects.push_back(pin_name);
         }
+    };
+
+    size_t workers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), cells.size() / kMinCellsPerWorker);
+    if (workers <= 1) {
+        expand(0, cells.size(), objects);
+        return;
+    }
+    // Chunks are merged in the order of the cells, so the result is the same
+    // as of the serial expansion
+    std::vector<SelectionObjects> chunks(workers);
+    std::vector<std::thread> threads;
+    size_t chunk_size = (cells.size() + workers - 1) / workers;
+    for (size_t chunk = 0; chunk < workers; chunk++) {
+        size_t begin = std::min(chunk * chunk_size, cells.size());
+        size_t end = std::min(begin + chunk_size, cells.size());
+        threads.emplace_back(expand, begin, end, std::ref(chunks[chunk]));
+    }
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    size_t total = objects.size();
+    for (auto &chunk : chunks) {
+        total += chunk.size();
+    }
+    objects.reserve(total);
+    for (auto &chunk : chunks) {
+        std::move(chunk.begin(), chunk.end(), std::back_inserter(objects));
     }
 }
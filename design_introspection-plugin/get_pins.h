@@ -27,11 +27,14 @@ struct GetPins : public GetCmd {
     GetPins() : GetCmd("get_pins", "Print matching pins") {}
 
   private:
+    // Cells expanded by a single worker thread at least
+    static constexpr size_t kMinCellsPerWorker = 4096;
+
     std::string TypeName() override;
     std::string SelectionType() override;
     SelectionObjects ExtractSelection(RTLIL::Design *design, const CommandArgs &args) override;
-    void ExecuteSelection(RTLIL::Design *design, const CommandArgs &args) override;
-    void ExtractSingleSelection(SelectionObjects &objects, RTLIL::Design *design, const std::string &port_name, const CommandArgs &args);
+    void ExtractSingleSelection(SelectionObjects &objects, RTLIL::Design *design, const std::string &cell_pattern, const std::string &port_name,
+                                const CommandArgs &args);
 };
 
 #endif // GET_PINS_H_
@@ -25,8 +25,6 @@ std::string GetPorts::TypeName() { return "port"; }
 
 std::string GetPorts::SelectionType() { return "x"; }
 
-void GetPorts::ExecuteSelection([[gnu::unused]] RTLIL::Design *design, [[gnu::unused]] const CommandArgs &args) {}
-
 GetPorts::SelectionObjects GetPorts::ExtractSelection(RTLIL::Design *design, const CommandArgs &args)
 {
     std::string port_name = args.selection_objects.at(0);
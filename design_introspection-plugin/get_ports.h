@@ -31,7 +31,6 @@ struct GetPorts : public GetCmd {
     std::string SelectionType() override;
     /* void execute(std::vector<std::string> args, RTLIL::Design* design) override; */
     SelectionObjects ExtractSelection(RTLIL::Design *design, const CommandArgs &args) override;
-    void ExecuteSelection(RTLIL::Design *design, const CommandArgs &args) override;
 };
 
 #endif // GET_PORTS_H_
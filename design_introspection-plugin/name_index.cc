@@ -0,0 +1,174 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#include "name_index.h"
+#include "kernel/register.h"
+#include <algorithm>
+#include <cstring>
+#include <memory>
+
+USING_YOSYS_NAMESPACE
+
+// The index of the last queried design with the state it was built for
+struct NameIndexCache {
+    RTLIL::Design *design = nullptr;
+    RTLIL::Module *module = nullptr;
+    size_t cells = 0;
+    size_t wires = 0;
+    int64_t pass_calls = 0;
+    uint64_t generation = 0;
+    std::unique_ptr<NameIndex> index;
+};
+
+static NameIndexCache name_index_cache;
+
+// Number of calls of the passes able to change the design, including the
+// ones run as native Tcl commands. The design introspection commands and the
+// other queries only read it, so they don't invalidate the index.
+static int64_t CountPassCalls()
+{
+    static const pool<std::string> read_only_passes = {"get_cells", "get_nets",  "get_pins",   "get_ports",
+                                                       "get_count", "selection_to_tcl_list", "get_clocks", "getparam"};
+    int64_t calls = 0;
+    for (auto &pass : pass_register) {
+        if (!read_only_passes.count(pass.first)) {
+            calls += pass.second->call_counter;
+        }
+    }
+    return calls;
+}
+
+const NameIndex &NameIndex::Get(RTLIL::Design *design)
+{
+    RTLIL::Module *module = design->top_module();
+    int64_t pass_calls = CountPassCalls();
+    auto &cache = name_index_cache;
+    if (!cache.index || cache.design != design || cache.module != module || cache.cells != module->cells_.size() ||
+        cache.wires != module->wires_.size() || cache.pass_calls != pass_calls) {
+        cache.index.reset(new NameIndex(module));
+        cache.index->generation_ = ++cache.generation;
+        cache.design = design;
+        cache.module = module;
+        cache.cells = module->cells_.size();
+        cache.wires = module->wires_.size();
+        cache.pass_calls = pass_calls;
+    }
+    return *cache.index;
+}
+
+NameIndex::NameIndex(RTLIL::Module *module)
+{
+    Build<RTLIL::Cell>(cells_, module->cells());
+    Build<RTLIL::Wire>(wires_, module->wires());
+}
+
+template <typename T> void NameIndex::Build(Objects<T> &objects, const std::vector<T *> &module_objects)
+{
+    objects.objects = module_objects;
+    objects.entries.reserve(module_objects.size());
+    for (auto object : module_objects) {
+        objects.entries.push_back(Entry<T>{RTLIL::unescape_id(object->name), objects.entries.size(), object});
+    }
+    std::sort(objects.entries.begin(), objects.entries.end());
+}
+
+template <typename T> std::vector<T *> NameIndex::Match(const Entries<T> &entries, const std::vector<std::string> &patterns)
+{
+    std::vector<const Entry<T> *> matches;
+    for (auto &pattern : patterns) {
+        // Only names starting with the literal prefix of the pattern can match it.
+        // Patterns starting with '$' also match any name ending with them and
+        // patterns starting with a wildcard or a backslash can match the
+        // backslash of the public names, such patterns are checked on all names.
+        std::string prefix(pattern, 0, pattern.find_first_of("*?[\\"));
+        bool all_names = prefix.empty() || prefix[0] == '$';
+        auto it = all_names ? entries.begin() : std::lower_bound(entries.begin(), entries.end(), Entry<T>{prefix, 0, nullptr});
+        for (; it != entries.end(); ++it) {
+            if (!all_names && it->name.compare(0, prefix.size(), prefix) != 0) {
+                break;
+            }
+            if (MatchIds(it->object->name, pattern)) {
+                matches.push_back(&*it);
+            }
+        }
+    }
+    std::sort(matches.begin(), matches.end(), [](const Entry<T> *a, const Entry<T> *b) { return a->order < b->order; });
+    matches.erase(std::unique(matches.begin(), matches.end()), matches.end());
+    std::vector<T *> objects;
+    objects.reserve(matches.size());
+    for (auto match : matches) {
+        objects.push_back(match->object);
+    }
+    return objects;
+}
+
+std::vector<RTLIL::Cell *> NameIndex::MatchCells(const std::vector<std::string> &patterns) const { return Match(cells_.entries, patterns); }
+
+std::vector<RTLIL::Wire *> NameIndex::MatchWires(const std::vector<std::string> &patterns) const { return Match(wires_.entries, patterns); }
+
+template <typename T>
+std::vector<size_t> NameIndex::WithAttribute(const Objects<T> &objects, const RTLIL::IdString &attribute, const std::string &value)
+{
+    if (!objects.attributes.count(attribute)) {
+        AttributeValues &values = objects.attributes[attribute];
+        for (size_t i = 0; i < objects.objects.size(); i++) {
+            values[objects.objects[i]->get_string_attribute(attribute)].push_back(i);
+        }
+    }
+    const AttributeValues &values = objects.attributes.at(attribute);
+    auto positions = values.find(value);
+    if (positions == values.end()) {
+        return {};
+    }
+    return positions->second;
+}
+
+std::vector<size_t> NameIndex::CellsWithAttribute(const RTLIL::IdString &attribute, const std::string &value) const
+{
+    return WithAttribute(cells_, attribute, value);
+}
+
+std::vector<size_t> NameIndex::WiresWithAttribute(const RTLIL::IdString &attribute, const std::string &value) const
+{
+    return WithAttribute(wires_, attribute, value);
+}
+
+bool NameIndex::MatchIds(const RTLIL::IdString &id, const std::string &pattern)
+{
+    const char *id_c = id.c_str();
+    const char *pat_c = pattern.c_str();
+    if (id_c == pattern) {
+        return true;
+    }
+    if (*id_c == '\\' && !strcmp(id_c + 1, pat_c)) {
+        return true;
+    }
+    if (patmatch(pat_c, id_c)) {
+        return true;
+    }
+    if (*id_c == '\\' && patmatch(pat_c, id_c + 1)) {
+        return true;
+    }
+    if (*id_c == '$' && *pat_c == '$') {
+        const char *suffix = strrchr(id_c, '$');
+        if (!strcmp(suffix, pat_c)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,93 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#ifndef _NAME_INDEX_H_
+#define _NAME_INDEX_H_
+
+#include "kernel/rtlil.h"
+#include <string>
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+// Sorted names of the cells and wires of the top module used by the get_*
+// commands instead of evaluating a Yosys selection for every query.
+// Patterns are matched the same way as the members of a selection, e.g. "top/c:<pattern>".
+class NameIndex
+{
+  public:
+    // Returns the index of the design's top module. It is rebuilt if any pass
+    // other than the queries ran since it was built, including the passes run
+    // as native Tcl commands.
+    static const NameIndex &Get(RTLIL::Design *design);
+
+    // Changes whenever the index is rebuilt, results derived from an index of
+    // the same generation are still valid.
+    uint64_t Generation() const { return generation_; }
+
+    // Objects matching any of the patterns in the order of the module's iteration
+    std::vector<RTLIL::Cell *> MatchCells(const std::vector<std::string> &patterns) const;
+    std::vector<RTLIL::Wire *> MatchWires(const std::vector<std::string> &patterns) const;
+
+    // All objects in the order of the module's iteration
+    const std::vector<RTLIL::Cell *> &Cells() const { return cells_.objects; }
+    const std::vector<RTLIL::Wire *> &Wires() const { return wires_.objects; }
+
+    // Positions in Cells() or Wires() of the objects whose attribute has the
+    // given string value. Objects without the attribute have an empty value.
+    // The index of an attribute is built on its first query.
+    std::vector<size_t> CellsWithAttribute(const RTLIL::IdString &attribute, const std::string &value) const;
+    std::vector<size_t> WiresWithAttribute(const RTLIL::IdString &attribute, const std::string &value) const;
+
+    // Same as the matching of the selection members in Yosys
+    static bool MatchIds(const RTLIL::IdString &id, const std::string &pattern);
+
+  private:
+    template <typename T> struct Entry {
+        // Name without the leading backslash of public names
+        std::string name;
+        // Position in the module's iteration order
+        size_t order;
+        T *object;
+
+        bool operator<(const Entry &other) const { return name < other.name; }
+    };
+    template <typename T> using Entries = std::vector<Entry<T>>;
+    // Attribute value to the sorted positions of the objects with that value
+    using AttributeValues = dict<std::string, std::vector<size_t>>;
+
+    template <typename T> struct Objects {
+        // Sorted by name
+        Entries<T> entries;
+        std::vector<T *> objects;
+        mutable dict<RTLIL::IdString, AttributeValues> attributes;
+    };
+
+    explicit NameIndex(RTLIL::Module *module);
+
+    template <typename T> static void Build(Objects<T> &objects, const std::vector<T *> &module_objects);
+    template <typename T> static std::vector<T *> Match(const Entries<T> &entries, const std::vector<std::string> &patterns);
+    template <typename T>
+    static std::vector<size_t> WithAttribute(const Objects<T> &objects, const RTLIL::IdString &attribute, const std::string &value);
+
+    Objects<RTLIL::Cell> cells_;
+    Objects<RTLIL::Wire> wires_;
+    uint64_t generation_ = 0;
+};
+
+#endif // _NAME_INDEX_H_
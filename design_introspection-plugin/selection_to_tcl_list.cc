@@ -40,43 +40,45 @@ void SelectionToTclList::execute(std::vector<std::string> args, RTLIL::Design *d
     extra_args(args, 1, design);
 
     Tcl_Interp *interp = yosys_get_tcl_interp();
-    Tcl_Obj *tcl_list = Tcl_NewListObj(0, NULL);
 
     auto &selection = design->selection();
     if (selection.empty()) {
         log_warning("Selection is empty\n");
     }
 
+    // The list is created at once from all the elements
+    std::vector<Tcl_Obj *> tcl_objects;
     for (auto mod : design->modules()) {
         if (selection.selected_module(mod->name)) {
-            for (auto wire : mod->wires()) {
-                if (selection.selected_member(mod->name, wire->name)) {
-                    AddObjectNameToTclList(mod->name, wire->name, tcl_list);
+            std::string prefix = RTLIL::unescape_id(mod->name) + "/";
+            bool whole_module = selection.selected_whole_module(mod->name);
+            if (whole_module) {
+                tcl_objects.reserve(tcl_objects.size() + mod->wires_.size() + mod->memories.size() + mod->cells_.size() + mod->processes.size());
+            }
+            auto add_selected = [&](const RTLIL::IdString &object) {
+                if (whole_module || selection.selected_member(mod->name, object)) {
+                    AddObjectName(prefix, object, tcl_objects);
                 }
+            };
+            for (auto wire : mod->wires()) {
+                add_selected(wire->name);
             }
             for (auto &it : mod->memories) {
-                if (selection.selected_member(mod->name, it.first)) {
-                    AddObjectNameToTclList(mod->name, it.first, tcl_list);
-                }
+                add_selected(it.first);
             }
             for (auto cell : mod->cells()) {
-                if (selection.selected_member(mod->name, cell->name)) {
-                    AddObjectNameToTclList(mod->name, cell->name, tcl_list);
-                }
+                add_selected(cell->name);
             }
             for (auto &it : mod->processes) {
-                if (selection.selected_member(mod->name, it.first)) {
-                    AddObjectNameToTclList(mod->name, it.first, tcl_list);
-                }
+                add_selected(it.first);
             }
         }
     }
-    Tcl_SetObjResult(interp, tcl_list);
+    Tcl_SetObjResult(interp, Tcl_NewListObj(tcl_objects.size(), tcl_objects.data()));
 }
 
-void SelectionToTclList::AddObjectNameToTclList(RTLIL::IdString &module, RTLIL::IdString &object, Tcl_Obj *tcl_list)
+void SelectionToTclList::AddObjectName(const std::string &module_prefix, const RTLIL::IdString &object, std::vector<Tcl_Obj *> &tcl_objects)
 {
-    std::string name = RTLIL::unescape_id(module) + "/" + RTLIL::unescape_id(object);
-    Tcl_Obj *value_obj = Tcl_NewStringObj(name.c_str(), name.size());
-    Tcl_ListObjAppendElement(yosys_get_tcl_interp(), tcl_list, value_obj);
+    std::string name = module_prefix + RTLIL::unescape_id(object);
+    tcl_objects.push_back(Tcl_NewStringObj(name.c_str(), name.size()));
 }
@@ -29,7 +29,7 @@ struct SelectionToTclList : public Pass {
     void execute(std::vector<std::string> args, RTLIL::Design *design) override;
 
   private:
-    void AddObjectNameToTclList(RTLIL::IdString &module, RTLIL::IdString &object, Tcl_Obj *tcl_list);
+    void AddObjectName(const std::string &module_prefix, const RTLIL::IdString &object, std::vector<Tcl_Obj *> &tcl_objects);
 };
 
 #endif // SELECTION_TO_TCL_LIST_H_
@@ -17,8 +17,8 @@ puts "\n*inter* cells"
 puts $fp "\n*inter* cells"
 puts $fp [get_cells *inter*]
 
-puts "\n*inter* cells with invalid filter expression"
-puts $fp "\n*inter* cells with invalid filter expression"
+puts "\n*inter* cells with != filter expression"
+puts $fp "\n*inter* cells with != filter expression"
 puts $fp [get_cells -filter {mr_ff != true} *inter* ]
 
 puts "\nFiltered cells"
@@ -30,3 +30,13 @@ puts $fp "\nAll cells"
 puts $fp [get_cells]
 
 close $fp
+
+# Repeated queries return the cached result until the design is modified
+set dont_touch_cells [get_cells -filter {dont_touch == true}]
+if {[get_cells -filter {dont_touch == true}] != $dont_touch_cells} {
+    error "Repeated query returned a different result"
+}
+setattr -set dont_touch {"true"} top/OBUF_7
+if {[lsearch -exact [get_cells -filter {dont_touch == true}] OBUF_7] < 0} {
+    error "Query result not updated after the design change"
+}
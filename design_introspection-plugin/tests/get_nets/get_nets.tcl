@@ -17,8 +17,8 @@ puts "\n*inter* nets"
 puts $fp "*inter* nets"
 puts $fp [get_nets *inter*]
 
-puts "\n*inter* nets with invalid filter expression"
-puts $fp "*inter* nets with invalid filter expression"
+puts "\n*inter* nets with != filter expression"
+puts $fp "*inter* nets with != filter expression"
 puts $fp [get_nets -filter {mr_ff != true} *inter* ]
 
 puts "\nFiltered nets"
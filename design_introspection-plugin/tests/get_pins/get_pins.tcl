@@ -17,12 +17,20 @@ puts "\n*inter* pins"
 puts $fp "\n*inter* pins"
 puts $fp [get_pins OBUF_6/I]
 
-puts "\n*inter* pins with invalid filter expression"
-puts $fp "\n*inter* pins with invalid filter expression"
+puts "\n*inter* pins with != filter expression"
+puts $fp "\n*inter* pins with != filter expression"
 puts $fp [get_pins -filter {mr_ff != true} *inter*/I ]
 
 puts "\nFiltered pins"
 puts $fp "\nFiltered pins"
 puts $fp [get_pins -filter {dont_touch == true || async_reg == true && mr_ff == true} *OBUF*/I ]
 
+puts "\nGrouped filter pins"
+puts $fp "\nGrouped filter pins"
+puts $fp [get_pins -filter {(dont_touch =~ "t*" || mr_ff == true) && async_reg != true} *OBUF*/I ]
+
+puts "\nPort pattern pins"
+puts $fp "\nPort pattern pins"
+puts $fp [get_pins OBUF_6/I* ]
+
 close $fp
@@ -0,0 +1,68 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright 2020-2022 F4PGA Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# SPDX-License-Identifier: Apache-2.0
+"""
+
+This script generates synthetic designs with many DSP cells for the dsp-ff
+plugin benchmarks. The design of a benchmark is written to <prefix>.v.
+"""
+
+import argparse
+
+
+def many_dsps(size):
+    """ Nexus multipliers with registered inputs and outputs """
+    lines = [
+        "module top(input wire CLK, input wire [{0}:0] A, input wire [{0}:0] B, output reg [{1}:0] Z);".format(9 * size - 1, 18 * size - 1),
+        "  reg [{}:0] ra, rb;".format(9 * size - 1),
+        "  wire [{}:0] z;".format(18 * size - 1),
+        "  always @(posedge CLK) begin",
+        "    ra <= A;",
+        "    rb <= B;",
+        "    Z <= z;",
+        "  end",
+    ]
+    for i in range(size):
+        lines += [
+            "  MULT9X9 #(.REGINPUTA(\"BYPASS\"), .REGINPUTB(\"BYPASS\"), .REGOUTPUT(\"BYPASS\")) mult{} (".format(i),
+            "    .A(ra[{}:{}]), .B(rb[{}:{}]), .Z(z[{}:{}])".format(9 * i + 8, 9 * i, 9 * i + 8, 9 * i, 18 * i + 17, 18 * i),
+            "  );",
+        ]
+    lines.append("endmodule")
+    return lines
+
+
+BENCHMARKS = {
+    "many_dsps": (many_dsps, 1000),
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("benchmark", choices=sorted(BENCHMARKS.keys()), help="Benchmark to generate")
+    parser.add_argument("prefix", help="Prefix of the written files")
+    parser.add_argument("--size", type=int, help="Size of the design (default depends on the benchmark)")
+    args = parser.parse_args()
+
+    generator, default_size = BENCHMARKS[args.benchmark]
+    with open(args.prefix + ".v", "w") as fp:
+        fp.write("\n".join(generator(args.size or default_size)) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,10 @@
+yosys -import
+if { [info procs dsp_ff] == {} } { plugin -i dsp-ff }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(BENCH_DESIGN).v
+hierarchy -top top
+synth_nexus -flatten
+techmap -map +/nexus/cells_sim.v t:VLO t:VHI %u ;# Unmap VHI and VLO
+
+bench_pass dsp_ff -rules ../nexus-dsp_rules.txt
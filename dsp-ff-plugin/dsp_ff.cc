@@ -1,6 +1,12 @@
+#include "../common/instrumentation.h"
+#include "../common/netlist_index.h"
 #include "kernel/register.h"
 #include "kernel/rtlil.h"
 #include "kernel/sigtools.h"
+#include <deque>
+#include <map>
+#include <set>
+#include <sys/stat.h>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -45,85 +51,15 @@ struct DspFF : public Pass {
 
     // ..........................................
 
-    /// Connection map
-    struct ConnMap {
-
-        /// Maps source SigBit to all sinks it drives CellPin.
-        dict<RTLIL::SigBit, std::vector<CellPin>> sinks;
-        /// Maps source SigBit to its driver CellPin
-        dict<RTLIL::SigBit, CellPin> drivers;
-
-        /// Builds the map
-        void build(RTLIL::Module *module, const SigMap &sigmap)
-        {
-            clear();
-
-            // Scan cell ports
-            for (auto *cell : module->cells()) {
-                for (const auto &it : cell->connections_) {
-                    const auto &port = it.first;
-                    const auto &sigbits = it.second.bits();
-                    for (size_t i = 0; i < sigbits.size(); ++i) {
-                        auto sigbit = sigmap(sigbits[i]);
-
-                        // This is an input port (sink))
-                        if (cell->input(port)) {
-                            auto &vec = sinks[sigbit];
-                            vec.push_back(CellPin(cell, port, i));
-                        }
-                        // This is a source
-                        if (cell->output(port)) {
-                            drivers.insert(std::make_pair(sigbit, CellPin(cell, port, i)));
-                        }
-                    }
-                }
-            }
-
-            // Scan top-level ports
-            for (auto &it : module->wires_) {
-                auto *wire = it.second;
-
-                if (!wire->port_input && !wire->port_output) {
-                    continue;
-                }
-
-                RTLIL::SigSpec sigspec(wire, wire->start_offset, wire->width);
-                const auto &sigbits = sigspec.bits();
-                for (size_t i = 0; i < sigbits.size(); ++i) {
-                    auto sigbit = sigbits[i];
-                    if (!sigbit.wire) {
-                        continue;
-                    }
-
-                    // Output port (sink)
-                    if (sigbit.wire->port_output) {
-                        auto &vec = sinks[sigmap(sigbit)];
-                        vec.push_back(CellPin(nullptr, sigbit.wire->name, i));
-                    }
-                    // Input port (source)
-                    if (sigbit.wire->port_input) {
-                        drivers.insert(std::make_pair(sigbit, CellPin(nullptr, sigbit.wire->name, i)));
-                    }
-                }
-            }
-        }
-
-        /// Clears the map
-        void clear()
-        {
-            sinks.clear();
-            drivers.clear();
-        };
-    };
-
-    // ..........................................
-
     /// Describes a flip-flop type that can be integrated with a DSP cell
     struct FlopType {
         RTLIL::IdString name;
 
         /// A dict of port names indexed by their functions (like "clk", "rst")
         dict<RTLIL::IdString, RTLIL::IdString> ports;
+        /// The data ports resolved from the dict once the rules are loaded
+        RTLIL::IdString portD;
+        RTLIL::IdString portQ;
 
         struct {
             /// A list of parameters that must match for all flip-flops
@@ -184,6 +120,9 @@ struct DspFF : public Pass {
         dict<RegisterType, std::vector<PortType>> registers;
     };
 
+    /// A register of a DSP type along with its ports
+    using RegisterRule = std::pair<RegisterType, std::vector<PortType>>;
+
     /// Describes a changes made to a DSP cell
     struct DspChanges {
         pool<RTLIL::IdString> params; // Modified params
@@ -248,7 +187,7 @@ struct DspFF : public Pass {
         // Parses a vector of strings like "<name>=<value>" starting from the
         // second one on the list
         auto parseNameValue = [&](const std::vector<std::string> &strs) {
-            const std::regex expr("(\\S+)=(\\S+)");
+            static const std::regex expr("(\\S+)=(\\S+)");
             std::smatch match;
 
             std::vector<std::pair<std::string, std::string>> vec;
@@ -266,7 +205,7 @@ struct DspFF : public Pass {
 
         // Parses port name as "<name>[<hi>:<lo>]" or just "<name>"
         auto parsePortName = [&](const std::string &str) {
-            const std::regex expr("^(.*)\\[([0-9]+):([0-9]+)\\]");
+            static const std::regex expr("^(.*)\\[([0-9]+):([0-9]+)\\]");
             std::smatch match;
 
             std::tuple<std::string, int, int> data;
@@ -376,9 +315,9 @@ struct DspFF : public Pass {
                 portType = PortType();
                 portType.name = RTLIL::escape_id(std::get<0>(spec));
                 portType.bits = std::make_pair(std::get<2>(spec), std::get<1>(spec));
-                portType.assoc.insert(std::make_pair(RTLIL::escape_id("clk"), std::make_pair(RTLIL::IdString(), RTLIL::Sx)));
-                portType.assoc.insert(std::make_pair(RTLIL::escape_id("rst"), std::make_pair(RTLIL::IdString(), RTLIL::Sx)));
-                portType.assoc.insert(std::make_pair(RTLIL::escape_id("ena"), std::make_pair(RTLIL::IdString(), RTLIL::Sx)));
+                portType.assoc.insert(std::make_pair(ID(clk), std::make_pair(RTLIL::IdString(), RTLIL::Sx)));
+                portType.assoc.insert(std::make_pair(ID(rst), std::make_pair(RTLIL::IdString(), RTLIL::Sx)));
+                portType.assoc.insert(std::make_pair(ID(ena), std::make_pair(RTLIL::IdString(), RTLIL::Sx)));
 
                 registerType = RegisterType();
 
@@ -424,11 +363,11 @@ struct DspFF : public Pass {
 
                 flopTypes.resize(flopTypes.size() + 1);
                 flopTypes.back().name = RTLIL::escape_id(fields[1]);
-                flopTypes.back().ports.insert(std::make_pair(RTLIL::escape_id("clk"), RTLIL::IdString()));
-                flopTypes.back().ports.insert(std::make_pair(RTLIL::escape_id("rst"), RTLIL::IdString()));
-                flopTypes.back().ports.insert(std::make_pair(RTLIL::escape_id("ena"), RTLIL::IdString()));
-                flopTypes.back().ports.insert(std::make_pair(RTLIL::escape_id("d"), RTLIL::IdString()));
-                flopTypes.back().ports.insert(std::make_pair(RTLIL::escape_id("q"), RTLIL::IdString()));
+                flopTypes.back().ports.insert(std::make_pair(ID(clk), RTLIL::IdString()));
+                flopTypes.back().ports.insert(std::make_pair(ID(rst), RTLIL::IdString()));
+                flopTypes.back().ports.insert(std::make_pair(ID(ena), RTLIL::IdString()));
+                flopTypes.back().ports.insert(std::make_pair(ID(d), RTLIL::IdString()));
+                flopTypes.back().ports.insert(std::make_pair(ID(q), RTLIL::IdString()));
             } else if (fields[0] == "endff") {
                 if (fields.size() != 1) {
                     log_error(" syntax error: '%s'\n", line.c_str());
@@ -450,12 +389,12 @@ struct DspFF : public Pass {
                     if (fields.size() != 3) {
                         log_error(" syntax error: '%s'\n", line.c_str());
                     }
-                    portType.assoc[RTLIL::escape_id("clk")] = std::make_pair(RTLIL::escape_id(fields[1]), RTLIL::Const::from_string(fields[2]));
+                    portType.assoc[ID(clk)] = std::make_pair(RTLIL::escape_id(fields[1]), RTLIL::Const::from_string(fields[2]));
                 } else if (tok.back() == "ff") {
                     if (fields.size() != 2) {
                         log_error(" syntax error: '%s'\n", line.c_str());
                     }
-                    flopTypes.back().ports[RTLIL::escape_id("clk")] = RTLIL::escape_id(fields[1]);
+                    flopTypes.back().ports[ID(clk)] = RTLIL::escape_id(fields[1]);
                 }
             } else if (fields[0] == "rst") {
                 if (tok.size() == 0 || (tok.back() != "port" && tok.back() != "ff")) {
@@ -467,12 +406,12 @@ struct DspFF : public Pass {
                     if (fields.size() != 3) {
                         log_error(" syntax error: '%s'\n", line.c_str());
                     }
-                    portType.assoc[RTLIL::escape_id("rst")] = std::make_pair(RTLIL::escape_id(fields[1]), RTLIL::Const::from_string(fields[2]));
+                    portType.assoc[ID(rst)] = std::make_pair(RTLIL::escape_id(fields[1]), RTLIL::Const::from_string(fields[2]));
                 } else if (tok.back() == "ff") {
                     if (fields.size() != 2) {
                         log_error(" syntax error: '%s'\n", line.c_str());
                     }
-                    flopTypes.back().ports[RTLIL::escape_id("rst")] = RTLIL::escape_id(fields[1]);
+                    flopTypes.back().ports[ID(rst)] = RTLIL::escape_id(fields[1]);
                 }
             } else if (fields[0] == "ena") {
                 if (tok.size() == 0 || (tok.back() != "port" && tok.back() != "ff")) {
@@ -484,12 +423,12 @@ struct DspFF : public Pass {
                     if (fields.size() != 3) {
                         log_error(" syntax error: '%s'\n", line.c_str());
                     }
-                    portType.assoc[RTLIL::escape_id("ena")] = std::make_pair(RTLIL::escape_id(fields[1]), RTLIL::Const::from_string(fields[2]));
+                    portType.assoc[ID(ena)] = std::make_pair(RTLIL::escape_id(fields[1]), RTLIL::Const::from_string(fields[2]));
                 } else if (tok.back() == "ff") {
                     if (fields.size() != 2) {
                         log_error(" syntax error: '%s'\n", line.c_str());
                     }
-                    flopTypes.back().ports[RTLIL::escape_id("ena")] = RTLIL::escape_id(fields[1]);
+                    flopTypes.back().ports[ID(ena)] = RTLIL::escape_id(fields[1]);
                 }
             }
 
@@ -501,7 +440,7 @@ struct DspFF : public Pass {
                     log_error(" unexpected keyword '%s'\n", fields[0].c_str());
                 }
 
-                flopTypes.back().ports[RTLIL::escape_id("d")] = RTLIL::escape_id(fields[1]);
+                flopTypes.back().ports[ID(d)] = RTLIL::escape_id(fields[1]);
             } else if (fields[0] == "q") {
                 if (fields.size() != 2) {
                     log_error(" syntax error: '%s'\n", line.c_str());
@@ -510,7 +449,7 @@ struct DspFF : public Pass {
                     log_error(" unexpected keyword '%s'\n", fields[0].c_str());
                 }
 
-                flopTypes.back().ports[RTLIL::escape_id("q")] = RTLIL::escape_id(fields[1]);
+                flopTypes.back().ports[ID(q)] = RTLIL::escape_id(fields[1]);
             }
 
             // Parameters that must be set to certain values
@@ -609,14 +548,51 @@ struct DspFF : public Pass {
             }
             m_DspTypes.insert(std::make_pair(it.name, it));
         }
-        for (const auto &it : flopTypes) {
+        for (auto &it : flopTypes) {
             if (m_FlopTypes.count(it.name)) {
                 log_error(" duplicated rule for flip-flop '%s'\n", it.name.c_str());
             }
+            it.portD = it.ports.at(ID(d));
+            it.portQ = it.ports.at(ID(q));
             m_FlopTypes.insert(std::make_pair(it.name, it));
         }
     }
 
+    /// Rules compiled from a file, reused for the whole Yosys session while
+    /// the file's modification time and size are unchanged
+    struct CompiledRules {
+        time_t mtime;
+        off_t size;
+        dict<RTLIL::IdString, DspType> dspTypes;
+        dict<RTLIL::IdString, FlopType> flopTypes;
+    };
+
+    static std::map<std::string, CompiledRules> &rules_cache()
+    {
+        static std::map<std::string, CompiledRules> cache;
+        return cache;
+    }
+
+    /// Loads the rules from the cache or compiles them from the file
+    void get_rules(const std::string &a_FileName)
+    {
+        struct stat fileStat;
+        bool hasStat = stat(a_FileName.c_str(), &fileStat) == 0;
+        auto &cache = rules_cache();
+        auto cached = cache.find(a_FileName);
+        if (hasStat && cached != cache.end() && cached->second.mtime == fileStat.st_mtime && cached->second.size == fileStat.st_size) {
+            log("Using rules from '%s' loaded before.\n", a_FileName.c_str());
+            m_DspTypes = cached->second.dspTypes;
+            m_FlopTypes = cached->second.flopTypes;
+            return;
+        }
+
+        load_rules(a_FileName);
+        if (hasStat) {
+            cache[a_FileName] = CompiledRules{fileStat.st_mtime, fileStat.st_size, m_DspTypes, m_FlopTypes};
+        }
+    }
+
     void dump_rules()
     {
 
@@ -704,15 +680,36 @@ struct DspFF : public Pass {
 
     // ..........................................
 
-    /// Temporary SigBit to SigBit helper map.
-    SigMap m_SigMap;
-    /// Module connection map
-    ConnMap m_ConnMap;
+    /// State of the processing of a single module. Everything the pass
+    /// learns about or changes in a module is kept here.
+    struct ModuleContext {
+        RTLIL::Module *module;
+
+        /// Module connectivity, follows the changes made to the cells
+        NetlistIndex index;
+        /// SigBit to SigBit helper map of the index
+        const SigMap &sigmap;
+
+        /// Cells to be removed in the commit phase
+        pool<RTLIL::Cell *> cellsToRemove;
+        /// DSP cells that got changed
+        dict<RTLIL::Cell *, DspChanges> dspChanges;
+
+        ModuleContext(RTLIL::Module *a_Module) : module(a_Module), index(a_Module, true), sigmap(index.GetSigMap()) {}
+
+        ModuleContext(const ModuleContext &ref) = delete;
+
+        /// Applies the changes deferred until the module has been processed
+        void commit()
+        {
+            for (const auto &cell : cellsToRemove) {
+                module->remove(cell);
+            }
+            cellsToRemove.clear();
+        }
+    };
 
-    /// Cells to be removed (per module!)
-    pool<RTLIL::Cell *> m_CellsToRemove;
-    /// DSP cells that got changed
-    dict<RTLIL::Cell *, DspChanges> m_DspChanges;
+    // ..........................................
 
     /// DSP types
     dict<RTLIL::IdString, DspType> m_DspTypes;
@@ -799,6 +796,7 @@ struct DspFF : public Pass {
     void execute(std::vector<std::string> a_Args, RTLIL::Design *a_Design) override
     {
         log_header(a_Design, "Executing DSP_FF pass.\n");
+        instrumentation::ScopedTimer timer(a_Design, "dsp_ff");
 
         std::string rulesFile;
 
@@ -820,61 +818,104 @@ struct DspFF : public Pass {
         }
 
         // Reset state
-        m_CellsToRemove.clear();
-        m_DspChanges.clear();
         m_DspTypes.clear();
         m_FlopTypes.clear();
 
         // Load rules
         rewrite_filename(rulesFile);
-        load_rules(rulesFile);
+        {
+            instrumentation::ScopedTimer rules_timer("dsp_ff.rules");
+            get_rules(rulesFile);
+        }
         if (log_force_debug) {
             dump_rules();
         }
 
+        // Registers enabled and flip-flops integrated per DSP type
+        std::map<std::string, std::pair<int, int>> absorbed;
+
         // Process modules
         for (auto module : a_Design->selected_modules()) {
 
-            // Setup the SigMap
-            m_SigMap.clear();
-            m_SigMap.set(module);
+            // Modules without DSP cells need no connectivity at all
+            std::vector<RTLIL::Cell *> dspCells;
+            for (auto cell : module->cells()) {
+                if (m_DspTypes.count(cell->type)) {
+                    dspCells.push_back(cell);
+                }
+            }
+            if (dspCells.empty()) {
+                continue;
+            }
 
-            // Build the connection map
-            m_ConnMap.clear();
-            m_ConnMap.build(module, m_SigMap);
+            instrumentation::count("dsp_ff.dsp_cells", dspCells.size());
+            instrumentation::ScopedTimer module_timer("dsp_ff.modules");
+            ModuleContext ctx(module);
+
+            // Process the registers of the DSP cells until no more flip-flops
+            // can be integrated. Integrating flip-flops changes the nets
+            // around them, so all registers of the DSP cells connected to
+            // these nets are queued again.
+            std::deque<std::pair<RTLIL::Cell *, const RegisterRule *>> worklist;
+            std::set<std::pair<RTLIL::Cell *, const RegisterRule *>> queued;
+            auto enqueue = [&](RTLIL::Cell *cell) {
+                for (const auto &rule : m_DspTypes.at(cell->type).registers) {
+                    auto item = std::make_pair(cell, &rule);
+                    if (queued.insert(item).second) {
+                        worklist.push_back(item);
+                    }
+                }
+            };
+            for (auto cell : dspCells) {
+                enqueue(cell);
+            }
 
-            // Look for DSP cells
-            for (auto cell : module->cells()) {
+            while (!worklist.empty()) {
+                auto item = worklist.front();
+                worklist.pop_front();
+                queued.erase(item);
 
-                // Not a DSP
-                if (!m_DspTypes.count(cell->type)) {
+                RTLIL::Cell *cell = item.first;
+                size_t removedFlops = ctx.cellsToRemove.size();
+                std::vector<RTLIL::SigBit> touchedBits;
+                if (!processRegister(ctx, cell, item.second->first, item.second->second, touchedBits)) {
                     continue;
                 }
 
-                // Process all registers
-                auto &dspType = m_DspTypes.at(cell->type);
-                for (auto &rule : dspType.registers) {
-                    processRegister(cell, rule.first, rule.second);
+                auto &summary = absorbed[cell->type.str()];
+                summary.first++;
+                summary.second += ctx.cellsToRemove.size() - removedFlops;
+
+                enqueue(cell);
+                auto enqueueDsp = [&](const NetlistIndex::PortBit &pin) {
+                    if (m_DspTypes.count(pin.cell->type)) {
+                        enqueue(pin.cell);
+                    }
+                };
+                for (const auto &bit : touchedBits) {
+                    ctx.index.ForEachDriver(bit, enqueueDsp);
+                    ctx.index.ForEachSink(bit, enqueueDsp);
                 }
             }
 
             // Remove cells
-            for (const auto &cell : m_CellsToRemove) {
-                module->remove(cell);
-            }
-            m_CellsToRemove.clear();
+            ctx.commit();
         }
 
-        // Clear maps
-        m_SigMap.clear();
-        m_ConnMap.clear();
+        // Print the summary
+        for (const auto &it : absorbed) {
+            log("Enabled %d register(s) integrating %d flip-flop(s) in %s cells.\n", it.second.first, it.second.second,
+                RTLIL::unescape_id(it.first).c_str());
+            instrumentation::count("dsp_ff.flip_flops", it.second.second);
+        }
+        instrumentation::sample_memory("dsp_ff");
     }
 
     // ..........................................
 
-    bool checkFlop(RTLIL::Cell *a_Cell)
+    bool checkFlop(RTLIL::Cell *a_Cell, const FlopType &a_FlopType)
     {
-        const auto &flopType = m_FlopTypes.at(a_Cell->type);
+        const auto &flopType = a_FlopType;
         bool isOk = true;
 
         log_debug("checking connected flip-flop '%s' of type '%s'... ", a_Cell->name.c_str(), a_Cell->type.c_str());
@@ -887,7 +928,7 @@ struct DspFF : public Pass {
 
         // Check if required parameters are set as they should be
         for (const auto &it : flopType.params.required) {
-            const auto curr = a_Cell->getParam(it.first);
+            const auto &curr = a_Cell->getParam(it.first);
             if (curr != it.second) {
                 log_debug("\n   param '%s' mismatch ('%s' instead of '%s')", it.first.c_str(), curr.decode_string().c_str(),
                           it.second.decode_string().c_str());
@@ -903,11 +944,11 @@ struct DspFF : public Pass {
         return isOk;
     }
 
-    bool checkFlopDataAgainstDspRegister(const FlopData &a_FlopData, RTLIL::Cell *a_Cell, const RegisterType &a_Register,
+    bool checkFlopDataAgainstDspRegister(ModuleContext &a_Ctx, const FlopData &a_FlopData, RTLIL::Cell *a_Cell, const RegisterType &a_Register,
                                          const std::vector<PortType> &a_Ports)
     {
         const auto &flopType = m_FlopTypes.at(a_FlopData.type);
-        const auto &changes = m_DspChanges[a_Cell];
+        const auto &changes = a_Ctx.dspChanges[a_Cell];
         bool isOk = true;
 
         log_debug("  checking connected flip-flop settings against the DSP register... ");
@@ -924,7 +965,7 @@ struct DspFF : public Pass {
                     auto sigbits = sigspec.bits();
                     log_assert(sigbits.size() <= 1);
                     if (!sigbits.empty()) {
-                        conn = m_SigMap(sigbits[0]);
+                        conn = a_Ctx.sigmap(sigbits[0]);
                     }
                 }
 
@@ -950,8 +991,8 @@ struct DspFF : public Pass {
         // Check parameters to be mapped (by the port rule)
         for (const auto &it : a_Register.params.map) {
             if (a_Cell->hasParam(it.first) && a_FlopData.params.dsp.count(it.second)) {
-                const auto curr = a_Cell->getParam(it.first);
-                const auto flop = a_FlopData.params.dsp.at(it.second);
+                const auto &curr = a_Cell->getParam(it.first);
+                const auto &flop = a_FlopData.params.dsp.at(it.second);
                 checkParam(it.first, curr, flop);
             }
         }
@@ -959,7 +1000,7 @@ struct DspFF : public Pass {
         // Check parameters to be set (by the port rule)
         for (const auto &it : a_Register.params.set) {
             if (a_Cell->hasParam(it.first)) {
-                const auto curr = a_Cell->getParam(it.first);
+                const auto &curr = a_Cell->getParam(it.first);
                 checkParam(it.first, curr, it.second);
             }
         }
@@ -967,8 +1008,8 @@ struct DspFF : public Pass {
         // Check parameters to be mapped (by the flip-flop rule)
         for (const auto &it : flopType.params.map) {
             if (a_Cell->hasParam(it.first) && a_FlopData.params.dsp.count(it.second)) {
-                const auto curr = a_Cell->getParam(it.first);
-                const auto flop = a_FlopData.params.dsp.at(it.second);
+                const auto &curr = a_Cell->getParam(it.first);
+                const auto &flop = a_FlopData.params.dsp.at(it.second);
                 checkParam(it.first, curr, flop);
             }
         }
@@ -976,7 +1017,7 @@ struct DspFF : public Pass {
         // Check parameters to be set (by the flip-flop rule)
         for (const auto &it : flopType.params.set) {
             if (a_Cell->hasParam(it.first)) {
-                const auto curr = a_Cell->getParam(it.first);
+                const auto &curr = a_Cell->getParam(it.first);
                 checkParam(it.first, curr, it.second);
             }
         }
@@ -1016,15 +1057,19 @@ struct DspFF : public Pass {
 
     // ..........................................
 
-    void processRegister(RTLIL::Cell *a_Cell, const RegisterType &a_Register, const std::vector<PortType> &a_Ports)
+    /// Attempts to integrate flip-flops into a DSP register. Returns true if
+    /// the register has been enabled, the nets the integrated flip-flops were
+    /// connected to are appended to a_TouchedBits.
+    bool processRegister(ModuleContext &a_Ctx, RTLIL::Cell *a_Cell, const RegisterType &a_Register, const std::vector<PortType> &a_Ports,
+                         std::vector<RTLIL::SigBit> &a_TouchedBits)
     {
 
         // The cell register control parameter(s) must not be set
         for (const auto &it : a_Register.params.set) {
-            const auto curr = a_Cell->getParam(it.first);
+            const auto &curr = a_Cell->getParam(it.first);
             if (curr == it.second) {
                 log_debug(" the param '%s' is already set to '%s'\n", it.first.c_str(), it.second.decode_string().c_str());
-                return;
+                return false;
             }
         }
 
@@ -1048,7 +1093,7 @@ struct DspFF : public Pass {
 
             flops[port.name] = std::vector<RTLIL::Cell *>(sigbits.size(), nullptr);
             for (size_t i = 0; i < sigbits.size(); ++i) {
-                auto sigbit = m_SigMap(sigbits[i]);
+                auto sigbit = a_Ctx.sigmap(sigbits[i]);
 
                 log_debug("  %2zu. ", i);
 
@@ -1064,36 +1109,29 @@ struct DspFF : public Pass {
                     continue;
                 }
 
+                if (a_Ctx.index.IsModulePort(sigbit)) {
+                    log_debug("connection reaches module edge\n");
+                    flopsOk = false;
+                    continue;
+                }
+
                 pool<CellPin> others;
+                auto addOther = [&](const NetlistIndex::PortBit &pin) { others.insert(CellPin(pin.cell, pin.port, pin.offset)); };
 
                 // Get sinks(s), discard the port completely if more than one sink
                 // is found.
                 if (a_Cell->output(port.name)) {
-                    if (m_ConnMap.sinks.count(sigbit)) {
-                        for (const auto &sink : m_ConnMap.sinks.at(sigbit)) {
-                            if (sink.cell != nullptr && m_CellsToRemove.count(sink.cell)) {
-                                continue;
-                            }
-                            others.insert(sink);
-                        }
-                    }
-
+                    a_Ctx.index.ForEachSink(sigbit, addOther);
                 }
                 // Get driver. Discard if the driver drives something else too
                 else if (a_Cell->input(port.name)) {
-                    if (m_ConnMap.drivers.count(sigbit)) {
-                        auto driver = m_ConnMap.drivers.at(sigbit);
-
-                        if (m_ConnMap.sinks.count(sigbit)) {
-                            auto sinks = m_ConnMap.sinks.at(sigbit);
-                            if (sinks.size() > 1) {
-                                log_debug("multiple sinks (%zu)\n", others.size());
-                                flopsOk = false;
-                                continue;
-                            }
-                        }
+                    a_Ctx.index.ForEachDriver(sigbit, addOther);
 
-                        others.insert(driver);
+                    size_t sinks = a_Ctx.index.SinkCount(sigbit);
+                    if (!others.empty() && sinks > 1) {
+                        log_debug("multiple sinks (%zu)\n", sinks);
+                        flopsOk = false;
+                        continue;
                     }
                 }
 
@@ -1113,28 +1151,20 @@ struct DspFF : public Pass {
                 auto &other = *others.begin();
                 auto *flop = other.cell;
 
-                if (flop == nullptr) {
-                    if (!other.port.empty()) {
-                        log_debug("connection reaches module edge\n");
-                        flopsOk = false;
-                    }
-                    log_debug("unconnected\n");
-                    continue;
-                }
-
-                if (!m_FlopTypes.count(flop->type)) {
+                auto flopTypeIt = m_FlopTypes.find(flop->type);
+                if (flopTypeIt == m_FlopTypes.end()) {
                     log_debug("non-flip-flop connected\n");
                     flopsOk = false;
                     continue;
                 }
 
                 // Check if the connection goes to the data input/output port
-                const auto &flopType = m_FlopTypes.at(flop->type);
+                const auto &flopType = flopTypeIt->second;
                 RTLIL::IdString flopPort;
                 if (a_Cell->output(port.name)) {
-                    flopPort = flopType.ports.at(RTLIL::escape_id("d"));
+                    flopPort = flopType.portD;
                 } else if (a_Cell->input(port.name)) {
-                    flopPort = flopType.ports.at(RTLIL::escape_id("q"));
+                    flopPort = flopType.portQ;
                 }
 
                 if (flopPort != other.port) {
@@ -1144,7 +1174,7 @@ struct DspFF : public Pass {
                 }
 
                 // Check the flip-flop configuration
-                if (!checkFlop(flop)) {
+                if (!checkFlop(flop, flopType)) {
                     flopsOk = false;
                     continue;
                 }
@@ -1160,7 +1190,7 @@ struct DspFF : public Pass {
                 }
 
                 // Store the flop and its data
-                groups.insert(getFlopData(flop, mappedParams));
+                groups.insert(getFlopData(a_Ctx, flop, flopType, mappedParams));
                 flops[port.name][i] = flop;
             }
         }
@@ -1168,26 +1198,26 @@ struct DspFF : public Pass {
         // Cannot integrate for various reasons
         if (!flopsOk) {
             log_debug(" cannot use the DSP register\n");
-            return;
+            return false;
         }
 
         // No matching flip-flop groups
         if (groups.empty()) {
             log_debug(" no matching flip-flops found\n");
-            return;
+            return false;
         }
 
         // Do not allow more than a single group
         if (groups.size() != 1) {
             log_debug(" %zu flip-flop groups, only a single one allowed\n", groups.size());
-            return;
+            return false;
         }
 
         // Validate the flip flop data agains the DSP cell
         const auto &flopData = *groups.begin();
-        if (!checkFlopDataAgainstDspRegister(flopData, a_Cell, a_Register, a_Ports)) {
+        if (!checkFlopDataAgainstDspRegister(a_Ctx, flopData, a_Cell, a_Register, a_Ports)) {
             log_debug(" flip-flops vs. DSP check failed\n");
-            return;
+            return false;
         }
 
         // Log connections
@@ -1232,9 +1262,9 @@ struct DspFF : public Pass {
 
                 RTLIL::IdString flopPort;
                 if (a_Cell->output(port.name)) {
-                    flopPort = flopType.ports.at(RTLIL::escape_id("q"));
+                    flopPort = flopType.portQ;
                 } else if (a_Cell->input(port.name)) {
-                    flopPort = flopType.ports.at(RTLIL::escape_id("d"));
+                    flopPort = flopType.portD;
                 }
 
                 if (!flop->hasPort(flopPort)) {
@@ -1248,7 +1278,14 @@ struct DspFF : public Pass {
                     sigbits[i] = sigspec.bits()[0];
                 }
 
-                m_CellsToRemove.insert(flop);
+                if (a_Ctx.cellsToRemove.insert(flop).second) {
+                    for (const auto &conn : flop->connections()) {
+                        for (const auto &bit : conn.second) {
+                            a_TouchedBits.push_back(a_Ctx.sigmap(bit));
+                        }
+                    }
+                    a_Ctx.index.RemoveCell(flop);
+                }
             }
 
             a_Cell->setPort(port.name, RTLIL::SigSpec(sigbits));
@@ -1268,7 +1305,7 @@ struct DspFF : public Pass {
 
                 log_debug(" connecting %s.%s to %s\n", a_Cell->type.c_str(), port.c_str(), sigBitName(conn).c_str());
                 a_Cell->setPort(port, conn);
-                m_DspChanges[a_Cell].conns.insert(port);
+                a_Ctx.dspChanges[a_Cell].conns.insert(port);
             }
         }
 
@@ -1276,7 +1313,7 @@ struct DspFF : public Pass {
         for (const auto &it : a_Register.connect) {
             log_debug(" connecting %s.%s to %s\n", a_Cell->type.c_str(), it.first.c_str(), it.second.as_string().c_str());
             a_Cell->setPort(it.first, it.second);
-            m_DspChanges[a_Cell].conns.insert(it.first);
+            a_Ctx.dspChanges[a_Cell].conns.insert(it.first);
         }
 
         // Map parameters (register rule)
@@ -1285,7 +1322,7 @@ struct DspFF : public Pass {
                 const auto &param = flopData.params.dsp.at(it.second);
                 log_debug(" setting param '%s' to '%s'\n", it.first.c_str(), param.decode_string().c_str());
                 a_Cell->setParam(it.first, param);
-                m_DspChanges[a_Cell].params.insert(it.first);
+                a_Ctx.dspChanges[a_Cell].params.insert(it.first);
             }
         }
 
@@ -1295,7 +1332,7 @@ struct DspFF : public Pass {
                 const auto &param = flopData.params.dsp.at(it.second);
                 log_debug(" setting param '%s' to '%s'\n", it.first.c_str(), param.decode_string().c_str());
                 a_Cell->setParam(it.first, param);
-                m_DspChanges[a_Cell].params.insert(it.first);
+                a_Ctx.dspChanges[a_Cell].params.insert(it.first);
             }
         }
 
@@ -1303,33 +1340,34 @@ struct DspFF : public Pass {
         for (const auto &it : a_Register.params.set) {
             log_debug(" setting param '%s' to '%s'\n", it.first.c_str(), it.second.decode_string().c_str());
             a_Cell->setParam(it.first, it.second);
-            m_DspChanges[a_Cell].params.insert(it.first);
+            a_Ctx.dspChanges[a_Cell].params.insert(it.first);
         }
 
         // Set parameters (flip-flop rule)
         for (const auto &it : flopType.params.set) {
             log_debug(" setting param '%s' to '%s'\n", it.first.c_str(), it.second.decode_string().c_str());
             a_Cell->setParam(it.first, it.second);
-            m_DspChanges[a_Cell].params.insert(it.first);
+            a_Ctx.dspChanges[a_Cell].params.insert(it.first);
         }
+
+        return true;
     }
 
     // ..........................................
 
     /// Collects flip-flop connectivity data and parameters which defines the
     /// group it belongs to.
-    FlopData getFlopData(RTLIL::Cell *a_Cell, const dict<RTLIL::IdString, RTLIL::Const> &a_ExtraParams)
+    FlopData getFlopData(ModuleContext &a_Ctx, RTLIL::Cell *a_Cell, const FlopType &a_FlopType,
+                         const dict<RTLIL::IdString, RTLIL::Const> &a_ExtraParams)
     {
         FlopData data(a_Cell->type);
-
-        log_assert(m_FlopTypes.count(a_Cell->type) != 0);
-        const auto &flopType = m_FlopTypes.at(a_Cell->type);
+        const auto &flopType = a_FlopType;
 
         // Gather connections to control ports
         for (const auto &it : flopType.ports) {
 
             // Skip "D" and "Q" as they connection will always differ.
-            if (it.first == RTLIL::escape_id("d") || it.first == RTLIL::escape_id("q")) {
+            if (it.first == ID(d) || it.first == ID(q)) {
                 continue;
             }
 
@@ -1338,7 +1376,7 @@ struct DspFF : public Pass {
                 auto sigbits = sigspec.bits();
                 log_assert(sigbits.size() <= 1);
                 if (!sigbits.empty()) {
-                    data.conns[it.first] = m_SigMap(sigbits[0]);
+                    data.conns[it.first] = a_Ctx.sigmap(sigbits[0]);
                 }
             }
         }
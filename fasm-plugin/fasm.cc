@@ -27,10 +27,101 @@
 #include "kernel/log.h"
 #include "kernel/register.h"
 #include "kernel/rtlil.h"
+#include <functional>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
+// FASM lines are collected in a buffer which is written out in large chunks
+class FasmStream
+{
+  public:
+    explicit FasmStream(std::ostream &os) : os_(os) { buffer_.reserve(kFlushSize); }
+    ~FasmStream() { Flush(); }
+
+    FasmStream &operator<<(const std::string &str)
+    {
+        buffer_ += str;
+        MaybeFlush();
+        return *this;
+    }
+
+    FasmStream &operator<<(const char *str)
+    {
+        buffer_ += str;
+        MaybeFlush();
+        return *this;
+    }
+
+    FasmStream &operator<<(int value) { return *this << std::to_string(value); }
+
+    void Flush()
+    {
+        os_.write(buffer_.data(), buffer_.size());
+        buffer_.clear();
+    }
+
+  private:
+    static constexpr size_t kFlushSize = 1 << 16;
+
+    void MaybeFlush()
+    {
+        if (buffer_.size() >= kFlushSize) {
+            Flush();
+        }
+    }
+
+    std::ostream &os_;
+    std::string buffer_;
+};
+
+// State shared by the feature emitters of a single write_fasm call
+struct FasmContext {
+    std::string pass_name;
+    std::string part_json;
+    const BankTilesMap *bank_tiles = nullptr;
+
+    // The part JSON is only read if any of the cells needs it
+    const BankTilesMap &BankTiles()
+    {
+        if (bank_tiles == nullptr) {
+            bank_tiles = &get_bank_tiles(part_json);
+        }
+        return *bank_tiles;
+    }
+};
+
+// Emits the FASM features of a cell annotated with the FASM_EXTRA parameter
+using FasmFeatureEmitter = std::function<void(RTLIL::Cell *cell, FasmContext &context, FasmStream &fasm)>;
+
+// Generate a fasm feature associated with the INTERNAL_VREF value per bank
+// e.g. VREF value of 0.675 for bank 34 is associated with tile HCLK_IOI3_X113Y26
+// hence we need to emit the following fasm feature: HCLK_IOI3_X113Y26.VREF.V_675_MV
+static void emit_internal_vref(RTLIL::Cell *cell, FasmContext &context, FasmStream &fasm)
+{
+    const auto &bank_tiles = context.BankTiles();
+    if (bank_tiles.size() == 0) {
+        log_cmd_error("%s: No bank tiles available on the target part.\n", context.pass_name.c_str());
+    }
+    int bank_number(cell->getParam(ID(NUMBER)).as_int());
+    auto bank_tile = bank_tiles.find(bank_number);
+    if (bank_tile == bank_tiles.end()) {
+        log_cmd_error("%s: No IO bank number %d on the target part.\n", context.pass_name.c_str(), bank_number);
+    }
+    int bank_vref(cell->getParam(ID(INTERNAL_VREF)).as_int());
+    fasm << "HCLK_IOI3_" << bank_tile->second << ".VREF.V_" << bank_vref << "_MV\n";
+}
+
+// Feature emitters by the value of the FASM_EXTRA parameter. New kinds of
+// annotated cells are supported by adding an entry here.
+static const dict<std::string, FasmFeatureEmitter> &fasm_feature_emitters()
+{
+    static const dict<std::string, FasmFeatureEmitter> emitters = {
+      {"INTERNAL_VREF", emit_internal_vref},
+    };
+    return emitters;
+}
+
 struct WriteFasm : public Backend {
     WriteFasm() : Backend("fasm", "Write out FASM features") {}
 
@@ -40,7 +131,9 @@ struct WriteFasm : public Backend {
         log("\n");
         log("    write_fasm -part_json <part_json_filename> <filename>\n");
         log("\n");
-        log("Write out a file with vref FASM features.\n");
+        log("Write out a file with the FASM features of the cells annotated with the\n");
+        log("FASM_EXTRA parameter, e.g. the INTERNAL_VREF features of the IO banks.\n");
+        log("The part JSON is only required if the design has such cells.\n");
         log("\n");
     }
 
@@ -62,23 +155,17 @@ struct WriteFasm : public Backend {
         if (top_module == nullptr) {
             log_cmd_error("%s: No top module detected.\n", pass_name.c_str());
         }
-        auto bank_tiles = get_bank_tiles(part_json);
-        // Generate a fasm feature associated with the INTERNAL_VREF value per bank
-        // e.g. VREF value of 0.675 for bank 34 is associated with tile HCLK_IOI3_X113Y26
-        // hence we need to emit the following fasm feature: HCLK_IOI3_X113Y26.VREF.V_675_MV
+        FasmContext context{pass_name, part_json};
+        FasmStream fasm(*f);
+        const auto &emitters = fasm_feature_emitters();
         for (auto cell : top_module->cells()) {
-            if (!cell->hasParam(ID(FASM_EXTRA)))
+            auto fasm_extra = cell->parameters.find(ID(FASM_EXTRA));
+            if (fasm_extra == cell->parameters.end()) {
                 continue;
-            if (cell->getParam(ID(FASM_EXTRA)) == RTLIL::Const("INTERNAL_VREF")) {
-                if (bank_tiles.size() == 0) {
-                    log_cmd_error("%s: No bank tiles available on the target part.\n", pass_name.c_str());
-                }
-                int bank_number(cell->getParam(ID(NUMBER)).as_int());
-                if (bank_tiles.count(bank_number) == 0) {
-                    log_cmd_error("%s: No IO bank number %d on the target part.\n", pass_name.c_str(), bank_number);
-                }
-                int bank_vref(cell->getParam(ID(INTERNAL_VREF)).as_int());
-                *f << "HCLK_IOI3_" << bank_tiles[bank_number] << ".VREF.V_" << bank_vref << "_MV\n";
+            }
+            auto emitter = emitters.find(fasm_extra->second.decode_string());
+            if (emitter != emitters.end()) {
+                emitter->second(cell, context, fasm);
             }
         }
     }
@@ -17,46 +17,33 @@
  *
  */
 
+#include "../common/netlist_index.h"
 #include "kernel/register.h"
 #include "kernel/rtlil.h"
-#include "kernel/sigtools.h"
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-/// A structure representing a pin
-struct Pin {
-    RTLIL::Cell *cell;    /// Cell pointer
-    RTLIL::IdString port; /// Cell port name
-    int bit;              /// Port bit index
-
-    Pin(RTLIL::Cell *_cell, const RTLIL::IdString &_port, int _bit = 0) : cell(_cell), port(_port), bit(_bit) {}
-
-    Pin(const Pin &ref) = default;
-
-    unsigned int hash() const
-    {
-        if (cell == nullptr) {
-            return mkhash_add(port.hash(), bit);
-        } else {
-            return mkhash_add(mkhash(cell->hash(), port.hash()), bit);
-        }
-    };
+/// An input port of a cell type with an embedded inverter
+struct InvertiblePort {
+    RTLIL::IdString port;  /// Cell port name
+    RTLIL::IdString param; /// Name of the parameter controlling the inversion
 };
 
-bool operator==(const Pin &lhs, const Pin &rhs) { return (lhs.cell == rhs.cell) && (lhs.port == rhs.port) && (lhs.bit == rhs.bit); }
+/// An invertible pin connected to an inverter
+struct InvertiblePin {
+    RTLIL::Cell *cell; /// Cell pointer
+    int port;          /// Index of the port among the invertible ports of the cell type
+    int bit;           /// Port bit index
+};
 
 struct IntegrateInv : public Pass {
 
-    /// Temporary SigBit to SigBit helper map.
-    SigMap m_SigMap;
-    /// Map of SigBit objects to inverter cells.
-    dict<RTLIL::SigBit, RTLIL::Cell *> m_InvMap;
-    /// Map of inverter cells that can potentially be integrated and invertable
-    /// pins that they are connected to
-    dict<RTLIL::Cell *, pool<Pin>> m_Inverters;
-    /// Map of invertable pins and names of parameters controlling inversions
-    dict<Pin, RTLIL::IdString> m_InvParams;
+    /// Invertible ports of cell types, kept for the whole pass
+    dict<RTLIL::IdString, std::vector<InvertiblePort>> m_InvertiblePorts;
+    /// Inverters of the processed module that can be integrated and the
+    /// invertible pins they drive
+    std::vector<std::pair<RTLIL::Cell *, std::vector<InvertiblePin>>> m_Inverters;
 
     IntegrateInv()
         : Pass("integrateinv", "Integrates inverters ($_NOT_ cells) into ports "
@@ -86,254 +73,158 @@ struct IntegrateInv : public Pass {
         // Process modules
         for (auto module : a_Design->selected_modules()) {
 
-            // Setup the SigMap
-            m_SigMap.clear();
-            m_SigMap.set(module);
-
-            m_Inverters.clear();
-            m_InvParams.clear();
-
-            // Setup inverter map
-            buildInverterMap(module);
-
             // Identify inverters that can be integrated and assign them with
-            // lists of cells and ports to integrate with
-            for (auto cell : module->selected_cells()) {
-                collectInverters(cell);
-            }
+            // lists of cells and ports to integrate with. All of them are
+            // collected before the netlist is modified.
+            NetlistIndex index(module);
+            collectInverters(module, index);
 
             // Integrate inverters
             integrateInverters();
         }
 
         // Clear maps
-        m_SigMap.clear();
-
-        m_InvMap.clear();
+        m_InvertiblePorts.clear();
         m_Inverters.clear();
-        m_InvParams.clear();
     }
 
-    void buildInverterMap(RTLIL::Module *a_Module)
+    const std::vector<InvertiblePort> &getInvertiblePorts(RTLIL::Design *a_Design, const RTLIL::IdString &a_Type)
     {
-        m_InvMap.clear();
-
-        for (auto cell : a_Module->cells()) {
-
-            // Skip non-inverters
-            if (cell->type != RTLIL::escape_id("$_NOT_")) {
-                continue;
-            }
-
-            // Get output connection
-            auto sigspec = cell->getPort(RTLIL::escape_id("Y"));
-            auto sigbit = m_SigMap(sigspec.bits().at(0));
-
-            // Store
-            log_assert(m_InvMap.count(sigbit) == 0);
-            m_InvMap[sigbit] = cell;
+        auto it = m_InvertiblePorts.find(a_Type);
+        if (it != m_InvertiblePorts.end()) {
+            return it->second;
         }
-    }
-
-    void collectInverters(RTLIL::Cell *a_Cell)
-    {
-        auto module = a_Cell->module;
-        auto design = module->design;
 
-        for (auto conn : a_Cell->connections()) {
-            auto port = conn.first;
-            auto sigspec = conn.second;
-
-            // Consider only inputs.
-            if (!a_Cell->input(port)) {
-                continue;
-            }
+        std::vector<InvertiblePort> ports;
 
-            // Get the cell module
-            auto cellModule = design->module(a_Cell->type);
-            if (!cellModule) {
-                continue;
-            }
+        // Get the cell module
+        auto cellModule = a_Design->module(a_Type);
+        if (cellModule) {
+            for (auto wire : cellModule->wires()) {
 
-            // Get wire.
-            auto wire = cellModule->wire(port);
-            if (!wire) {
-                continue;
-            }
-
-            // Check if the pin has an embedded inverter.
-            auto it = wire->attributes.find(ID::invertible_pin);
-            if (it == wire->attributes.end()) {
-                continue;
-            }
-
-            // Decode the parameter name.
-            RTLIL::IdString paramName = RTLIL::escape_id(it->second.decode_string());
-
-            // Look for connected inverters
-            auto sigbits = sigspec.bits();
-            for (size_t bit = 0; bit < sigbits.size(); ++bit) {
-
-                auto sigbit = sigbits[bit];
-                if (!sigbit.wire) {
+                // Consider only inputs.
+                if (!wire->port_input) {
                     continue;
                 }
 
-                sigbit = m_SigMap(sigbit);
-
-                // Get the inverter if any
-                if (!m_InvMap.count(sigbit)) {
+                // Check if the pin has an embedded inverter.
+                auto attr = wire->attributes.find(ID::invertible_pin);
+                if (attr == wire->attributes.end()) {
                     continue;
                 }
-                auto inv = m_InvMap.at(sigbit);
-
-                // Save the inverter pin and the parameter name
-                auto pin = Pin(a_Cell, port, bit);
-
-                auto &list = m_Inverters[inv];
-                list.insert(pin);
 
-                log_assert(m_InvParams.count(pin) == 0);
-                m_InvParams[pin] = paramName;
+                // Decode the parameter name.
+                ports.push_back({wire->name, RTLIL::escape_id(attr->second.decode_string())});
             }
         }
+
+        return m_InvertiblePorts[a_Type] = std::move(ports);
     }
 
-    void integrateInverters()
+    void collectInverters(RTLIL::Module *a_Module, const NetlistIndex &a_Index)
     {
+        m_Inverters.clear();
 
-        for (auto it : m_Inverters) {
-            auto inv = it.first;
-            auto pins = it.second;
-
-            // List all sinks of the inverter
-            auto sinks = getSinksForDriver(Pin(inv, RTLIL::escape_id("Y")));
-
-            // If the inverter drives only invertable pins then integrate it
-            if (sinks == pins) {
-                log("Integrating inverter %s into:\n", log_id(inv->name));
-
-                // Integrate into each pin
-                for (auto pin : pins) {
-                    log_assert(pin.cell != nullptr);
-                    log(" %s.%s[%d]\n", log_id(pin.cell->name), log_id(pin.port), pin.bit);
-
-                    // Change the connection
-                    auto sigspec = pin.cell->getPort(pin.port);
-                    auto sigbits = sigspec.bits();
-
-                    log_assert((size_t)pin.bit < sigbits.size());
-                    sigbits[pin.bit] = RTLIL::SigBit(inv->getPort(RTLIL::escape_id("A"))[0]);
-                    pin.cell->setPort(pin.port, RTLIL::SigSpec(sigbits));
+        for (auto cell : a_Module->cells()) {
 
-                    // Get the control parameter
-                    log_assert(m_InvParams.count(pin) != 0);
-                    auto paramName = m_InvParams[pin];
+            // Skip non-inverters
+            if (cell->type != RTLIL::escape_id("$_NOT_")) {
+                continue;
+            }
 
-                    RTLIL::Const invMask;
-                    auto param = pin.cell->parameters.find(paramName);
-                    if (param == pin.cell->parameters.end()) {
-                        invMask = RTLIL::Const(0, sigspec.size());
-                    } else {
-                        invMask = RTLIL::Const(param->second);
-                    }
+            // Inverters driving top-level ports can't be integrated
+            auto sigbit = cell->getPort(RTLIL::escape_id("Y")).bits().at(0);
+            if (a_Index.IsModulePort(sigbit)) {
+                continue;
+            }
 
-                    // Check width.
-                    if (invMask.size() != sigspec.size()) {
-                        log_error("The inversion parameter needs to be the same width as "
-                                  "the port (%s port %s parameter %s)",
-                                  log_id(pin.cell->name), log_id(pin.port), log_id(paramName));
-                    }
+            // The inverter can be integrated only if all of its sinks are
+            // invertible pins of selected cells
+            std::vector<InvertiblePin> pins;
+            bool integrable = true;
+            a_Index.ForEachSink(sigbit, [&](const NetlistIndex::PortBit &sink) {
+                if (!integrable) {
+                    return;
+                }
+                if (!a_Module->selected(sink.cell)) {
+                    integrable = false;
+                    return;
+                }
 
-                    // Toggle bit in the control parameter bitmask
-                    if (invMask[pin.bit] == RTLIL::State::S0) {
-                        invMask[pin.bit] = RTLIL::State::S1;
-                    } else if (invMask[pin.bit] == RTLIL::State::S1) {
-                        invMask[pin.bit] = RTLIL::State::S0;
-                    } else {
-                        log_error("The inversion parameter must contain only 0s and 1s (%s "
-                                  "parameter %s)\n",
-                                  log_id(pin.cell->name), log_id(paramName));
+                const auto &ports = getInvertiblePorts(a_Module->design, sink.cell->type);
+                for (size_t port = 0; port < ports.size(); ++port) {
+                    if (ports[port].port == sink.port) {
+                        pins.push_back({sink.cell, int(port), sink.offset});
+                        return;
                     }
-
-                    // Set the parameter back
-                    pin.cell->setParam(paramName, invMask);
                 }
+                integrable = false;
+            });
 
-                // Remove the inverter
-                inv->module->remove(inv);
+            if (integrable && !pins.empty()) {
+                m_Inverters.emplace_back(cell, std::move(pins));
             }
         }
     }
 
-    pool<Pin> getSinksForDriver(const Pin &a_Driver)
+    void integrateInverters()
     {
-        auto module = a_Driver.cell->module;
-        pool<Pin> sinks;
-
-        // The driver has to be an output pin
-        if (!a_Driver.cell->output(a_Driver.port)) {
-            return sinks;
-        }
-
-        // Get the driver sigbit
-        auto driverSigspec = a_Driver.cell->getPort(a_Driver.port);
-        auto driverSigbit = m_SigMap(driverSigspec.bits().at(a_Driver.bit));
+        for (auto &inverter : m_Inverters) {
+            auto invCell = inverter.first;
+            auto &pins = inverter.second;
 
-        // Look for connected sinks
-        for (auto cell : module->cells()) {
-            for (auto conn : cell->connections()) {
-                auto port = conn.first;
-                auto sigspec = conn.second;
+            log("Integrating inverter %s into:\n", log_id(invCell->name));
 
-                // Consider only sinks (inputs)
-                if (!cell->input(port)) {
-                    continue;
-                }
+            // Integrate into each pin
+            for (auto &pin : pins) {
+                auto cell = pin.cell;
+                auto &invPort = m_InvertiblePorts.at(cell->type).at(pin.port);
+                log(" %s.%s[%d]\n", log_id(cell->name), log_id(invPort.port), pin.bit);
 
-                // Check all sigbits
+                // Change the connection
+                auto sigspec = cell->getPort(invPort.port);
                 auto sigbits = sigspec.bits();
-                for (size_t bit = 0; bit < sigbits.size(); ++bit) {
 
-                    auto sigbit = sigbits[bit];
-                    if (!sigbit.wire) {
-                        continue;
-                    }
+                log_assert((size_t)pin.bit < sigbits.size());
+                sigbits[pin.bit] = RTLIL::SigBit(invCell->getPort(RTLIL::escape_id("A"))[0]);
+                cell->setPort(invPort.port, RTLIL::SigSpec(sigbits));
 
-                    // Got a sink pin of another cell
-                    sigbit = m_SigMap(sigbit);
-                    if (sigbit == driverSigbit) {
-                        sinks.insert(Pin(cell, port, bit));
-                    }
-                }
-            }
-        }
-
-        // Look for connected top-level output ports
-        for (auto conn : module->connections()) {
-            auto dst = conn.first;
-            auto src = conn.second;
+                // Get the control parameter
+                auto &paramName = invPort.param;
 
-            auto sigbits = dst.bits();
-            for (size_t bit = 0; bit < sigbits.size(); ++bit) {
-
-                auto sigbit = sigbits[bit];
-                if (!sigbit.wire) {
-                    continue;
+                RTLIL::Const invMask;
+                auto param = cell->parameters.find(paramName);
+                if (param == cell->parameters.end()) {
+                    invMask = RTLIL::Const(0, sigspec.size());
+                } else {
+                    invMask = RTLIL::Const(param->second);
                 }
 
-                if (!sigbit.wire->port_output) {
-                    continue;
+                // Check width.
+                if (invMask.size() != sigspec.size()) {
+                    log_error("The inversion parameter needs to be the same width as "
+                              "the port (%s port %s parameter %s)",
+                              log_id(cell->name), log_id(invPort.port), log_id(paramName));
                 }
 
-                sigbit = m_SigMap(sigbit);
-                if (sigbit == driverSigbit) {
-                    sinks.insert(Pin(nullptr, sigbit.wire->name, bit));
+                // Toggle bit in the control parameter bitmask
+                if (invMask[pin.bit] == RTLIL::State::S0) {
+                    invMask[pin.bit] = RTLIL::State::S1;
+                } else if (invMask[pin.bit] == RTLIL::State::S1) {
+                    invMask[pin.bit] = RTLIL::State::S0;
+                } else {
+                    log_error("The inversion parameter must contain only 0s and 1s (%s "
+                              "parameter %s)\n",
+                              log_id(cell->name), log_id(paramName));
                 }
+
+                // Set the parameter back
+                cell->setParam(paramName, invMask);
             }
-        }
 
-        return sinks;
+            // Remove the inverter
+            invCell->module->remove(invCell);
+        }
     }
 
 } IntegrateInv;
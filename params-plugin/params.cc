@@ -15,23 +15,39 @@
  *
  * SPDX-License-Identifier: Apache-2.0
  */
+#include "../common/tcl_commands.h"
 #include "kernel/log.h"
 #include "kernel/register.h"
 #include "kernel/rtlil.h"
+#include <algorithm>
+#include <thread>
 
 USING_YOSYS_NAMESPACE
 
 PRIVATE_NAMESPACE_BEGIN
 
-void register_in_tcl_interpreter(const std::string &command)
+// Parameter value in the form returned to Tcl
+std::string param_value_string(const RTLIL::Const &value)
 {
-    Tcl_Interp *interp = yosys_get_tcl_interp();
-    std::string tcl_script = stringf("proc %s args { return [yosys %s {*}$args] }", command.c_str(), command.c_str());
-    Tcl_Eval(interp, tcl_script.c_str());
+    if (value.flags & RTLIL::CONST_FLAG_STRING) {
+        return value.decode_string();
+    }
+    return std::to_string(value.as_int());
 }
 
 struct GetParam : public Pass {
-    GetParam() : Pass("getparam", "get parameter on object") { register_in_tcl_interpreter(pass_name); }
+    // Cells scanned by a single worker thread at least
+    static constexpr size_t kMinCellsPerWorker = 4096;
+
+    // Values of the requested parameters found on a cell
+    struct CellParams {
+        RTLIL::Module *module;
+        RTLIL::Cell *cell;
+        // Index of the parameter name and its value
+        std::vector<std::pair<size_t, std::string>> values;
+    };
+
+    GetParam() : Pass("getparam", "get parameter on object") { tcl_commands::register_command(this); }
 
     void help() override
     {
@@ -41,6 +57,12 @@ struct GetParam : public Pass {
         log("\n");
         log("Get the given parameter on the selected object. \n");
         log("\n");
+        log("   getparam -dict names selection\n");
+        log("\n");
+        log("Get all the parameters from the Tcl list of names on the selected objects\n");
+        log("in one pass. Returns a Tcl dict of module/cell names to dicts of the names\n");
+        log("of the parameters found on the cell and their values.\n");
+        log("\n");
     }
 
     void execute(std::vector<std::string> args, RTLIL::Design *design) override
@@ -48,6 +70,14 @@ struct GetParam : public Pass {
         if (args.size() == 1) {
             log_error("Incorrect number of arguments");
         }
+        if (args.at(1) == "-dict") {
+            if (args.size() < 3) {
+                log_error("Incorrect number of arguments");
+            }
+            extra_args(args, 3, design);
+            GetParamDict(split_tokens(args.at(2)), design);
+            return;
+        }
         extra_args(args, 2, design);
 
         auto param = RTLIL::IdString(RTLIL::escape_id(args.at(1)));
@@ -56,16 +86,9 @@ struct GetParam : public Pass {
 
         for (auto module : design->selected_modules()) {
             for (auto cell : module->selected_cells()) {
-                auto params = cell->parameters;
-                auto it = params.find(param);
-                if (it != params.end()) {
-                    std::string value;
-                    auto param_obj = it->second;
-                    if (param_obj.flags & RTLIL::CONST_FLAG_STRING) {
-                        value = param_obj.decode_string();
-                    } else {
-                        value = std::to_string(param_obj.as_int());
-                    }
+                auto it = cell->parameters.find(param);
+                if (it != cell->parameters.end()) {
+                    std::string value = param_value_string(it->second);
                     Tcl_Obj *value_obj = Tcl_NewStringObj(value.c_str(), value.size());
                     Tcl_ListObjAppendElement(interp, tcl_list, value_obj);
                 }
@@ -74,6 +97,71 @@ struct GetParam : public Pass {
         Tcl_SetObjResult(interp, tcl_list);
     }
 
+    void GetParamDict(const std::vector<std::string> &names, RTLIL::Design *design)
+    {
+        std::vector<RTLIL::IdString> params;
+        for (auto &name : names) {
+            params.push_back(RTLIL::escape_id(name));
+        }
+        std::vector<CellParams> cells;
+        for (auto module : design->selected_modules()) {
+            for (auto cell : module->selected_cells()) {
+                cells.push_back(CellParams{module, cell, {}});
+            }
+        }
+
+        // Look up and decode the values on worker threads. Each cell is
+        // only accessed by the worker owning its chunk and the threads don't
+        // create IdStrings or Tcl objects.
+        auto scan = [&params, &cells](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++) {
+                const auto &parameters = cells[i].cell->parameters;
+                for (size_t param = 0; param < params.size(); param++) {
+                    auto it = parameters.find(params[param]);
+                    if (it != parameters.end()) {
+                        cells[i].values.emplace_back(param, param_value_string(it->second));
+                    }
+                }
+            }
+        };
+        size_t workers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), cells.size() / kMinCellsPerWorker);
+        if (workers > 1) {
+            std::vector<std::thread> threads;
+            size_t chunk = (cells.size() + workers - 1) / workers;
+            for (size_t begin = 0; begin < cells.size(); begin += chunk) {
+                threads.emplace_back(scan, begin, std::min(begin + chunk, cells.size()));
+            }
+            for (auto &thread : threads) {
+                thread.join();
+            }
+        } else {
+            scan(0, cells.size());
+        }
+
+        Tcl_Interp *interp = yosys_get_tcl_interp();
+        std::vector<Tcl_Obj *> param_keys;
+        for (auto &name : names) {
+            param_keys.push_back(Tcl_NewStringObj(name.c_str(), name.size()));
+            Tcl_IncrRefCount(param_keys.back());
+        }
+        Tcl_Obj *tcl_dict = Tcl_NewDictObj();
+        for (auto &cell : cells) {
+            if (cell.values.empty()) {
+                continue;
+            }
+            Tcl_Obj *cell_dict = Tcl_NewDictObj();
+            for (auto &value : cell.values) {
+                Tcl_DictObjPut(interp, cell_dict, param_keys[value.first], Tcl_NewStringObj(value.second.c_str(), value.second.size()));
+            }
+            std::string cell_name = RTLIL::unescape_id(cell.module->name) + "/" + RTLIL::unescape_id(cell.cell->name);
+            Tcl_DictObjPut(interp, tcl_dict, Tcl_NewStringObj(cell_name.c_str(), cell_name.size()), cell_dict);
+        }
+        for (auto key : param_keys) {
+            Tcl_DecrRefCount(key);
+        }
+        Tcl_SetObjResult(interp, tcl_dict);
+    }
+
 } GetParam;
 
 PRIVATE_NAMESPACE_END
@@ -33,6 +33,19 @@ if {$phase == $reference_phase} {
 } else {
 	puts $fp "FAIL: $phase != $reference_phase"
 }
+
+# Get several parameters of both instances at once
+set params [getparam -dict {CLKOUT2_PHASE CLKFBOUT_MULT} top/PLLE2_ADV_0 top/PLLE2_ADV]
+set reference_params [list 70 12 90000 12]
+set params_list [list \
+	[dict get $params top/PLLE2_ADV_0 CLKOUT2_PHASE] [dict get $params top/PLLE2_ADV_0 CLKFBOUT_MULT] \
+	[dict get $params top/PLLE2_ADV CLKOUT2_PHASE] [dict get $params top/PLLE2_ADV CLKFBOUT_MULT]]
+puts -nonewline $fp "Parameter dict: "
+if {$params_list == $reference_params} {
+	puts $fp "PASS"
+} else {
+	puts $fp "FAIL: $params_list != $reference_params"
+}
 close $fp
 
 # Start flow after library reading
@@ -0,0 +1,67 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright 2020-2022 F4PGA Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# SPDX-License-Identifier: Apache-2.0
+"""
+
+This script generates synthetic designs with many IOs for the ql-iob plugin
+benchmarks. The design of a benchmark is written to <prefix>.v, its pin
+constraints to <prefix>.pcf and a matching pin map to <prefix>.csv.
+"""
+
+import argparse
+
+
+def many_ios(size):
+    """ Registered inputs and outputs, every port constrained to its own pin """
+    lines = [
+        "module top(input wire clk, input wire [{0}:0] in, output reg [{0}:0] out);".format(size - 1),
+        "  always @(posedge clk) out <= in;",
+        "endmodule",
+    ]
+    ports = ["clk"] + ["in[{}]".format(i) for i in range(size)] + ["out[{}]".format(i) for i in range(size)]
+    constraints = ["set_io {} P{}".format(port, i) for i, port in enumerate(ports)]
+    pins = ["name,x,y,z,type"]
+    for i in range(len(ports)):
+        pins.append("P{},{},{},0,{}".format(i, 2 * (i % 64), i // 64, "CLOCK" if i == 0 else "BIDIR"))
+    return lines, constraints, pins
+
+
+BENCHMARKS = {
+    "many_ios": (many_ios, 2000),
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("benchmark", choices=sorted(BENCHMARKS.keys()), help="Benchmark to generate")
+    parser.add_argument("prefix", help="Prefix of the written files")
+    parser.add_argument("--size", type=int, help="Size of the design (default depends on the benchmark)")
+    args = parser.parse_args()
+
+    generator, default_size = BENCHMARKS[args.benchmark]
+    lines, constraints, pins = generator(args.size or default_size)
+    with open(args.prefix + ".v", "w") as fp:
+        fp.write("\n".join(lines) + "\n")
+    with open(args.prefix + ".pcf", "w") as fp:
+        fp.write("\n".join(constraints) + "\n")
+    with open(args.prefix + ".csv", "w") as fp:
+        fp.write("\n".join(pins) + "\n")
+
+
+if __name__ == "__main__":
+    main()
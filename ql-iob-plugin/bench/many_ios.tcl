@@ -0,0 +1,19 @@
+yosys -import
+if { [info procs quicklogic_iob] == {} } { plugin -i ql-iob }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(BENCH_DESIGN).v
+
+# Generic synthesis
+synth -lut 4 -flatten -auto-top
+
+# Techmap
+read_verilog -lib ../tests/common/pp3_cells_sim.v
+techmap -map ../tests/common/pp3_cells_map.v
+
+# Insert QuickLogic specific IOBs and clock buffers
+clkbufmap -buf $_BUF_ Y:A -inpad ckpad Q:P
+iopadmap -bits -outpad outpad A:P -inpad inpad Q:P -tinoutpad bipad EN:Q:A:P A:top
+opt_clean
+
+bench_pass quicklogic_iob $::env(BENCH_DESIGN).pcf $::env(BENCH_DESIGN).csv
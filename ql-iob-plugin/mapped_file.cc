@@ -0,0 +1,91 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#include "mapped_file.hh"
+
+#ifdef _WIN32
+#include <fstream>
+#include <sstream>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+// ============================================================================
+
+MappedFile::~MappedFile() { close(); }
+
+void MappedFile::close()
+{
+#ifndef _WIN32
+    if (m_Mapped) {
+        munmap(const_cast<char *>(m_Data), m_Size);
+    }
+#endif
+    m_Data = nullptr;
+    m_Size = 0;
+    m_Buffer.clear();
+    m_Mapped = false;
+}
+
+bool MappedFile::open(const std::string &a_FileName)
+{
+    close();
+
+#ifdef _WIN32
+    std::ifstream file(a_FileName.c_str(), std::ios::binary);
+    if (!file.good()) {
+        return false;
+    }
+
+    std::stringstream ss;
+    ss << file.rdbuf();
+    m_Buffer = ss.str();
+    m_Data = m_Buffer.data();
+    m_Size = m_Buffer.size();
+#else
+    int fd = ::open(a_FileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0) {
+        ::close(fd);
+        return false;
+    }
+
+    // Empty files can't be mapped
+    m_Size = fileStat.st_size;
+    if (m_Size != 0) {
+        void *data = mmap(nullptr, m_Size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            ::close(fd);
+            m_Size = 0;
+            return false;
+        }
+        m_Data = static_cast<const char *>(data);
+        m_Mapped = true;
+    }
+
+    ::close(fd);
+#endif
+
+    return true;
+}
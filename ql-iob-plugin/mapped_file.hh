@@ -0,0 +1,100 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ *
+ */
+#ifndef MAPPED_FILE_HH
+#define MAPPED_FILE_HH
+
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include <sys/stat.h>
+#include <sys/types.h>
+
+// ============================================================================
+
+/// A read-only file mapped into memory. Views into the data stay valid for
+/// the lifetime of the instance.
+class MappedFile {
+public:
+
+    /// Constructor
+    MappedFile () = default;
+    /// Destructor, unmaps the file
+    ~MappedFile ();
+
+    MappedFile (const MappedFile&) = delete;
+    MappedFile& operator= (const MappedFile&) = delete;
+
+    /// Maps the file. Returns false in case of error
+    bool open (const std::string& a_FileName);
+
+    /// Returns the file contents
+    std::string_view getData () const { return std::string_view(m_Data, m_Size); }
+
+private:
+
+    /// Releases the mapping
+    void close ();
+
+    /// The mapped data
+    const char* m_Data = nullptr;
+    /// Size of the data
+    size_t m_Size = 0;
+    /// The data read into memory where mapping is not available
+    std::string m_Buffer;
+    /// True if m_Data points to a mapping
+    bool m_Mapped = false;
+};
+
+// ============================================================================
+
+/// Parses a file with T::parse(). The result is kept for the session and
+/// returned again until the modification time or the size of the file
+/// changes. Returns nullptr in case of error.
+template <typename T> std::shared_ptr<const T> loadCached (const std::string& a_FileName) {
+
+    struct CacheEntry {
+        time_t mtime;
+        off_t  size;
+        std::shared_ptr<const T> parser;
+    };
+    static std::map<std::string, CacheEntry> cache;
+
+    struct stat fileStat;
+    if (stat(a_FileName.c_str(), &fileStat) != 0) {
+        return nullptr;
+    }
+
+    auto it = cache.find(a_FileName);
+    if (it != cache.end() && it->second.mtime == fileStat.st_mtime && it->second.size == fileStat.st_size) {
+        return it->second.parser;
+    }
+
+    auto parser = std::make_shared<T>();
+    if (!parser->parse(a_FileName)) {
+        cache.erase(a_FileName);
+        return nullptr;
+    }
+
+    cache[a_FileName] = CacheEntry{fileStat.st_mtime, fileStat.st_size, parser};
+    return parser;
+}
+
+#endif // MAPPED_FILE_HH
@@ -18,28 +18,39 @@
  */
 #include "pcf_parser.hh"
 
-#include <regex>
-
 // ============================================================================
 
-bool PcfParser::parse(const std::string &a_FileName)
-{
-
-    // Open the file
-    std::ifstream file(a_FileName.c_str());
+static bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f'; }
 
-    // Parse it
-    return parse(file);
+static void skipSpaces(std::string_view &a_Str)
+{
+    size_t i = 0;
+    while (i < a_Str.size() && isSpace(a_Str[i])) {
+        ++i;
+    }
+    a_Str.remove_prefix(i);
 }
 
-const std::vector<PcfParser::Constraint> PcfParser::getConstraints() const { return m_Constraints; }
+// Returns the leading token of characters other than spaces and '#'
+static std::string_view getToken(std::string_view &a_Str)
+{
+    size_t i = 0;
+    while (i < a_Str.size() && !isSpace(a_Str[i]) && a_Str[i] != '#') {
+        ++i;
+    }
+    auto token = a_Str.substr(0, i);
+    a_Str.remove_prefix(i);
+    return token;
+}
 
 // ============================================================================
 
-bool PcfParser::parse(std::ifstream &a_Stream)
+bool PcfParser::parse(const std::string &a_FileName)
 {
-
-    if (!a_Stream.good()) {
+    // Map the file
+    m_File.reset(new MappedFile());
+    if (!m_File->open(a_FileName)) {
+        m_File.reset();
         return false;
     }
 
@@ -47,18 +58,60 @@ bool PcfParser::parse(std::ifstream &a_Stream)
     m_Constraints.clear();
 
     // Parse PCF lines
-    std::regex re("^\\s*set_io\\s+([^#\\s]+)\\s+([^#\\s]+)(?:\\s+#(.*))?");
+    std::string_view data = m_File->getData();
+    while (!data.empty()) {
+        size_t end = data.find('\n');
+        std::string_view line = data.substr(0, end);
+        data.remove_prefix(end == std::string_view::npos ? data.size() : end + 1);
+
+        Constraint constraint;
+        if (parseLine(line, constraint)) {
+            m_Constraints.push_back(constraint);
+        }
+    }
+
+    return true;
+}
+
+const std::vector<PcfParser::Constraint> &PcfParser::getConstraints() const { return m_Constraints; }
+
+// ============================================================================
 
-    while (a_Stream.good()) {
-        std::string line;
-        std::getline(a_Stream, line);
+bool PcfParser::parseLine(std::string_view a_Line, Constraint &a_Constraint)
+{
+    // set_io <net> <pad> [# <comment>]
+    skipSpaces(a_Line);
+    if (getToken(a_Line) != "set_io" || a_Line.empty() || !isSpace(a_Line[0])) {
+        return false;
+    }
 
-        // Match against regex
-        std::cmatch cm;
-        if (std::regex_match(line.c_str(), cm, re)) {
-            m_Constraints.push_back(Constraint(cm[1].str(), cm[2].str(), cm[3].str()));
+    skipSpaces(a_Line);
+    auto netName = getToken(a_Line);
+    if (netName.empty() || a_Line.empty() || !isSpace(a_Line[0])) {
+        return false;
+    }
+
+    skipSpaces(a_Line);
+    auto padName = getToken(a_Line);
+    if (padName.empty()) {
+        return false;
+    }
+
+    // The comment has to be separated from the pad name
+    std::string_view comment;
+    if (!a_Line.empty()) {
+        if (!isSpace(a_Line[0])) {
+            return false;
+        }
+        skipSpaces(a_Line);
+        if (!a_Line.empty()) {
+            if (a_Line[0] != '#') {
+                return false;
+            }
+            comment = a_Line.substr(1);
         }
     }
 
+    a_Constraint = Constraint(netName, padName, comment);
     return true;
 }
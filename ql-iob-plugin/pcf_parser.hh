@@ -19,8 +19,11 @@
 #ifndef PCF_PARSER_HH
 #define PCF_PARSER_HH
 
-#include <fstream>
+#include "mapped_file.hh"
+
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 // ============================================================================
@@ -28,19 +31,19 @@
 class PcfParser {
 public:
 
-    /// A constraint
+    /// A constraint. The strings refer to the data of the parsed file.
     struct Constraint {
 
-        const std::string netName;
-        const std::string padName;
-        const std::string comment;
+        std::string_view netName;
+        std::string_view padName;
+        std::string_view comment;
 
         Constraint () = default;
 
         Constraint (
-            const std::string& a_NetName,
-            const std::string& a_PadName,
-            const std::string& a_Comment = std::string()
+            std::string_view a_NetName,
+            std::string_view a_PadName,
+            std::string_view a_Comment = std::string_view()
         ) : netName(a_NetName), padName(a_PadName), comment(a_Comment) {}
     };
 
@@ -50,13 +53,17 @@ public:
     /// Parses a PCF file and stores constraint within the class instance.
     /// Returns false in case of error
     bool parse (const std::string& a_FileName);
-    bool parse (std::ifstream& a_Stream);
 
     /// Returns the constraint list
-    const std::vector<Constraint> getConstraints () const;
+    const std::vector<Constraint>& getConstraints () const;
 
 private:
 
+    /// Parses a single line, returns false if it isn't a constraint
+    static bool parseLine (std::string_view a_Line, Constraint& a_Constraint);
+
+    /// The parsed file
+    std::unique_ptr<MappedFile> m_File;
     /// A list of constraints
     std::vector<Constraint> m_Constraints;
 };
@@ -18,105 +18,76 @@
  */
 #include "pinmap_parser.hh"
 
-#include <sstream>
-
 // ============================================================================
 
-bool PinmapParser::parse(const std::string &a_FileName)
+// Returns the next line without the line terminator
+static std::string_view getLine(std::string_view &a_Data)
 {
+    size_t end = a_Data.find('\n');
+    std::string_view line = a_Data.substr(0, end);
+    a_Data.remove_prefix(end == std::string_view::npos ? a_Data.size() : end + 1);
 
-    // Open the file
-    std::ifstream file(a_FileName.c_str());
-
-    // Parse it
-    return parse(file);
+    if (!line.empty() && line.back() == '\r') {
+        line.remove_suffix(1);
+    }
+    return line;
 }
 
-const std::vector<PinmapParser::Entry> PinmapParser::getEntries() const { return m_Entries; }
-
 // ============================================================================
 
-std::vector<std::string> PinmapParser::getFields(const std::string &a_String)
+void PinmapParser::getFields(std::string_view a_Line)
 {
-
-    std::vector<std::string> fields;
-    std::stringstream ss(a_String);
-
-    while (ss.good()) {
-        std::string field;
-        std::getline(ss, field, ',');
-
-        fields.push_back(field);
-    }
-
-    return fields;
-}
-
-bool PinmapParser::parseHeader(std::ifstream &a_Stream)
-{
-
-    // Get the header line
-    std::string header;
-    std::getline(a_Stream, header);
-
-    // Parse fields
-    m_Fields = getFields(header);
-    if (m_Fields.empty()) {
-        return false;
+    while (true) {
+        size_t end = a_Line.find(',');
+        m_Data.push_back(a_Line.substr(0, end));
+        if (end == std::string_view::npos) {
+            break;
+        }
+        a_Line.remove_prefix(end + 1);
     }
-
-    return true;
 }
 
-bool PinmapParser::parseData(std::ifstream &a_Stream)
+int PinmapParser::getColumn(std::string_view a_Name) const
 {
-
-    // Parse lines as they come
-    while (a_Stream.good()) {
-        std::string line;
-        std::getline(a_Stream, line);
-
-        if (line.empty()) {
-            continue;
+    for (size_t i = 0; i < m_Fields.size(); ++i) {
+        if (m_Fields[i] == a_Name) {
+            return i;
         }
-
-        // Parse datafields
-        auto data = getFields(line);
-
-        // Assign data fields to columns
-        Entry entry;
-        for (size_t i = 0; i < data.size(); ++i) {
-
-            if (i >= m_Fields.size()) {
-                return false;
-            }
-
-            entry[m_Fields[i]] = data[i];
-        }
-
-        m_Entries.push_back(entry);
     }
-
-    return true;
+    return -1;
 }
 
-bool PinmapParser::parse(std::ifstream &a_Stream)
+bool PinmapParser::parse(const std::string &a_FileName)
 {
-
-    if (!a_Stream.good()) {
+    // Map the file
+    m_File.reset(new MappedFile());
+    if (!m_File->open(a_FileName)) {
+        m_File.reset();
         return false;
     }
 
     // Clear pinmap entries
-    m_Entries.clear();
+    m_Fields.clear();
+    m_Data.clear();
+    m_Entries.assign(1, 0);
 
     // Parse header
-    if (!parseHeader(a_Stream)) {
-        return false;
-    }
+    std::string_view data = m_File->getData();
+    getFields(getLine(data));
+    m_Fields.swap(m_Data);
+
     // Parse data fields
-    if (!parseData(a_Stream)) {
-        return false;
+    while (!data.empty()) {
+        auto line = getLine(data);
+        if (line.empty()) {
+            continue;
+        }
+
+        getFields(line);
+        if (m_Data.size() - m_Entries.back() > m_Fields.size()) {
+            return false;
+        }
+        m_Entries.push_back(m_Data.size());
     }
 
     return true;
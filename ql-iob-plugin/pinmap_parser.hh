@@ -19,44 +19,55 @@
 #ifndef PINMAP_PARSER_HH
 #define PINMAP_PARSER_HH
 
-#include <fstream>
+#include "mapped_file.hh"
+
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
-#include <map>
 
 // ============================================================================
 
 class PinmapParser {
 public:
 
-    /// A pinmap entry type
-    typedef std::map<std::string, std::string> Entry;
-
     /// Constructor
     PinmapParser () = default;
 
     /// Parses a pinmap CSV file
     bool parse (const std::string& a_FileName);
-    bool parse (std::ifstream& a_Stream);
 
-    /// Returns a vector of entries
-    const std::vector<Entry> getEntries() const;
+    /// Returns the index of the column with the given name or -1
+    int getColumn (std::string_view a_Name) const;
 
-private:
+    /// Returns the number of entries
+    size_t getEntryCount () const { return m_Entries.size() - 1; }
 
-    /// Splits the input string into a vector of fields. Fields are comma
-    /// separated.
-    static std::vector<std::string> getFields (const std::string& a_String);
+    /// Returns true if the entry has a field in the given column
+    bool hasField (size_t a_Entry, int a_Column) const {
+        return a_Column >= 0 && m_Entries[a_Entry] + a_Column < m_Entries[a_Entry + 1];
+    }
+
+    /// Returns a field of an entry, refers to the data of the parsed file
+    std::string_view getField (size_t a_Entry, int a_Column) const {
+        return hasField(a_Entry, a_Column) ? m_Data[m_Entries[a_Entry] + a_Column] : std::string_view();
+    }
+
+private:
 
-    /// Parses the header
-    bool parseHeader (std::ifstream& a_Stream);
-    /// Parses the data
-    bool parseData   (std::ifstream& a_Stream);
+    /// Splits the line into fields and appends them to the data. Fields are
+    /// comma separated.
+    void getFields (std::string_view a_Line);
 
+    /// The parsed file
+    std::unique_ptr<MappedFile> m_File;
     /// Header fields
-    std::vector<std::string> m_Fields;
-    /// A list of entries
-    std::vector<Entry> m_Entries;
+    std::vector<std::string_view> m_Fields;
+    /// Fields of all entries
+    std::vector<std::string_view> m_Data;
+    /// Offsets of the first field of each entry in m_Data, followed by the
+    /// size of m_Data
+    std::vector<size_t> m_Entries = {0};
 };
 
 #endif // PINMAP_PARSER_HH
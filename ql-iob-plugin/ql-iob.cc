@@ -25,6 +25,7 @@
 
 #include <regex>
 #include <sstream>
+#include <unordered_set>
 
 #ifndef YS_OVERRIDE
 #define YS_OVERRIDE override
@@ -46,6 +47,12 @@ struct QuicklogicIob : public Pass {
         }
     };
 
+    /// Location and IO cell type of a pad
+    struct PadSite {
+        std::string loc;
+        std::string type;
+    };
+
     QuicklogicIob() : Pass("quicklogic_iob", "Map IO buffers to cells that correspond to their assigned locations") {}
 
     void help() YS_OVERRIDE
@@ -143,39 +150,91 @@ struct QuicklogicIob : public Pass {
 
         // Read and parse the PCF file
         log("Loading PCF from '%s'...\n", a_Args[1].c_str());
-        auto pcfParser = PcfParser();
-        if (!pcfParser.parse(a_Args[1])) {
+        auto pcfParser = loadCached<PcfParser>(a_Args[1]);
+        if (!pcfParser) {
             log_cmd_error("Failed to parse the PCF file!\n");
         }
 
-        // Build a map of net names to constraints
-        std::unordered_map<std::string, const PcfParser::Constraint> constraintMap;
-        for (auto &constraint : pcfParser.getConstraints()) {
-            if (constraintMap.count(constraint.netName) != 0) {
-                log_cmd_error("The net '%s' is constrained twice!", constraint.netName.c_str());
-            }
-            constraintMap.emplace(constraint.netName, constraint);
-        }
-
         // Read and parse pinmap CSV file
         log("Loading pinmap CSV from '%s'...\n", a_Args[2].c_str());
-        auto pinmapParser = PinmapParser();
-        if (!pinmapParser.parse(a_Args[2])) {
+        auto pinmapParser = loadCached<PinmapParser>(a_Args[2]);
+        if (!pinmapParser) {
             log_cmd_error("Failed to parse the pinmap CSV file!\n");
         }
 
-        // Build a map of pad names to entries
-        std::unordered_map<std::string, std::vector<PinmapParser::Entry>> pinmapMap;
-        for (auto &entry : pinmapParser.getEntries()) {
-            if (entry.count("name") != 0) {
-                auto &name = entry.at("name");
+        // Build a map of pad names to pinmap entries
+        const PinmapParser &pinmap = *pinmapParser;
+        int nameColumn = pinmap.getColumn("name");
+        int xColumn = pinmap.getColumn("x");
+        int yColumn = pinmap.getColumn("y");
+        int typeColumn = pinmap.getColumn("type");
+
+        std::unordered_map<std::string_view, std::vector<size_t>> pinmapMap;
+        for (size_t entry = 0; entry < pinmap.getEntryCount(); ++entry) {
+            if (pinmap.hasField(entry, nameColumn)) {
+                pinmapMap[pinmap.getField(entry, nameColumn)].push_back(entry);
+            }
+        }
+
+        // Resolve the site of each pad for each IO cell type
+        std::unordered_map<std::string, std::unordered_map<std::string_view, PadSite>> padSites;
+        for (auto &it : ioCellTypes) {
+            auto &sites = padSites[it.first];
+            for (auto &pad : pinmapMap) {
+                size_t entry = choosePinmapEntry(pinmap, typeColumn, pad.second, it.second);
 
-                if (pinmapMap.count(name) == 0) {
-                    pinmapMap[name] = std::vector<PinmapParser::Entry>();
+                PadSite site;
+                if (pinmap.hasField(entry, xColumn) && pinmap.hasField(entry, yColumn)) {
+                    site.loc = "X" + std::string(pinmap.getField(entry, xColumn)) + "Y" + std::string(pinmap.getField(entry, yColumn));
+                }
+                if (pinmap.hasField(entry, typeColumn)) {
+                    site.type = pinmap.getField(entry, typeColumn);
                 }
+                sites.emplace(pad.first, site);
+            }
+        }
 
-                pinmapMap[name].push_back(entry);
+        // Resolve the net names of the constraints to top-level wires and
+        // their bits. A net name is either a name of a wire, which constrains
+        // all of its bits, or a name of a wire followed by a bit index in
+        // square brackets or parentheses.
+        const auto &constraints = pcfParser->getConstraints();
+        std::unordered_set<std::string> netNames;
+        dict<RTLIL::Wire *, int> wireConstraints;
+        dict<RTLIL::SigBit, int> bitConstraints;
+        for (size_t i = 0; i < constraints.size(); ++i) {
+            std::string netName(constraints[i].netName);
+            if (!netNames.insert(netName).second) {
+                log_cmd_error("The net '%s' is constrained twice!", netName.c_str());
             }
+
+            auto wire = topModule->wire(RTLIL::escape_id(netName));
+            if (wire != nullptr) {
+                wireConstraints[wire] = i;
+            }
+
+            std::string baseName;
+            int index;
+            bool brackets;
+            if (!splitIndexedName(netName, baseName, index, brackets)) {
+                continue;
+            }
+            wire = topModule->wire(RTLIL::escape_id(baseName));
+            if (wire == nullptr || index >= wire->width) {
+                continue;
+            }
+
+            // Square brackets take precedence over parentheses
+            RTLIL::SigBit bit(wire, index);
+            if (brackets || bitConstraints.count(bit) == 0) {
+                bitConstraints[bit] = i;
+            }
+        }
+
+        // Map of IO cell types
+        dict<RTLIL::IdString, const IoCellType *> ioCells;
+        for (auto &it : ioCellTypes) {
+            ioCells[RTLIL::escape_id(it.first)] = &it.second;
         }
 
         // Check all IO cells
@@ -184,14 +243,15 @@ struct QuicklogicIob : public Pass {
         log("  type       | net        | pad        | loc      | type     | instance\n");
         log(" ------------+------------+------------+----------+----------+-----------\n");
         for (auto cell : topModule->cells()) {
-            auto ysCellType = RTLIL::unescape_id(cell->type);
 
             // Not an IO cell
-            if (ioCellTypes.count(ysCellType) == 0) {
+            auto ioCell = ioCells.find(cell->type);
+            if (ioCell == ioCells.end()) {
                 continue;
             }
+            const auto &ioCellType = *ioCell->second;
 
-            log("  %-10s ", ysCellType.c_str());
+            log("  %-10s ", ioCellType.type.c_str());
 
             std::string netName;
             std::string padName;
@@ -199,57 +259,46 @@ struct QuicklogicIob : public Pass {
             std::string cellType;
 
             // Get connections to the specified port
-            const auto &ioCellType = ioCellTypes.at(ysCellType);
-            const std::string port = RTLIL::escape_id(ioCellType.port);
-            if (cell->connections().count(port)) {
-
-                // Get the sigspec of the connection
-                auto sigspec = cell->connections().at(port);
+            auto conn = cell->connections().find(RTLIL::escape_id(ioCellType.port));
+            if (conn != cell->connections().end()) {
 
                 // Get the connected wire
-                for (auto sigbit : sigspec.bits()) {
-                    if (sigbit.wire != nullptr) {
-                        auto wire = sigbit.wire;
-
-                        // Has to be top level wire
-                        if (wire->port_input || wire->port_output) {
-
-                            // Check if the wire is constrained. Get pad name.
-                            std::string baseName = RTLIL::unescape_id(wire->name);
-                            std::string netNames[] = {
-                              baseName,
-                              stringf("%s[%d]", baseName.c_str(), sigbit.offset),
-                              stringf("%s(%d)", baseName.c_str(), sigbit.offset),
-                            };
-
-                            padName = "";
-                            netName = "";
-
-                            for (auto &name : netNames) {
-                                if (constraintMap.count(name)) {
-                                    auto constraint = constraintMap.at(name);
-                                    padName = constraint.padName;
-                                    netName = name;
-                                    break;
-                                }
-                            }
-
-                            // Check if there is an entry in the pinmap for this pad name
-                            if (pinmapMap.count(padName)) {
-
-                                // Choose a correct entry for the cell
-                                auto entry = choosePinmapEntry(pinmapMap.at(padName), ioCellType);
-
-                                // Location string
-                                if (entry.count("x") && entry.count("y")) {
-                                    locName = stringf("X%sY%s", entry.at("x").c_str(), entry.at("y").c_str());
-                                }
-
-                                // Cell type
-                                if (entry.count("type")) {
-                                    cellType = entry.at("type");
-                                }
-                            }
+                for (auto sigbit : conn->second) {
+
+                    // Has to be top level wire
+                    if (sigbit.wire == nullptr || !(sigbit.wire->port_input || sigbit.wire->port_output)) {
+                        continue;
+                    }
+
+                    // Check if the wire is constrained. Get pad name.
+                    padName = "";
+                    netName = "";
+
+                    int constraint = -1;
+                    auto wireConstraint = wireConstraints.find(sigbit.wire);
+                    if (wireConstraint != wireConstraints.end()) {
+                        constraint = wireConstraint->second;
+                    } else {
+                        auto bitConstraint = bitConstraints.find(sigbit);
+                        if (bitConstraint != bitConstraints.end()) {
+                            constraint = bitConstraint->second;
+                        }
+                    }
+                    if (constraint < 0) {
+                        continue;
+                    }
+                    padName = std::string(constraints[constraint].padName);
+                    netName = std::string(constraints[constraint].netName);
+
+                    // Check if there is an entry in the pinmap for this pad name
+                    auto &sites = padSites.at(ioCellType.type);
+                    auto site = sites.find(padName);
+                    if (site != sites.end()) {
+                        if (!site->second.loc.empty()) {
+                            locName = site->second.loc;
+                        }
+                        if (!site->second.type.empty()) {
+                            cellType = site->second.type;
                         }
                     }
                 }
@@ -264,7 +313,39 @@ struct QuicklogicIob : public Pass {
         }
     }
 
-    PinmapParser::Entry choosePinmapEntry(const std::vector<PinmapParser::Entry> &a_Entries, const IoCellType &a_IoCellType)
+    /// Splits a net name in the form of "name[index]" or "name(index)",
+    /// returns false for other names
+    static bool splitIndexedName(const std::string &a_Name, std::string &a_BaseName, int &a_Index, bool &a_Brackets)
+    {
+        if (a_Name.size() < 4) {
+            return false;
+        }
+
+        char close = a_Name.back();
+        if (close != ']' && close != ')') {
+            return false;
+        }
+        char open = (close == ']') ? '[' : '(';
+
+        size_t pos = a_Name.rfind(open);
+        if (pos == std::string::npos || pos == 0 || pos + 2 >= a_Name.size()) {
+            return false;
+        }
+
+        a_Index = 0;
+        for (size_t i = pos + 1; i < a_Name.size() - 1; ++i) {
+            if (!isdigit((unsigned char)a_Name[i]) || a_Index > 100000000) {
+                return false;
+            }
+            a_Index = a_Index * 10 + (a_Name[i] - '0');
+        }
+
+        a_BaseName = a_Name.substr(0, pos);
+        a_Brackets = (close == ']');
+        return true;
+    }
+
+    size_t choosePinmapEntry(const PinmapParser &a_Pinmap, int a_TypeColumn, const std::vector<size_t> &a_Entries, const IoCellType &a_IoCellType)
     {
         // No preferred types, pick the first one
         if (a_IoCellType.preferredTypes.empty()) {
@@ -275,8 +356,8 @@ struct QuicklogicIob : public Pass {
         for (auto &type : a_IoCellType.preferredTypes) {
 
             // Find an entry for that type. If found then return it.
-            for (auto &entry : a_Entries) {
-                if (type == entry.at("type")) {
+            for (auto entry : a_Entries) {
+                if (a_Pinmap.hasField(entry, a_TypeColumn) && type == a_Pinmap.getField(entry, a_TypeColumn)) {
                     return entry;
                 }
             }
@@ -0,0 +1,92 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright 2020-2022 F4PGA Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# SPDX-License-Identifier: Apache-2.0
+"""
+
+This script collects profiles written by `synth_quicklogic -profile` for
+every benchmark into a single results file and compares them against a
+baseline.
+The return code is non-zero if any metric regressed by more than the
+given threshold.
+"""
+
+import argparse
+import json
+import os
+import sys
+
+METRICS = ["wall_time", "peak_rss", "cells"]
+
+
+def summarize(profile):
+    """ Reduces the profile of a single run to the compared metrics """
+    labels = profile["labels"]
+    return {
+        "family": profile["family"],
+        "wall_time": sum(label["wall_time"] for label in labels),
+        "peak_rss": max([label["peak_rss"] for label in labels] or [0]),
+        "cells": labels[-1]["cells_after"] if labels else 0,
+        "labels": {label["label"]: label["wall_time"] for label in labels},
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--baseline", help="Baseline results file")
+    parser.add_argument("--threshold", type=float, default=20.0, help="Allowed regression in percent")
+    parser.add_argument("--output", required=True, help="Results file to write")
+    parser.add_argument("profiles", nargs="+", help="Profile files, named <benchmark>.json")
+    args = parser.parse_args()
+
+    results = {}
+    for profile_file in args.profiles:
+        with open(profile_file) as fp:
+            results[os.path.splitext(os.path.basename(profile_file))[0]] = summarize(json.load(fp))
+    with open(args.output, "w") as fp:
+        json.dump(results, fp, indent=2, sort_keys=True)
+
+    print("{:<20} {:<12} {:>12} {:>14} {:>12}".format("benchmark", "family", "wall [s]", "peak rss [KiB]", "cells"))
+    for name, result in sorted(results.items()):
+        print("{:<20} {:<12} {:>12.3f} {:>14} {:>12}".format(name, result["family"], result["wall_time"], result["peak_rss"], result["cells"]))
+
+    if not args.baseline or not os.path.exists(args.baseline):
+        print("No baseline found, skipping comparison")
+        return 0
+
+    with open(args.baseline) as fp:
+        baseline = json.load(fp)
+
+    failed = False
+    for name, result in sorted(results.items()):
+        if name not in baseline:
+            continue
+        for metric in METRICS:
+            reference = baseline[name][metric]
+            limit = reference * (1 + args.threshold / 100)
+            if reference > 0 and result[metric] > limit:
+                print("{}: {} regressed from {} to {} (threshold {}%)".format(name, metric, reference, result[metric], args.threshold))
+                failed = True
+        for label, wall_time in sorted(result["labels"].items()):
+            reference = baseline[name]["labels"].get(label, 0)
+            if wall_time > reference * (1 + args.threshold / 100) and reference > 0:
+                print("{}: label {} slowed down from {:.3f}s to {:.3f}s".format(name, label, reference, wall_time))
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
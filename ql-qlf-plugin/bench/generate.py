@@ -0,0 +1,83 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright 2020-2022 F4PGA Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# SPDX-License-Identifier: Apache-2.0
+"""
+
+This script generates synthetic designs with many DSP and BRAM cells for the
+ql-qlf plugin benchmarks. The design of a benchmark is written to <prefix>.v.
+"""
+
+import argparse
+
+
+def dsp_array(size):
+    """ Independent registered multipliers of mixed widths """
+    widths = [(20, 18), (16, 16), (10, 9), (8, 8)]
+    lines = ["module top(input clk, input [19:0] a, input [17:0] b, output [{}:0] z);".format(38 * size - 1)]
+    for i in range(size):
+        a_width, b_width = widths[i % len(widths)]
+        lines += [
+            "  reg [{}:0] p{};".format(a_width + b_width - 1, i),
+            "  always @(posedge clk) p{} <= a[{}:0] * (b[{}:0] ^ {});".format(i, a_width - 1, b_width - 1, (i + 1) % (1 << b_width)),
+            "  assign z[{}:{}] = p{};".format(38 * i + a_width + b_width - 1, 38 * i, i),
+        ]
+    lines.append("endmodule")
+    return lines
+
+
+def bram_array(size):
+    """ Independent simple dual port memories """
+    lines = [
+        "module top(input clk, input [9:0] waddr, input [9:0] raddr, input [35:0] wdata, input [{0}:0] we, output [{1}:0] rdata);".format(
+            size - 1, 36 * size - 1
+        )
+    ]
+    for i in range(size):
+        lines += [
+            "  reg [35:0] mem{}[0:1023];".format(i),
+            "  reg [35:0] q{};".format(i),
+            "  always @(posedge clk) begin",
+            "    if (we[{0}]) mem{0}[waddr] <= wdata;".format(i),
+            "    q{0} <= mem{0}[raddr];".format(i),
+            "  end",
+            "  assign rdata[{}:{}] = q{};".format(36 * i + 35, 36 * i, i),
+        ]
+    lines.append("endmodule")
+    return lines
+
+
+BENCHMARKS = {
+    "dsp_array": (dsp_array, 200),
+    "bram_array": (bram_array, 100),
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("benchmark", choices=sorted(BENCHMARKS.keys()), help="Benchmark to generate")
+    parser.add_argument("prefix", help="Prefix of the written files")
+    parser.add_argument("--size", type=int, help="Size of the design (default depends on the benchmark)")
+    args = parser.parse_args()
+
+    generator, default_size = BENCHMARKS[args.benchmark]
+    with open(args.prefix + ".v", "w") as fp:
+        fp.write("\n".join(generator(args.size or default_size)) + "\n")
+
+
+if __name__ == "__main__":
+    main()
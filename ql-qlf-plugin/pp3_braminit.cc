@@ -19,26 +19,143 @@
 
 #include "kernel/sigtools.h"
 #include "kernel/yosys.h"
-#include <bitset>
+#include <memory>
 #include <stdio.h>
 #include <stdlib.h>
 
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
+// Words of a memory initialization file with their addresses, in the order
+// they appear in the file
+struct InitFile {
+    std::vector<std::pair<long, uint32_t>> words;
+};
+
+static void parse_init_file(InitFile &init, const char *data, size_t size)
+{
+    bool in_comment = false;
+    long cursor = 0;
+    size_t i = 0;
+
+    while (i < size) {
+        if (in_comment) {
+            if (data[i] == '*' && i + 1 < size && data[i + 1] == '/') {
+                in_comment = false;
+                i += 2;
+            } else
+                i++;
+            continue;
+        }
+        if (data[i] == '/' && i + 1 < size && data[i + 1] == '*') {
+            in_comment = true;
+            i += 2;
+            continue;
+        }
+        if (data[i] == ' ' || data[i] == '\t' || data[i] == '\r' || data[i] == '\n') {
+            i++;
+            continue;
+        }
+        if (data[i] == '/' && i + 1 < size && data[i + 1] == '/') {
+            while (i < size && data[i] != '\n')
+                i++;
+            continue;
+        }
+
+        size_t start = i;
+        while (i < size && data[i] != ' ' && data[i] != '\t' && data[i] != '\r' && data[i] != '\n') {
+            if (data[i] == '/' && i + 1 < size && data[i + 1] == '*')
+                break;
+            i++;
+        }
+
+        std::string token(data + start, i - start);
+        bool set_cursor = token[0] == '@';
+        const char *nptr = token.c_str() + (set_cursor ? 1 : 0);
+        char *endptr;
+        long value = strtol(nptr, &endptr, 16);
+        if (!*nptr || *endptr) {
+            log("Can not parse %s `%s` for %s.\n", set_cursor ? "address" : "value", nptr, token.c_str());
+            continue;
+        }
+
+        if (set_cursor)
+            cursor = value;
+        else
+            init.words.emplace_back(cursor++, value);
+    }
+}
+
+// Reads a memory initialization file. The contents are cached by path and
+// reused until the modification time or the size of the file changes, so
+// RAMs initialized from the same file only parse it once. Returns nullptr if
+// the file can't be read.
+static std::shared_ptr<const InitFile> load_init_file(const std::string &path)
+{
+    struct CacheEntry {
+        time_t mtime;
+        off_t size;
+        std::shared_ptr<const InitFile> init;
+    };
+    static std::map<std::string, CacheEntry> cache;
+
+    struct stat file_stat;
+    if (stat(path.c_str(), &file_stat) != 0)
+        return nullptr;
+
+    auto it = cache.find(path);
+    if (it != cache.end() && it->second.mtime == file_stat.st_mtime && it->second.size == file_stat.st_size)
+        return it->second.init;
+
+    auto init = std::make_shared<InitFile>();
+#ifdef _WIN32
+    std::ifstream f(path.c_str(), std::ios::binary);
+    if (f.fail())
+        return nullptr;
+    std::stringstream ss;
+    ss << f.rdbuf();
+    std::string data = ss.str();
+    parse_init_file(*init, data.data(), data.size());
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return nullptr;
+    size_t size = file_stat.st_size;
+    if (size != 0) {
+        void *data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (data == MAP_FAILED) {
+            close(fd);
+            return nullptr;
+        }
+        parse_init_file(*init, static_cast<const char *>(data), size);
+        munmap(data, size);
+    }
+    close(fd);
+#endif
+
+    cache[path] = CacheEntry{file_stat.st_mtime, file_stat.st_size, init};
+    return init;
+}
+
 static void run_pp3_braminit(Module *module)
 {
     for (auto cell : module->selected_cells()) {
-        uint32_t mem[2048];
         int32_t ramDataWidth = 32;
         int32_t ramDataDepth = 512;
 
-        log("cell type %s\n", RTLIL::id2cstr(cell->name));
+        log_debug("cell type %s\n", RTLIL::id2cstr(cell->name));
 
         /* Only consider cells we're interested in */
         if (cell->type != ID(RAM_16K_BLK) && cell->type != ID(RAM_8K_BLK))
             continue;
-        log("found ram block\n");
+        log_debug("found ram block\n");
         if (!cell->hasParam(ID(INIT_FILE)))
             continue;
         std::string init_file = cell->getParam(ID(INIT_FILE)).decode_string();
@@ -51,67 +168,6 @@ static void run_pp3_braminit(Module *module)
         ramDataWidth = cell->getParam(ID(data_width_int)).as_int();
         ramDataDepth = cell->getParam(ID(data_depth_int)).as_int();
 
-        std::ifstream f;
-        f.open(init_file.c_str());
-        if (f.fail()) {
-            log("Can not open file `%s`.\n", init_file.c_str());
-            continue;
-        }
-
-        /* Defaults to 0 */
-        memset(mem, 0x00, sizeof(mem));
-
-        /* Process each line */
-        bool in_comment = false;
-        int cursor = 0;
-
-        while (!f.eof()) {
-            std::string line, token;
-            std::getline(f, line);
-
-            for (int i = 0; i < GetSize(line); i++) {
-                if (in_comment && line.compare(i, 2, "*/") == 0) {
-                    line[i] = ' ';
-                    line[i + 1] = ' ';
-                    in_comment = false;
-                    continue;
-                }
-                if (!in_comment && line.compare(i, 2, "/*") == 0)
-                    in_comment = true;
-                if (in_comment)
-                    line[i] = ' ';
-            }
-
-            while (1) {
-                bool set_cursor = false;
-                long value;
-
-                token = next_token(line, " \t\r\n");
-                if (token.empty() || token.compare(0, 2, "//") == 0)
-                    break;
-
-                if (token[0] == '@') {
-                    token = token.substr(1);
-                    set_cursor = true;
-                }
-
-                const char *nptr = token.c_str();
-                char *endptr;
-                value = strtol(nptr, &endptr, 16);
-                if (!*nptr || *endptr) {
-                    log("Can not parse %s `%s` for %s.\n", set_cursor ? "address" : "value", nptr, token.c_str());
-                    continue;
-                }
-
-                if (set_cursor)
-                    cursor = value;
-                else if (cursor >= 0 && cursor < ramDataDepth)
-                    mem[cursor++] = value;
-                else
-                    log("Attempt to initialize non existent address %d\n", cursor);
-            }
-        }
-
         // TODO: Support RAM initialization for other widths than 8, 16 and 32
         if (ramDataWidth != 8 && ramDataWidth != 16 && ramDataWidth != 32) {
             log("WARNING: The RAM cell '%s' has data width of %d. Initialization of this width from a file is not supported yet!\n",
@@ -119,17 +175,26 @@ static void run_pp3_braminit(Module *module)
             continue;
         }
 
-        /* Set attributes */
-        std::string val = "";
-        for (int i = ramDataDepth - 1; i >= 0; i--) {
-            if (ramDataWidth == 8)
-                val += std::bitset<8>(mem[i]).to_string();
-            else if (ramDataWidth == 16)
-                val += std::bitset<16>(mem[i]).to_string();
-            else if (ramDataWidth == 32)
-                val += std::bitset<32>(mem[i]).to_string();
+        auto init = load_init_file(init_file);
+        if (!init) {
+            log("Can not open file `%s`.\n", init_file.c_str());
+            continue;
         }
-        cell->setParam(RTLIL::escape_id("INIT"), RTLIL::Const::from_string(val));
+
+        /* Defaults to 0 */
+        std::vector<uint32_t> mem(std::max(ramDataDepth, 0));
+        for (auto &word : init->words) {
+            if (word.first >= 0 && word.first < ramDataDepth)
+                mem[word.first] = word.second;
+            else
+                log("Attempt to initialize non existent address %ld\n", word.first);
+        }
+
+        /* Set attributes */
+        std::vector<RTLIL::State> bits(mem.size() * ramDataWidth);
+        for (size_t i = 0; i < bits.size(); i++)
+            bits[i] = (mem[i / ramDataWidth] >> (i % ramDataWidth)) & 1 ? RTLIL::State::S1 : RTLIL::State::S0;
+        cell->setParam(RTLIL::escape_id("INIT"), RTLIL::Const(bits));
     }
 }
 
@@ -4,10 +4,9 @@
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-#include "pmgen/ql-bram-asymmetric-wider-read.h"
-#include "pmgen/ql-bram-asymmetric-wider-write.h"
+#include "pmgen/ql-bram-asymmetric.h"
 
-void test_ql_bram_asymmetric_wider_read(ql_bram_asymmetric_wider_read_pm &pm)
+void test_ql_bram_asymmetric_wider_read(ql_bram_asymmetric_pm &pm)
 {
     auto mem = pm.st_ql_bram_asymmetric_wider_read.mem;
     auto mem_wr_addr = pm.st_ql_bram_asymmetric_wider_read.mem_wr_addr;
@@ -76,25 +75,13 @@ void test_ql_bram_asymmetric_wider_read(ql_bram_asymmetric_wider_read_pm &pm)
     if ((wr_en_and_a_w != wr_addr_cw) & (wr_en_and_b_w != wr_addr_cw))
         log_error("This is not the $and cell we are looking for\n");
 
-    // Compare and assign wires
-    RTLIL::Wire *wr_en_w = nullptr;
-    RTLIL::Wire *wr_addr_w = nullptr;
-    RTLIL::Wire *wr_data_w = nullptr;
-    RTLIL::Wire *rd_addr_w = nullptr;
-    RTLIL::Wire *rd_data_w = nullptr;
-
-    for (auto wire : pm.module->wires_) {
-        if (wire.second == wr_en_cw)
-            wr_en_w = wire.second;
-        if (wire.second == wr_addr_cw)
-            wr_addr_w = wire.second;
-        if (wire.second == wr_data_cw)
-            wr_data_w = wire.second;
-        if (wire.second == rd_data_cw)
-            rd_data_w = wire.second;
-        if (wire.second == rd_addr_cw)
-            rd_addr_w = wire.second;
-    }
+    // The wires come from ports of cells in this module, no need to look
+    // them up among the module wires
+    RTLIL::Wire *wr_en_w = wr_en_cw;
+    RTLIL::Wire *wr_addr_w = wr_addr_cw;
+    RTLIL::Wire *wr_data_w = wr_data_cw;
+    RTLIL::Wire *rd_addr_w = rd_addr_cw;
+    RTLIL::Wire *rd_data_w = rd_data_cw;
 
     if (!wr_en_w | !wr_addr_w | !wr_data_w | !rd_data_w | !rd_addr_w)
         log_error("Match between RAM input wires and memory cell ports not found\n");
@@ -159,15 +146,16 @@ void test_ql_bram_asymmetric_wider_read(ql_bram_asymmetric_wider_read_pm &pm)
     // Bypass shift on write address line
     cell->setPort(RTLIL::escape_id("WR_EN"), RTLIL::SigSpec(wr_en_w));
 
-    // Cleanup the module from unused cells
-    pm.module->remove(mem);
-    pm.module->remove(mux);
-    pm.module->remove(wr_en_shift);
-    pm.module->remove(wr_en_and);
-    pm.module->remove(wr_data_shift);
+    // Cleanup the module from unused cells. The removal is left to the
+    // matcher so that the other pattern doesn't see the cells.
+    pm.autoremove(mem);
+    pm.autoremove(mux);
+    pm.autoremove(wr_en_shift);
+    pm.autoremove(wr_en_and);
+    pm.autoremove(wr_data_shift);
 }
 
-void test_ql_bram_asymmetric_wider_write(ql_bram_asymmetric_wider_write_pm &pm)
+void test_ql_bram_asymmetric_wider_write(ql_bram_asymmetric_pm &pm)
 {
     auto mem = pm.st_ql_bram_asymmetric_wider_write.mem;
     auto mem_wr_addr = pm.st_ql_bram_asymmetric_wider_write.mem_wr_addr;
@@ -261,28 +249,14 @@ void test_ql_bram_asymmetric_wider_write(ql_bram_asymmetric_wider_write_pm &pm)
 
     // Check if wr_en_and cell has one of its inputs connected to write address
 
-    // Compare and assign wires
-    RTLIL::Wire *rd_addr_w = nullptr;
-    RTLIL::Wire *rd_data_w = nullptr;
-    RTLIL::Wire *rd_en_w = nullptr;
-    RTLIL::Wire *rd_clk_w = nullptr;
-    RTLIL::Wire *wr_addr_w = nullptr;
-    RTLIL::Wire *wr_data_w = nullptr;
-
-    for (auto wire : pm.module->wires_) {
-        if (wire.second == rd_addr_wc)
-            rd_addr_w = wire.second;
-        if (wire.second == rd_data_wc)
-            rd_data_w = wire.second;
-        if (wire.second == rd_en_wc)
-            rd_en_w = wire.second;
-        if (wire.second == clk_wc)
-            rd_clk_w = wire.second;
-        if (wire.second == wr_addr_wc)
-            wr_addr_w = wire.second;
-        if (wire.second == wr_data_wc)
-            wr_data_w = wire.second;
-    }
+    // The wires come from ports of cells in this module, no need to look
+    // them up among the module wires
+    RTLIL::Wire *rd_addr_w = rd_addr_wc;
+    RTLIL::Wire *rd_data_w = rd_data_wc;
+    RTLIL::Wire *rd_en_w = rd_en_wc;
+    RTLIL::Wire *rd_clk_w = clk_wc;
+    RTLIL::Wire *wr_addr_w = wr_addr_wc;
+    RTLIL::Wire *wr_data_w = wr_data_wc;
 
     if (!rd_addr_w | !rd_data_w | !rd_en_w | !rd_clk_w | !wr_addr_w | !wr_data_w)
         log_error("Match between RAM input wires and memory cell ports not found\n");
@@ -334,18 +308,19 @@ void test_ql_bram_asymmetric_wider_write(ql_bram_asymmetric_wider_write_pm &pm)
     auto rd_en_s = RTLIL::SigSpec(rd_en_w);
     cell->setPort(RTLIL::escape_id("RD_EN"), rd_en_s);
 
-    // Cleanup the module from unused cells
-    pm.module->remove(mem);
-    pm.module->remove(rd_data_shift);
-    pm.module->remove(rd_data_ff);
-    pm.module->remove(wr_en_mux);
+    // Cleanup the module from unused cells. The removal is left to the
+    // matcher so that the other pattern doesn't see the cells.
+    pm.autoremove(mem);
+    pm.autoremove(rd_data_shift);
+    pm.autoremove(rd_data_ff);
+    pm.autoremove(wr_en_mux);
     if (wr_addr_ff)
-        pm.module->remove(wr_addr_ff);
+        pm.autoremove(wr_addr_ff);
     // Check if detected $and is connected to RD_ADDR
     if ((rd_addr_and_a_wc != rd_addr_w) & (rd_addr_and_b_wc != rd_addr_w))
         log_error("This is not the $and cell we are looking for\n");
     else
-        pm.module->remove(rd_addr_and);
+        pm.autoremove(rd_addr_and);
 }
 
 struct QLBramAsymmetric : public Pass {
@@ -378,11 +353,15 @@ struct QLBramAsymmetric : public Pass {
 
         int found_cells;
         for (auto module : a_Design->selected_modules()) {
-            found_cells = ql_bram_asymmetric_wider_write_pm(module, module->selected_cells())
-                            .run_ql_bram_asymmetric_wider_write(test_ql_bram_asymmetric_wider_write);
+            std::vector<RTLIL::Cell *> cells = module->selected_cells();
+            if (std::none_of(cells.begin(), cells.end(), [](RTLIL::Cell *cell) { return cell->type == ID($mem_v2); }))
+                continue;
+
+            // Both patterns share one matcher and its index of the module
+            ql_bram_asymmetric_pm pm(module, cells);
+            found_cells = pm.run_ql_bram_asymmetric_wider_write(test_ql_bram_asymmetric_wider_write);
             log_debug("found %d cells matching for wider write port\n", found_cells);
-            found_cells = ql_bram_asymmetric_wider_read_pm(module, module->selected_cells())
-                            .run_ql_bram_asymmetric_wider_read(test_ql_bram_asymmetric_wider_read);
+            found_cells = pm.run_ql_bram_asymmetric_wider_read(test_ql_bram_asymmetric_wider_read);
             log_debug("found %d cells matching for wider read port\n", found_cells);
         }
     }
@@ -11,6 +11,8 @@
 #include "kernel/rtlil.h"
 #include "kernel/sigtools.h"
 
+#include <algorithm>
+
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
@@ -23,11 +25,21 @@ struct QlBramSplitPass : public Pass {
     void help() override
     {
         log("\n");
-        log("    ql_bram_split [selection]\n");
+        log("    ql_bram_split [options] [selection]\n");
         log("\n");
         log("    This pass identifies k6n10f 18K BRAM cells\n");
         log("    and packs pairs of them together into final TDP36K cell that can\n");
         log("    be split into 2x18K BRAMs.\n");
+        log("\n");
+        log("    -match_clocks\n");
+        log("        Only pair BRAM cells connected to the same clocks.\n");
+        log("\n");
+        log("    -locality <attribute>\n");
+        log("        Pair BRAM cells in the order of the values of the given attribute\n");
+        log("        (eg. a placement constraint or 'src'), so that cells close to each\n");
+        log("        other end up in the same TDP36K cell. Cells without the attribute\n");
+        log("        are paired last. By default cells are paired in the order they are\n");
+        log("        found.\n");
     }
 
     // ..........................................
@@ -35,8 +47,13 @@ struct QlBramSplitPass : public Pass {
     /// Describes BRAM config unique to a whole BRAM cell
     struct BramConfig {
 
-        // Port connections
-        dict<RTLIL::IdString, RTLIL::SigSpec> connections;
+        // Connections of the compared ports. Each bit is either the id of its
+        // SigMap-canonical bit in the module or a negative id of a constant.
+        // Ports are terminated with kEnd.
+        std::vector<int> signals;
+
+        // Whether this is a TDP (or SDP) BRAM
+        bool tdp;
 
         // TODO: Possibly include parameters here. For now we have just
         // connections.
@@ -46,16 +63,30 @@ struct QlBramSplitPass : public Pass {
         BramConfig(const BramConfig &ref) = default;
         BramConfig(BramConfig &&ref) = default;
 
-        unsigned int hash() const { return connections.hash(); }
+        unsigned int hash() const { return mkhash(hash_ops<std::vector<int>>::hash(signals), tdp); }
 
-        bool operator==(const BramConfig &ref) const { return connections == ref.connections; }
+        bool operator==(const BramConfig &ref) const { return signals == ref.signals && tdp == ref.tdp; }
+    };
+
+    /// Terminates a port in BramConfig::signals
+    enum { kEnd = -1 };
+
+    /// BRAM cells of a module grouped by their configuration
+    struct ModuleGroups {
+        RTLIL::Module *module;
+        std::vector<RTLIL::Cell *> cells;
+        std::vector<std::vector<RTLIL::Cell *>> groups;
+        std::vector<bool> groupIsTdp;
+    };
+
+    /// Names looked up by the grouping, resolved once per pass
+    struct ConfigNames {
+        std::vector<RTLIL::IdString> ports;
+        RTLIL::IdString tdpType;
     };
 
     // ..........................................
 
-    // BRAM control and config ports to consider and how to map them to ports
-    // of the target BRAM cell
-    const std::vector<std::pair<std::string, std::string>> m_BramSharedPorts = {};
     // BRAM parameters
     const std::vector<std::string> m_BramParams = {"CFG_ABITS", "CFG_DBITS"};
 
@@ -89,8 +120,11 @@ struct QlBramSplitPass : public Pass {
     // Target BRAM SDP cell type for the split mode
     const std::string m_Bram2x18SDPType = "BRAM2x18_SDP";
 
-    /// Temporary SigBit to SigBit helper map.
-    SigMap m_SigMap;
+    // Clock ports of the BRAM 1x18 cells, considered with -match_clocks
+    const std::vector<std::string> m_BramClockPorts = {"CLK1", "CLK2"};
+
+    /// Attribute ordering cells for pairing
+    RTLIL::IdString m_LocalityAttr;
 
     // ..........................................
 
@@ -129,7 +163,7 @@ struct QlBramSplitPass : public Pass {
         }
     }
 
-    void map_pairs(std::vector<RTLIL::Cell *> group, BramConfig config, std::vector<const RTLIL::Cell *> *cellsToRemove, RTLIL::Module *module)
+    void map_pairs(const std::vector<RTLIL::Cell *> &group, std::vector<const RTLIL::Cell *> *cellsToRemove, RTLIL::Module *module)
     {
         // Ensure an even number
         size_t count = group.size();
@@ -176,14 +210,6 @@ struct QlBramSplitPass : public Pass {
                 log_error(" The target cell type '%s' is not known!", m_Bram2x18Type.c_str());
             }
 
-            // Connect shared ports
-            for (const auto &it : m_BramSharedPorts) {
-                auto src = RTLIL::escape_id(it.first);
-                auto dst = RTLIL::escape_id(it.second);
-
-                bram_2x18->setPort(dst, config.connections.at(src));
-            }
-
             // Connect data ports
             // Connect first bram
             map_ports(m_BramDataPorts_0, bram_0, bram_2x18);
@@ -225,17 +251,36 @@ struct QlBramSplitPass : public Pass {
         log_header(a_Design, "Executing QL_BRAM_Split pass.\n");
 
         // Parse args
-        extra_args(a_Args, 1, a_Design);
-
-        // Process modules
-        for (auto module : a_Design->selected_modules()) {
+        bool matchClocks = false;
+        m_LocalityAttr = RTLIL::IdString();
+        size_t argidx;
+        for (argidx = 1; argidx < a_Args.size(); argidx++) {
+            if (a_Args[argidx] == "-match_clocks") {
+                matchClocks = true;
+                continue;
+            }
+            if (a_Args[argidx] == "-locality" && argidx + 1 < a_Args.size()) {
+                m_LocalityAttr = RTLIL::escape_id(a_Args[++argidx]);
+                continue;
+            }
+            break;
+        }
+        extra_args(a_Args, argidx, a_Design);
 
-            // Setup the SigMap
-            m_SigMap.clear();
-            m_SigMap.set(module);
+        ConfigNames names;
+        if (matchClocks) {
+            for (const auto &it : m_BramClockPorts) {
+                names.ports.push_back(RTLIL::escape_id(it));
+            }
+        }
+        names.tdpType = RTLIL::escape_id(m_Bram1x18TDPType);
+        const RTLIL::IdString sdpType = RTLIL::escape_id(m_Bram1x18SDPType);
 
-            // Assemble BRAM cell groups
-            dict<BramConfig, std::vector<RTLIL::Cell *>> sdp_groups, tdp_groups;
+        // Collect BRAM cells of the selected modules
+        std::vector<ModuleGroups> modules;
+        for (auto module : a_Design->selected_modules()) {
+            ModuleGroups moduleGroups;
+            moduleGroups.module = module;
             for (auto cell : module->selected_cells()) {
 
                 // Skip if it has the (* keep *) attribute set
@@ -243,39 +288,48 @@ struct QlBramSplitPass : public Pass {
                     continue;
                 }
 
-                // Check if this is a BRAM cell and add to a group
-                const auto key = getBramConfig(cell);
-                if (cell->type == RTLIL::escape_id(m_Bram1x18TDPType)) {
-                    tdp_groups[key].push_back(cell);
-                } else if (cell->type == RTLIL::escape_id(m_Bram1x18SDPType)) {
-                    sdp_groups[key].push_back(cell);
-                } else {
-                    continue;
+                // Check if this is a BRAM cell
+                if (cell->type == names.tdpType || cell->type == sdpType) {
+                    moduleGroups.cells.push_back(cell);
                 }
             }
+            if (!moduleGroups.cells.empty()) {
+                modules.push_back(std::move(moduleGroups));
+            }
+        }
 
-            std::vector<const RTLIL::Cell *> cellsToRemove;
+        // Assemble BRAM cell groups
+        for (auto &moduleGroups : modules) {
+            groupCells(moduleGroups, names);
+        }
+
+        // Process modules
+        for (auto &moduleGroups : modules) {
+            auto module = moduleGroups.module;
 
-            // Map cell pairs to the target BRAM 2x18 cell
-            for (const auto &it : sdp_groups) {
-                const auto &group = it.second;
-                const auto &config = it.first;
-                map_pairs(group, config, &cellsToRemove, module);
+            if (!m_LocalityAttr.empty()) {
+                for (auto &group : moduleGroups.groups) {
+                    sortByLocality(group);
+                }
             }
-            for (const auto &it : tdp_groups) {
-                const auto &group = it.second;
-                const auto &config = it.first;
-                map_pairs(group, config, &cellsToRemove, module);
+
+            std::vector<const RTLIL::Cell *> cellsToRemove;
+
+            // Map cell pairs to the target BRAM 2x18 cell, SDP groups first
+            for (bool tdp : {false, true}) {
+                for (size_t i = 0; i < moduleGroups.groups.size(); ++i) {
+                    if (moduleGroups.groupIsTdp[i] == tdp) {
+                        map_pairs(moduleGroups.groups[i], &cellsToRemove, module);
+                    }
+                }
             }
 
-            // Remove old cells
+            // Remove the replaced cells in one sweep once all pairs are built,
+            // Yosys has no bulk removal of cells
             for (const auto &cell : cellsToRemove) {
                 module->remove(const_cast<RTLIL::Cell *>(cell));
             }
         }
-
-        // Clear
-        m_SigMap.clear();
     }
 
     // ..........................................
@@ -305,34 +359,80 @@ struct QlBramSplitPass : public Pass {
     }
 
     /// Given a BRAM cell populates and returns a BramConfig struct for it.
-    BramConfig getBramConfig(RTLIL::Cell *a_Cell)
+    BramConfig getBramConfig(const RTLIL::Cell *a_Cell, const SigMap &a_SigMap, dict<RTLIL::SigBit, int> &a_BitIds, const ConfigNames &a_Names)
     {
         BramConfig config;
+        config.tdp = (a_Cell->type == a_Names.tdpType);
 
-        for (const auto &it : m_BramSharedPorts) {
-            auto port = RTLIL::escape_id(it.first);
+        for (const auto &port : a_Names.ports) {
 
             // Port unconnected
             if (!a_Cell->hasPort(port)) {
-                config.connections[port] = RTLIL::SigSpec(RTLIL::Sx);
+                config.signals.push_back(constantId(RTLIL::Sx));
+                config.signals.push_back(kEnd);
                 continue;
             }
 
-            // Get the port connection and map it to unique SigBits
-            const auto &orgSigSpec = a_Cell->getPort(port);
-            const auto &orgSigBits = orgSigSpec.bits();
+            // Map the port connection to unique SigBits
+            for (auto bit : a_SigMap(a_Cell->getPort(port))) {
+                if (bit.wire == nullptr) {
+                    config.signals.push_back(constantId(bit.data));
+                } else {
+                    config.signals.push_back(a_BitIds.insert(std::make_pair(bit, (int)a_BitIds.size())).first->second);
+                }
+            }
+            config.signals.push_back(kEnd);
+        }
+
+        return config;
+    }
+
+    /// Returns a negative id for a constant bit, distinct from kEnd
+    static int constantId(RTLIL::State a_State) { return -2 - (int)a_State; }
+
+    /// Groups the BRAM cells of a module by their configuration
+    void groupCells(ModuleGroups &a_Module, const ConfigNames &a_Names)
+    {
+        // The SigMap is only needed when there are connections to compare
+        SigMap sigmap;
+        if (!a_Names.ports.empty()) {
+            sigmap.set(a_Module.module);
+        }
 
-            RTLIL::SigSpec newSigSpec;
-            for (size_t i = 0; i < orgSigBits.size(); ++i) {
-                auto newSigBit = m_SigMap(orgSigBits[i]);
-                newSigSpec.append(newSigBit);
+        dict<RTLIL::SigBit, int> bitIds;
+        dict<BramConfig, int> groupIds;
+        for (auto cell : a_Module.cells) {
+            auto key = getBramConfig(cell, sigmap, bitIds, a_Names);
+            auto it = groupIds.find(key);
+            if (it == groupIds.end()) {
+                a_Module.groupIsTdp.push_back(key.tdp);
+                it = groupIds.insert(std::make_pair(std::move(key), (int)a_Module.groups.size())).first;
+                a_Module.groups.emplace_back();
             }
+            a_Module.groups[it->second].push_back(cell);
+        }
+    }
 
-            // Store
-            config.connections[port] = newSigSpec;
+    /// Orders BRAM cells by the value of the locality attribute
+    void sortByLocality(std::vector<RTLIL::Cell *> &a_Cells)
+    {
+        std::vector<std::pair<std::string, RTLIL::Cell *>> keyed;
+        std::vector<RTLIL::Cell *> unplaced;
+        for (auto cell : a_Cells) {
+            if (cell->has_attribute(m_LocalityAttr)) {
+                keyed.emplace_back(cell->get_string_attribute(m_LocalityAttr), cell);
+            } else {
+                unplaced.push_back(cell);
+            }
         }
+        using Keyed = std::pair<std::string, RTLIL::Cell *>;
+        std::stable_sort(keyed.begin(), keyed.end(), [](const Keyed &a, const Keyed &b) { return a.first < b.first; });
 
-        return config;
+        a_Cells.clear();
+        for (auto &it : keyed) {
+            a_Cells.push_back(it.second);
+        }
+        a_Cells.insert(a_Cells.end(), unplaced.begin(), unplaced.end());
     }
 
 } QlBramSplitPass;
@@ -0,0 +1,159 @@
+// Copyright (C) 2020-2022  The SymbiFlow Authors.
+//
+// Use of this source code is governed by a ISC-style
+// license that can be found in the LICENSE file or at
+// https://opensource.org/licenses/ISC
+//
+// SPDX-License-Identifier:ISC
+
+#include "kernel/log.h"
+#include "kernel/register.h"
+#include "kernel/rtlil.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+// ============================================================================
+
+struct QlBramTypesPass : public Pass {
+
+    QlBramTypesPass() : Pass("ql_bram_types", "Change TDP36K type to subtypes") {}
+
+    void help() override
+    {
+        log("\n");
+        log("    ql_bram_types [selection]\n");
+        log("\n");
+        log("    This pass changes the type of TDP36K cells to the subtypes\n");
+        log("    specialized for their data widths and modes:\n");
+        log("\n");
+        log("        TDP36K_BRAM_WR_X<w>_RD_X<r>_{split,nonsplit}\n");
+        log("        TDP36K_FIFO_ASYNC_WR_X<w>_RD_X<r>_{split,nonsplit}\n");
+        log("        TDP36K_FIFO_SYNC_WR_X<w>_RD_X<r>_{split,nonsplit}\n");
+        log("\n");
+        log("    The subtype is determined by the 'is_inferred', 'is_fifo', 'sync_fifo',\n");
+        log("    'is_split', 'wr_data_width' and 'rd_data_width' attributes of the cell.\n");
+        log("    Cells whose attributes don't match any subtype are left unchanged.\n");
+        log("\n");
+    }
+
+    // ..........................................
+
+    /// Returns the integer value of an attribute, or -1 if it's not set or
+    /// isn't a number
+    static int getIntAttribute(const RTLIL::Cell *a_Cell, const RTLIL::IdString &a_Name)
+    {
+        auto it = a_Cell->attributes.find(a_Name);
+        if (it == a_Cell->attributes.end()) {
+            return -1;
+        }
+
+        const auto &value = it->second;
+        if (!(value.flags & RTLIL::CONST_FLAG_STRING)) {
+            return value.is_fully_def() ? value.as_int() : -1;
+        }
+
+        std::string str = value.decode_string();
+        if (str.empty() || str.find_first_not_of("0123456789") != std::string::npos || str.size() > 9) {
+            return -1;
+        }
+        return std::stoi(str);
+    }
+
+    /// Maps a data width to the width of the specialized cell type. Returns 0
+    /// for unsupported widths.
+    static int getTypeWidth(int a_Width, bool a_Split)
+    {
+        switch (a_Width) {
+        case 36:
+        case 32:
+            return a_Split ? 0 : 36;
+        case 18:
+        case 16:
+            return 18;
+        case 9:
+        case 8:
+            return 9;
+        case 4:
+        case 2:
+        case 1:
+            return a_Width;
+        default:
+            return 0;
+        }
+    }
+
+    /// Returns the specialized type of a TDP36K cell, or an empty string if
+    /// there is none
+    static std::string getBramType(const RTLIL::Cell *a_Cell)
+    {
+        bool isInferred = getIntAttribute(a_Cell, ID(is_inferred)) == 1;
+        bool isFifo = getIntAttribute(a_Cell, ID(is_fifo)) == 1;
+        bool isSplit = getIntAttribute(a_Cell, ID(is_split)) == 1;
+        int syncFifo = getIntAttribute(a_Cell, ID(sync_fifo));
+        int wrDataWidth = getIntAttribute(a_Cell, ID(wr_data_width));
+        int rdDataWidth = getIntAttribute(a_Cell, ID(rd_data_width));
+
+        // Split cells with widths that no split subtype supports fall back
+        // to the nonsplit subtypes
+        for (bool split : {true, false}) {
+            if (split && !isSplit) {
+                continue;
+            }
+
+            int wrWidth = getTypeWidth(wrDataWidth, split);
+            int rdWidth = getTypeWidth(rdDataWidth, split);
+            if (wrWidth == 0 || rdWidth == 0) {
+                continue;
+            }
+
+            const char *mode = nullptr;
+            if (isInferred) {
+                mode = "BRAM";
+            } else if (isFifo && syncFifo == 0) {
+                mode = "FIFO_ASYNC";
+            } else if (isFifo && syncFifo == 1) {
+                mode = "FIFO_SYNC";
+            } else {
+                return std::string();
+            }
+
+            return stringf("TDP36K_%s_WR_X%d_RD_X%d_%s", mode, wrWidth, rdWidth, split ? "split" : "nonsplit");
+        }
+
+        return std::string();
+    }
+
+    void execute(std::vector<std::string> a_Args, RTLIL::Design *a_Design) override
+    {
+        log_header(a_Design, "Executing QL_BRAM_TYPES pass.\n");
+
+        // Parse args
+        extra_args(a_Args, 1, a_Design);
+
+        // Change the types of the cells
+        dict<std::string, int> counts;
+        for (auto module : a_Design->selected_modules()) {
+            for (auto cell : module->selected_cells()) {
+                if (cell->type != ID(TDP36K)) {
+                    continue;
+                }
+
+                std::string type = getBramType(cell);
+                if (type.empty()) {
+                    continue;
+                }
+
+                cell->type = RTLIL::escape_id(type);
+                counts[type]++;
+            }
+        }
+
+        for (auto &it : counts) {
+            log(" %s: %d cell(s)\n", it.first.c_str(), it.second);
+        }
+    }
+
+} QlBramTypesPass;
+
+PRIVATE_NAMESPACE_END
@@ -1,13 +1,11 @@
 #include "kernel/sigtools.h"
 #include "kernel/yosys.h"
 
+#include "ql-dsp-mode.h"
+
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-#define MODE_BITS_REGISTER_INPUTS_ID 92
-#define MODE_BITS_OUTPUT_SELECT_START_ID 81
-#define MODE_BITS_OUTPUT_SELECT_WIDTH 3
-
 // ============================================================================
 
 struct QlDspIORegs : public Pass {
@@ -17,8 +15,30 @@ struct QlDspIORegs : public Pass {
     const std::vector<std::string> ports2del_mult_add = {"dly_b"};
     const std::vector<std::string> ports2del_extension = {"saturate_enable", "shift_right", "round"};
 
-    /// Temporary SigBit to SigBit helper map.
-    SigMap m_SigMap;
+    /// Configuration of a DSP cell read by the analysis
+    struct DspInfo {
+        RTLIL::Cell *cell;
+        bool use_dsp_cfg_params;
+        QlDspMode mode;
+        bool have_macc;
+    };
+
+    /// Inferred DSP cells of a module and their configuration
+    struct ModuleDsps {
+        RTLIL::Module *module;
+        std::vector<DspInfo> dsps;
+    };
+
+    /// Names looked up by the analysis, created once per pass
+    struct Names {
+        RTLIL::IdString ql_dsp2 = ID(QL_DSP2);
+        RTLIL::IdString ql_dsp3 = ID(QL_DSP3);
+        RTLIL::IdString is_inferred = ID(is_inferred);
+        RTLIL::IdString mode_bits = ID(MODE_BITS);
+        RTLIL::IdString register_inputs = ID(register_inputs);
+        RTLIL::IdString output_select = ID(output_select);
+        RTLIL::IdString feedback = ID(feedback);
+    };
 
     // ..........................................
 
@@ -43,21 +63,41 @@ struct QlDspIORegs : public Pass {
         }
         extra_args(a_Args, argidx, a_Design);
 
+        Names names;
+
+        // Gather the candidate cells of each module by type first so that
+        // modules without any are skipped entirely
+        std::vector<ModuleDsps> modules;
+        std::vector<std::vector<RTLIL::Cell *>> candidates;
         for (auto module : a_Design->selected_modules()) {
-            ql_dsp_io_regs_pass(module);
+            std::vector<RTLIL::Cell *> cells;
+            for (auto cell : module->cells())
+                if (cell->type == names.ql_dsp2 || cell->type == names.ql_dsp3)
+                    cells.push_back(cell);
+            if (cells.empty())
+                continue;
+            modules.push_back(ModuleDsps{module, {}});
+            candidates.push_back(std::move(cells));
         }
+
+        // Analyze all cells before any of them is retyped
+        for (size_t i = 0; i < modules.size(); i++)
+            analyze_module(names, modules[i], candidates[i]);
+
+        for (auto &module : modules)
+            for (auto &dsp : module.dsps)
+                retype_dsp(dsp);
     }
 
     // Returns a pair of mask and value describing constant bit connections of
     // a SigSpec
-    std::pair<uint32_t, uint32_t> get_constant_mask_value(const RTLIL::SigSpec *sigspec)
+    static std::pair<uint32_t, uint32_t> get_constant_mask_value(const SigMap &sigmap, const RTLIL::SigSpec *sigspec)
     {
         uint32_t mask = 0L;
         uint32_t value = 0L;
 
-        auto sigbits = sigspec->bits();
-        for (ssize_t i = (sigbits.size() - 1); i >= 0; --i) {
-            auto other = m_SigMap(sigbits[i]);
+        for (int i = GetSize(*sigspec) - 1; i >= 0; --i) {
+            auto other = sigmap((*sigspec)[i]);
 
             mask <<= 1;
             value <<= 1;
@@ -72,152 +112,127 @@ struct QlDspIORegs : public Pass {
         return std::make_pair(mask, value);
     }
 
-    void ql_dsp_io_regs_pass(RTLIL::Module *module)
+    static void analyze_module(const Names &names, ModuleDsps &module, const std::vector<RTLIL::Cell *> &cells)
     {
-        // Setup the SigMap
-        m_SigMap.clear();
-        m_SigMap.set(module);
-
-        for (auto cell : module->cells_) {
-            std::string cell_type = cell.second->type.str();
-            if (cell_type == RTLIL::escape_id("QL_DSP2") || cell_type == RTLIL::escape_id("QL_DSP3")) {
-                auto dsp = cell.second;
-
-                // If the cell does not have the "is_inferred" attribute set
-                // then don't touch it.
-                if (!dsp->has_attribute(RTLIL::escape_id("is_inferred")) || dsp->get_bool_attribute(RTLIL::escape_id("is_inferred")) == false) {
-                    continue;
-                }
-
-                bool del_clk = true;
-                bool use_dsp_cfg_params = (cell_type == RTLIL::escape_id("QL_DSP3"));
-
-                int reg_in_i;
-                int out_sel_i;
-
-                // Get DSP configuration
-                if (use_dsp_cfg_params) {
-                    // Read MODE_BITS at correct indexes
-                    auto mode_bits = &dsp->getParam(RTLIL::escape_id("MODE_BITS"));
-                    RTLIL::Const register_inputs;
-                    register_inputs = mode_bits->bits.at(MODE_BITS_REGISTER_INPUTS_ID);
-                    reg_in_i = register_inputs.as_int();
-
-                    RTLIL::Const output_select;
-                    output_select = mode_bits->extract(MODE_BITS_OUTPUT_SELECT_START_ID, MODE_BITS_OUTPUT_SELECT_WIDTH);
-                    out_sel_i = output_select.as_int();
-                } else {
-                    // Read dedicated configuration ports
-                    const RTLIL::SigSpec *register_inputs;
-                    register_inputs = &dsp->getPort(RTLIL::escape_id("register_inputs"));
-                    if (!register_inputs)
-                        log_error("register_inputs port not found!");
-                    auto reg_in_c = register_inputs->as_const();
-                    reg_in_i = reg_in_c.as_int();
-
-                    const RTLIL::SigSpec *output_select;
-                    output_select = &dsp->getPort(RTLIL::escape_id("output_select"));
-                    if (!output_select)
-                        log_error("output_select port not found!");
-                    auto out_sel_c = output_select->as_const();
-                    out_sel_i = out_sel_c.as_int();
-                }
-
-                // Get the feedback port
-                const RTLIL::SigSpec *feedback;
-                feedback = &dsp->getPort(RTLIL::escape_id("feedback"));
-                if (!feedback)
-                    log_error("feedback port not found!");
-
-                // Check if feedback is or can be set to 0 which implies MACC
-                auto feedback_con = get_constant_mask_value(feedback);
-                bool have_macc = (feedback_con.second == 0x0);
-                // log("mask=0x%08X value=0x%08X\n", consts.first, consts.second);
-                // log_error("=== END HERE ===\n");
-
-                // Build new type name
-                std::string new_type = cell_type;
-                new_type += "_MULT";
-
-                if (have_macc) {
-                    switch (out_sel_i) {
-                    case 1:
-                    case 2:
-                    case 3:
-                    case 5:
-                    case 7:
-                        del_clk = false;
-                        new_type += "ACC";
-                        break;
-                    default:
-                        break;
-                    }
-                } else {
-                    switch (out_sel_i) {
-                    case 1:
-                    case 2:
-                    case 3:
-                    case 5:
-                    case 7:
-                        new_type += "ADD";
-                        break;
-                    default:
-                        break;
-                    }
-                }
-
-                if (reg_in_i) {
-                    del_clk = false;
-                    new_type += "_REGIN";
-                }
-
-                if (out_sel_i > 3) {
-                    del_clk = false;
-                    new_type += "_REGOUT";
-                }
-
-                // Set new type name
-                dsp->type = RTLIL::IdString(new_type);
-
-                std::vector<std::string> ports2del;
-
-                if (del_clk)
-                    ports2del.push_back("clk");
-
-                switch (out_sel_i) {
-                case 0:
-                case 4:
-                case 6:
-                    ports2del.insert(ports2del.end(), ports2del_mult.begin(), ports2del_mult.end());
-                    // Mark for deleton additional configuration ports
-                    if (!use_dsp_cfg_params) {
-                        ports2del.insert(ports2del.end(), ports2del_extension.begin(), ports2del_extension.end());
-                    }
-                    break;
-                case 1:
-                case 2:
-                case 3:
-                case 5:
-                case 7:
-                    if (have_macc) {
-                        ports2del.insert(ports2del.end(), ports2del_mult_acc.begin(), ports2del_mult_acc.end());
-                    } else {
-                        ports2del.insert(ports2del.end(), ports2del_mult_add.begin(), ports2del_mult_add.end());
-                    }
-                    break;
-                }
-
-                for (auto portname : ports2del) {
-                    const RTLIL::SigSpec *port = &dsp->getPort(RTLIL::escape_id(portname));
-                    if (!port)
-                        log_error("%s port not found!", portname.c_str());
-                    dsp->connections_.erase(RTLIL::escape_id(portname));
-                }
+        SigMap sigmap(module.module);
+
+        for (auto dsp : cells) {
+            // If the cell does not have the "is_inferred" attribute set
+            // then don't touch it.
+            if (!dsp->get_bool_attribute(names.is_inferred)) {
+                continue;
+            }
+
+            DspInfo info;
+            info.cell = dsp;
+            info.use_dsp_cfg_params = (dsp->type == names.ql_dsp3);
+
+            // Get DSP configuration
+            if (info.use_dsp_cfg_params) {
+                // Read MODE_BITS at correct indexes
+                info.mode = decode_ql_dsp_mode_bits(dsp->getParam(names.mode_bits));
+            } else {
+                // Read dedicated configuration ports
+                info.mode.register_inputs = dsp->getPort(names.register_inputs).as_const().as_bool();
+                info.mode.output_select = dsp->getPort(names.output_select).as_const().as_int();
             }
+
+            // Get the feedback port
+            const RTLIL::SigSpec *feedback;
+            feedback = &dsp->getPort(names.feedback);
+
+            // Check if feedback is or can be set to 0 which implies MACC
+            auto feedback_con = get_constant_mask_value(sigmap, feedback);
+            info.have_macc = (feedback_con.second == 0x0);
+
+            module.dsps.push_back(info);
         }
+    }
 
-        // Clear the sigmap
-        m_SigMap.clear();
+    void retype_dsp(const DspInfo &info)
+    {
+        auto dsp = info.cell;
+        bool del_clk = true;
+        int out_sel_i = info.mode.output_select;
+
+        // Build new type name
+        std::string new_type = dsp->type.str();
+        new_type += "_MULT";
+
+        if (info.have_macc) {
+            switch (out_sel_i) {
+            case 1:
+            case 2:
+            case 3:
+            case 5:
+            case 7:
+                del_clk = false;
+                new_type += "ACC";
+                break;
+            default:
+                break;
+            }
+        } else {
+            switch (out_sel_i) {
+            case 1:
+            case 2:
+            case 3:
+            case 5:
+            case 7:
+                new_type += "ADD";
+                break;
+            default:
+                break;
+            }
+        }
+
+        if (info.mode.register_inputs) {
+            del_clk = false;
+            new_type += "_REGIN";
+        }
+
+        if (out_sel_i > 3) {
+            del_clk = false;
+            new_type += "_REGOUT";
+        }
+
+        // Set new type name
+        dsp->type = RTLIL::IdString(new_type);
+
+        std::vector<std::string> ports2del;
+
+        if (del_clk)
+            ports2del.push_back("clk");
+
+        switch (out_sel_i) {
+        case 0:
+        case 4:
+        case 6:
+            ports2del.insert(ports2del.end(), ports2del_mult.begin(), ports2del_mult.end());
+            // Mark for deleton additional configuration ports
+            if (!info.use_dsp_cfg_params) {
+                ports2del.insert(ports2del.end(), ports2del_extension.begin(), ports2del_extension.end());
+            }
+            break;
+        case 1:
+        case 2:
+        case 3:
+        case 5:
+        case 7:
+            if (info.have_macc) {
+                ports2del.insert(ports2del.end(), ports2del_mult_acc.begin(), ports2del_mult_acc.end());
+            } else {
+                ports2del.insert(ports2del.end(), ports2del_mult_add.begin(), ports2del_mult_add.end());
+            }
+            break;
+        }
+
+        for (auto portname : ports2del) {
+            RTLIL::IdString port = RTLIL::escape_id(portname);
+            if (!dsp->hasPort(port))
+                log_error("%s port not found!", portname.c_str());
+            dsp->connections_.erase(port);
+        }
     }
 
 } QlDspIORegs;
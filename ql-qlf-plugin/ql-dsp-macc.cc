@@ -279,7 +279,12 @@ struct QlDspMacc : public Pass {
         extra_args(a_Args, argidx, a_Design);
 
         for (auto module : a_Design->selected_modules()) {
-            ql_dsp_macc_pm(module, module->selected_cells()).run_ql_dsp_macc(create_ql_macc_dsp);
+            // Every match starts at a $mul, don't build the matcher index for
+            // modules that have none
+            std::vector<RTLIL::Cell *> cells = module->selected_cells();
+            if (std::none_of(cells.begin(), cells.end(), [](RTLIL::Cell *cell) { return cell->type == ID($mul); }))
+                continue;
+            ql_dsp_macc_pm(module, cells).run_ql_dsp_macc(create_ql_macc_dsp);
         }
     }
 
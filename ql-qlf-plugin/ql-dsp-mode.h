@@ -0,0 +1,54 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef QL_DSP_MODE_H
+#define QL_DSP_MODE_H
+
+#include "kernel/rtlil.h"
+
+// Layout of the MODE_BITS parameter of the k6n10f DSP cells: the FIR
+// coefficients of both halves followed, for QL_DSP3, by F_MODE and the
+// configuration that QL_DSP2 takes through its ports (output_select,
+// saturate_enable, shift_right, round and register_inputs)
+#define MODE_BITS_BASE_SIZE 80
+#define MODE_BITS_EXTENSION_SIZE 13
+#define MODE_BITS_OUTPUT_SELECT_START_ID 81
+#define MODE_BITS_OUTPUT_SELECT_WIDTH 3
+#define MODE_BITS_REGISTER_INPUTS_ID 92
+
+YOSYS_NAMESPACE_BEGIN
+
+// The part of a DSP configuration that determines the final cell type
+struct QlDspMode {
+    int output_select = 0;
+    bool register_inputs = false;
+};
+
+// Reads the mode of a QL_DSP3 cell straight from the bits of MODE_BITS
+inline QlDspMode decode_ql_dsp_mode_bits(const RTLIL::Const &mode_bits)
+{
+    QlDspMode mode;
+    for (int i = 0; i < MODE_BITS_OUTPUT_SELECT_WIDTH; i++)
+        if (mode_bits.bits.at(MODE_BITS_OUTPUT_SELECT_START_ID + i) == RTLIL::State::S1)
+            mode.output_select |= 1 << i;
+    mode.register_inputs = mode_bits.bits.at(MODE_BITS_REGISTER_INPUTS_ID) == RTLIL::State::S1;
+    return mode;
+}
+
+YOSYS_NAMESPACE_END
+
+#endif // QL_DSP_MODE_H
@@ -0,0 +1,158 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+
+#include "kernel/yosys.h"
+
+USING_YOSYS_NAMESPACE
+PRIVATE_NAMESPACE_BEGIN
+
+// ============================================================================
+
+struct QlDspMulPartitionPass : public Pass {
+
+    QlDspMulPartitionPass() : Pass("ql_dsp_mul_partition", "Maps multipliers to the best fitting DSP variant") {}
+
+    // A DSP variant mul2dsp can map multipliers to
+    struct DspRule {
+        std::string type;
+        int a_maxwidth;
+        int b_maxwidth;
+        int a_minwidth;
+        int b_minwidth;
+    };
+
+    // DSP variants in the order of preference
+    std::vector<DspRule> m_Rules;
+
+    void help() override
+    {
+        log("\n");
+        log("    ql_dsp_mul_partition -rule <type> <a_max> <b_max> <a_min> <b_min> ... [selection]\n");
+        log("\n");
+        log("    This pass assigns every $mul cell to the first DSP variant whose\n");
+        log("    minimum operand widths it meets, using the same checks as mul2dsp, and\n");
+        log("    maps each group with a single mul2dsp techmap call restricted to its\n");
+        log("    members. Variants without any multipliers are skipped. Multipliers\n");
+        log("    that mul2dsp leaves unmapped, and parts of split multipliers that are\n");
+        log("    too narrow for a variant, are handed over to the following variants.\n");
+        log("    This replaces running 'techmap -map +/mul2dsp.v' followed by\n");
+        log("    'chtype -set $mul t:$__soft_mul' for every variant in turn.\n");
+        log("\n");
+        log("    -rule <type> <a_max> <b_max> <a_min> <b_min>\n");
+        log("        Add a DSP variant of the given cell type, with the given maximum\n");
+        log("        and minimum operand widths (the DSP_A_MAXWIDTH, DSP_B_MAXWIDTH,\n");
+        log("        DSP_A_MINWIDTH and DSP_B_MINWIDTH mul2dsp defines). May be given\n");
+        log("        more than once, in the order of preference.\n");
+        log("\n");
+    }
+
+    void clear_flags() override { m_Rules.clear(); }
+
+    // Returns the index of the first rule starting at `first` which mul2dsp
+    // maps the multiplier with, or -1 if none does
+    int classify(RTLIL::Cell *cell, size_t first) const
+    {
+        // mul2dsp checks the minimum widths before swapping the operands, so
+        // they apply to A and B as given. DSP_Y_MINWIDTH isn't passed to it.
+        int a_width = cell->getParam(ID(A_WIDTH)).as_int();
+        int b_width = cell->getParam(ID(B_WIDTH)).as_int();
+
+        for (size_t i = first; i < m_Rules.size(); i++) {
+            if (a_width >= m_Rules[i].a_minwidth && b_width >= m_Rules[i].b_minwidth)
+                return i;
+        }
+        return -1;
+    }
+
+    void execute(std::vector<std::string> a_Args, RTLIL::Design *a_Design) override
+    {
+        log_header(a_Design, "Executing QL_DSP_MUL_PARTITION pass.\n");
+
+        size_t argidx;
+        for (argidx = 1; argidx < a_Args.size(); argidx++) {
+            if (a_Args[argidx] == "-rule" && argidx + 5 < a_Args.size()) {
+                DspRule rule;
+                rule.type = a_Args[++argidx];
+                rule.a_maxwidth = atoi(a_Args[++argidx].c_str());
+                rule.b_maxwidth = atoi(a_Args[++argidx].c_str());
+                rule.a_minwidth = atoi(a_Args[++argidx].c_str());
+                rule.b_minwidth = atoi(a_Args[++argidx].c_str());
+                m_Rules.push_back(rule);
+                continue;
+            }
+
+            break;
+        }
+        extra_args(a_Args, argidx, a_Design);
+
+        if (m_Rules.empty())
+            log_cmd_error("At least one DSP variant has to be given with -rule.\n");
+
+        // Multipliers to be mapped by each rule
+        std::vector<RTLIL::Selection> groups(m_Rules.size(), RTLIL::Selection(false));
+        std::vector<int> groupSizes(m_Rules.size(), 0);
+
+        for (auto module : a_Design->selected_modules()) {
+            for (auto cell : module->selected_cells()) {
+                if (cell->type != ID($mul))
+                    continue;
+                int rule = classify(cell, 0);
+                if (rule < 0)
+                    continue;
+                groups[rule].selected_members[module->name].insert(cell->name);
+                groupSizes[rule]++;
+            }
+        }
+
+        for (size_t i = 0; i < m_Rules.size(); i++) {
+            if (groupSizes[i] == 0)
+                continue;
+
+            const auto &rule = m_Rules[i];
+            log("Mapping %d multiplier(s) to %s.\n", groupSizes[i], rule.type.c_str());
+            Pass::call_on_selection(a_Design, groups[i],
+                                    stringf("techmap -map +/mul2dsp.v "
+                                            "-D DSP_A_MAXWIDTH=%d -D DSP_B_MAXWIDTH=%d "
+                                            "-D DSP_A_MINWIDTH=%d -D DSP_B_MINWIDTH=%d "
+                                            "-D DSP_NAME=%s",
+                                            rule.a_maxwidth, rule.b_maxwidth, rule.a_minwidth, rule.b_minwidth, rule.type.c_str()));
+
+            // Multipliers mul2dsp failed to map are still $mul cells and parts
+            // of split multipliers that are too narrow for this rule are left
+            // behind as $__soft_mul cells. Hand both over to the following
+            // rules, the latter turned back into $mul cells.
+            for (auto &it : groups[i].selected_members) {
+                RTLIL::Module *module = a_Design->module(it.first);
+                for (auto cell : module->cells()) {
+                    if (cell->type == ID($__soft_mul))
+                        cell->type = ID($mul);
+                    else if (cell->type != ID($mul) || !it.second.count(cell->name))
+                        continue;
+                    int next = classify(cell, i + 1);
+                    if (next < 0)
+                        continue;
+                    groups[next].selected_members[module->name].insert(cell->name);
+                    groupSizes[next]++;
+                }
+            }
+        }
+    }
+
+} QlDspMulPartitionPass;
+
+PRIVATE_NAMESPACE_END
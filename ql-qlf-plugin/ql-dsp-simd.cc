@@ -21,12 +21,13 @@
 #include "kernel/rtlil.h"
 #include "kernel/sigtools.h"
 
+#include "ql-dsp-mode.h"
+
+#include <algorithm>
+
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
-#define MODE_BITS_BASE_SIZE 80
-#define MODE_BITS_EXTENSION_SIZE 13
-
 // ============================================================================
 
 struct QlDspSimdPass : public Pass {
@@ -36,11 +37,18 @@ struct QlDspSimdPass : public Pass {
     void help() override
     {
         log("\n");
-        log("    ql_dsp_simd [selection]\n");
+        log("    ql_dsp_simd [options] [selection]\n");
         log("\n");
         log("    This pass identifies k6n10f DSP cells with identical configuration\n");
         log("    and packs pairs of them together into other DSP cells that can\n");
         log("    perform SIMD operation.\n");
+        log("\n");
+        log("    -locality <attribute>\n");
+        log("        Pair DSP cells with identical configuration in the order of the\n");
+        log("        values of the given attribute (eg. a placement constraint or\n");
+        log("        'src'), so that cells close to each other end up in the same\n");
+        log("        SIMD cell. Cells without the attribute are paired last. By\n");
+        log("        default cells are paired in the order they are found.\n");
     }
 
     // ..........................................
@@ -48,23 +56,41 @@ struct QlDspSimdPass : public Pass {
     /// Describes DSP config unique to a whole DSP cell
     struct DspConfig {
 
-        // Port connections
-        dict<RTLIL::IdString, RTLIL::SigSpec> connections;
+        // Connections of the config ports followed by the config parameters
+        // (for cells with configuration parameters). Each bit is either the
+        // id of its SigMap-canonical bit in the module or a negative id of a
+        // constant. Ports and parameters are terminated with kEnd.
+        std::vector<int> signals;
 
         // Whether DSPs pass configuration bits through ports of parameters
         bool use_cfg_params;
 
-        // TODO: Possibly include parameters here. For now we have just
-        // connections.
-
         DspConfig() = default;
 
         DspConfig(const DspConfig &ref) = default;
         DspConfig(DspConfig &&ref) = default;
 
-        unsigned int hash() const { return connections.hash(); }
+        unsigned int hash() const { return mkhash(hash_ops<std::vector<int>>::hash(signals), use_cfg_params); }
+
+        bool operator==(const DspConfig &ref) const { return signals == ref.signals && use_cfg_params == ref.use_cfg_params; }
+    };
+
+    /// Terminates a port or a parameter in DspConfig::signals
+    enum { kEnd = -1 };
 
-        bool operator==(const DspConfig &ref) const { return connections == ref.connections && use_cfg_params == ref.use_cfg_params; }
+    /// DSP cells of a module grouped by their configuration
+    struct ModuleGroups {
+        RTLIL::Module *module;
+        SigMap sigmap;
+        std::vector<RTLIL::Cell *> cells;
+        std::vector<std::vector<RTLIL::Cell *>> groups;
+    };
+
+    /// Names of the DSP ports and parameters looked up by the grouping
+    struct ConfigNames {
+        std::vector<RTLIL::IdString> ports;
+        std::vector<RTLIL::IdString> portsExpand;
+        std::vector<RTLIL::IdString> params;
     };
 
     // ..........................................
@@ -106,8 +132,8 @@ struct QlDspSimdPass : public Pass {
     const std::string m_SimdDspType_cfg_ports = "QL_DSP2";
     const std::string m_SimdDspType_cfg_params = "QL_DSP3";
 
-    /// Temporary SigBit to SigBit helper map.
-    SigMap m_SigMap;
+    /// Attribute ordering cells for pairing
+    RTLIL::IdString m_LocalityAttr;
 
     // ..........................................
 
@@ -116,17 +142,34 @@ struct QlDspSimdPass : public Pass {
         log_header(a_Design, "Executing QL_DSP_SIMD pass.\n");
 
         // Parse args
-        extra_args(a_Args, 1, a_Design);
-
-        // Process modules
-        for (auto module : a_Design->selected_modules()) {
+        m_LocalityAttr = RTLIL::IdString();
+        size_t argidx;
+        for (argidx = 1; argidx < a_Args.size(); argidx++) {
+            if (a_Args[argidx] == "-locality" && argidx + 1 < a_Args.size()) {
+                m_LocalityAttr = RTLIL::escape_id(a_Args[++argidx]);
+                continue;
+            }
+            break;
+        }
+        extra_args(a_Args, argidx, a_Design);
 
-            // Setup the SigMap
-            m_SigMap.clear();
-            m_SigMap.set(module);
+        // Look up the names once rather than for every cell
+        ConfigNames names;
+        for (const auto &it : m_DspCfgPorts) {
+            names.ports.push_back(RTLIL::escape_id(it.first));
+        }
+        for (const auto &it : m_DspCfgPorts_expand) {
+            names.portsExpand.push_back(RTLIL::escape_id(it.first));
+        }
+        for (const auto &it : m_DspParams2Mode) {
+            names.params.push_back(RTLIL::escape_id(it));
+        }
 
-            // Assemble DSP cell groups
-            dict<DspConfig, std::vector<RTLIL::Cell *>> groups;
+        // Collect DSP cells of the selected modules
+        std::vector<ModuleGroups> modules;
+        for (auto module : a_Design->selected_modules()) {
+            ModuleGroups moduleGroups;
+            moduleGroups.module = module;
             for (auto cell : module->selected_cells()) {
 
                 // Check if this is a DSP cell we are looking for (type starts with m_SisdDspType)
@@ -139,19 +182,34 @@ struct QlDspSimdPass : public Pass {
                     continue;
                 }
 
-                // Add to a group
-                const auto key = getDspConfig(cell);
-                groups[key].push_back(cell);
+                moduleGroups.cells.push_back(cell);
+            }
+            if (!moduleGroups.cells.empty()) {
+                modules.push_back(std::move(moduleGroups));
+            }
+        }
+
+        // Assemble DSP cell groups
+        for (auto &moduleGroups : modules) {
+            groupCells(moduleGroups, names);
+        }
+
+        // Process modules
+        for (auto &moduleGroups : modules) {
+            auto module = moduleGroups.module;
+
+            if (!m_LocalityAttr.empty()) {
+                for (auto &group : moduleGroups.groups) {
+                    sortByLocality(group);
+                }
             }
 
             std::vector<const RTLIL::Cell *> cellsToRemove;
 
             // Map cell pairs to the target DSP SIMD cell
-            for (const auto &it : groups) {
-                const auto &group = it.second;
-                const auto &config = it.first;
-
-                bool use_cfg_params = config.use_cfg_params;
+            size_t simdCount = 0;
+            for (const auto &group : moduleGroups.groups) {
+                bool use_cfg_params = isCfgParamsType(group.front());
                 // Ensure an even number
                 size_t count = group.size();
                 if (count & 1)
@@ -162,7 +220,11 @@ struct QlDspSimdPass : public Pass {
                     const RTLIL::Cell *dsp_a = group[i];
                     const RTLIL::Cell *dsp_b = group[i + 1];
 
-                    std::string name = stringf("simd%ld", i / 2);
+                    // Names are unique in the whole module
+                    std::string name;
+                    do {
+                        name = stringf("simd%zu", simdCount++);
+                    } while (module->cell(RTLIL::escape_id(name)) != nullptr);
                     std::string SimdDspType;
 
                     if (use_cfg_params)
@@ -192,7 +254,11 @@ struct QlDspSimdPass : public Pass {
                         auto sport = RTLIL::escape_id(it.first);
                         auto dport = RTLIL::escape_id(it.second);
 
-                        simd->setPort(dport, config.connections.at(sport));
+                        if (dsp_a->hasPort(sport)) {
+                            simd->setPort(dport, moduleGroups.sigmap(dsp_a->getPort(sport)));
+                        } else {
+                            simd->setPort(dport, RTLIL::SigSpec(RTLIL::Sx));
+                        }
                     }
 
                     // Connect data ports
@@ -282,8 +348,6 @@ struct QlDspSimdPass : public Pass {
             }
         }
 
-        // Clear
-        m_SigMap.clear();
     }
 
     // ..........................................
@@ -312,46 +376,107 @@ struct QlDspSimdPass : public Pass {
         return std::make_pair(wire->width, wire->port_output);
     }
 
+    /// Returns true if the DSP cell passes configuration bits through parameters
+    bool isCfgParamsType(const RTLIL::Cell *a_Cell)
+    {
+        const std::string &cell_type = a_Cell->type.str();
+        const std::string &suffix = m_SisdDspType_cfg_params_suffix;
+
+        return cell_type.size() >= suffix.size() && 0 == cell_type.compare(cell_type.size() - suffix.size(), suffix.size(), suffix);
+    }
+
     /// Given a DSP cell populates and returns a DspConfig struct for it.
-    DspConfig getDspConfig(RTLIL::Cell *a_Cell)
+    DspConfig getDspConfig(const RTLIL::Cell *a_Cell, const SigMap &a_SigMap, dict<RTLIL::SigBit, int> &a_BitIds, const ConfigNames &a_Names)
     {
         DspConfig config;
+        config.use_cfg_params = isCfgParamsType(a_Cell);
 
-        string cell_type = a_Cell->type.str();
-        string suffix = m_SisdDspType_cfg_params_suffix;
+        auto addPort = [&](const RTLIL::IdString &port) {
 
-        bool use_cfg_params = cell_type.size() >= suffix.size() && 0 == cell_type.compare(cell_type.size() - suffix.size(), suffix.size(), suffix);
+            // Port unconnected
+            if (!a_Cell->hasPort(port)) {
+                config.signals.push_back(constantId(RTLIL::Sx));
+                config.signals.push_back(kEnd);
+                return;
+            }
 
-        std::vector<std::pair<std::string, std::string>> DspCfgPorts = m_DspCfgPorts;
-        if (!use_cfg_params)
-            DspCfgPorts.insert(DspCfgPorts.end(), m_DspCfgPorts_expand.begin(), m_DspCfgPorts_expand.end());
+            // Map the port connection to unique SigBits
+            for (auto bit : a_SigMap(a_Cell->getPort(port))) {
+                if (bit.wire == nullptr) {
+                    config.signals.push_back(constantId(bit.data));
+                } else {
+                    config.signals.push_back(a_BitIds.insert(std::make_pair(bit, (int)a_BitIds.size())).first->second);
+                }
+            }
+            config.signals.push_back(kEnd);
+        };
 
-        config.use_cfg_params = use_cfg_params;
+        for (const auto &port : a_Names.ports) {
+            addPort(port);
+        }
 
-        for (const auto &it : DspCfgPorts) {
-            auto port = RTLIL::escape_id(it.first);
+        if (!config.use_cfg_params) {
+            for (const auto &port : a_Names.portsExpand) {
+                addPort(port);
+            }
+            return config;
+        }
 
-            // Port unconnected
-            if (!a_Cell->hasPort(port)) {
-                config.connections[port] = RTLIL::SigSpec(RTLIL::Sx);
-                continue;
+        // The configuration parameters have to match as well
+        for (const auto &name : a_Names.params) {
+            auto param = a_Cell->parameters.find(name);
+            if (param != a_Cell->parameters.end()) {
+                for (auto bit : param->second.bits) {
+                    config.signals.push_back(constantId(bit));
+                }
             }
+            config.signals.push_back(kEnd);
+        }
+
+        return config;
+    }
 
-            // Get the port connection and map it to unique SigBits
-            const auto &orgSigSpec = a_Cell->getPort(port);
-            const auto &orgSigBits = orgSigSpec.bits();
+    /// Returns a negative id for a constant bit, distinct from kEnd
+    static int constantId(RTLIL::State a_State) { return -2 - (int)a_State; }
 
-            RTLIL::SigSpec newSigSpec;
-            for (size_t i = 0; i < orgSigBits.size(); ++i) {
-                auto newSigBit = m_SigMap(orgSigBits[i]);
-                newSigSpec.append(newSigBit);
+    /// Groups the DSP cells of a module by their configuration
+    void groupCells(ModuleGroups &a_Module, const ConfigNames &a_Names)
+    {
+        a_Module.sigmap.set(a_Module.module);
+
+        dict<RTLIL::SigBit, int> bitIds;
+        dict<DspConfig, int> groupIds;
+        for (auto cell : a_Module.cells) {
+            auto key = getDspConfig(cell, a_Module.sigmap, bitIds, a_Names);
+            auto it = groupIds.find(key);
+            if (it == groupIds.end()) {
+                it = groupIds.insert(std::make_pair(std::move(key), (int)a_Module.groups.size())).first;
+                a_Module.groups.emplace_back();
             }
+            a_Module.groups[it->second].push_back(cell);
+        }
+    }
 
-            // Store
-            config.connections[port] = newSigSpec;
+    /// Orders DSP cells by the value of the locality attribute
+    void sortByLocality(std::vector<RTLIL::Cell *> &a_Cells)
+    {
+        std::vector<std::pair<std::string, RTLIL::Cell *>> keyed;
+        std::vector<RTLIL::Cell *> unplaced;
+        for (auto cell : a_Cells) {
+            if (cell->has_attribute(m_LocalityAttr)) {
+                keyed.emplace_back(cell->get_string_attribute(m_LocalityAttr), cell);
+            } else {
+                unplaced.push_back(cell);
+            }
         }
+        using Keyed = std::pair<std::string, RTLIL::Cell *>;
+        std::stable_sort(keyed.begin(), keyed.end(), [](const Keyed &a, const Keyed &b) { return a.first < b.first; });
 
-        return config;
+        a_Cells.clear();
+        for (auto &it : keyed) {
+            a_Cells.push_back(it.second);
+        }
+        a_Cells.insert(a_Cells.end(), unplaced.begin(), unplaced.end());
     }
 
 } QlDspSimdPass;
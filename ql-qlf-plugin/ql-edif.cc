@@ -25,34 +25,38 @@
 #include "kernel/register.h"
 #include "kernel/rtlil.h"
 #include "kernel/sigtools.h"
+#include <algorithm>
 #include <string>
+#include <thread>
+#include <tuple>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
 #define EDIF_DEF(_id) edif_names(RTLIL::unescape_id(_id), true).c_str()
-#define EDIF_DEFR(_id, _ren, _bl, _br) edif_names(RTLIL::unescape_id(_id), true, _ren, _bl, _br).c_str()
 #define EDIF_REF(_id) edif_names(RTLIL::unescape_id(_id), false).c_str()
 
 struct EdifNames {
     int counter;
     char delim_left, delim_right;
-    std::set<std::string> generated_names, used_names;
-    std::map<std::string, std::string> name_map;
+    pool<std::string> generated_names, used_names;
+    dict<std::string, std::string> name_map;
+
+    // Escaped forms of identifiers, memoized per IdString so that cell types,
+    // ports and parameters emitted many times are only mangled once
+    struct CachedName {
+        std::string ref, def;
+    };
+    dict<RTLIL::IdString, CachedName> id_cache;
+    int cache_hits = 0;
 
     EdifNames() : counter(1), delim_left('['), delim_right(']') {}
 
-    std::string operator()(std::string id, bool define, bool port_rename = false, int range_left = 0, int range_right = 0)
+    // Assigns an EDIF identifier to the name unless it already has one
+    void resolve(const std::string &id)
     {
-        if (define) {
-            std::string new_id = operator()(id, false);
-            if (port_rename)
-                return stringf("(rename %s \"%s%c%d:%d%c\")", new_id.c_str(), id.c_str(), delim_left, range_left, range_right, delim_right);
-            return new_id != id ? stringf("(rename %s \"%s\")", new_id.c_str(), id.c_str()) : id;
-        }
-
-        if (name_map.count(id) > 0)
-            return name_map.at(id);
+        if (name_map.count(id) > 0 || used_names.count(id) > 0)
+            return;
         if (generated_names.count(id) > 0)
             goto do_rename;
         if (id == "GND" || id == "VCC")
@@ -71,7 +75,7 @@ struct EdifNames {
         }
 
         used_names.insert(id);
-        return id;
+        return;
 
     do_rename:;
         std::string gen_name;
@@ -82,10 +86,529 @@ struct EdifNames {
         }
         generated_names.insert(gen_name);
         name_map[id] = gen_name;
-        return gen_name;
+    }
+
+    // Returns the EDIF form of a name passed to resolve() before. Doesn't
+    // modify the table so module writers may share it once it is frozen.
+    std::string get(const std::string &id, bool define, bool port_rename = false, int range_left = 0, int range_right = 0) const
+    {
+        auto it = name_map.find(id);
+        const std::string &new_id = it != name_map.end() ? it->second : id;
+        if (!define)
+            return new_id;
+        if (port_rename)
+            return stringf("(rename %s \"%s%c%d:%d%c\")", new_id.c_str(), id.c_str(), delim_left, range_left, range_right, delim_right);
+        return new_id != id ? stringf("(rename %s \"%s\")", new_id.c_str(), id.c_str()) : id;
+    }
+
+    std::string operator()(const std::string &id, bool define, bool port_rename = false, int range_left = 0, int range_right = 0)
+    {
+        resolve(id);
+        return get(id, define, port_rename, range_left, range_right);
+    }
+
+    const CachedName &resolve(const RTLIL::IdString &id)
+    {
+        auto it = id_cache.find(id);
+        if (it != id_cache.end()) {
+            cache_hits++;
+            return it->second;
+        }
+        std::string name = RTLIL::unescape_id(id);
+        resolve(name);
+        return id_cache[id] = CachedName{get(name, false), get(name, true)};
+    }
+
+    // Escaped form of an identifier passed to resolve() before
+    const CachedName &lookup(const RTLIL::IdString &id) const { return id_cache.at(id); }
+
+    // Hashlib tables rehash lazily on the first lookup after an insertion,
+    // even through a const reference. Doing one lookup here after all names
+    // have been resolved makes the later lookups read-only, so that they can
+    // run concurrently.
+    void freeze() const
+    {
+        name_map.count(std::string());
+        id_cache.count(RTLIL::IdString());
+    }
+};
+
+// Append-only output buffer. Numbers are formatted in place instead of going
+// through a temporary string. A discarding buffer only evaluates its inputs,
+// which lets the name resolution pass share the code of the writer.
+struct EdifBuffer {
+    std::string data;
+    bool discard = false;
+
+    EdifBuffer &operator<<(const std::string &str)
+    {
+        if (!discard)
+            data.append(str);
+        return *this;
+    }
+    EdifBuffer &operator<<(const char *str)
+    {
+        if (!discard)
+            data.append(str);
+        return *this;
+    }
+    EdifBuffer &operator<<(char c)
+    {
+        if (!discard)
+            data.push_back(c);
+        return *this;
+    }
+    EdifBuffer &operator<<(int value)
+    {
+        if (value < 0)
+            return *this << '-' << (unsigned)(-(long long)value);
+        return *this << (unsigned)value;
+    }
+    EdifBuffer &operator<<(unsigned value)
+    {
+        if (!discard) {
+            char buf[16];
+            char *end = buf + sizeof(buf), *begin = end;
+            do {
+                *--begin = '0' + value % 10;
+                value /= 10;
+            } while (value);
+            data.append(begin, end - begin);
+        }
+        return *this;
+    }
+};
+
+struct EdifOptions {
+    bool port_rename = false;
+    bool attr_properties = false;
+    bool nogndvcc = false, gndvccy = false, keepmode = false;
+    std::map<RTLIL::IdString, std::map<RTLIL::IdString, int>> lib_cell_ports;
+};
+
+// A module port bit (cell == nullptr) or a cell port bit joined to a net
+struct EdifRef {
+    RTLIL::Wire *wire;
+    RTLIL::Cell *cell;
+    const RTLIL::IdString *port;
+    int index; // -1 for single-bit ports
+    bool driver;
+};
+
+struct EdifNet {
+    RTLIL::SigBit sig;
+    std::vector<EdifRef> refs;
+};
+
+// Direction and declared width of a cell port connection
+struct EdifPort {
+    bool output;
+    int width; // -1 if the cell type has no module with the port
+};
+
+// Nets of a module in the order they are first seen, keyed by their
+// canonical bit
+struct EdifModule {
+    RTLIL::Module *module = nullptr;
+    // Cell port connections in the order of cells() and connections()
+    std::vector<EdifPort> ports;
+    SigMap sigmap;
+    dict<RTLIL::SigBit, int> net_ids;
+    std::vector<EdifNet> nets;
+    std::vector<std::tuple<RTLIL::Cell *, const RTLIL::IdString *, int, RTLIL::SigBit>> unconnected;
+    std::string text;
+
+    EdifNet &net(const RTLIL::SigBit &bit)
+    {
+        auto it = net_ids.find(bit);
+        if (it != net_ids.end())
+            return nets[it->second];
+        net_ids[bit] = GetSize(nets);
+        nets.push_back(EdifNet{bit, {}});
+        return nets.back();
+    }
+};
+
+// Looks up the directions and widths of the cell ports of a module. Cell::output
+// copies IdStrings and reads the shared cell type and module tables, so this
+// runs on the main thread before the nets are collected.
+static void collect_ports(EdifModule &em, RTLIL::Design *design)
+{
+    for (auto cell : em.module->cells()) {
+        RTLIL::Module *type_module = design->module(cell->type);
+        for (auto &conn : cell->connections()) {
+            RTLIL::Wire *w = type_module ? type_module->wire(conn.first) : nullptr;
+            em.ports.push_back(EdifPort{cell->output(conn.first), w ? GetSize(w) : -1});
+        }
+    }
+}
+
+// Builds the net table of a module. Only touches the module itself and the
+// ports collected before, so modules are processed in parallel.
+static void collect_nets(EdifModule &em)
+{
+    RTLIL::Module *module = em.module;
+    SigMap &sigmap = em.sigmap;
+    sigmap.set(module);
+
+    size_t port = 0;
+    for (auto cell : module->cells()) {
+        for (auto &conn : cell->connections())
+            if (em.ports[port++].output)
+                sigmap.add(conn.second);
+    }
+
+    for (auto wire : module->wires())
+        for (auto b1 : SigSpec(wire)) {
+            auto b2 = sigmap(b1);
+
+            if (b1 == b2 || !b2.wire)
+                continue;
+
+            log_assert(b1.wire != nullptr);
+
+            Wire *w1 = b1.wire;
+            Wire *w2 = b2.wire;
+
+            {
+                int c1 = w1->get_bool_attribute(ID::keep);
+                int c2 = w2->get_bool_attribute(ID::keep);
+
+                if (c1 > c2)
+                    goto promote;
+                if (c1 < c2)
+                    goto nopromote;
+            }
+
+            {
+                int c1 = w1->name.isPublic();
+                int c2 = w2->name.isPublic();
+
+                if (c1 > c2)
+                    goto promote;
+                if (c1 < c2)
+                    goto nopromote;
+            }
+
+            {
+                auto count_nontrivial_attr = [](Wire *w) {
+                    int count = w->attributes.size();
+                    count -= w->attributes.count(ID::src);
+                    count -= w->attributes.count(ID::unused_bits);
+                    return count;
+                };
+
+                int c1 = count_nontrivial_attr(w1);
+                int c2 = count_nontrivial_attr(w2);
+
+                if (c1 > c2)
+                    goto promote;
+                if (c1 < c2)
+                    goto nopromote;
+            }
+
+            {
+                int c1 = w1->port_id ? INT_MAX - w1->port_id : 0;
+                int c2 = w2->port_id ? INT_MAX - w2->port_id : 0;
+
+                if (c1 > c2)
+                    goto promote;
+                if (c1 < c2)
+                    goto nopromote;
+            }
+
+        nopromote:
+            if (0)
+            promote:
+                sigmap.add(b1);
+        }
+
+    for (auto wire : module->wires()) {
+        if (wire->port_id == 0)
+            continue;
+        for (int i = 0; i < wire->width; i++) {
+            int index = wire->width == 1 ? -1 : wire->width - i - 1;
+            em.net(sigmap(RTLIL::SigBit(wire, i))).refs.push_back(EdifRef{wire, nullptr, nullptr, index, wire->port_input});
+        }
+    }
+
+    port = 0;
+    for (auto cell : module->cells()) {
+        for (auto &p : cell->connections()) {
+            RTLIL::SigSpec sig = sigmap(p.second);
+            const EdifPort &info = em.ports[port++];
+            int width = info.width >= 0 ? info.width : GetSize(sig);
+            bool driver = info.output;
+            for (int i = 0; i < GetSize(sig); i++) {
+                RTLIL::SigBit bit = sig[i];
+                if (bit.wire == nullptr && bit != RTLIL::State::S0 && bit != RTLIL::State::S1) {
+                    em.unconnected.emplace_back(cell, &p.first, i, bit);
+                    continue;
+                }
+                em.net(bit).refs.push_back(EdifRef{nullptr, cell, &p.first, width == 1 ? -1 : i, driver});
+            }
+        }
+    }
+}
+
+// Name of the net of a wire bit, the same as log_signal() without spaces and
+// backslashes
+static std::string net_name(const RTLIL::SigBit &bit)
+{
+    std::string name = bit.wire->name.str();
+    if (bit.wire->width != 1) {
+        int index = bit.wire->upto ? bit.wire->start_offset + bit.wire->width - bit.offset - 1 : bit.wire->start_offset + bit.offset;
+        name += '[';
+        name += std::to_string(index);
+        name += ']';
+    }
+    name.erase(std::remove_if(name.begin(), name.end(), [](char c) { return c == ' ' || c == '\\'; }), name.end());
+    return name;
+}
+
+static std::string hex_string(const RTLIL::Const &val)
+{
+    size_t size = val.bits.size();
+    std::string str((size + 3) / 4, '0');
+    for (size_t i = 0; i < str.size(); i++) {
+        int digit_value = 0;
+        for (size_t j = 0; j < 4 && 4 * i + j < size; j++)
+            if (val.bits.at(4 * i + j) == RTLIL::State::S1)
+                digit_value |= 1 << j;
+        str[str.size() - i - 1] = "0123456789abcdef"[digit_value];
+    }
+    return str;
+}
+
+// Writes the cell of a module. The writer runs twice per module: first
+// serially with a resolver and a discarding buffer to assign names in output
+// order and report problems, then on a worker thread against the read-only
+// name table to render the text.
+struct EdifModuleWriter {
+    const EdifOptions &opts;
+    const EdifNames &names;
+    EdifNames *resolver;
+    EdifBuffer &out;
+
+    std::string name(const std::string &id, bool define, bool port_rename = false, int range_left = 0, int range_right = 0)
+    {
+        if (resolver) {
+            resolver->resolve(id);
+            return std::string();
+        }
+        return names.get(id, define, port_rename, range_left, range_right);
+    }
+    const std::string &def(const RTLIL::IdString &id) { return resolver ? resolver->resolve(id).def : names.lookup(id).def; }
+    const std::string &ref(const RTLIL::IdString &id) { return resolver ? resolver->resolve(id).ref : names.lookup(id).ref; }
+
+    std::string ref_string(const EdifRef &ref) const
+    {
+        std::string str = "(portRef ";
+        str += names.lookup(ref.cell ? *ref.port : ref.wire->name).ref;
+        if (ref.index >= 0) {
+            str += '_';
+            str += std::to_string(ref.index);
+            str += '_';
+        }
+        if (ref.cell) {
+            str += " (instanceRef ";
+            str += names.lookup(ref.cell->name).ref;
+            str += ')';
+        }
+        str += ')';
+        return str;
+    }
+
+    std::vector<std::pair<std::string, bool>> joined_refs(const EdifNet &net) const
+    {
+        std::vector<std::pair<std::string, bool>> refs;
+        refs.reserve(net.refs.size());
+        for (auto &ref : net.refs)
+            refs.emplace_back(ref_string(ref), ref.driver);
+        std::sort(refs.begin(), refs.end());
+        refs.erase(std::unique(refs.begin(), refs.end()), refs.end());
+        return refs;
+    }
+
+    // LUT cells (lut_in >= 0) have their INIT parameters written as hex strings
+    void add_prop(const RTLIL::IdString &prop_name, const RTLIL::Const &val, int lut_in = -1)
+    {
+        const std::string &prop = def(prop_name);
+        if (resolver)
+            return;
+        out << "\n            (property " << prop;
+        if ((val.flags & RTLIL::CONST_FLAG_STRING) != 0)
+            out << " (string \"" << val.decode_string() << "\"))";
+        else if (val.bits.size() <= 32 && val.is_fully_def()) {
+            if (lut_in >= 0 && strstr(prop_name.c_str(), "INIT"))
+                out << stringf(" (string \"%0*X\"))", (1 << lut_in) / 4, val.as_int());
+            else
+                out << " (integer " << (unsigned)val.as_int() << "))";
+        } else
+            out << " (string \"" << GetSize(val.bits) << "'h" << hex_string(val) << "\"))";
+    }
+
+    void write_module(EdifModule &em)
+    {
+        RTLIL::Module *module = em.module;
+
+        out << "    (cell " << def(module->name) << "\n";
+        out << "      (cellType GENERIC)\n";
+        out << "      (view VIEW_NETLIST\n";
+        out << "        (viewType NETLIST)\n";
+        out << "        (interface\n";
+
+        for (auto wire : module->wires()) {
+            if (wire->port_id == 0)
+                continue;
+            const char *dir = "INOUT";
+            if (!wire->port_output)
+                dir = "INPUT";
+            else if (!wire->port_input)
+                dir = "OUTPUT";
+            if (wire->width == 1) {
+                out << "          (port " << def(wire->name) << " (direction " << dir << ")";
+            } else {
+                int b[2];
+                b[wire->upto ? 0 : 1] = wire->start_offset;
+                b[wire->upto ? 1 : 0] = wire->start_offset + GetSize(wire) - 1;
+                const std::string &port = def(wire->name);
+                out << "          (port (array ";
+                if (opts.port_rename)
+                    out << names.get(RTLIL::unescape_id(wire->name), true, true, b[0], b[1]);
+                else
+                    out << port;
+                out << ' ' << wire->width << ") (direction " << dir << ")";
+            }
+            if (opts.attr_properties)
+                for (auto &p : wire->attributes)
+                    add_prop(p.first, p.second);
+            out << ")\n";
+        }
+
+        out << "        )\n";
+        out << "        (contents\n";
+
+        if (!opts.nogndvcc) {
+            out << "          (instance GND (viewRef VIEW_NETLIST (cellRef GND (libraryRef LIB))))\n";
+            out << "          (instance VCC (viewRef VIEW_NETLIST (cellRef VCC (libraryRef LIB))))\n";
+        }
+
+        for (auto cell : module->cells()) {
+            out << "          (instance " << def(cell->name) << "\n";
+            out << "            (viewRef VIEW_NETLIST (cellRef " << ref(cell->type);
+            out << (opts.lib_cell_ports.count(cell->type) > 0 ? " (libraryRef LIB)" : "") << "))";
+            int lut_in = -1;
+            const char *lut_pos = strstr(cell->type.c_str(), "LUT");
+            if (lut_pos)
+                lut_in = atoi(lut_pos + 3); // get the number of LUT inputs
+            for (auto &p : cell->parameters)
+                add_prop(p.first, p.second, lut_in);
+            if (opts.attr_properties)
+                for (auto &p : cell->attributes)
+                    add_prop(p.first, p.second, lut_in);
+            out << ")\n";
+            if (resolver)
+                for (auto &p : cell->connections())
+                    ref(p.first);
+        }
+
+        for (auto &net : em.nets) {
+            RTLIL::SigBit sig = net.sig;
+            if (sig.wire == nullptr && sig != RTLIL::State::S0 && sig != RTLIL::State::S1) {
+                if (sig == RTLIL::State::Sx) {
+                    if (resolver)
+                        for (auto &ref : joined_refs(net))
+                            log_warning("Exporting x-bit on %s as zero bit.\n", ref.first.c_str());
+                    sig = RTLIL::State::S0;
+                } else if (sig == RTLIL::State::Sz) {
+                    continue;
+                } else {
+                    for (auto &ref : joined_refs(net))
+                        log_error("Don't know how to handle %s on %s.\n", log_signal(sig), ref.first.c_str());
+                    log_abort();
+                }
+            }
+            if (sig.wire == nullptr && opts.nogndvcc)
+                log_error("Design contains constant nodes (map with \"hilomap\" first).\n");
+
+            std::string netname;
+            if (sig == RTLIL::State::S0)
+                netname = "GND_NET";
+            else if (sig == RTLIL::State::S1)
+                netname = "VCC_NET";
+            else
+                netname = net_name(sig);
+            out << "          (net " << name(netname, true) << " (joined\n";
+            if (!resolver)
+                for (auto &ref : joined_refs(net))
+                    out << "              " << ref.first << "\n";
+            if (sig == RTLIL::State::S0)
+                out << "            (portRef " << (opts.gndvccy ? 'Y' : 'G') << " (instanceRef GND))\n";
+            if (sig == RTLIL::State::S1)
+                out << "            (portRef " << (opts.gndvccy ? 'Y' : 'P') << " (instanceRef VCC))\n";
+            out << "            )";
+            if (opts.attr_properties && sig.wire != nullptr)
+                for (auto &p : sig.wire->attributes)
+                    add_prop(p.first, p.second);
+            out << "\n          )\n";
+        }
+
+        for (auto wire : module->wires()) {
+            if (!wire->get_bool_attribute(ID::keep))
+                continue;
+
+            for (int i = 0; i < wire->width; i++) {
+                RTLIL::SigBit raw_sig(wire, i);
+                RTLIL::SigBit mapped_sig = em.sigmap(raw_sig);
+
+                auto it = em.net_ids.find(mapped_sig);
+                if (raw_sig == mapped_sig || it == em.net_ids.end())
+                    continue;
+
+                std::string netname = net_name(raw_sig);
+
+                if (opts.keepmode) {
+                    out << "          (net " << name(netname, true) << " (joined\n";
+                    if (!resolver)
+                        for (auto &ref : joined_refs(em.nets[it->second]))
+                            if (ref.second)
+                                out << "              " << ref.first << "\n";
+                    out << "            )";
+
+                    if (opts.attr_properties)
+                        for (auto &p : wire->attributes)
+                            add_prop(p.first, p.second);
+
+                    out << "\n          )\n";
+                } else if (resolver) {
+                    resolver->resolve(netname);
+                    log_warning("Ignoring conflicting 'keep' property on net %s. Use -keep to generate the extra net nevertheless.\n",
+                                names.get(netname, true).c_str());
+                }
+            }
+        }
+
+        out << "        )\n";
+        out << "      )\n";
+        out << "    )\n";
     }
 };
 
+// Runs job(0) ... job(count - 1), each on its own thread
+template <typename Job> static void run_parallel(size_t count, const Job &job)
+{
+    if (count == 1) {
+        job(0);
+        return;
+    }
+    std::vector<std::thread> threads;
+    for (size_t i = 0; i < count; i++)
+        threads.emplace_back([&job, i]() { job(i); });
+    for (auto &thread : threads)
+        thread.join();
+}
+
 struct QLEdifBackend : public Backend {
     QLEdifBackend() : Backend("ql_edif", "write design to EDIF netlist file") {}
     void help() override
@@ -128,10 +651,7 @@ struct QLEdifBackend : public Backend {
     {
         log_header(design, "Executing QL EDIF backend.\n");
         std::string top_module_name;
-        bool port_rename = false;
-        bool attr_properties = false;
-        std::map<RTLIL::IdString, std::map<RTLIL::IdString, int>> lib_cell_ports;
-        bool nogndvcc = false, gndvccy = false, keepmode = false;
+        EdifOptions opts;
         CellTypes ct(design);
         EdifNames edif_names;
 
@@ -142,24 +662,24 @@ struct QLEdifBackend : public Backend {
                 continue;
             }
             if (args[argidx] == "-nogndvcc") {
-                nogndvcc = true;
+                opts.nogndvcc = true;
                 continue;
             }
             if (args[argidx] == "-gndvccy") {
-                gndvccy = true;
+                opts.gndvccy = true;
                 continue;
             }
             if (args[argidx] == "-attrprop") {
-                attr_properties = true;
+                opts.attr_properties = true;
                 continue;
             }
             if (args[argidx] == "-keep") {
-                keepmode = true;
+                opts.keepmode = true;
                 continue;
             }
             if (args[argidx] == "-pvector" && argidx + 1 < args.size()) {
                 std::string parray;
-                port_rename = true;
+                opts.port_rename = true;
                 parray = args[++argidx];
                 if (parray == "par") {
                     edif_names.delim_left = '(';
@@ -196,9 +716,9 @@ struct QLEdifBackend : public Backend {
 
             for (auto cell : module->cells()) {
                 if (design->module(cell->type) == nullptr || design->module(cell->type)->get_blackbox_attribute()) {
-                    lib_cell_ports[cell->type];
+                    opts.lib_cell_ports[cell->type];
                     for (auto p : cell->connections())
-                        lib_cell_ports[cell->type][p.first] = GetSize(p.second);
+                        opts.lib_cell_ports[cell->type][p.first] = GetSize(p.second);
                 }
             }
         }
@@ -206,40 +726,41 @@ struct QLEdifBackend : public Backend {
         if (top_module_name.empty())
             log_error("No module found in design!\n");
 
-        *f << stringf("(edif %s\n", EDIF_DEF(top_module_name));
-        *f << stringf("  (edifVersion 2 0 0)\n");
-        *f << stringf("  (edifLevel 0)\n");
-        *f << stringf("  (keywordMap (keywordLevel 0))\n");
-        *f << stringf("  (comment \"Generated by %s\")\n", yosys_version_str);
-
-        *f << stringf("  (external LIB\n");
-        *f << stringf("    (edifLevel 0)\n");
-        *f << stringf("    (technology (numberDefinition))\n");
-
-        if (!nogndvcc) {
-            *f << stringf("    (cell GND\n");
-            *f << stringf("      (cellType GENERIC)\n");
-            *f << stringf("      (view VIEW_NETLIST\n");
-            *f << stringf("        (viewType NETLIST)\n");
-            *f << stringf("        (interface (port %c (direction OUTPUT)))\n", gndvccy ? 'Y' : 'G');
-            *f << stringf("      )\n");
-            *f << stringf("    )\n");
-
-            *f << stringf("    (cell VCC\n");
-            *f << stringf("      (cellType GENERIC)\n");
-            *f << stringf("      (view VIEW_NETLIST\n");
-            *f << stringf("        (viewType NETLIST)\n");
-            *f << stringf("        (interface (port %c (direction OUTPUT)))\n", gndvccy ? 'Y' : 'P');
-            *f << stringf("      )\n");
-            *f << stringf("    )\n");
+        EdifBuffer out;
+        out << "(edif " << EDIF_DEF(top_module_name) << "\n";
+        out << "  (edifVersion 2 0 0)\n";
+        out << "  (edifLevel 0)\n";
+        out << "  (keywordMap (keywordLevel 0))\n";
+        out << "  (comment \"Generated by " << yosys_version_str << "\")\n";
+
+        out << "  (external LIB\n";
+        out << "    (edifLevel 0)\n";
+        out << "    (technology (numberDefinition))\n";
+
+        if (!opts.nogndvcc) {
+            out << "    (cell GND\n";
+            out << "      (cellType GENERIC)\n";
+            out << "      (view VIEW_NETLIST\n";
+            out << "        (viewType NETLIST)\n";
+            out << "        (interface (port " << (opts.gndvccy ? 'Y' : 'G') << " (direction OUTPUT)))\n";
+            out << "      )\n";
+            out << "    )\n";
+
+            out << "    (cell VCC\n";
+            out << "      (cellType GENERIC)\n";
+            out << "      (view VIEW_NETLIST\n";
+            out << "        (viewType NETLIST)\n";
+            out << "        (interface (port " << (opts.gndvccy ? 'Y' : 'P') << " (direction OUTPUT)))\n";
+            out << "      )\n";
+            out << "    )\n";
         }
 
-        for (auto &cell_it : lib_cell_ports) {
-            *f << stringf("    (cell %s\n", EDIF_DEF(cell_it.first));
-            *f << stringf("      (cellType GENERIC)\n");
-            *f << stringf("      (view VIEW_NETLIST\n");
-            *f << stringf("        (viewType NETLIST)\n");
-            *f << stringf("        (interface\n");
+        for (auto &cell_it : opts.lib_cell_ports) {
+            out << "    (cell " << edif_names.resolve(cell_it.first).def << "\n";
+            out << "      (cellType GENERIC)\n";
+            out << "      (view VIEW_NETLIST\n";
+            out << "        (viewType NETLIST)\n";
+            out << "        (interface\n";
             for (auto &port_it : cell_it.second) {
                 const char *dir = "INOUT";
                 if (ct.cell_known(cell_it.first)) {
@@ -258,20 +779,19 @@ struct QLEdifBackend : public Backend {
                         start = w->start_offset;
                     }
                 }
+                const std::string &port = edif_names.resolve(port_it.first).def;
                 if (width == 1)
-                    *f << stringf("          (port %s (direction %s))\n", EDIF_DEF(port_it.first), dir);
+                    out << "          (port " << port << " (direction " << dir << "))\n";
                 else {
-                    for (int b = start; b < start + width; b++) {
-                        *f << stringf("          (port (rename %s_%d_ \"%s(%d)\") (direction %s))\n", EDIF_DEF(port_it.first), b,
-                                      EDIF_DEF(port_it.first), b, dir);
-                    }
+                    for (int b = start; b < start + width; b++)
+                        out << "          (port (rename " << port << '_' << b << "_ \"" << port << '(' << b << ")\") (direction " << dir << "))\n";
                 }
             }
-            *f << stringf("        )\n");
-            *f << stringf("      )\n");
-            *f << stringf("    )\n");
+            out << "        )\n";
+            out << "      )\n";
+            out << "    )\n";
         }
-        *f << stringf("  )\n");
+        out << "  )\n";
 
         std::vector<RTLIL::Module *> sorted_modules;
 
@@ -302,330 +822,63 @@ struct QLEdifBackend : public Backend {
                 module_deps.erase(sorted_modules.at(sorted_modules_idx++));
         }
 
-        *f << stringf("  (library DESIGN\n");
-        *f << stringf("    (edifLevel 0)\n");
-        *f << stringf("    (technology (numberDefinition))\n");
-
-        auto add_prop = [&](IdString name, Const val) {
-            if ((val.flags & RTLIL::CONST_FLAG_STRING) != 0)
-                *f << stringf("\n            (property %s (string \"%s\"))", EDIF_DEF(name), val.decode_string().c_str());
-            else if (val.bits.size() <= 32 && RTLIL::SigSpec(val).is_fully_def()) {
-                *f << stringf("\n            (property %s (integer %u))", EDIF_DEF(name), val.as_int());
-            } else {
-                std::string hex_string = "";
-                for (size_t i = 0; i < val.bits.size(); i += 4) {
-                    int digit_value = 0;
-                    if (i + 0 < val.bits.size() && val.bits.at(i + 0) == RTLIL::State::S1)
-                        digit_value |= 1;
-                    if (i + 1 < val.bits.size() && val.bits.at(i + 1) == RTLIL::State::S1)
-                        digit_value |= 2;
-                    if (i + 2 < val.bits.size() && val.bits.at(i + 2) == RTLIL::State::S1)
-                        digit_value |= 4;
-                    if (i + 3 < val.bits.size() && val.bits.at(i + 3) == RTLIL::State::S1)
-                        digit_value |= 8;
-                    char digit_str[2] = {"0123456789abcdef"[digit_value], 0};
-                    hex_string = std::string(digit_str) + hex_string;
-                }
-                *f << stringf("\n            (property %s (string \"%d'h%s\"))", EDIF_DEF(name), GetSize(val.bits), hex_string.c_str());
-            }
-        };
-        auto add_lut_prop = [&](IdString name, Const val, int lut_in) {
-            if ((val.flags & RTLIL::CONST_FLAG_STRING) != 0)
-                *f << stringf("\n            (property %s (string \"%s\"))", EDIF_DEF(name), val.decode_string().c_str());
-            else if (val.bits.size() <= 32 && RTLIL::SigSpec(val).is_fully_def()) {
-                if (strstr(name.c_str(), "INIT")) {
-                    int hex_code_width = ((1 << lut_in) / 4);
-                    *f << stringf("\n            (property %s (string \"%0*X\"))", EDIF_DEF(name), hex_code_width, val.as_int());
-                } else {
-                    *f << stringf("\n            (property %s (integer %u))", EDIF_DEF(name), val.as_int());
-                }
-            } else {
-                std::string hex_string = "";
-                for (size_t i = 0; i < val.bits.size(); i += 4) {
-                    int digit_value = 0;
-                    if (i + 0 < val.bits.size() && val.bits.at(i + 0) == RTLIL::State::S1)
-                        digit_value |= 1;
-                    if (i + 1 < val.bits.size() && val.bits.at(i + 1) == RTLIL::State::S1)
-                        digit_value |= 2;
-                    if (i + 2 < val.bits.size() && val.bits.at(i + 2) == RTLIL::State::S1)
-                        digit_value |= 4;
-                    if (i + 3 < val.bits.size() && val.bits.at(i + 3) == RTLIL::State::S1)
-                        digit_value |= 8;
-                    char digit_str[2] = {"0123456789abcdef"[digit_value], 0};
-                    hex_string = std::string(digit_str) + hex_string;
-                }
-                *f << stringf("\n            (property %s (string \"%d'h%s\"))", EDIF_DEF(name), GetSize(val.bits), hex_string.c_str());
-            }
-        };
-        for (auto module : sorted_modules) {
-            if (module->get_blackbox_attribute())
-                continue;
-
-            SigMap sigmap(module);
-            std::map<RTLIL::SigSpec, std::set<std::pair<std::string, bool>>> net_join_db;
-
-            *f << stringf("    (cell %s\n", EDIF_DEF(module->name));
-            *f << stringf("      (cellType GENERIC)\n");
-            *f << stringf("      (view VIEW_NETLIST\n");
-            *f << stringf("        (viewType NETLIST)\n");
-            *f << stringf("        (interface\n");
-
-            for (auto cell : module->cells()) {
-                for (auto &conn : cell->connections())
-                    if (cell->output(conn.first))
-                        sigmap.add(conn.second);
+        out << "  (library DESIGN\n";
+        out << "    (edifLevel 0)\n";
+        out << "    (technology (numberDefinition))\n";
+        f->write(out.data.data(), out.data.size());
+        out.data.clear();
+
+        std::vector<RTLIL::Module *> modules;
+        for (auto module : sorted_modules)
+            if (!module->get_blackbox_attribute())
+                modules.push_back(module);
+
+        // Modules go through in batches: the net tables are collected and the
+        // text is rendered on worker threads, while names are assigned
+        // serially in between so that they come out the same as when writing
+        // the modules one after the other.
+        size_t workers = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t first = 0; first < modules.size(); first += workers) {
+            std::vector<EdifModule> batch(std::min(workers, modules.size() - first));
+            for (size_t i = 0; i < batch.size(); i++)
+                batch[i].module = modules[first + i];
+
+            for (auto &em : batch)
+                collect_ports(em, design);
+            run_parallel(batch.size(), [&](size_t i) { collect_nets(batch[i]); });
+
+            EdifBuffer discard;
+            discard.discard = true;
+            for (auto &em : batch) {
+                for (auto &it : em.unconnected)
+                    log_warning("Bit %d of cell port %s.%s.%s driven by %s will be left unconnected in EDIF output.\n", std::get<2>(it),
+                                log_id(em.module), log_id(std::get<0>(it)), log_id(*std::get<1>(it)), log_signal(std::get<3>(it)));
+                EdifModuleWriter{opts, edif_names, &edif_names, discard}.write_module(em);
             }
 
-            for (auto wire : module->wires())
-                for (auto b1 : SigSpec(wire)) {
-                    auto b2 = sigmap(b1);
-
-                    if (b1 == b2 || !b2.wire)
-                        continue;
-
-                    log_assert(b1.wire != nullptr);
-
-                    Wire *w1 = b1.wire;
-                    Wire *w2 = b2.wire;
-
-                    {
-                        int c1 = w1->get_bool_attribute(ID::keep);
-                        int c2 = w2->get_bool_attribute(ID::keep);
-
-                        if (c1 > c2)
-                            goto promote;
-                        if (c1 < c2)
-                            goto nopromote;
-                    }
-
-                    {
-                        int c1 = w1->name.isPublic();
-                        int c2 = w2->name.isPublic();
-
-                        if (c1 > c2)
-                            goto promote;
-                        if (c1 < c2)
-                            goto nopromote;
-                    }
+            edif_names.freeze();
+            run_parallel(batch.size(), [&](size_t i) {
+                EdifBuffer buffer;
+                EdifModuleWriter{opts, edif_names, nullptr, buffer}.write_module(batch[i]);
+                batch[i].text = std::move(buffer.data);
+            });
 
-                    {
-                        auto count_nontrivial_attr = [](Wire *w) {
-                            int count = w->attributes.size();
-                            count -= w->attributes.count(ID::src);
-                            count -= w->attributes.count(ID::unused_bits);
-                            return count;
-                        };
-
-                        int c1 = count_nontrivial_attr(w1);
-                        int c2 = count_nontrivial_attr(w2);
-
-                        if (c1 > c2)
-                            goto promote;
-                        if (c1 < c2)
-                            goto nopromote;
-                    }
-
-                    {
-                        int c1 = w1->port_id ? INT_MAX - w1->port_id : 0;
-                        int c2 = w2->port_id ? INT_MAX - w2->port_id : 0;
-
-                        if (c1 > c2)
-                            goto promote;
-                        if (c1 < c2)
-                            goto nopromote;
-                    }
-
-                nopromote:
-                    if (0)
-                    promote:
-                        sigmap.add(b1);
-                }
-
-            for (auto wire : module->wires()) {
-                if (wire->port_id == 0)
-                    continue;
-                const char *dir = "INOUT";
-                if (!wire->port_output)
-                    dir = "INPUT";
-                else if (!wire->port_input)
-                    dir = "OUTPUT";
-                if (wire->width == 1) {
-                    *f << stringf("          (port %s (direction %s)", EDIF_DEF(wire->name), dir);
-                    if (attr_properties)
-                        for (auto &p : wire->attributes)
-                            add_prop(p.first, p.second);
-                    *f << ")\n";
-                    RTLIL::SigSpec sig = sigmap(RTLIL::SigSpec(wire));
-                    net_join_db[sig].insert(make_pair(stringf("(portRef %s)", EDIF_REF(wire->name)), wire->port_input));
-                } else {
-                    int b[2];
-                    b[wire->upto ? 0 : 1] = wire->start_offset;
-                    b[wire->upto ? 1 : 0] = wire->start_offset + GetSize(wire) - 1;
-                    *f << stringf("          (port (array %s %d) (direction %s)", EDIF_DEFR(wire->name, port_rename, b[0], b[1]), wire->width, dir);
-                    if (attr_properties)
-                        for (auto &p : wire->attributes)
-                            add_prop(p.first, p.second);
-
-                    *f << ")\n";
-                    for (int i = 0; i < wire->width; i++) {
-                        RTLIL::SigSpec sig = sigmap(RTLIL::SigSpec(wire, i));
-                        net_join_db[sig].insert(
-                          make_pair(stringf("(portRef %s_%d_)", EDIF_REF(wire->name), GetSize(wire) - i - 1), wire->port_input));
-                    }
-                }
-            }
-
-            *f << stringf("        )\n");
-            *f << stringf("        (contents\n");
-
-            if (!nogndvcc) {
-                *f << stringf("          (instance GND (viewRef VIEW_NETLIST (cellRef GND (libraryRef LIB))))\n");
-                *f << stringf("          (instance VCC (viewRef VIEW_NETLIST (cellRef VCC (libraryRef LIB))))\n");
-            }
-
-            for (auto cell : module->cells()) {
-                *f << stringf("          (instance %s\n", EDIF_DEF(cell->name));
-                *f << stringf("            (viewRef VIEW_NETLIST (cellRef %s%s))", EDIF_REF(cell->type),
-                              lib_cell_ports.count(cell->type) > 0 ? " (libraryRef LIB)" : "");
-                const char *lut_pos;
-                lut_pos = strstr(cell->type.c_str(), "LUT");
-                if (lut_pos) {
-                    int lut_in = atoi(lut_pos + 3); // get the number of LUT inputs
-                    for (auto &p : cell->parameters)
-                        add_lut_prop(p.first, p.second, lut_in);
-                    if (attr_properties)
-                        for (auto &p : cell->attributes)
-                            add_lut_prop(p.first, p.second, lut_in);
-                } else {
-                    for (auto &p : cell->parameters)
-                        add_prop(p.first, p.second);
-                    if (attr_properties)
-                        for (auto &p : cell->attributes)
-                            add_prop(p.first, p.second);
-                }
-
-                *f << stringf(")\n");
-                for (auto &p : cell->connections()) {
-                    RTLIL::SigSpec sig = sigmap(p.second);
-                    for (int i = 0; i < GetSize(sig); i++)
-                        if (sig[i].wire == NULL && sig[i] != RTLIL::State::S0 && sig[i] != RTLIL::State::S1)
-                            log_warning("Bit %d of cell port %s.%s.%s driven by %s will be left unconnected in EDIF output.\n", i, log_id(module),
-                                        log_id(cell), log_id(p.first), log_signal(sig[i]));
-                        else {
-                            int member_idx = GetSize(sig) - i - 1;
-                            auto m = design->module(cell->type);
-                            int width = sig.size();
-                            if (m) {
-                                auto w = m->wire(p.first);
-                                if (w) {
-                                    member_idx = GetSize(w) - i - 1;
-                                    width = GetSize(w);
-                                }
-                            }
-                            if (width == 1)
-                                net_join_db[sig[i]].insert(make_pair(
-                                  stringf("(portRef %s (instanceRef %s))", EDIF_REF(p.first), EDIF_REF(cell->name)), cell->output(p.first)));
-                            else {
-                                net_join_db[sig[i]].insert(make_pair(stringf("(portRef %s_%d_ (instanceRef %s))", EDIF_REF(p.first),
-                                                                             width - member_idx - 1, EDIF_REF(cell->name)), // reverse IDs
-                                                                     cell->output(p.first)));
-                            }
-                        }
-                }
-            }
-
-            for (auto &it : net_join_db) {
-                RTLIL::SigBit sig = it.first;
-                if (sig.wire == NULL && sig != RTLIL::State::S0 && sig != RTLIL::State::S1) {
-                    if (sig == RTLIL::State::Sx) {
-                        for (auto &ref : it.second)
-                            log_warning("Exporting x-bit on %s as zero bit.\n", ref.first.c_str());
-                        sig = RTLIL::State::S0;
-                    } else if (sig == RTLIL::State::Sz) {
-                        continue;
-                    } else {
-                        for (auto &ref : it.second)
-                            log_error("Don't know how to handle %s on %s.\n", log_signal(sig), ref.first.c_str());
-                        log_abort();
-                    }
-                }
-                std::string netname;
-                if (sig == RTLIL::State::S0)
-                    netname = "GND_NET";
-                else if (sig == RTLIL::State::S1)
-                    netname = "VCC_NET";
-                else {
-                    netname = log_signal(sig);
-                    for (size_t i = 0; i < netname.size(); i++)
-                        if (netname[i] == ' ' || netname[i] == '\\')
-                            netname.erase(netname.begin() + i--);
-                }
-                *f << stringf("          (net %s (joined\n", EDIF_DEF(netname));
-                for (auto &ref : it.second)
-                    *f << stringf("              %s\n", ref.first.c_str());
-                if (sig.wire == NULL) {
-                    if (nogndvcc)
-                        log_error("Design contains constant nodes (map with \"hilomap\" first).\n");
-                    if (sig == RTLIL::State::S0)
-                        *f << stringf("            (portRef %c (instanceRef GND))\n", gndvccy ? 'Y' : 'G');
-                    if (sig == RTLIL::State::S1)
-                        *f << stringf("            (portRef %c (instanceRef VCC))\n", gndvccy ? 'Y' : 'P');
-                }
-                *f << stringf("            )");
-                if (attr_properties && sig.wire != NULL)
-                    for (auto &p : sig.wire->attributes)
-                        add_prop(p.first, p.second);
-                *f << stringf("\n          )\n");
-            }
-
-            for (auto wire : module->wires()) {
-                if (!wire->get_bool_attribute(ID::keep))
-                    continue;
-
-                for (int i = 0; i < wire->width; i++) {
-                    SigBit raw_sig = RTLIL::SigSpec(wire, i);
-                    SigBit mapped_sig = sigmap(raw_sig);
-
-                    if (raw_sig == mapped_sig || net_join_db.count(mapped_sig) == 0)
-                        continue;
-
-                    std::string netname = log_signal(raw_sig);
-                    for (size_t i = 0; i < netname.size(); i++)
-                        if (netname[i] == ' ' || netname[i] == '\\')
-                            netname.erase(netname.begin() + i--);
-
-                    if (keepmode) {
-                        *f << stringf("          (net %s (joined\n", EDIF_DEF(netname));
-
-                        auto &refs = net_join_db.at(mapped_sig);
-                        for (auto &ref : refs)
-                            if (ref.second)
-                                *f << stringf("              %s\n", ref.first.c_str());
-                        *f << stringf("            )");
-
-                        if (attr_properties && raw_sig.wire != NULL)
-                            for (auto &p : raw_sig.wire->attributes)
-                                add_prop(p.first, p.second);
+            for (auto &em : batch)
+                f->write(em.text.data(), em.text.size());
+        }
 
-                        *f << stringf("\n          )\n");
-                    } else {
-                        log_warning("Ignoring conflicting 'keep' property on net %s. Use -keep to generate the extra net nevertheless.\n",
-                                    EDIF_DEF(netname));
-                    }
-                }
-            }
+        out << "  )\n";
 
-            *f << stringf("        )\n");
-            *f << stringf("      )\n");
-            *f << stringf("    )\n");
-        }
-        *f << stringf("  )\n");
+        out << "  (design " << EDIF_DEF(top_module_name) << "\n";
+        out << "    (cellRef " << EDIF_REF(top_module_name) << " (libraryRef DESIGN))\n";
+        out << "  )\n";
 
-        *f << stringf("  (design %s\n", EDIF_DEF(top_module_name));
-        *f << stringf("    (cellRef %s (libraryRef DESIGN))\n", EDIF_REF(top_module_name));
-        *f << stringf("  )\n");
+        out << ")\n";
+        f->write(out.data.data(), out.data.size());
 
-        *f << stringf(")\n");
+        int lookups = edif_names.cache_hits + GetSize(edif_names.id_cache);
+        log("Escaped %d identifier(s), name cache hit rate %.1f%% over %d lookup(s).\n", GetSize(edif_names.id_cache),
+            lookups ? 100.0 * edif_names.cache_hits / lookups : 0.0, lookups);
     }
 } QLEdifBackend;
 
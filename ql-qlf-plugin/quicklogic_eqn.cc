@@ -19,11 +19,16 @@
 
 #include "kernel/sigtools.h"
 #include "kernel/yosys.h"
+#include <thread>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
 
 struct QuicklogicEqnPass : public Pass {
+    // Distinct LUT functions below which generating equations on threads
+    // isn't worth it
+    static constexpr size_t kMinFunctionsPerWorker = 4096;
+
     QuicklogicEqnPass() : Pass("quicklogic_eqn", "Quicklogic: Calculate equations for luts") {}
     void help() override
     {
@@ -34,21 +39,22 @@ struct QuicklogicEqnPass : public Pass {
         log("\n");
     }
 
-    Const init2eqn(Const init, int inputs)
+    // Sum of products of the minterms set in the INIT value of a LUT
+    static Const init2eqn(const Const &init, int inputs)
     {
-        std::string init_bits = init.as_string();
         const char *names[] = {"I0", "I1", "I2", "I3", "I4"};
 
         std::string eqn;
-        int width = (int)pow(2, inputs);
+        int width = 1 << inputs;
+        // Minterms are taken from the most significant bits of a wider INIT
+        int offset = GetSize(init.bits) - width;
         for (int i = 0; i < width; i++) {
-            if (init_bits[width - 1 - i] == '1') {
+            if (offset + i >= 0 && init.bits[offset + i] == RTLIL::State::S1) {
                 eqn += "(";
                 for (int j = 0; j < inputs; j++) {
-                    if (i & (1 << j))
-                        eqn += names[j];
-                    else
-                        eqn += std::string("~") + names[j];
+                    if (!(i & (1 << j)))
+                        eqn += "~";
+                    eqn += names[j];
 
                     if (j != (inputs - 1))
                         eqn += "*";
@@ -58,7 +64,7 @@ struct QuicklogicEqnPass : public Pass {
         }
         if (eqn.empty())
             return Const("0");
-        eqn = eqn.substr(0, eqn.length() - 1);
+        eqn.pop_back();
         return Const(eqn);
     }
 
@@ -68,32 +74,55 @@ struct QuicklogicEqnPass : public Pass {
 
         extra_args(args, args.size(), design);
 
-        int cnt = 0;
+        const dict<RTLIL::IdString, int> lut_inputs = {{ID(LUT1), 1}, {ID(LUT2), 2}, {ID(LUT3), 3}, {ID(LUT4), 4}, {ID(LUT5), 5}};
+
+        // Mapped netlists use few distinct LUT functions, so each (inputs,
+        // INIT) pair gets its equation generated once
+        typedef std::pair<int, RTLIL::Const> LutFunction;
+        dict<LutFunction, int> function_ids;
+        std::vector<LutFunction> functions;
+        std::vector<std::pair<RTLIL::Cell *, int>> luts;
+
         for (auto module : design->selected_modules()) {
             for (auto cell : module->selected_cells()) {
-                if (cell->type == ID(LUT1)) {
-                    cell->setParam(ID(EQN), init2eqn(cell->getParam(ID::INIT), 1));
-                    cnt++;
-                }
-                if (cell->type == ID(LUT2)) {
-                    cell->setParam(ID(EQN), init2eqn(cell->getParam(ID::INIT), 2));
-                    cnt++;
-                }
-                if (cell->type == ID(LUT3)) {
-                    cell->setParam(ID(EQN), init2eqn(cell->getParam(ID::INIT), 3));
-                    cnt++;
-                }
-                if (cell->type == ID(LUT4)) {
-                    cell->setParam(ID(EQN), init2eqn(cell->getParam(ID::INIT), 4));
-                    cnt++;
-                }
-                if (cell->type == ID(LUT5)) {
-                    cell->setParam(ID(EQN), init2eqn(cell->getParam(ID::INIT), 5));
-                    cnt++;
+                auto it = lut_inputs.find(cell->type);
+                if (it == lut_inputs.end())
+                    continue;
+                LutFunction function(it->second, cell->getParam(ID::INIT));
+                auto fit = function_ids.find(function);
+                if (fit == function_ids.end()) {
+                    fit = function_ids.insert(std::make_pair(function, GetSize(functions))).first;
+                    functions.push_back(function);
                 }
+                luts.emplace_back(cell, fit->second);
+            }
+        }
+
+        // Equations are plain strings, so they are built on worker threads.
+        // The parameters are set afterwards as IdString copies aren't thread
+        // safe.
+        std::vector<RTLIL::Const> eqns(functions.size());
+        size_t workers = std::min<size_t>(std::max(1u, std::thread::hardware_concurrency()), functions.size() / kMinFunctionsPerWorker);
+        if (workers <= 1) {
+            for (size_t i = 0; i < functions.size(); i++)
+                eqns[i] = init2eqn(functions[i].second, functions[i].first);
+        } else {
+            std::vector<std::thread> threads;
+            for (size_t w = 0; w < workers; w++) {
+                threads.emplace_back([&, w]() {
+                    for (size_t i = w; i < functions.size(); i += workers)
+                        eqns[i] = init2eqn(functions[i].second, functions[i].first);
+                });
             }
+            for (auto &thread : threads)
+                thread.join();
         }
-        log_header(design, "Updated %d of LUT* elements with equation.\n", cnt);
+
+        for (auto &lut : luts)
+            lut.first->setParam(ID(EQN), eqns[lut.second]);
+
+        log("Generated %d distinct equation(s).\n", GetSize(functions));
+        log_header(design, "Updated %d of LUT* elements with equation.\n", GetSize(luts));
     }
 } QuicklogicEqnPass;
 
@@ -16,10 +16,19 @@
  * SPDX-License-Identifier: Apache-2.0
  *
  */
+#include "../common/instrumentation.h"
 #include "kernel/celltypes.h"
 #include "kernel/log.h"
 #include "kernel/register.h"
 #include "kernel/rtlil.h"
+#include "backends/rtlil/rtlil_backend.h"
+#include "libs/sha1/sha1.h"
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
 
 USING_YOSYS_NAMESPACE
 PRIVATE_NAMESPACE_BEGIN
@@ -96,6 +105,17 @@ struct SynthQuickLogicPass : public ScriptPass {
         log("        that support them. \n");
         log("        Specifying this switch turns it off.\n");
         log("\n");
+        log("    -checkpoint_dir <directory>\n");
+        log("        save the design in the given directory at the start of every label,\n");
+        log("        keyed by a hash of the options and of the input design. When a later\n");
+        log("        run without -run finds checkpoints for the same options and input\n");
+        log("        design, it resumes from the latest one instead of starting over.\n");
+        log("        With -run, the checkpoint of the first label is loaded if present.\n");
+        log("\n");
+        log("    -profile <file>\n");
+        log("        write wall time, peak RSS and cell count changes of every executed\n");
+        log("        command, and totals per label, to the given JSON file.\n");
+        log("\n");
         log("\n");
         log("The following commands are executed by this synthesis command:\n");
         help_script();
@@ -103,6 +123,8 @@ struct SynthQuickLogicPass : public ScriptPass {
     }
 
     string top_opt, edif_file, blif_file, family, currmodule, verilog_file, use_dsp_cfg_params;
+    string checkpoint_dir, checkpoint_key, output_checkpoint_key;
+    string profile_file, profile_label;
     bool nodsp;
     bool inferAdder;
     bool inferBram;
@@ -129,6 +151,189 @@ struct SynthQuickLogicPass : public ScriptPass {
         nodsp = false;
         nosdff = false;
         use_dsp_cfg_params = "";
+        checkpoint_dir = "";
+        checkpoint_key = "";
+        output_checkpoint_key = "";
+        profile_file = "";
+        profile_label = "";
+        profile_steps.clear();
+    }
+
+    // Measurements of a single command run by the script
+    struct ProfileStep {
+        std::string label, command;
+        double wall_time;
+        long peak_rss;
+        size_t cells_before, cells_after;
+    };
+
+    std::vector<ProfileStep> profile_steps;
+
+    static size_t count_cells(RTLIL::Design *design)
+    {
+        size_t count = 0;
+        for (auto module : design->modules())
+            count += module->cells().size();
+        return count;
+    }
+
+    static std::string escape_json(const std::string &str)
+    {
+        std::string escaped;
+        escaped.reserve(str.size());
+        for (char c : str) {
+            if (c == '"' || c == '\\')
+                escaped += '\\';
+            escaped += c;
+        }
+        return escaped;
+    }
+
+    // Hides ScriptPass::run() to record every command when profiling
+    void run(std::string command, std::string info = std::string())
+    {
+        if (help_mode) {
+            ScriptPass::run(command, info);
+            return;
+        }
+
+        instrumentation::ScopedTimer timer("ql-qlf.synth_quicklogic." + profile_label);
+        if (profile_file.empty()) {
+            ScriptPass::run(command, info);
+            return;
+        }
+
+        ProfileStep step;
+        step.label = profile_label;
+        step.command = command;
+        step.cells_before = count_cells(active_design);
+        const auto start = std::chrono::steady_clock::now();
+        ScriptPass::run(command, info);
+        const std::chrono::duration<double> wall_time = std::chrono::steady_clock::now() - start;
+        step.wall_time = wall_time.count();
+        step.peak_rss = instrumentation::Registry::peak_rss();
+        step.cells_after = count_cells(active_design);
+        profile_steps.push_back(step);
+    }
+
+    void write_profile()
+    {
+        std::ofstream json_file(profile_file);
+        if (!json_file.good())
+            log_cmd_error("Can't open profile file `%s' for writing.\n", profile_file.c_str());
+
+        json_file << "{\n  \"family\": \"" << escape_json(family) << "\",\n  \"steps\": [";
+        bool first = true;
+        for (const auto &step : profile_steps) {
+            json_file << (first ? "\n" : ",\n") << "    {\"label\": \"" << escape_json(step.label) << "\", \"command\": \""
+                      << escape_json(step.command) << "\", \"wall_time\": " << step.wall_time << ", \"peak_rss\": " << step.peak_rss
+                      << ", \"cells_before\": " << step.cells_before << ", \"cells_after\": " << step.cells_after << "}";
+            first = false;
+        }
+        json_file << "\n  ],\n  \"labels\": [";
+
+        // Steps of a label are consecutive, so totals are accumulated in order
+        first = true;
+        for (size_t i = 0; i < profile_steps.size();) {
+            size_t j = i;
+            double wall_time = 0;
+            for (; j < profile_steps.size() && profile_steps[j].label == profile_steps[i].label; j++)
+                wall_time += profile_steps[j].wall_time;
+            json_file << (first ? "\n" : ",\n") << "    {\"label\": \"" << escape_json(profile_steps[i].label) << "\", \"wall_time\": " << wall_time
+                      << ", \"peak_rss\": " << profile_steps[j - 1].peak_rss << ", \"cells_before\": " << profile_steps[i].cells_before
+                      << ", \"cells_after\": " << profile_steps[j - 1].cells_after << "}";
+            first = false;
+            i = j;
+        }
+        json_file << "\n  ]\n}\n";
+    }
+
+    // Labels a run can be resumed from, in script order
+    const std::vector<std::string> checkpoint_labels = {"prepare",   "coarse",    "map_bram", "map_ffram", "map_gates", "map_ffs", "map_luts",
+                                                        "map_cells", "check",     "iomap",    "finalize",  "blif",      "edif",    "verilog"};
+
+    // Labels whose checkpoint also depends on whether an EDIF netlist is
+    // written, as finalize and edif modify the design for it
+    const pool<std::string> output_checkpoint_labels = {"blif", "edif", "verilog"};
+
+    std::string checkpoint_file(const std::string &label)
+    {
+        const std::string &key = output_checkpoint_labels.count(label) ? output_checkpoint_key : checkpoint_key;
+        return checkpoint_dir + "/" + key + "-" + label + ".il";
+    }
+
+    // Like check_label(), additionally saving a checkpoint of the design
+    // before the commands of the label are run
+    bool check_stage(const std::string &label, const std::string &info = std::string())
+    {
+        if (!check_label(label, info))
+            return false;
+        profile_label = label;
+        if (!help_mode && !checkpoint_dir.empty() && label != "begin") {
+            const std::string file = checkpoint_file(label);
+            std::ifstream checkpoint_in(file);
+            if (!checkpoint_in.good()) {
+                const std::string tmp_file = file + ".tmp";
+                Pass::call(active_design, "write_rtlil " + tmp_file);
+                if (std::rename(tmp_file.c_str(), file.c_str()) != 0) {
+                    log_warning("Can't save checkpoint `%s': %s\n", file.c_str(), strerror(errno));
+                    std::remove(tmp_file.c_str());
+                }
+            }
+        }
+        return true;
+    }
+
+    // Computes the checkpoint keys and replaces the design with the latest
+    // matching checkpoint. Returns the label to resume from or an empty
+    // string if there's no usable checkpoint.
+    std::string load_checkpoint(RTLIL::Design *design, const string &run_from, const string &run_to)
+    {
+        if (mkdir(checkpoint_dir.c_str(), 0777) != 0 && errno != EEXIST)
+            log_cmd_error("Can't create checkpoint directory `%s': %s\n", checkpoint_dir.c_str(), strerror(errno));
+
+        // The keys are made of the settings the script reads, after the
+        // family defaults were applied. Names of the output files don't
+        // change the design, so they are left out.
+        SHA1 sha1;
+        sha1.update(stringf("%s\n", yosys_version_str));
+        sha1.update(stringf("%s\n%s\n%s\n%d%d%d%d%d%d%d%d\n%d\n", family.c_str(), top_opt.c_str(), use_dsp_cfg_params.c_str(), nodsp, inferAdder,
+                            inferBram, bramTypes, abcOpt, abc9, noffmap, nosdff, design->scratchpad_get_int("abc9.D", 0)));
+        std::stringstream design_dump;
+        RTLIL_BACKEND::dump_design(design_dump, design, false);
+        sha1.update(design_dump.str());
+        checkpoint_key = sha1.final();
+
+        SHA1 output_sha1;
+        output_sha1.update(checkpoint_key + (edif_file.empty() ? "\n" : "\nedif\n"));
+        output_checkpoint_key = output_sha1.final();
+
+        // Without -run resume from the latest checkpoint before the end label
+        std::vector<std::string> candidates;
+        if (run_from.empty()) {
+            for (const auto &label : checkpoint_labels) {
+                candidates.insert(candidates.begin(), label);
+                if (label == run_to)
+                    break;
+            }
+        } else {
+            candidates.push_back(run_from);
+        }
+
+        for (const auto &label : candidates) {
+            const std::string file = checkpoint_file(label);
+            std::ifstream checkpoint_in(file);
+            if (!checkpoint_in.good())
+                continue;
+            checkpoint_in.close();
+
+            log("Resuming from checkpoint %s.\n", file.c_str());
+            for (auto module : design->modules().to_vector())
+                design->remove(module);
+            run_frontend(file, "rtlil", design);
+            return label;
+        }
+        return std::string();
     }
 
     void execute(std::vector<std::string> args, RTLIL::Design *design) override
@@ -138,6 +343,14 @@ struct SynthQuickLogicPass : public ScriptPass {
 
         size_t argidx;
         for (argidx = 1; argidx < args.size(); argidx++) {
+            if (args[argidx] == "-checkpoint_dir" && argidx + 1 < args.size()) {
+                checkpoint_dir = args[++argidx];
+                continue;
+            }
+            if (args[argidx] == "-profile" && argidx + 1 < args.size()) {
+                profile_file = args[++argidx];
+                continue;
+            }
             if (args[argidx] == "-run" && argidx + 1 < args.size()) {
                 size_t pos = args[argidx + 1].find(':');
                 if (pos == std::string::npos) {
@@ -232,15 +445,25 @@ struct SynthQuickLogicPass : public ScriptPass {
 
         log_header(design, "Executing SYNTH_QUICKLOGIC pass.\n");
         log_push();
+        instrumentation::ScopedTimer timer(design, "ql-qlf.synth_quicklogic");
+
+        if (!checkpoint_dir.empty()) {
+            std::string resume_label = load_checkpoint(design, run_from, run_to);
+            if (!resume_label.empty())
+                run_from = resume_label;
+        }
 
         run_script(design, run_from, run_to);
 
+        if (!profile_file.empty())
+            write_profile();
+
         log_pop();
     }
 
     void script() override
     {
-        if (check_label("begin")) {
+        if (check_stage("begin")) {
             std::string family_path = " +/quicklogic/" + family;
             std::string readVelArgs;
 
@@ -258,7 +481,7 @@ struct SynthQuickLogicPass : public ScriptPass {
             run(stringf("hierarchy -check %s", help_mode ? "-top <top>" : top_opt.c_str()));
         }
 
-        if (check_label("prepare")) {
+        if (check_stage("prepare")) {
             run("proc");
             run("flatten");
             if (family == "pp3") {
@@ -277,7 +500,7 @@ struct SynthQuickLogicPass : public ScriptPass {
             noDFFArgs += " -nodffe";
         }
 
-        if (check_label("coarse")) {
+        if (check_stage("coarse")) {
             run("check");
             run("opt -nodffe -nosdff");
             run("fsm");
@@ -322,8 +545,7 @@ struct SynthQuickLogicPass : public ScriptPass {
                 if (help_mode) {
                     run("wreduce t:$mul", "                  (for qlf_k6n10f if not -no_dsp)");
                     run("ql_dsp_macc" + use_dsp_cfg_params, "(for qlf_k6n10f if not -no_dsp)");
-                    run("techmap -map +/mul2dsp.v [...]", "  (for qlf_k6n10f if not -no_dsp)");
-                    run("chtype -set $mul t:$__soft_mul", "  (for qlf_k6n10f if not -no_dsp)");
+                    run("ql_dsp_mul_partition [...]", "     (for qlf_k6n10f if not -no_dsp)");
                     run("techmap -map +/quicklogic/" + family + "/dsp_map.v", "(for qlf_k6n10f if not -no_dsp)");
                     if (use_dsp_cfg_params.empty())
                         run("techmap -map +/quicklogic/" + family + "/dsp_map.v -D USE_DSP_CFG_PARAMS=0", "(for qlf_k6n10f if not -no_dsp)");
@@ -337,14 +559,11 @@ struct SynthQuickLogicPass : public ScriptPass {
                     run("wreduce t:$mul");
                     run("ql_dsp_macc" + use_dsp_cfg_params);
 
-                    for (const auto &rule : dsp_rules) {
-                        run(stringf("techmap -map +/mul2dsp.v "
-                                    "-D DSP_A_MAXWIDTH=%zu -D DSP_B_MAXWIDTH=%zu "
-                                    "-D DSP_A_MINWIDTH=%zu -D DSP_B_MINWIDTH=%zu "
-                                    "-D DSP_NAME=%s",
-                                    rule.a_maxwidth, rule.b_maxwidth, rule.a_minwidth, rule.b_minwidth, rule.type.c_str()));
-                        run("chtype -set $mul t:$__soft_mul");
-                    }
+                    std::string partition_args;
+                    for (const auto &rule : dsp_rules)
+                        partition_args += stringf(" -rule %s %zu %zu %zu %zu", rule.type.c_str(), rule.a_maxwidth, rule.b_maxwidth, rule.a_minwidth,
+                                                  rule.b_minwidth);
+                    run("ql_dsp_mul_partition" + partition_args);
                     if (use_dsp_cfg_params.empty())
                         run("techmap -map +/quicklogic/" + family + "/dsp_map.v -D USE_DSP_CFG_PARAMS=0");
                     else
@@ -369,7 +588,7 @@ struct SynthQuickLogicPass : public ScriptPass {
             run("ql_bram_asymmetric");
         }
 
-        if (check_label("map_bram", "(skip if -no_bram)") && (family == "qlf_k6n10" || family == "qlf_k6n10f" || family == "pp3") && inferBram) {
+        if (check_stage("map_bram", "(skip if -no_bram)") && (family == "qlf_k6n10" || family == "qlf_k6n10f" || family == "pp3") && inferBram) {
             run("memory_bram -rules +/quicklogic/" + family + "/brams.txt");
             if (family == "pp3") {
                 run("pp3_braminit");
@@ -380,56 +599,12 @@ struct SynthQuickLogicPass : public ScriptPass {
                 run("techmap -map +/quicklogic/" + family + "/brams_final_map.v");
             }
 
-            // Data width to specialized cell type width map
-            const std::unordered_map<int, int> dataWidth36 = {{36, 36}, {32, 36}, {18, 18}, {16, 18}, {9, 9}, {8, 9}, {4, 4}, {2, 2}, {1, 1}};
-            const std::unordered_map<int, int> dataWidth18 = {{18, 18}, {16, 18}, {9, 9}, {8, 9}, {4, 4}, {2, 2}, {1, 1}};
-
-            // Perform a series of 'chtype' passess
-            if (bramTypes) {
-                for (const auto &ww : dataWidth18) {
-                    for (const auto &rw : dataWidth18) {
-                        auto cmd =
-                          stringf("chtype -set TDP36K_BRAM_WR_X%d_RD_X%d_split t:TDP36K a:is_inferred=1 %%i a:is_split=1 %%i a:wr_data_width=%d "
-                                  "%%i a:rd_data_width=%d %%i",
-                                  ww.second, rw.second, ww.first, rw.first);
-                        run(cmd);
-
-                        auto cmd1 = stringf("chtype -set TDP36K_FIFO_ASYNC_WR_X%d_RD_X%d_split t:TDP36K a:is_fifo=1 %%i a:sync_fifo=0 %%i "
-                                            "a:is_split=1 %%i a:wr_data_width=%d "
-                                            "%%i a:rd_data_width=%d %%i",
-                                            ww.second, rw.second, ww.first, rw.first);
-                        run(cmd1);
-
-                        auto cmd2 = stringf("chtype -set TDP36K_FIFO_SYNC_WR_X%d_RD_X%d_split t:TDP36K a:is_fifo=1 %%i a:sync_fifo=1 %%i "
-                                            "a:is_split=1 %%i a:wr_data_width=%d "
-                                            "%%i a:rd_data_width=%d %%i",
-                                            ww.second, rw.second, ww.first, rw.first);
-                        run(cmd2);
-                    }
-                }
-
-                for (const auto &ww : dataWidth36) {
-                    for (const auto &rw : dataWidth36) {
-                        auto cmd = stringf(
-                          "chtype -set TDP36K_BRAM_WR_X%d_RD_X%d_nonsplit t:TDP36K a:is_inferred=1 %%i a:wr_data_width=%d %%i a:rd_data_width=%d %%i",
-                          ww.second, rw.second, ww.first, rw.first);
-                        run(cmd);
-
-                        auto cmd1 = stringf("chtype -set TDP36K_FIFO_ASYNC_WR_X%d_RD_X%d_nonsplit t:TDP36K a:is_fifo=1 %%i a:sync_fifo=0 %%i "
-                                            "a:wr_data_width=%d %%i a:rd_data_width=%d %%i",
-                                            ww.second, rw.second, ww.first, rw.first);
-                        run(cmd1);
-
-                        auto cmd2 = stringf("chtype -set TDP36K_FIFO_SYNC_WR_X%d_RD_X%d_nonsplit t:TDP36K a:is_fifo=1 %%i a:sync_fifo=1 %%i "
-                                            "a:wr_data_width=%d %%i a:rd_data_width=%d %%i",
-                                            ww.second, rw.second, ww.first, rw.first);
-                        run(cmd2);
-                    }
-                }
+            if (help_mode || bramTypes) {
+                run("ql_bram_types", "(if -bram_types)");
             }
         }
 
-        if (check_label("map_ffram")) {
+        if (check_stage("map_ffram")) {
             run("opt -fast -mux_undef -undriven -fine" + noDFFArgs);
             run("memory_map -iattr -attr !ram_block -attr !rom_block -attr logic_block "
                 "-attr syn_ramstyle=auto -attr syn_ramstyle=registers "
@@ -437,7 +612,7 @@ struct SynthQuickLogicPass : public ScriptPass {
             run("opt -undriven -fine" + noDFFArgs);
         }
 
-        if (check_label("map_gates")) {
+        if (check_stage("map_gates")) {
             if (inferAdder && (family == "qlf_k4n8" || family == "qlf_k6n10" || family == "qlf_k6n10f")) {
                 run("techmap -map +/techmap.v -map +/quicklogic/" + family + "/arith_map.v");
             } else {
@@ -453,7 +628,7 @@ struct SynthQuickLogicPass : public ScriptPass {
             run("opt" + noDFFArgs);
         }
 
-        if (check_label("map_ffs")) {
+        if (check_stage("map_ffs")) {
             run("opt_expr");
             if (family == "qlf_k4n8") {
                 run("shregmap -minlen 8 -maxlen 8");
@@ -490,7 +665,7 @@ struct SynthQuickLogicPass : public ScriptPass {
             run("opt" + noDFFArgs);
         }
 
-        if (check_label("map_luts")) {
+        if (check_stage("map_luts")) {
             if (abcOpt) {
                 if (family == "qlf_k6n10" || family == "qlf_k6n10f") {
                     run("abc -lut 6 ");
@@ -521,26 +696,26 @@ struct SynthQuickLogicPass : public ScriptPass {
             run("opt_lut");
         }
 
-        if (check_label("map_cells") && (family == "qlf_k6n10" || family == "pp3")) {
+        if (check_stage("map_cells") && (family == "qlf_k6n10" || family == "pp3")) {
             std::string techMapArgs;
             techMapArgs = "-map +/quicklogic/" + family + "/lut_map.v";
             run("techmap " + techMapArgs);
             run("clean");
         }
 
-        if (check_label("check")) {
+        if (check_stage("check")) {
             run("autoname");
             run("hierarchy -check");
             run("stat");
             run("check -noinit");
         }
 
-        if (check_label("iomap") && family == "pp3") {
+        if (check_stage("iomap") && family == "pp3") {
             run("clkbufmap -inpad ckpad Q:P");
             run("iopadmap -bits -outpad outpad A:P -inpad inpad Q:P -tinoutpad bipad EN:Q:A:P A:top");
         }
 
-        if (check_label("finalize")) {
+        if (check_stage("finalize")) {
             if (family == "pp3") {
                 run("setundef -zero -params -undriven");
             }
@@ -552,20 +727,20 @@ struct SynthQuickLogicPass : public ScriptPass {
             run("blackbox =A:whitebox");
         }
 
-        if (check_label("blif")) {
+        if (check_stage("blif")) {
             if (!blif_file.empty()) {
                 run(stringf("write_blif -param %s", help_mode ? "<file-name>" : blif_file.c_str()));
             }
         }
 
-        if (check_label("edif") && (!edif_file.empty())) {
+        if (check_stage("edif") && (!edif_file.empty())) {
             run("splitnets -ports -format ()");
             run("quicklogic_eqn");
 
             run(stringf("write_ql_edif -nogndvcc -attrprop -pvector par %s %s", this->currmodule.c_str(), edif_file.c_str()));
         }
 
-        if (check_label("verilog")) {
+        if (check_stage("verilog")) {
             if (!verilog_file.empty()) {
                 run("write_verilog -noattr -nohex " + verilog_file);
             }
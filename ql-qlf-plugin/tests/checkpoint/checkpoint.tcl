@@ -0,0 +1,40 @@
+yosys -import
+if { [info procs quicklogic_eqn] == {} } { plugin -i ql-qlf }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+set CHECKPOINT_DIR $TMP_DIR/checkpoints
+file delete -force $CHECKPOINT_DIR
+file mkdir $TMP_DIR
+
+proc file_contents {path} {
+    set f [open $path]
+    set data [read $f]
+    close $f
+    return $data
+}
+
+# Internal names of a design read from Verilog depend on the global object
+# counter, so both runs read the same RTLIL to have the same checkpoint key
+read_verilog $::env(DESIGN_TOP).v
+write_rtlil $TMP_DIR/input.il
+design -reset
+
+# First run saves a checkpoint at every label
+read_rtlil $TMP_DIR/input.il
+synth_quicklogic -family qlf_k4n8 -top top -checkpoint_dir $CHECKPOINT_DIR
+if { [llength [glob -nocomplain $CHECKPOINT_DIR/*.il]] == 0 } {
+    error "No checkpoints were saved"
+}
+write_verilog -noattr $TMP_DIR/first.v
+design -reset
+
+# Second run of the same input resumes from the latest checkpoint,
+# which the verify step checks in the log
+read_rtlil $TMP_DIR/input.il
+synth_quicklogic -family qlf_k4n8 -top top -checkpoint_dir $CHECKPOINT_DIR
+write_verilog -noattr $TMP_DIR/second.v
+
+if { [file_contents $TMP_DIR/first.v] ne [file_contents $TMP_DIR/second.v] } {
+    error "Netlist resumed from a checkpoint differs from the original one"
+}
@@ -0,0 +1,50 @@
+yosys -import
+if { [info procs quicklogic_eqn] == {} } { plugin -i ql-qlf }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+file mkdir $TMP_DIR
+
+# DSP variants of qlf_k6n10f as used by synth_quicklogic
+set RULES {
+    $__QL_MUL20X18 20 18 11 10
+    $__QL_MUL10X9  10  9  4  4
+}
+
+# Lines of the statistics that count multiplier cells
+proc mul_counts {path} {
+    set f [open $path]
+    set data [read $f]
+    close $f
+    return [lsearch -all -inline -regexp [split $data "\n"] {\$(__QL_MUL|mul|__mul|__soft_mul)}]
+}
+
+read_verilog $::env(DESIGN_TOP).v
+hierarchy -top top
+proc
+wreduce t:\$mul
+design -save read
+
+# Reference: a mul2dsp techmap followed by chtype for every variant in turn
+foreach {type a_max b_max a_min b_min} $RULES {
+    techmap -map +/mul2dsp.v -D DSP_A_MAXWIDTH=$a_max -D DSP_B_MAXWIDTH=$b_max \
+        -D DSP_A_MINWIDTH=$a_min -D DSP_B_MINWIDTH=$b_min -D DSP_NAME=$type
+    chtype -set \$mul t:\$__soft_mul
+}
+tee -q -o $TMP_DIR/loop.txt stat
+
+design -load read
+set partition_args {}
+foreach {type a_max b_max a_min b_min} $RULES {
+    lappend partition_args -rule $type $a_max $b_max $a_min $b_min
+}
+ql_dsp_mul_partition {*}$partition_args
+tee -q -o $TMP_DIR/partition.txt stat
+
+set loop [mul_counts $TMP_DIR/loop.txt]
+if { [llength $loop] == 0 } {
+    error "No multipliers found in the statistics"
+}
+if { $loop ne [mul_counts $TMP_DIR/partition.txt] } {
+    error "ql_dsp_mul_partition result differs from the techmap/chtype loop:\n$loop\n[mul_counts $TMP_DIR/partition.txt]"
+}
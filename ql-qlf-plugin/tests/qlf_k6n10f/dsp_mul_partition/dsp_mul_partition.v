@@ -0,0 +1,41 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module top (
+    input  wire [31:0] A,
+    input  wire [31:0] B,
+    output wire [21:0] Z_10x12,
+    output wire [21:0] Z_12x10,
+    output wire [37:0] Z_20x18,
+    output wire [15:0] Z_8x8,
+    output wire [19:0] Z_4x16,
+    output wire [ 5:0] Z_3x3,
+    output wire [63:0] Z_32x32
+);
+
+    // Narrower than the minimum A width of the 20x18 variant, but wide
+    // enough for it once swapped
+    assign Z_10x12 = A[9:0] * B[11:0];
+    assign Z_12x10 = A[11:0] * B[9:0];
+    assign Z_20x18 = A[19:0] * B[17:0];
+    assign Z_8x8   = A[7:0] * B[7:0];
+    assign Z_4x16  = A[3:0] * B[15:0];
+    // Too narrow for any variant
+    assign Z_3x3   = A[2:0] * B[2:0];
+    // Split into parts of different variants
+    assign Z_32x32 = A * B;
+
+endmodule
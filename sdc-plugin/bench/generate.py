@@ -0,0 +1,86 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright 2020-2022 F4PGA Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# SPDX-License-Identifier: Apache-2.0
+"""
+
+This script generates synthetic designs with many clocks for the sdc plugin
+benchmarks. The design of a benchmark is written to <prefix>.v and its
+timing constraints to <prefix>.sdc.
+"""
+
+import argparse
+
+
+def many_clocks(size):
+    """ Independent clocks, each driving a small counter """
+    ports = ", ".join("input clk{}".format(i) for i in range(size))
+    lines = ["module top({}, output [{}:0] out);".format(ports, size - 1)]
+    for i in range(size):
+        lines += [
+            "  reg [3:0] cnt{} = 0;".format(i),
+            "  always @(posedge clk{0}) cnt{0} <= cnt{0} + 1;".format(i),
+            "  assign out[{0}] = cnt{0}[3];".format(i),
+        ]
+    lines.append("endmodule")
+    constraints = ["create_clock -period {:.1f} -waveform {{0.000 {:.3f}}} clk{}".format(10.0 + i % 10, (10.0 + i % 10) / 2, i) for i in range(size)]
+    return lines, constraints
+
+
+def clock_tree(size):
+    """ Clocks propagated through long chains of buffers """
+    depth = 50
+    ports = ", ".join("input clk{}".format(i) for i in range(size))
+    lines = ["module top({}, output [{}:0] out);".format(ports, size - 1)]
+    for i in range(size):
+        lines.append("  wire [{}:0] clk{}_tree;".format(depth, i))
+        lines.append("  assign clk{0}_tree[0] = clk{0};".format(i))
+        for j in range(depth):
+            lines.append("  IBUF ibuf{0}_{1} (.I(clk{0}_tree[{1}]), .O(clk{0}_tree[{2}]));".format(i, j, j + 1))
+        lines += [
+            "  reg [1:0] cnt{} = 0;".format(i),
+            "  always @(posedge clk{0}_tree[{1}]) cnt{0} <= cnt{0} + 1;".format(i, depth),
+            "  assign out[{0}] = cnt{0}[1];".format(i),
+        ]
+    lines.append("endmodule")
+    constraints = ["create_clock -period 10.0 -waveform {{0.000 5.000}} clk{}".format(i) for i in range(size)]
+    return lines, constraints
+
+
+BENCHMARKS = {
+    "many_clocks": (many_clocks, 1000),
+    "clock_tree": (clock_tree, 100),
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("benchmark", choices=sorted(BENCHMARKS.keys()), help="Benchmark to generate")
+    parser.add_argument("prefix", help="Prefix of the written files")
+    parser.add_argument("--size", type=int, help="Size of the design (default depends on the benchmark)")
+    args = parser.parse_args()
+
+    generator, default_size = BENCHMARKS[args.benchmark]
+    lines, constraints = generator(args.size or default_size)
+    with open(args.prefix + ".v", "w") as fp:
+        fp.write("\n".join(lines) + "\n")
+    with open(args.prefix + ".sdc", "w") as fp:
+        fp.write("\n".join(constraints) + "\n")
+
+
+if __name__ == "__main__":
+    main()
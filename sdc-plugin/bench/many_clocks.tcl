@@ -0,0 +1,13 @@
+yosys -import
+if { [info procs read_sdc] == {} } { plugin -i sdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(BENCH_DESIGN).v
+read_verilog -specify -lib -D_EXPLICIT_CARRY +/xilinx/cells_sim.v
+read_verilog -lib +/xilinx/cells_xtra.v
+hierarchy -check -auto-top
+synth_xilinx -flatten -abc9 -nosrl -nodsp -iopad -run prepare:check
+
+bench_pass read_sdc $::env(BENCH_DESIGN).sdc
+bench_pass propagate_clocks
+bench_pass write_sdc $::env(BENCH_DESIGN).out.sdc
@@ -19,17 +19,44 @@
 #include <cassert>
 #include <cmath>
 #include <limits>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
-const std::vector<std::string> Pll::inputs = {"CLKIN1", "CLKIN2"};
-const std::vector<std::string> Pll::outputs = {"CLKOUT0", "CLKOUT1", "CLKOUT2", "CLKOUT3", "CLKOUT4", "CLKOUT5"};
-const float Pll::delay = 0;
-const std::string Pll::name = "PLLE2_ADV";
+const std::vector<Buffer> Buffer::clock_buffers = {
+  IBuf(), Bufg(), Buffer(0, "BUFGCE", "I", "O"), Buffer(0, "BUFGCE_DIV", "I", "O", "BUFGCE_DIVIDE"), Buffer(0, "BUFH", "I", "O"),
+  Buffer(0, "BUFHCE", "I", "O"), Buffer(0, "BUFR", "I", "O", "BUFR_DIVIDE")};
 
-Pll::Pll(RTLIL::Cell *cell, float input_clock_period, float input_clock_rising_edge) : ClockDivider({"PLLE2_ADV"})
+const std::vector<ClockDivider> ClockDivider::clock_dividers = {
+  {"PLLE2_ADV", {"CLKIN1", "CLKIN2"}, {"CLKOUT0", "CLKOUT1", "CLKOUT2", "CLKOUT3", "CLKOUT4", "CLKOUT5"}},
+  {"PLLE2_BASE", {"CLKIN1"}, {"CLKOUT0", "CLKOUT1", "CLKOUT2", "CLKOUT3", "CLKOUT4", "CLKOUT5"}},
+  {"MMCME2_ADV", {"CLKIN1", "CLKIN2"}, {"CLKOUT0", "CLKOUT1", "CLKOUT2", "CLKOUT3", "CLKOUT4", "CLKOUT5", "CLKOUT6"}},
+  {"MMCME2_BASE", {"CLKIN1"}, {"CLKOUT0", "CLKOUT1", "CLKOUT2", "CLKOUT3", "CLKOUT4", "CLKOUT5", "CLKOUT6"}}};
+
+float Buffer::Divisor(RTLIL::Cell *cell) const
+{
+    RTLIL::IdString param(RTLIL::escape_id(divide_param));
+    if (divide_param.empty() || !cell->hasParam(param)) {
+        return 1.0;
+    }
+    auto param_obj = cell->parameters.at(param);
+    if (!(param_obj.flags & RTLIL::CONST_FLAG_STRING)) {
+        return param_obj.as_int();
+    }
+    std::string value = param_obj.decode_string();
+    if (value == "BYPASS") {
+        return 1.0;
+    }
+    try {
+        return std::stof(value);
+    } catch (const std::logic_error &) {
+        log_cmd_error("Invalid %s value on cell %s: %s\n", divide_param.c_str(), RTLIL::id2cstr(cell->name), value.c_str());
+    }
+}
+
+Pll::Pll(const ClockDivider &divider, RTLIL::Cell *cell, float input_clock_period, float input_clock_rising_edge) : ClockDivider(divider)
 {
-    assert(RTLIL::unescape_id(cell->type) == "PLLE2_ADV");
+    assert(RTLIL::unescape_id(cell->type) == type);
     FetchParams(cell);
     CheckInputClockPeriod(cell, input_clock_period);
     CalculateOutputClockPeriods();
@@ -52,14 +79,15 @@ void Pll::FetchParams(RTLIL::Cell *cell)
 {
     clkin1_period = FetchParam(cell, "CLKIN1_PERIOD", 0.0);
     clkin2_period = FetchParam(cell, "CLKIN2_PERIOD", 0.0);
-    clk_mult = FetchParam(cell, "CLKFBOUT_MULT", 5.0);
+    // MMCMs take fractional CLKFBOUT_MULT_F and CLKOUT0_DIVIDE_F values
+    clk_mult = FetchParam(cell, "CLKFBOUT_MULT_F", FetchParam(cell, "CLKFBOUT_MULT", 5.0));
     clk_fbout_phase = FetchParam(cell, "CLKFBOUT_PHASE", 0.0);
     divclk_divisor = FetchParam(cell, "DIVCLK_DIVIDE", 1.0);
     for (auto output : outputs) {
         // CLKOUT[0-5]_DUTY_CYCLE
         clkout_duty_cycle[output] = FetchParam(cell, output + "_DUTY_CYCLE", 0.5);
         // CLKOUT[0-5]_DIVIDE
-        clkout_divisor[output] = FetchParam(cell, output + "_DIVIDE", 1.0);
+        clkout_divisor[output] = FetchParam(cell, output + "_DIVIDE_F", FetchParam(cell, output + "_DIVIDE", 1.0));
         // CLKOUT[0-5]_PHASE
         clkout_phase[output] = FetchParam(cell, output + "_PHASE", 0.0);
     }
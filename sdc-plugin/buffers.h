@@ -25,28 +25,47 @@
 
 USING_YOSYS_NAMESPACE
 
+// Clock buffer primitive the clocks are propagated through from the input to the output port.
+// Buffers with a divide parameter are regional dividers, their outputs get generated clocks.
 struct Buffer {
-    Buffer(float delay, const std::string &type, const std::string &output) : delay(delay), type(type), output(output) {}
+    Buffer(float delay, const std::string &type, const std::string &input, const std::string &output, const std::string &divide_param = "")
+        : delay(delay), type(type), input(input), output(output), divide_param(divide_param)
+    {
+    }
+
+    // Division of the input clock set on the cell, 1 for plain buffers
+    float Divisor(RTLIL::Cell *cell) const;
+
     float delay;
     std::string type;
+    std::string input;
     std::string output;
+    std::string divide_param;
+
+    // Buffers traversed by the clock propagation
+    static const std::vector<Buffer> clock_buffers;
 };
 
 struct IBuf : Buffer {
-    IBuf() : Buffer(0, "IBUF", "O"){};
+    IBuf() : Buffer(0, "IBUF", "I", "O"){};
 };
 
 struct Bufg : Buffer {
-    Bufg() : Buffer(0, "BUFG", "O"){};
+    Bufg() : Buffer(0, "BUFG", "I", "O"){};
 };
 
 struct ClockDivider {
     std::string type;
+    std::vector<std::string> inputs;
+    std::vector<std::string> outputs;
+
+    // Clock dividers recognized by the clock propagation
+    static const std::vector<ClockDivider> clock_dividers;
 };
 
+// PLL and MMCM clock dividers
 struct Pll : public ClockDivider {
-    Pll() : ClockDivider({"PLLE2_ADV"}) {}
-    Pll(RTLIL::Cell *cell, float input_clock_period, float input_clock_rising_edge);
+    Pll(const ClockDivider &divider, RTLIL::Cell *cell, float input_clock_period, float input_clock_rising_edge);
 
     // Helper function to fetch a cell parameter or return a default value
     static float FetchParam(RTLIL::Cell *cell, std::string &&param_name, float default_value);
@@ -55,8 +74,6 @@ struct Pll : public ClockDivider {
     // TODO Add support for CLKINSEL
     float ClkinPeriod() { return clkin1_period; }
 
-    static const std::vector<std::string> inputs;
-    static const std::vector<std::string> outputs;
     std::unordered_map<std::string, float> clkout_period;
     std::unordered_map<std::string, float> clkout_duty_cycle;
     std::unordered_map<std::string, float> clkout_rising_edge;
@@ -76,8 +93,6 @@ struct Pll : public ClockDivider {
     // Calculate the rising and falling edges of the output clocks
     void CalculateOutputClockWaveforms(float input_clock_rising_edge);
 
-    static const float delay;
-    static const std::string name;
     std::unordered_map<std::string, float> clkout_divisor;
     std::unordered_map<std::string, float> clkout_phase;
     float clkin1_period;
@@ -20,7 +20,26 @@
 #include "propagation.h"
 #include <cassert>
 #include <cmath>
-#include <regex>
+#include <set>
+
+// Clocks of the module queried last and their parameters, valid until Clocks::Invalidate
+struct ClockTable {
+    RTLIL::Module *module = nullptr;
+    std::map<std::string, RTLIL::Wire *> wires;
+    // Indexed by the wire hash, which is unique for every wire ever created
+    dict<unsigned int, ClockParams> params;
+    // Periods of the clocks of the module, the shortest one sets the ABC9 delay target
+    std::multiset<float> periods;
+    // Hashes of the clock wires whose period is counted in periods
+    pool<unsigned int> counted;
+    // Escaped names of the wires with the wire names they were created from
+    dict<unsigned int, std::pair<RTLIL::IdString, std::string>> wire_names;
+};
+
+static ClockTable clock_table;
+
+// Rounds the value the same way as storing it in an attribute and reading it back
+static float Normalize(float value) { return std::stof(std::to_string(value)); }
 
 void Clock::Add(const std::string &name, RTLIL::Wire *wire, float period, float rising_edge, float falling_edge, ClockType type)
 {
@@ -34,6 +53,16 @@ void Clock::Add(const std::string &name, RTLIL::Wire *wire, float period, float
     wire->set_string_attribute(RTLIL::escape_id("PERIOD"), std::to_string(period));
     std::string waveform(std::to_string(rising_edge) + " " + std::to_string(falling_edge));
     wire->set_string_attribute(RTLIL::escape_id("WAVEFORM"), waveform);
+    // Keep the cached clocks in sync
+    ClockParams params{Normalize(period), Normalize(rising_edge), Normalize(falling_edge)};
+    if (clock_table.module && clock_table.module == wire->module) {
+        clock_table.wires.insert(std::make_pair(Clock::WireName(wire), wire));
+        if (!clock_table.counted.insert(wire->hash()).second) {
+            clock_table.periods.erase(clock_table.periods.find(clock_table.params.at(wire->hash()).period));
+        }
+        clock_table.periods.insert(params.period);
+    }
+    clock_table.params[wire->hash()] = params;
 }
 
 void Clock::Add(const std::string &name, std::vector<RTLIL::Wire *> wires, float period, float rising_edge, float falling_edge, ClockType type)
@@ -46,7 +75,7 @@ void Clock::Add(RTLIL::Wire *wire, float period, float rising_edge, float fallin
     Add(Clock::WireName(wire), wire, period, rising_edge, falling_edge, type);
 }
 
-float Clock::Period(RTLIL::Wire *clock_wire)
+float Clock::ParsePeriod(RTLIL::Wire *clock_wire)
 {
     if (!clock_wire->has_attribute(RTLIL::escape_id("PERIOD"))) {
         log_cmd_error("PERIOD has not been specified on wire '%s'.\n", WireName(clock_wire).c_str());
@@ -64,10 +93,9 @@ float Clock::Period(RTLIL::Wire *clock_wire)
     return period;
 }
 
-std::pair<float, float> Clock::Waveform(RTLIL::Wire *clock_wire)
+std::pair<float, float> Clock::ParseWaveform(RTLIL::Wire *clock_wire, float period)
 {
     if (!clock_wire->has_attribute(RTLIL::escape_id("WAVEFORM"))) {
-        float period(Period(clock_wire));
         if (!period) {
             log_cmd_error("Neither PERIOD nor WAVEFORM has been specified for wire %s\n", WireName(clock_wire).c_str());
             return std::make_pair(0, 0);
@@ -90,9 +118,22 @@ std::pair<float, float> Clock::Waveform(RTLIL::Wire *clock_wire)
     return std::make_pair(rising_edge, falling_edge);
 }
 
-float Clock::RisingEdge(RTLIL::Wire *clock_wire) { return Waveform(clock_wire).first; }
+const ClockParams &Clock::GetParams(RTLIL::Wire *clock_wire)
+{
+    auto it = clock_table.params.find(clock_wire->hash());
+    if (it != clock_table.params.end()) {
+        return it->second;
+    }
+    float period(ParsePeriod(clock_wire));
+    auto waveform(ParseWaveform(clock_wire, period));
+    return clock_table.params[clock_wire->hash()] = ClockParams{period, waveform.first, waveform.second};
+}
+
+float Clock::Period(RTLIL::Wire *clock_wire) { return GetParams(clock_wire).period; }
 
-float Clock::FallingEdge(RTLIL::Wire *clock_wire) { return Waveform(clock_wire).second; }
+float Clock::RisingEdge(RTLIL::Wire *clock_wire) { return GetParams(clock_wire).rising_edge; }
+
+float Clock::FallingEdge(RTLIL::Wire *clock_wire) { return GetParams(clock_wire).falling_edge; }
 
 std::string Clock::Name(RTLIL::Wire *clock_wire)
 {
@@ -107,7 +148,12 @@ std::string Clock::WireName(RTLIL::Wire *clock_wire)
     if (!clock_wire) {
         return std::string();
     }
-    return AddEscaping(RTLIL::unescape_id(clock_wire->name));
+    // Wires can be renamed, so the cached name is checked against the current one
+    auto &name = clock_table.wire_names[clock_wire->hash()];
+    if (name.first != clock_wire->name) {
+        name = std::make_pair(clock_wire->name, AddEscaping(RTLIL::unescape_id(clock_wire->name)));
+    }
+    return name.second;
 }
 
 std::string Clock::SourceWireName(RTLIL::Wire *clock_wire)
@@ -126,37 +172,57 @@ bool Clock::GetClockWireBoolAttribute(RTLIL::Wire *wire, const std::string &attr
     return false;
 }
 
-const std::map<std::string, RTLIL::Wire *> Clocks::GetClocks(RTLIL::Design *design)
+const std::map<std::string, RTLIL::Wire *> Clocks::GetClocks(RTLIL::Design *design) { return GetClocks(design->top_module()); }
+
+const std::map<std::string, RTLIL::Wire *> Clocks::GetClocks(RTLIL::Module *module)
 {
-    std::map<std::string, RTLIL::Wire *> clock_wires;
-    RTLIL::Module *top_module = design->top_module();
-    for (auto &wire_obj : top_module->wires_) {
+    if (clock_table.module == module) {
+        return clock_table.wires;
+    }
+    clock_table.module = module;
+    clock_table.wires.clear();
+    clock_table.periods.clear();
+    clock_table.counted.clear();
+    for (auto &wire_obj : module->wires_) {
         auto &wire = wire_obj.second;
         if (wire->has_attribute(RTLIL::escape_id("CLOCK_SIGNAL"))) {
             if (wire->get_string_attribute(RTLIL::escape_id("CLOCK_SIGNAL")) == "yes") {
-                clock_wires.insert(std::make_pair(Clock::WireName(wire), wire));
+                clock_table.wires.insert(std::make_pair(Clock::WireName(wire), wire));
             }
         }
     }
-    return clock_wires;
+    return clock_table.wires;
 }
 
-void Clocks::UpdateAbc9DelayTarget(RTLIL::Design *design)
+void Clocks::Invalidate()
+{
+    clock_table.module = nullptr;
+    clock_table.wires.clear();
+    clock_table.params.clear();
+    clock_table.periods.clear();
+    clock_table.counted.clear();
+    clock_table.wire_names.clear();
+}
+
+int Clocks::Abc9DelayTarget(RTLIL::Design *design)
 {
-    std::map<std::string, RTLIL::Wire *> clock_wires = Clocks::GetClocks(design);
-
-    for (auto &clock_wire : clock_wires) {
-        auto &wire = clock_wire.second;
-        float period = Clock::Period(wire);
-
-        // Set the ABC9 delay to the shortest clock period in the design.
-        //
-        // By convention, delays in Yosys are in picoseconds, but ABC9 has
-        // no information on interconnect delay, so target half the specified
-        // clock period to give timing slack; otherwise ABC9 may produce a
-        // mapping that cannot meet the specified clock.
-        int abc9_delay = design->scratchpad_get_int("abc9.D", INT32_MAX);
-        int period_ps = period * 1000.0 / 2.0;
-        design->scratchpad_set_int("abc9.D", std::min(abc9_delay, period_ps));
+    // Clocks found by the wire scan are counted on the first query, the
+    // added ones are kept up to date by Clock::Add
+    for (auto &clock : GetClocks(design)) {
+        auto &wire = clock.second;
+        if (!clock_table.counted.count(wire->hash())) {
+            clock_table.periods.insert(Clock::Period(wire));
+            clock_table.counted.insert(wire->hash());
+        }
     }
+    if (clock_table.periods.empty()) {
+        return INT32_MAX;
+    }
+    return Abc9Delay(*clock_table.periods.begin());
+}
+
+void Clocks::UpdateAbc9DelayTarget(RTLIL::Design *design)
+{
+    int abc9_delay = design->scratchpad_get_int("abc9.D", INT32_MAX);
+    design->scratchpad_set_int("abc9.D", std::min(abc9_delay, Abc9DelayTarget(design)));
 }
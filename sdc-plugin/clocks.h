@@ -30,6 +30,13 @@ class BufferPropagation;
 class ClockDividerPropagation;
 class Propagation;
 
+// Clock parameters as stored in the PERIOD and WAVEFORM attributes of a clock wire
+struct ClockParams {
+    float period;
+    float rising_edge;
+    float falling_edge;
+};
+
 class Clock
 {
   public:
@@ -46,7 +53,22 @@ class Clock
     static float FallingEdge(RTLIL::Wire *clock_wire);
     static std::string Name(RTLIL::Wire *clock_wire);
     static std::string WireName(RTLIL::Wire *wire);
-    static std::string AddEscaping(const std::string &name) { return std::regex_replace(name, std::regex{"\\$"}, "\\$"); }
+    static std::string AddEscaping(const std::string &name)
+    {
+        size_t pos = name.find('$');
+        if (pos == std::string::npos) {
+            return name;
+        }
+        std::string escaped(name, 0, pos);
+        escaped.reserve(name.size() + 4);
+        for (; pos < name.size(); pos++) {
+            if (name[pos] == '$') {
+                escaped += '\\';
+            }
+            escaped += name[pos];
+        }
+        return escaped;
+    }
     static std::string SourceWireName(RTLIL::Wire *clock_wire);
     static bool IsPropagated(RTLIL::Wire *wire) { return GetClockWireBoolAttribute(wire, "IS_PROPAGATED"); }
 
@@ -55,7 +77,10 @@ class Clock
     static bool IsExplicit(RTLIL::Wire *wire) { return GetClockWireBoolAttribute(wire, "IS_EXPLICIT"); }
 
   private:
-    static std::pair<float, float> Waveform(RTLIL::Wire *clock_wire);
+    // Returns the parameters of the clock, parsing the wire attributes only on the first query
+    static const ClockParams &GetParams(RTLIL::Wire *clock_wire);
+    static float ParsePeriod(RTLIL::Wire *clock_wire);
+    static std::pair<float, float> ParseWaveform(RTLIL::Wire *clock_wire, float period);
 
     static bool GetClockWireBoolAttribute(RTLIL::Wire *wire, const std::string &attribute_name);
 };
@@ -64,7 +89,22 @@ class Clocks
 {
   public:
     static const std::map<std::string, RTLIL::Wire *> GetClocks(RTLIL::Design *design);
+    // Clocks of any module of the design, the cache holds the module queried last
+    static const std::map<std::string, RTLIL::Wire *> GetClocks(RTLIL::Module *module);
+    // Set the ABC9 delay to the shortest clock period in the design.
+    //
+    // By convention, delays in Yosys are in picoseconds, but ABC9 has
+    // no information on interconnect delay, so target half the specified
+    // clock period to give timing slack; otherwise ABC9 may produce a
+    // mapping that cannot meet the specified clock.
+    static int Abc9Delay(float period) { return period * 1000.0 / 2.0; }
+    // Returns the ABC9 delay of the shortest clock period or INT32_MAX if there are no clocks
+    static int Abc9DelayTarget(RTLIL::Design *design);
     static void UpdateAbc9DelayTarget(RTLIL::Design *design);
+    // Drops the clocks and parameters cached since the last call.
+    // The attributes of the wires can be changed by any other pass, so every
+    // command working with clocks must call it before the first query.
+    static void Invalidate();
 };
 
 #endif // _CLOCKS_H_
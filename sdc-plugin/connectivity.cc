@@ -0,0 +1,126 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#include "connectivity.h"
+#include <algorithm>
+
+USING_YOSYS_NAMESPACE
+
+Connectivity::Connectivity(RTLIL::Module *module) : module_(module), netlist_(module), sigmap_(netlist_.GetSigMap())
+{
+    for (auto wire : module->wires()) {
+        for (auto bit : sigmap_(wire)) {
+            if (!bit.wire) {
+                continue;
+            }
+            auto &wires = wires_[bit];
+            if (wires.empty() || wires.back() != wire) {
+                wires.push_back(wire);
+            }
+        }
+    }
+}
+
+bool Connectivity::IsOutput(RTLIL::Cell *cell, const RTLIL::IdString &port) { return cell->output(port) || !cell->input(port); }
+
+std::vector<RTLIL::Cell *> Connectivity::SinkCells(RTLIL::Wire *wire, const RTLIL::IdString &cell_type, const RTLIL::IdString &port) const
+{
+    std::vector<RTLIL::Cell *> cells;
+    if (!wire) {
+        return cells;
+    }
+    pool<RTLIL::Cell *> seen;
+    for (auto bit : sigmap_(wire)) {
+        netlist_.ForEachSink(bit, [&](const NetlistIndex::PortBit &pin) {
+            if (!cell_type.empty() && pin.cell->type != cell_type) {
+                return;
+            }
+            if (!port.empty() && pin.port != port) {
+                return;
+            }
+            if (seen.insert(pin.cell).second) {
+                cells.push_back(pin.cell);
+            }
+        });
+    }
+    return cells;
+}
+
+std::vector<Connectivity::CellPin> Connectivity::SinkPins(RTLIL::Wire *wire) const
+{
+    std::vector<CellPin> pins;
+    if (!wire) {
+        return pins;
+    }
+    pool<std::pair<RTLIL::Cell *, RTLIL::IdString>> seen;
+    for (auto bit : sigmap_(wire)) {
+        netlist_.ForEachSink(bit, [&](const NetlistIndex::PortBit &pin) {
+            if (seen.insert(std::make_pair(pin.cell, pin.port)).second) {
+                pins.emplace_back(pin.cell, pin.port);
+            }
+        });
+    }
+    return pins;
+}
+
+std::vector<RTLIL::Wire *> Connectivity::OutputWires(RTLIL::Cell *cell, const RTLIL::IdString &port) const
+{
+    std::vector<RTLIL::Wire *> wires;
+    if (!cell || !cell->hasPort(port) || !IsOutput(cell, port)) {
+        return wires;
+    }
+    for (auto &chunk : cell->getPort(port).chunks()) {
+        if (chunk.wire && std::find(wires.begin(), wires.end(), chunk.wire) == wires.end()) {
+            wires.push_back(chunk.wire);
+        }
+    }
+    return wires;
+}
+
+std::vector<RTLIL::Wire *> Connectivity::AliasWires(RTLIL::Wire *wire) const
+{
+    std::vector<RTLIL::Wire *> aliases;
+    if (!wire) {
+        return aliases;
+    }
+    pool<RTLIL::Wire *> seen;
+    for (auto bit : sigmap_(wire)) {
+        auto it = wires_.find(bit);
+        if (it == wires_.end()) {
+            continue;
+        }
+        for (auto alias : it->second) {
+            if (seen.insert(alias).second) {
+                aliases.push_back(alias);
+            }
+        }
+    }
+    return aliases;
+}
+
+bool Connectivity::HasSinkCell(RTLIL::Wire *wire) const
+{
+    if (!wire) {
+        return false;
+    }
+    for (auto bit : sigmap_(wire)) {
+        if (netlist_.SinkCount(bit) > 0) {
+            return true;
+        }
+    }
+    return false;
+}
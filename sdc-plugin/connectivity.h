@@ -0,0 +1,75 @@
+/*
+ * Copyright 2020-2022 F4PGA Authors
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * SPDX-License-Identifier: Apache-2.0
+ */
+#ifndef _CONNECTIVITY_H_
+#define _CONNECTIVITY_H_
+
+#include "../common/netlist_index.h"
+#include "kernel/rtlil.h"
+#include "kernel/sigtools.h"
+#include <vector>
+
+USING_YOSYS_NAMESPACE
+
+// Connectivity of a single module built once with all signals canonicalized
+// with SigMap. It answers the driver/sink queries of the clock propagation
+// without evaluating a Yosys selection for every hop.
+class Connectivity
+{
+  public:
+    struct CellPin {
+        RTLIL::Cell *cell;
+        RTLIL::IdString port;
+
+        CellPin(RTLIL::Cell *cell, const RTLIL::IdString &port) : cell(cell), port(port) {}
+    };
+
+    explicit Connectivity(RTLIL::Module *module);
+
+    RTLIL::Module *GetModule() const { return module_; }
+
+    // Cells having an input port connected to the wire, each cell listed once.
+    // If cell_type is not empty only cells of this type are returned.
+    // If port is not empty only connections on this port are considered.
+    std::vector<RTLIL::Cell *> SinkCells(RTLIL::Wire *wire, const RTLIL::IdString &cell_type = RTLIL::IdString(),
+                                         const RTLIL::IdString &port = RTLIL::IdString()) const;
+
+    // Cell input ports connected to the wire, each port listed once
+    std::vector<CellPin> SinkPins(RTLIL::Wire *wire) const;
+
+    // Wires connected to the given output port of the cell
+    std::vector<RTLIL::Wire *> OutputWires(RTLIL::Cell *cell, const RTLIL::IdString &port) const;
+
+    // Wires sharing at least one net with the given wire, including the wire itself
+    std::vector<RTLIL::Wire *> AliasWires(RTLIL::Wire *wire) const;
+
+    bool HasSinkCell(RTLIL::Wire *wire) const;
+
+    // Cells of unknown type have no port directions, such ports are considered
+    // both inputs and outputs
+    static bool IsOutput(RTLIL::Cell *cell, const RTLIL::IdString &port);
+
+  private:
+    RTLIL::Module *module_;
+    // Cell input ports driven by the nets
+    NetlistIndex netlist_;
+    const SigMap &sigmap_;
+    // Maps a net to all the wires carrying it
+    dict<RTLIL::SigBit, std::vector<RTLIL::Wire *>> wires_;
+};
+
+#endif // _CONNECTIVITY_H_
@@ -16,123 +16,250 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include "propagation.h"
-#include <cassert>
+#include <algorithm>
 
 USING_YOSYS_NAMESPACE
 
-void Propagation::PropagateThroughBuffers(Buffer buffer)
+void IncrementalPropagation::Start(RTLIL::Module *top_module)
 {
-    for (auto &clock : Clocks::GetClocks(design_)) {
+    if (top_module != module_ || top_module->hash() != module_hash_) {
+        valid_ = false;
+    }
+    if (!valid_) {
+        cones_.clear();
+    }
+    module_ = top_module;
+    module_hash_ = top_module->hash();
+    propagated_.clear();
+    current_cone_ = nullptr;
+}
+
+bool IncrementalPropagation::ConeChanged(RTLIL::Wire *clock_wire) const
+{
+    auto it = cones_.find(clock_wire->hash());
+    if (!valid_ || it == cones_.end()) {
+        return true;
+    }
+    const Cone &cone = it->second;
+    if (cone.period != clock_wire->get_string_attribute(RTLIL::escape_id("PERIOD")) ||
+        cone.waveform != clock_wire->get_string_attribute(RTLIL::escape_id("WAVEFORM"))) {
+        return true;
+    }
+    for (auto wire_hash : cone.wires) {
+        if (changed_wires_.count(wire_hash)) {
+            return true;
+        }
+    }
+    // Cell types and parameters can change without notifying the monitor
+    for (auto &it : cone.cells) {
+        RTLIL::Cell *cell = module_->cell(it.first);
+        if (!cell || cell->type != it.second.first || cell->parameters.hash() != it.second.second) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool IncrementalPropagation::IsUpToDate(const std::map<std::string, RTLIL::Wire *> &clocks)
+{
+    for (auto &clock : clocks) {
+        if (ConeChanged(clock.second)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool IncrementalPropagation::NeedsPropagation(RTLIL::Wire *clock_wire)
+{
+    auto it = propagated_.find(clock_wire->hash());
+    if (it == propagated_.end()) {
+        if (!ConeChanged(clock_wire)) {
+            current_cone_ = nullptr;
+            return false;
+        }
+        propagated_[clock_wire->hash()] = clock_wire;
+        cones_[clock_wire->hash()] = Cone();
+    }
+    current_cone_ = &cones_[clock_wire->hash()];
+    AddToCone({clock_wire});
+    return true;
+}
+
+void IncrementalPropagation::AddToCone(const std::vector<RTLIL::Wire *> &wires)
+{
+    if (!current_cone_) {
+        return;
+    }
+    for (auto wire : wires) {
+        current_cone_->wires.insert(wire->hash());
+    }
+}
+
+void IncrementalPropagation::AddToCone(RTLIL::Cell *cell)
+{
+    if (!current_cone_ || !cell) {
+        return;
+    }
+    current_cone_->cells[cell->name] = std::make_pair(cell->type, cell->parameters.hash());
+}
+
+void IncrementalPropagation::Finish(RTLIL::Design *design)
+{
+    // Clocks updated by other clocks after they were checked keep the old
+    // parameters, so they are propagated again in the next run
+    for (auto &it : propagated_) {
+        Cone &cone = cones_[it.first];
+        cone.period = it.second->get_string_attribute(RTLIL::escape_id("PERIOD"));
+        cone.waveform = it.second->get_string_attribute(RTLIL::escape_id("WAVEFORM"));
+    }
+    propagated_.clear();
+    current_cone_ = nullptr;
+    changed_wires_.clear();
+    RTLIL::Module *top_module = design->top_module();
+    top_module->monitors.insert(this);
+    valid_ = true;
+}
+
+void IncrementalPropagation::AddChangedWires(RTLIL::Module *module, const RTLIL::SigSpec &sig)
+{
+    if (!valid_ || module != module_) {
+        return;
+    }
+    for (auto &chunk : sig.chunks()) {
+        if (chunk.wire) {
+            changed_wires_.insert(chunk.wire->hash());
+        }
+    }
+    if (changed_wires_.size() > max_changed_wires) {
+        valid_ = false;
+        changed_wires_.clear();
+    }
+}
+
+void IncrementalPropagation::notify_connect(RTLIL::Cell *cell, const RTLIL::IdString &, const RTLIL::SigSpec &old_sig, const RTLIL::SigSpec &sig)
+{
+    AddChangedWires(cell->module, old_sig);
+    AddChangedWires(cell->module, sig);
+}
+
+void IncrementalPropagation::notify_connect(RTLIL::Module *module, const RTLIL::SigSig &sigsig)
+{
+    AddChangedWires(module, sigsig.first);
+    AddChangedWires(module, sigsig.second);
+}
+
+void IncrementalPropagation::notify_connect(RTLIL::Module *module, const std::vector<RTLIL::SigSig> &)
+{
+    // All connections of the module were replaced
+    if (module == module_) {
+        valid_ = false;
+    }
+}
+
+void IncrementalPropagation::notify_blackout(RTLIL::Module *module)
+{
+    if (module == module_) {
+        valid_ = false;
+    }
+}
+
+void Propagation::PropagateThroughBuffers(const std::vector<Buffer> &buffers)
+{
+    for (auto &clock : Clocks::GetClocks(connectivity_.GetModule())) {
         auto &clock_wire = clock.second;
+        if (!StartClock(clock_wire)) {
+            continue;
+        }
 #ifdef SDC_DEBUG
         log("Clock wire %s\n", Clock::WireName(clock_wire).c_str());
 #endif
-        auto buf_wires = FindSinkWiresForCellType(clock_wire, buffer.type, buffer.output);
-        int path_delay(0);
-        for (auto wire : buf_wires) {
+        float period(Clock::Period(clock_wire));
+        float rising_edge(Clock::RisingEdge(clock_wire));
+        float falling_edge(Clock::FallingEdge(clock_wire));
+        for (auto &sink : FindBufferSinkWires(clock_wire, buffers)) {
 #ifdef SDC_DEBUG
-            log("%s wire: %s\n", buffer.type.c_str(), RTLIL::id2cstr(wire->name));
+            log("Buffer sink wire: %s\n", RTLIL::id2cstr(sink.wire->name));
 #endif
-            path_delay += buffer.delay;
-            Clock::Add(wire, Clock::Period(clock_wire), Clock::RisingEdge(clock_wire) + path_delay, Clock::FallingEdge(clock_wire) + path_delay,
-                       Clock::PROPAGATED);
+            if (sink.divisor == 1) {
+                Clock::Add(sink.wire, period, rising_edge + sink.delay, falling_edge + sink.delay, Clock::PROPAGATED);
+            } else {
+                // Divided clocks have a 50% duty cycle
+                float divided_period(period * sink.divisor);
+                Clock::Add(sink.wire, divided_period, rising_edge + sink.delay, rising_edge + sink.delay + divided_period / 2, Clock::GENERATED);
+            }
         }
     }
 }
 
-std::vector<RTLIL::Wire *> Propagation::FindSinkWiresForCellType(RTLIL::Wire *driver_wire, const std::string &cell_type, const std::string &cell_port)
+std::vector<Propagation::BufferSink> Propagation::FindBufferSinkWires(RTLIL::Wire *driver_wire, const std::vector<Buffer> &buffers)
 {
-    std::vector<RTLIL::Wire *> wires;
+    std::vector<BufferSink> sinks;
     if (!driver_wire) {
-        return wires;
+        return sinks;
     }
-    auto cell = FindSinkCellOfType(driver_wire, cell_type);
-    RTLIL::Wire *wire = FindSinkWireOnPort(cell, cell_port);
-    if (wire) {
-        wires.push_back(wire);
-        auto further_wires = FindSinkWiresForCellType(wire, cell_type, cell_port);
-        std::copy(further_wires.begin(), further_wires.end(), std::back_inserter(wires));
+    // Breadth-first traversal, the list of found wires is the work queue
+    pool<RTLIL::Wire *> visited{driver_wire};
+    BufferSink current{driver_wire, 0, 1};
+    size_t next = 0;
+    for (;;) {
+        for (auto &buffer : buffers) {
+            for (auto cell : FindSinkCellsOfType(current.wire, buffer.type, buffer.input)) {
+                float divisor(current.divisor * buffer.Divisor(cell));
+                for (auto sink_wire : FindSinkWiresOnPort(cell, buffer.output)) {
+                    if (visited.insert(sink_wire).second) {
+                        sinks.push_back({sink_wire, current.delay + buffer.delay, divisor});
+                    }
+                }
+            }
+        }
+        if (next == sinks.size()) {
+            break;
+        }
+        current = sinks[next++];
     }
-    return wires;
+    return sinks;
 }
 
-RTLIL::Cell *Propagation::FindSinkCellOfType(RTLIL::Wire *wire, const std::string &type)
+std::vector<RTLIL::Cell *> Propagation::FindSinkCellsOfType(RTLIL::Wire *wire, const std::string &type, const std::string &port)
 {
-    RTLIL::Cell *sink_cell = NULL;
-    if (!wire) {
-        return sink_cell;
-    }
-    RTLIL::Module *top_module = design_->top_module();
-    assert(top_module);
-    std::string base_selection = top_module->name.str() + "/w:" + wire->name.str();
-    pass_->extra_args(std::vector<std::string>{base_selection, "%co:+" + type, base_selection, "%d"}, 0, design_);
-    auto selected_cells = top_module->selected_cells();
-    // FIXME Handle more than one sink
-    assert(selected_cells.size() <= 1);
-    if (selected_cells.size() > 0) {
-        sink_cell = selected_cells.at(0);
+    auto sink_cells = connectivity_.SinkCells(wire, RTLIL::escape_id(type), RTLIL::escape_id(port));
+    RecordCone(wire, sink_cells);
 #ifdef SDC_DEBUG
+    for (auto sink_cell : sink_cells) {
         log("Found sink cell: %s\n", RTLIL::unescape_id(sink_cell->name).c_str());
-#endif
     }
-    return sink_cell;
+#endif
+    return sink_cells;
 }
 
-RTLIL::Cell *Propagation::FindSinkCellOnPort(RTLIL::Wire *wire, const std::string &port)
+bool Propagation::WireHasSinkCell(RTLIL::Wire *wire)
 {
-    RTLIL::Cell *sink_cell = NULL;
-    if (!wire) {
-        return sink_cell;
-    }
-    RTLIL::Module *top_module = design_->top_module();
-    assert(top_module);
-    std::string base_selection = top_module->name.str() + "/w:" + wire->name.str();
-    pass_->extra_args(std::vector<std::string>{base_selection, "%co:+[" + port + "]", base_selection, "%d"}, 0, design_);
-    auto selected_cells = top_module->selected_cells();
-    // FIXME Handle more than one sink
-    assert(selected_cells.size() <= 1);
-    if (selected_cells.size() > 0) {
-        sink_cell = selected_cells.at(0);
-#ifdef SDC_DEBUG
-        log("Found sink cell: %s\n", RTLIL::unescape_id(sink_cell->name).c_str());
-#endif
-    }
-    return sink_cell;
+    RecordCone(wire, {});
+    return connectivity_.HasSinkCell(wire);
 }
 
-bool Propagation::WireHasSinkCell(RTLIL::Wire *wire)
+void Propagation::RecordCone(RTLIL::Wire *wire, const std::vector<RTLIL::Cell *> &cells)
 {
-    if (!wire) {
-        return false;
+    if (!incremental_ || !wire) {
+        return;
+    }
+    // Any change on the net can change the result of the query, so all its wires are recorded
+    incremental_->AddToCone(connectivity_.AliasWires(wire));
+    for (auto cell : cells) {
+        incremental_->AddToCone(cell);
     }
-    RTLIL::Module *top_module = design_->top_module();
-    assert(top_module);
-    std::string base_selection = top_module->name.str() + "/w:" + wire->name.str();
-    pass_->extra_args(std::vector<std::string>{base_selection, "%co:*", base_selection, "%d"}, 0, design_);
-    auto selected_cells = top_module->selected_cells();
-    return selected_cells.size() > 0;
 }
 
-RTLIL::Wire *Propagation::FindSinkWireOnPort(RTLIL::Cell *cell, const std::string &port_name)
+std::vector<RTLIL::Wire *> Propagation::FindSinkWiresOnPort(RTLIL::Cell *cell, const std::string &port_name)
 {
-    RTLIL::Wire *sink_wire = NULL;
-    if (!cell) {
-        return sink_wire;
-    }
-    RTLIL::Module *top_module = design_->top_module();
-    assert(top_module);
-    std::string base_selection = top_module->name.str() + "/c:" + cell->name.str();
-    pass_->extra_args(std::vector<std::string>{base_selection, "%co:+[" + port_name + "]", base_selection, "%d"}, 0, design_);
-    auto selected_wires = top_module->selected_wires();
-    // FIXME Handle more than one sink
-    assert(selected_wires.size() <= 1);
-    if (selected_wires.size() > 0) {
-        sink_wire = selected_wires.at(0);
+    auto sink_wires = connectivity_.OutputWires(cell, RTLIL::escape_id(port_name));
 #ifdef SDC_DEBUG
+    for (auto sink_wire : sink_wires) {
         log("Found sink wire: %s\n", RTLIL::unescape_id(sink_wire->name).c_str());
-#endif
     }
-    return sink_wire;
+#endif
+    return sink_wires;
 }
 
 void NaturalPropagation::Run()
@@ -140,8 +267,11 @@ void NaturalPropagation::Run()
 #ifdef SDC_DEBUG
     log("Start natural clock propagation\n");
 #endif
-    for (auto &clock : Clocks::GetClocks(design_)) {
+    for (auto &clock : Clocks::GetClocks(connectivity_.GetModule())) {
         auto &clock_wire = clock.second;
+        if (!StartClock(clock_wire)) {
+            continue;
+        }
 #ifdef SDC_DEBUG
         log("Processing clock %s\n", RTLIL::id2cstr(clock_wire->name));
 #endif
@@ -154,31 +284,14 @@ void NaturalPropagation::Run()
 #endif
 }
 
-std::vector<RTLIL::Wire *> NaturalPropagation::FindAliasWires(RTLIL::Wire *wire)
-{
-    RTLIL::Module *top_module = design_->top_module();
-    assert(top_module);
-    std::vector<RTLIL::Wire *> alias_wires;
-    pass_->extra_args(std::vector<std::string>{top_module->name.str() + "/w:" + wire->name.str(), "%a"}, 0, design_);
-    for (auto module : design_->selected_modules()) {
-        for (auto wire : module->selected_wires()) {
-            alias_wires.push_back(wire);
-        }
-    }
-    return alias_wires;
-}
+std::vector<RTLIL::Wire *> NaturalPropagation::FindAliasWires(RTLIL::Wire *wire) { return connectivity_.AliasWires(wire); }
 
 void BufferPropagation::Run()
 {
 #ifdef SDC_DEBUG
     log("Start buffer clock propagation\n");
-    log("IBUF pass\n");
 #endif
-    PropagateThroughBuffers(IBuf());
-#ifdef SDC_DEBUG
-    log("BUFG pass\n");
-#endif
-    PropagateThroughBuffers(Bufg());
+    PropagateThroughBuffers(Buffer::clock_buffers);
 #ifdef SDC_DEBUG
     log("Finish buffer clock propagation\n\n");
 #endif
@@ -189,49 +302,135 @@ void ClockDividerPropagation::Run()
 #ifdef SDC_DEBUG
     log("Start clock divider clock propagation\n");
 #endif
-    PropagateThroughClockDividers(Pll());
-    PropagateThroughBuffers(Bufg());
+    for (auto &divider : ClockDivider::clock_dividers) {
+        PropagateThroughClockDividers(divider);
+    }
+    PropagateThroughBuffers(Buffer::clock_buffers);
 #ifdef SDC_DEBUG
     log("Finish clock divider clock propagation\n\n");
 #endif
 }
 
-void ClockDividerPropagation::PropagateThroughClockDividers(ClockDivider divider)
+void ClockDividerPropagation::PropagateThroughClockDividers(const ClockDivider &divider)
 {
-    for (auto &clock : Clocks::GetClocks(design_)) {
+    for (auto &clock : Clocks::GetClocks(connectivity_.GetModule())) {
         auto &clock_wire = clock.second;
+        if (!StartClock(clock_wire)) {
+            continue;
+        }
 #ifdef SDC_DEBUG
         log("Processing clock %s\n", Clock::WireName(clock_wire).c_str());
 #endif
-        PropagateClocksForCellType(clock_wire, divider.type);
+        PropagateClocksForCellType(clock_wire, divider);
     }
 }
 
-void ClockDividerPropagation::PropagateClocksForCellType(RTLIL::Wire *driver_wire, const std::string &cell_type)
+void ClockDividerPropagation::PropagateClocksForCellType(RTLIL::Wire *driver_wire, const ClockDivider &divider)
 {
-    if (cell_type == "PLLE2_ADV") {
-        RTLIL::Cell *cell = NULL;
-        for (auto input : Pll::inputs) {
-            cell = FindSinkCellOnPort(driver_wire, input);
-            if (cell and RTLIL::unescape_id(cell->type) == cell_type) {
-                break;
+    pool<RTLIL::Cell *> cells;
+    for (auto &input : divider.inputs) {
+        for (auto cell : FindSinkCellsOfType(driver_wire, divider.type, input)) {
+            cells.insert(cell);
+        }
+    }
+    for (auto cell : cells) {
+        Pll pll(divider, cell, Clock::Period(driver_wire), Clock::RisingEdge(driver_wire));
+        for (auto &output : divider.outputs) {
+            for (auto wire : FindSinkWiresOnPort(cell, output)) {
+                // Don't add clocks on dangling wires
+                // TODO Remove the workaround with the WireHasSinkCell check once the following issue is fixed:
+                // https://github.com/SymbiFlow/yosys-f4pga-plugins/issues/59
+                if (WireHasSinkCell(wire)) {
+                    float clkout_period(pll.clkout_period.at(output));
+                    float clkout_rising_edge(pll.clkout_rising_edge.at(output));
+                    float clkout_falling_edge(pll.clkout_falling_edge.at(output));
+                    Clock::Add(wire, clkout_period, clkout_rising_edge, clkout_falling_edge, Clock::GENERATED);
+                }
             }
         }
-        if (!cell) {
-            return;
-        }
-        Pll pll(cell, Clock::Period(driver_wire), Clock::RisingEdge(driver_wire));
-        for (auto output : Pll::outputs) {
-            RTLIL::Wire *wire = FindSinkWireOnPort(cell, output);
-            // Don't add clocks on dangling wires
-            // TODO Remove the workaround with the WireHasSinkCell check once the following issue is fixed:
-            // https://github.com/SymbiFlow/yosys-f4pga-plugins/issues/59
-            if (wire && WireHasSinkCell(wire)) {
-                float clkout_period(pll.clkout_period.at(output));
-                float clkout_rising_edge(pll.clkout_rising_edge.at(output));
-                float clkout_falling_edge(pll.clkout_falling_edge.at(output));
-                Clock::Add(wire, clkout_period, clkout_rising_edge, clkout_falling_edge, Clock::GENERATED);
+    }
+}
+
+void HierarchicalPropagation::Run()
+{
+    for (auto module : ModulesTopDown()) {
+#ifdef SDC_DEBUG
+        log("Propagating clocks in module %s\n", RTLIL::id2cstr(module->name));
+#endif
+        const Connectivity &connectivity = GetConnectivity(module);
+        BufferPropagation(design_, connectivity).Run();
+        ClockDividerPropagation(design_, connectivity).Run();
+        PropagateIntoSubmodules(module);
+    }
+}
+
+std::vector<RTLIL::Module *> HierarchicalPropagation::ModulesTopDown()
+{
+    // Reversed post-order of the depth-first traversal of the instances
+    std::vector<RTLIL::Module *> order;
+    pool<RTLIL::Module *> visited;
+    std::vector<std::pair<RTLIL::Module *, std::vector<RTLIL::Cell *>>> stack;
+    RTLIL::Module *top_module = design_->top_module();
+    visited.insert(top_module);
+    stack.emplace_back(top_module, top_module->cells());
+    while (!stack.empty()) {
+        auto &cells = stack.back().second;
+        if (cells.empty()) {
+            order.push_back(stack.back().first);
+            stack.pop_back();
+            continue;
+        }
+        RTLIL::Module *submodule = design_->module(cells.back()->type);
+        cells.pop_back();
+        if (submodule && !submodule->get_blackbox_attribute() && visited.insert(submodule).second) {
+            stack.emplace_back(submodule, submodule->cells());
+        }
+    }
+    std::reverse(order.begin(), order.end());
+    return order;
+}
+
+void HierarchicalPropagation::PropagateIntoSubmodules(RTLIL::Module *module)
+{
+    const Connectivity &connectivity = GetConnectivity(module);
+    for (auto &clock : Clocks::GetClocks(module)) {
+        auto &clock_wire = clock.second;
+        ClockParams params{Clock::Period(clock_wire), Clock::RisingEdge(clock_wire), Clock::FallingEdge(clock_wire)};
+        for (auto &pin : connectivity.SinkPins(clock_wire)) {
+            RTLIL::Module *submodule = design_->module(pin.cell->type);
+            if (!submodule || submodule->get_blackbox_attribute()) {
+                continue;
+            }
+            RTLIL::Wire *port_wire = submodule->wire(pin.port);
+            if (!port_wire || !port_wire->port_input || port_wire->width != 1) {
+                continue;
             }
+            // Instances of the same module driven by different clocks can't be
+            // constrained without uniquifying the module
+            auto it = port_clocks_.find(port_wire);
+            if (it != port_clocks_.end()) {
+                auto &other = it->second.second;
+                if (other.period != params.period || other.rising_edge != params.rising_edge || other.falling_edge != params.falling_edge) {
+                    log_warning("Port %s of module %s is driven by clocks %s and %s with different parameters, keeping %s\n",
+                                RTLIL::id2cstr(port_wire->name), RTLIL::id2cstr(submodule->name), it->second.first.c_str(),
+                                Clock::Name(clock_wire).c_str(), it->second.first.c_str());
+                }
+                continue;
+            }
+#ifdef SDC_DEBUG
+            log("Clock %s enters port %s of cell %s\n", Clock::WireName(clock_wire).c_str(), RTLIL::id2cstr(pin.port), RTLIL::id2cstr(pin.cell->name));
+#endif
+            port_clocks_[port_wire] = std::make_pair(Clock::Name(clock_wire), params);
+            Clock::Add(port_wire, params.period, params.rising_edge, params.falling_edge, Clock::PROPAGATED);
         }
     }
 }
+
+const Connectivity &HierarchicalPropagation::GetConnectivity(RTLIL::Module *module)
+{
+    auto &connectivity = connectivities_[module];
+    if (!connectivity) {
+        connectivity.reset(new Connectivity(module));
+    }
+    return *connectivity;
+}
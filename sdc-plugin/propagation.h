@@ -19,35 +19,113 @@
 #define _PROPAGATION_H_
 
 #include "clocks.h"
+#include "connectivity.h"
+#include <memory>
 
 USING_YOSYS_NAMESPACE
 
+// Fan-out cones of the clocks from the previous propagate_clocks -incremental run.
+// Changes of the top module since then are tracked as a monitor, so only the
+// clocks reaching changed parts of the netlist are propagated again.
+class IncrementalPropagation : public RTLIL::Monitor
+{
+  public:
+    // Prepares a new run on the top module, dropping all cones if the module changed
+    void Start(RTLIL::Module *top_module);
+    // Returns true if no clock needs to be propagated again
+    bool IsUpToDate(const std::map<std::string, RTLIL::Wire *> &clocks);
+    // Returns true if the clock needs to be propagated in the current run.
+    // In that case the clock's cone is cleared and collected again by AddToCone.
+    bool NeedsPropagation(RTLIL::Wire *clock_wire);
+    // Adds the wires or the cell to the cone of the last clock accepted by NeedsPropagation
+    void AddToCone(const std::vector<RTLIL::Wire *> &wires);
+    void AddToCone(RTLIL::Cell *cell);
+    // Stores the state of the propagated clocks and starts tracking changes
+    void Finish(RTLIL::Design *design);
+
+    void notify_connect(RTLIL::Cell *cell, const RTLIL::IdString &port, const RTLIL::SigSpec &old_sig, const RTLIL::SigSpec &sig) override;
+    void notify_connect(RTLIL::Module *module, const RTLIL::SigSig &sigsig) override;
+    void notify_connect(RTLIL::Module *module, const std::vector<RTLIL::SigSig> &sigsig_vec) override;
+    void notify_blackout(RTLIL::Module *module) override;
+
+  private:
+    struct Cone {
+        // Clock parameters the cone was propagated with
+        std::string period;
+        std::string waveform;
+        // Hashes of the wires of the cone, wire hashes are never reused
+        pool<unsigned int> wires;
+        // Cells of the cone with their types and parameter hashes
+        dict<RTLIL::IdString, std::pair<RTLIL::IdString, unsigned int>> cells;
+    };
+
+    bool ConeChanged(RTLIL::Wire *clock_wire) const;
+    void AddChangedWires(RTLIL::Module *module, const RTLIL::SigSpec &sig);
+
+    // Past this number of changed wires it is faster to propagate everything again
+    static const size_t max_changed_wires = 1 << 20;
+
+    RTLIL::Module *module_ = nullptr;
+    unsigned int module_hash_ = 0;
+    bool valid_ = false;
+    pool<unsigned int> changed_wires_;
+    dict<unsigned int, Cone> cones_;
+    // Clocks propagated in the current run
+    dict<unsigned int, RTLIL::Wire *> propagated_;
+    Cone *current_cone_ = nullptr;
+};
+
 class Propagation
 {
   public:
-    Propagation(RTLIL::Design *design, Pass *pass) : design_(design), pass_(pass) {}
+    Propagation(RTLIL::Design *design, const Connectivity &connectivity, IncrementalPropagation *incremental = nullptr)
+        : design_(design), connectivity_(connectivity), incremental_(incremental)
+    {
+    }
     virtual ~Propagation() {}
 
     virtual void Run() = 0;
 
   protected:
     RTLIL::Design *design_;
-    Pass *pass_;
+    // Connectivity of the top module shared by all propagations
+    const Connectivity &connectivity_;
+    // Set when only the clocks with changed fan-out cones are propagated
+    IncrementalPropagation *incremental_;
+
+    // Returns false if the clock doesn't need to be propagated again
+    bool StartClock(RTLIL::Wire *clock_wire) { return !incremental_ || incremental_->NeedsPropagation(clock_wire); }
+
+    // Wire reached from a clock through a chain of buffers
+    struct BufferSink {
+        RTLIL::Wire *wire;
+        // Sum of the delays of the passed buffers
+        float delay;
+        // Product of the divisors of the passed buffers
+        float divisor;
+    };
 
     // This propagation doesn't change the clock so the sink wire is only marked
-    // as propagated clock signal, but has the properties of the driving clock
-    void PropagateThroughBuffers(Buffer buffer);
-    std::vector<RTLIL::Wire *> FindSinkWiresForCellType(RTLIL::Wire *driver_wire, const std::string &cell_type, const std::string &cell_port);
-    RTLIL::Cell *FindSinkCellOfType(RTLIL::Wire *wire, const std::string &type);
-    RTLIL::Cell *FindSinkCellOnPort(RTLIL::Wire *wire, const std::string &port);
-    RTLIL::Wire *FindSinkWireOnPort(RTLIL::Cell *cell, const std::string &port_name);
+    // as propagated clock signal, but has the properties of the driving clock.
+    // Clocks divided by regional buffers are added as generated clocks.
+    void PropagateThroughBuffers(const std::vector<Buffer> &buffers);
+    // Wires reachable from the driver wire through chains and fan-out trees of
+    // any of the given buffers
+    std::vector<BufferSink> FindBufferSinkWires(RTLIL::Wire *driver_wire, const std::vector<Buffer> &buffers);
+    std::vector<RTLIL::Cell *> FindSinkCellsOfType(RTLIL::Wire *wire, const std::string &type, const std::string &port);
+    std::vector<RTLIL::Wire *> FindSinkWiresOnPort(RTLIL::Cell *cell, const std::string &port_name);
     bool WireHasSinkCell(RTLIL::Wire *wire);
+    // Adds the queried wire and the found cells to the cone of the propagated clock
+    void RecordCone(RTLIL::Wire *wire, const std::vector<RTLIL::Cell *> &cells);
 };
 
 class NaturalPropagation : public Propagation
 {
   public:
-    NaturalPropagation(RTLIL::Design *design, Pass *pass) : Propagation(design, pass) {}
+    NaturalPropagation(RTLIL::Design *design, const Connectivity &connectivity, IncrementalPropagation *incremental = nullptr)
+        : Propagation(design, connectivity, incremental)
+    {
+    }
 
     void Run() override;
     std::vector<RTLIL::Wire *> FindAliasWires(RTLIL::Wire *wire);
@@ -56,7 +134,10 @@ class NaturalPropagation : public Propagation
 class BufferPropagation : public Propagation
 {
   public:
-    BufferPropagation(RTLIL::Design *design, Pass *pass) : Propagation(design, pass) {}
+    BufferPropagation(RTLIL::Design *design, const Connectivity &connectivity, IncrementalPropagation *incremental = nullptr)
+        : Propagation(design, connectivity, incremental)
+    {
+    }
 
     void Run() override;
 };
@@ -64,10 +145,36 @@ class BufferPropagation : public Propagation
 class ClockDividerPropagation : public Propagation
 {
   public:
-    ClockDividerPropagation(RTLIL::Design *design, Pass *pass) : Propagation(design, pass) {}
+    ClockDividerPropagation(RTLIL::Design *design, const Connectivity &connectivity, IncrementalPropagation *incremental = nullptr)
+        : Propagation(design, connectivity, incremental)
+    {
+    }
 
     void Run() override;
-    void PropagateClocksForCellType(RTLIL::Wire *driver_wire, const std::string &cell_type);
-    void PropagateThroughClockDividers(ClockDivider divider);
+    void PropagateClocksForCellType(RTLIL::Wire *driver_wire, const ClockDivider &divider);
+    void PropagateThroughClockDividers(const ClockDivider &divider);
+};
+
+// Propagation through the design hierarchy without flattening. The clocks
+// are propagated in each module with its own connectivity and passed from
+// the instantiating modules into the input ports of the submodules.
+class HierarchicalPropagation
+{
+  public:
+    explicit HierarchicalPropagation(RTLIL::Design *design) : design_(design) {}
+
+    void Run();
+
+  private:
+    // Modules reachable from the top module, each one after all its parents
+    std::vector<RTLIL::Module *> ModulesTopDown();
+    // Adds the clocks of the module to the input ports of the instantiated submodules
+    void PropagateIntoSubmodules(RTLIL::Module *module);
+    const Connectivity &GetConnectivity(RTLIL::Module *module);
+
+    RTLIL::Design *design_;
+    std::map<RTLIL::Module *, std::unique_ptr<Connectivity>> connectivities_;
+    // Clocks of the submodule ports with the name of the driving clock
+    dict<RTLIL::Wire *, std::pair<std::string, ClockParams>> port_clocks_;
 };
 #endif // PROPAGATION_H_
@@ -17,15 +17,23 @@
  */
 #include <algorithm>
 #include <array>
+#include <cerrno>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <functional>
 #include <istream>
 #include <iterator>
 #include <map>
 #include <memory>
 #include <ostream>
 #include <sstream>
+#include <stdexcept>
 #include <string>
 #include <vector>
 
+#include "../common/instrumentation.h"
+#include "../common/tcl_commands.h"
 #include "clocks.h"
 #include "kernel/log.h"
 #include "kernel/register.h"
@@ -40,35 +48,6 @@ USING_YOSYS_NAMESPACE
 
 PRIVATE_NAMESPACE_BEGIN
 
-struct ReadSdcCmd : public Frontend {
-    ReadSdcCmd() : Frontend("sdc", "Read SDC file") {}
-
-    void help() override
-    {
-        log("\n");
-        log("    read_sdc <filename>\n");
-        log("\n");
-        log("Read SDC file.\n");
-        log("\n");
-    }
-
-    void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *) override
-    {
-        if (args.size() < 2) {
-            log_cmd_error("Missing script file.\n");
-        }
-        log("\nReading clock constraints file(SDC)\n\n");
-        size_t argidx = 1;
-        extra_args(f, filename, args, argidx);
-        std::string content{std::istreambuf_iterator<char>(*f), std::istreambuf_iterator<char>()};
-        log("%s\n", content.c_str());
-        Tcl_Interp *interp = yosys_get_tcl_interp();
-        if (Tcl_EvalFile(interp, args[argidx].c_str()) != TCL_OK) {
-            log_cmd_error("TCL interpreter returned an error: %s\n", Tcl_GetStringResult(interp));
-        }
-    }
-};
-
 struct WriteSdcCmd : public Backend {
     WriteSdcCmd(SdcWriter &sdc_writer) : Backend("sdc", "Write SDC file"), sdc_writer_(sdc_writer) {}
 
@@ -86,6 +65,7 @@ struct WriteSdcCmd : public Backend {
 
     void execute(std::ostream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
     {
+        instrumentation::ScopedTimer timer(design, "sdc.write_sdc");
         size_t argidx;
         bool include_propagated = false;
         if (args.size() < 2) {
@@ -101,6 +81,7 @@ struct WriteSdcCmd : public Backend {
         }
         log("\nWriting out clock constraints file(SDC)\n");
         extra_args(f, filename, args, argidx);
+        Clocks::Invalidate();
         sdc_writer_.WriteSdc(design, *f, include_propagated);
     }
 
@@ -126,41 +107,52 @@ struct CreateClockCmd : public Pass {
         log("\n");
     }
 
-    void execute(std::vector<std::string> args, RTLIL::Design *design) override
+    // Options of the command, the remaining arguments are the targets
+    struct Options {
+        std::string name;
+        bool is_waveform_specified = false;
+        float rising_edge = 0;
+        float falling_edge = 0;
+        float period = 0;
+    };
+
+    template <typename Args> static size_t ParseOptions(const Args &args, Options &options)
     {
         size_t argidx;
-        std::string name;
-        bool is_waveform_specified(false);
-        float rising_edge(0);
-        float falling_edge(0);
-        float period(0);
-        if (args.size() < 4) {
-            log_cmd_error("Incorrect number of arguments\n");
-        }
         for (argidx = 1; argidx < args.size(); argidx++) {
-            std::string arg = args[argidx];
+            auto arg = args[argidx];
             if (arg == "-add" && argidx + 1 < args.size()) {
                 continue;
             }
             if (arg == "-name" && argidx + 1 < args.size()) {
-                name = args[++argidx];
+                options.name = std::string(args[++argidx]);
                 continue;
             }
             if (arg == "-period" && argidx + 1 < args.size()) {
-                period = std::stof(args[++argidx]);
+                options.period = std::stof(std::string(args[++argidx]));
                 continue;
             }
             if (arg == "-waveform" && argidx + 1 < args.size()) {
                 std::string edges(args[++argidx]);
                 std::copy_if(edges.begin(), edges.end(), edges.begin(), [](char c) { return c != '{' or c != '}'; });
                 std::stringstream ss(edges);
-                ss >> rising_edge >> falling_edge;
-                is_waveform_specified = true;
+                ss >> options.rising_edge >> options.falling_edge;
+                options.is_waveform_specified = true;
                 continue;
             }
             break;
         }
-        if (period <= 0) {
+        return argidx;
+    }
+
+    void execute(std::vector<std::string> args, RTLIL::Design *design) override
+    {
+        if (args.size() < 4) {
+            log_cmd_error("Incorrect number of arguments\n");
+        }
+        Options options;
+        size_t argidx = ParseOptions(args, options);
+        if (options.period <= 0) {
             log_cmd_error("Incorrect period value\n");
         }
         // Add "w:" prefix to selection arguments to enforce wire object
@@ -185,14 +177,82 @@ struct CreateClockCmd : public Pass {
         if (selected_wires.size() == 0) {
             log_cmd_error("Target selection is empty\n");
         }
-        if (name.empty()) {
-            name = RTLIL::unescape_id(selected_wires.at(0)->name);
+        Add(options, selected_wires);
+    }
+
+    // Native Tcl implementation of the command. Targets given as plain wire names
+    // are looked up directly, any other selection is handled by the Yosys pass.
+    static int TclCommand(ClientData, Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
+    {
+        tcl_commands::Args args(objc, objv);
+        if (args.size() < 4) {
+            return tcl_commands::error(interp, "Incorrect number of arguments");
         }
-        if (!is_waveform_specified) {
-            rising_edge = 0;
-            falling_edge = period / 2;
+        Options options;
+        size_t argidx;
+        try {
+            argidx = ParseOptions(args, options);
+        } catch (const std::logic_error &e) {
+            return tcl_commands::error(interp, "Incorrect period value");
+        }
+        if (options.period <= 0) {
+            return tcl_commands::error(interp, "Incorrect period value");
         }
-        Clock::Add(name, selected_wires, period, rising_edge, falling_edge, Clock::EXPLICIT);
+        RTLIL::Design *design = yosys_get_design();
+        std::vector<RTLIL::Wire *> selected_wires;
+        for (; argidx < args.size(); argidx++) {
+            auto target = args[argidx];
+            if (target.empty() || target.find_first_of("*?[]%@/:= \t") != std::string::npos) {
+                // Fall back to the pass for selection expressions
+                Tcl_Obj *yosys_cmd = Tcl_NewStringObj("yosys", -1);
+                Tcl_IncrRefCount(yosys_cmd);
+                std::vector<Tcl_Obj *> objs{yosys_cmd};
+                objs.insert(objs.end(), objv, objv + objc);
+                int result = Tcl_EvalObjv(interp, objs.size(), objs.data(), 0);
+                Tcl_DecrRefCount(yosys_cmd);
+                return result;
+            }
+            RTLIL::IdString id = RTLIL::escape_id(std::string(target));
+            for (auto module : design->modules()) {
+                if (module->get_blackbox_attribute()) {
+                    continue;
+                }
+                RTLIL::Wire *wire = module->wire(id);
+                if (wire && std::find(selected_wires.begin(), selected_wires.end(), wire) == selected_wires.end()) {
+                    selected_wires.push_back(wire);
+                }
+            }
+        }
+        if (selected_wires.size() == 0) {
+            return tcl_commands::error(interp, "Target selection is empty");
+        }
+        if (selected_wires.size() > 1) {
+            // Keep the order of the pass, the first wire names the clock
+            pool<RTLIL::Wire *> targets(selected_wires.begin(), selected_wires.end());
+            selected_wires.clear();
+            for (auto module : design->modules()) {
+                for (auto wire : module->wires()) {
+                    if (targets.count(wire)) {
+                        selected_wires.push_back(wire);
+                    }
+                }
+            }
+        }
+        Add(options, selected_wires);
+        return TCL_OK;
+    }
+
+    static void Add(Options &options, const std::vector<RTLIL::Wire *> &selected_wires)
+    {
+        Clocks::Invalidate();
+        if (options.name.empty()) {
+            options.name = RTLIL::unescape_id(selected_wires.at(0)->name);
+        }
+        if (!options.is_waveform_specified) {
+            options.rising_edge = 0;
+            options.falling_edge = options.period / 2;
+        }
+        Clock::Add(options.name, selected_wires, options.period, options.rising_edge, options.falling_edge, Clock::EXPLICIT);
     }
 
     void AddWirePrefix(std::vector<std::string> &args, size_t argidx)
@@ -202,13 +262,74 @@ struct CreateClockCmd : public Pass {
     }
 };
 
+struct ReadSdcCmd : public Frontend {
+    ReadSdcCmd(CreateClockCmd &create_clock_cmd, SetFalsePath &set_false_path_cmd, SetMaxDelay &set_max_delay_cmd,
+               SetClockGroups &set_clock_groups_cmd)
+        : Frontend("sdc", "Read SDC file"), create_clock_cmd_(create_clock_cmd), set_false_path_cmd_(set_false_path_cmd),
+          set_max_delay_cmd_(set_max_delay_cmd), set_clock_groups_cmd_(set_clock_groups_cmd)
+    {
+    }
+
+    void help() override
+    {
+        log("\n");
+        log("    read_sdc [-quiet] <filename>\n");
+        log("\n");
+        log("Read SDC file.\n");
+        log("\n");
+        log("The create_clock, set_false_path, set_max_delay and set_clock_groups\n");
+        log("commands are evaluated natively by the Tcl interpreter, without going\n");
+        log("through the Yosys pass invocation for each of them.\n");
+        log("\n");
+        log("    -quiet\n");
+        log("        Don't print the content of the file.\n");
+        log("\n");
+    }
+
+    void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
+    {
+        instrumentation::ScopedTimer timer(design, "sdc.read_sdc");
+        bool is_quiet(false);
+        size_t argidx;
+        for (argidx = 1; argidx < args.size(); argidx++) {
+            if (args[argidx] == "-quiet") {
+                is_quiet = true;
+                continue;
+            }
+            break;
+        }
+        if (argidx >= args.size()) {
+            log_cmd_error("Missing script file.\n");
+        }
+        log("\nReading clock constraints file(SDC)\n\n");
+        extra_args(f, filename, args, argidx);
+        if (!is_quiet) {
+            std::string content{std::istreambuf_iterator<char>(*f), std::istreambuf_iterator<char>()};
+            log("%s\n", content.c_str());
+        }
+        Tcl_Interp *interp = yosys_get_tcl_interp();
+        tcl_commands::register_native_command(create_clock_cmd_);
+        tcl_commands::register_native_command(set_false_path_cmd_);
+        tcl_commands::register_native_command(set_max_delay_cmd_);
+        tcl_commands::register_native_command(set_clock_groups_cmd_);
+        if (Tcl_EvalFile(interp, args[argidx].c_str()) != TCL_OK) {
+            log_cmd_error("TCL interpreter returned an error: %s\n", Tcl_GetStringResult(interp));
+        }
+    }
+
+    CreateClockCmd &create_clock_cmd_;
+    SetFalsePath &set_false_path_cmd_;
+    SetMaxDelay &set_max_delay_cmd_;
+    SetClockGroups &set_clock_groups_cmd_;
+};
+
 struct GetClocksCmd : public Pass {
-    GetClocksCmd() : Pass("get_clocks", "Create clock object") {}
+    GetClocksCmd() : Pass("get_clocks", "Create clock object") { tcl_commands::register_command(this); }
 
     void help() override
     {
         log("\n");
-        log("    get_clocks [-include_generated_clocks] [-of <nets>] "
+        log("    get_clocks [-include_generated_clocks] [-dict] [-stats] [-of <nets>] "
             "[<patterns>]\n");
         log("\n");
         log("Returns all clocks in the design.\n");
@@ -216,6 +337,15 @@ struct GetClocksCmd : public Pass {
         log("    -include_generated_clocks\n");
         log("        Include auto-generated clocks.\n");
         log("\n");
+        log("    -dict\n");
+        log("        Return a Tcl dict mapping each clock to a dict with its period,\n");
+        log("        waveform, type and source_wires instead of a list of names.\n");
+        log("        This fetches all the clock properties with a single call.\n");
+        log("\n");
+        log("    -stats\n");
+        log("        Print the period of every clock domain in the design and its\n");
+        log("        ABC9 delay. The shortest period sets the ABC9 delay target.\n");
+        log("\n");
         log("    -of\n");
         log("        Get clocks of these nets.\n");
         log("\n");
@@ -235,11 +365,36 @@ struct GetClocksCmd : public Pass {
         return port_list;
     }
 
+    void LogStats(RTLIL::Design *design, const std::map<std::string, RTLIL::Wire *> &clocks)
+    {
+        // Clock wires with the same name belong to the same domain
+        std::map<std::string, float> domains;
+        for (auto &clock : clocks) {
+            float period(Clock::Period(clock.second));
+            auto it = domains.emplace(Clock::Name(clock.second), period).first;
+            it->second = std::min(it->second, period);
+        }
+        int target(Clocks::Abc9DelayTarget(design));
+        log("Clock domains:\n");
+        for (auto &domain : domains) {
+            int abc9_delay(Clocks::Abc9Delay(domain.second));
+            log("  %-40s period %10.3f ns  ABC9 delay %8d ps%s\n", domain.first.c_str(), domain.second, abc9_delay,
+                abc9_delay == target ? "  (target)" : "");
+        }
+        if (domains.empty()) {
+            log("  none\n");
+        } else {
+            log("ABC9 delay target: %d ps\n", target);
+        }
+    }
+
     void execute(std::vector<std::string> args, RTLIL::Design *design) override
     {
 
         // Parse command arguments
         bool include_generated_clocks(false);
+        bool as_dict(false);
+        bool stats(false);
         std::vector<std::string> clocks_nets;
         size_t argidx(0);
 
@@ -250,6 +405,14 @@ struct GetClocksCmd : public Pass {
                 include_generated_clocks = true;
                 continue;
             }
+            if (arg == "-dict") {
+                as_dict = true;
+                continue;
+            }
+            if (arg == "-stats") {
+                stats = true;
+                continue;
+            }
             if (arg == "-of" and argidx + 1 < args.size()) {
                 clocks_nets = extract_list(args[++argidx]);
 #ifdef SDC_DEBUG
@@ -267,17 +430,22 @@ struct GetClocksCmd : public Pass {
         }
 
         // Parse object patterns
-        std::vector<std::string> clocks_list(args.begin() + argidx, args.end());
+        pool<std::string> clocks_list(args.begin() + argidx, args.end());
 
         // Fetch clocks in the design
+        Clocks::Invalidate();
         std::map<std::string, RTLIL::Wire *> clocks(Clocks::GetClocks(design));
         if (clocks.size() == 0) {
             log_warning("No clocks found in design\n");
         }
+        if (stats) {
+            LogStats(design, clocks);
+        }
 
-        // Extract clocks into tcl list
+        // Extract clocks into tcl list or dict
+        pool<std::string> clocks_nets_pool(clocks_nets.begin(), clocks_nets.end());
         Tcl_Interp *interp = yosys_get_tcl_interp();
-        Tcl_Obj *tcl_list = Tcl_NewListObj(0, NULL);
+        Tcl_Obj *tcl_result = as_dict ? Tcl_NewDictObj() : Tcl_NewListObj(0, NULL);
         for (auto &clock : clocks) {
             // Skip propagated clocks (i.e. clock wires with the same parameters
             // as the master clocks they originate from
@@ -289,19 +457,36 @@ struct GetClocksCmd : public Pass {
                 continue;
             }
             // Check if clock name is in the list of design clocks
-            if (clocks_list.size() > 0 and std::find(clocks_list.begin(), clocks_list.end(), clock.first) == clocks_list.end()) {
+            if (clocks_list.size() > 0 and !clocks_list.count(clock.first)) {
                 continue;
             }
             // Check if clock wire is in the -of list
-            if (clocks_nets.size() > 0 and std::find(clocks_nets.begin(), clocks_nets.end(), Clock::WireName(clock.second)) == clocks_nets.end()) {
+            if (clocks_nets_pool.size() > 0 and !clocks_nets_pool.count(Clock::WireName(clock.second))) {
                 continue;
             }
             auto &wire = clock.second;
             const char *name = RTLIL::id2cstr(wire->name);
             Tcl_Obj *name_obj = Tcl_NewStringObj(name, -1);
-            Tcl_ListObjAppendElement(interp, tcl_list, name_obj);
+            if (as_dict) {
+                Tcl_DictObjPut(interp, tcl_result, name_obj, ClockProperties(interp, wire));
+            } else {
+                Tcl_ListObjAppendElement(interp, tcl_result, name_obj);
+            }
         }
-        Tcl_SetObjResult(interp, tcl_list);
+        Tcl_SetObjResult(interp, tcl_result);
+    }
+
+    // Returns the dict with the properties of the clock
+    Tcl_Obj *ClockProperties(Tcl_Interp *interp, RTLIL::Wire *wire)
+    {
+        Tcl_Obj *waveform[] = {Tcl_NewDoubleObj(Clock::RisingEdge(wire)), Tcl_NewDoubleObj(Clock::FallingEdge(wire))};
+        const char *type = Clock::IsGenerated(wire) ? "generated" : Clock::IsPropagated(wire) ? "propagated" : "explicit";
+        Tcl_Obj *properties = Tcl_NewDictObj();
+        Tcl_DictObjPut(interp, properties, Tcl_NewStringObj("period", -1), Tcl_NewDoubleObj(Clock::Period(wire)));
+        Tcl_DictObjPut(interp, properties, Tcl_NewStringObj("waveform", -1), Tcl_NewListObj(2, waveform));
+        Tcl_DictObjPut(interp, properties, Tcl_NewStringObj("type", -1), Tcl_NewStringObj(type, -1));
+        Tcl_DictObjPut(interp, properties, Tcl_NewStringObj("source_wires", -1), Tcl_NewStringObj(Clock::SourceWireName(wire).c_str(), -1));
+        return properties;
     }
 };
 
@@ -311,38 +496,235 @@ struct PropagateClocksCmd : public Pass {
     void help() override
     {
         log("\n");
-        log("    propagate_clocks\n");
+        log("    propagate_clocks [-incremental] [-hierarchical]\n");
         log("\n");
         log("Propagate clock information throughout the design.\n");
         log("\n");
+        log("    -incremental\n");
+        log("        Propagate only the clocks that are new, have changed parameters or\n");
+        log("        whose fan-out cone changed since the last run with this option.\n");
+        log("        Changes of the top module are tracked between the runs.\n");
+        log("\n");
+        log("    -hierarchical\n");
+        log("        Propagate the clocks into the input ports of the submodule instances\n");
+        log("        and through the submodules, so the design doesn't need to be\n");
+        log("        flattened first. Instances of a module driven by different clocks\n");
+        log("        get the clock of the first one.\n");
+        log("\n");
     }
 
     void execute(std::vector<std::string> args, RTLIL::Design *design) override
     {
-        if (args.size() > 1) {
+        instrumentation::ScopedTimer timer(design, "sdc.propagate_clocks");
+        bool incremental(false);
+        bool hierarchical(false);
+        size_t argidx;
+        for (argidx = 1; argidx < args.size(); argidx++) {
+            if (args[argidx] == "-incremental") {
+                incremental = true;
+                continue;
+            }
+            if (args[argidx] == "-hierarchical") {
+                hierarchical = true;
+                continue;
+            }
+            break;
+        }
+        if (argidx < args.size()) {
             log_warning("Command accepts no arguments.\nAll will be ignored.\n");
         }
         if (!design->top_module()) {
             log_cmd_error("No top module selected\n");
         }
+        if (incremental && hierarchical) {
+            log_cmd_error("Options -incremental and -hierarchical can't be used together\n");
+        }
+        Propagate(design, incremental, hierarchical);
+    }
 
-        std::array<std::unique_ptr<Propagation>, 2> passes{std::unique_ptr<Propagation>(new BufferPropagation(design, this)),
-                                                           std::unique_ptr<Propagation>(new ClockDividerPropagation(design, this))};
-
+    // Propagates the clocks of the design with the options of the pass
+    void Propagate(RTLIL::Design *design, bool incremental, bool hierarchical)
+    {
         log("Perform clock propagation\n");
-
-        for (auto &pass : passes) {
-            pass->Run();
+        Clocks::Invalidate();
+        if (incremental) {
+            incremental_.Start(design->top_module());
+        }
+        if (hierarchical) {
+            HierarchicalPropagation(design).Run();
+        } else if (incremental && incremental_.IsUpToDate(Clocks::GetClocks(design))) {
+            log("Clocks are up to date\n");
+        } else {
+            // The propagation only adds attributes so the connectivity is built once
+            Connectivity connectivity(design->top_module());
+            IncrementalPropagation *tracking = incremental ? &incremental_ : nullptr;
+            std::array<std::unique_ptr<Propagation>, 2> passes{
+              std::unique_ptr<Propagation>(new BufferPropagation(design, connectivity, tracking)),
+              std::unique_ptr<Propagation>(new ClockDividerPropagation(design, connectivity, tracking))};
+
+            for (auto &pass : passes) {
+                pass->Run();
+            }
+            if (incremental) {
+                incremental_.Finish(design);
+            }
         }
 
         Clocks::UpdateAbc9DelayTarget(design);
+        if (instrumentation::registry().enabled()) {
+            instrumentation::count("sdc.propagate_clocks.clocks", Clocks::GetClocks(design).size());
+            instrumentation::sample_memory("sdc.propagate_clocks");
+        }
     }
+
+    // Fan-out cones of the clocks kept between the incremental runs
+    IncrementalPropagation incremental_;
+};
+
+struct ProcessConstraintsCmd : public Pass {
+    ProcessConstraintsCmd(PropagateClocksCmd &propagate_clocks_cmd, SdcWriter &sdc_writer)
+        : Pass("process_constraints", "Read, propagate and write out the timing constraints"), propagate_clocks_cmd_(propagate_clocks_cmd),
+          sdc_writer_(sdc_writer)
+    {
+    }
+
+    void help() override
+    {
+        log("\n");
+        log("    process_constraints [-part_json <part_json_filename>] [-xdc <filename>]...\n");
+        log("                        [-sdc <filename>]... [-hierarchical]\n");
+        log("                        [-include_propagated_clocks] [<filename>]\n");
+        log("\n");
+        log("Run the whole constraint flow of the design with a single command. This is\n");
+        log("a convenience wrapper which runs read_xdc, read_sdc, propagate_clocks and\n");
+        log("write_sdc in turn. The steps run the same way as the commands, except that\n");
+        log("the output reuses the clock table kept up to date by the propagation.\n");
+        log("The time spent in every step is printed at the end.\n");
+        log("\n");
+        log("    -part_json <part_json_filename>\n");
+        log("        Part file passed to read_xdc. Required with -xdc.\n");
+        log("\n");
+        log("    -xdc <filename>\n");
+        log("        Read the XDC file with read_xdc, which needs the XDC plugin.\n");
+        log("        May be given more than once.\n");
+        log("\n");
+        log("    -sdc <filename>\n");
+        log("        Read the SDC file with read_sdc. May be given more than once.\n");
+        log("\n");
+        log("    -hierarchical\n");
+        log("        Propagate the clocks like propagate_clocks -hierarchical.\n");
+        log("\n");
+        log("    -include_propagated_clocks\n");
+        log("        Write out all propagated clocks.\n");
+        log("\n");
+        log("    <filename>\n");
+        log("        SDC file to write. Nothing is written if it is not given.\n");
+        log("\n");
+    }
+
+    void execute(std::vector<std::string> args, RTLIL::Design *design) override
+    {
+        instrumentation::ScopedTimer timer(design, "sdc.process_constraints");
+        std::string part_json;
+        std::vector<std::string> xdc_files;
+        std::vector<std::string> sdc_files;
+        bool hierarchical(false);
+        bool include_propagated(false);
+        size_t argidx;
+        for (argidx = 1; argidx < args.size(); argidx++) {
+            if (args[argidx] == "-part_json" && argidx + 1 < args.size()) {
+                part_json = args[++argidx];
+                continue;
+            }
+            if (args[argidx] == "-xdc" && argidx + 1 < args.size()) {
+                xdc_files.push_back(args[++argidx]);
+                continue;
+            }
+            if (args[argidx] == "-sdc" && argidx + 1 < args.size()) {
+                sdc_files.push_back(args[++argidx]);
+                continue;
+            }
+            if (args[argidx] == "-hierarchical") {
+                hierarchical = true;
+                continue;
+            }
+            if (args[argidx] == "-include_propagated_clocks") {
+                include_propagated = true;
+                continue;
+            }
+            break;
+        }
+        std::string filename;
+        if (argidx < args.size()) {
+            filename = args[argidx++];
+        }
+        if (argidx < args.size()) {
+            log_cmd_error("Unexpected argument %s\n", args[argidx].c_str());
+        }
+        if (!xdc_files.empty() && part_json.empty()) {
+            log_cmd_error("Option -xdc requires -part_json\n");
+        }
+        if (!xdc_files.empty() && !pass_register.count("read_xdc")) {
+            log_cmd_error("Option -xdc requires the XDC plugin\n");
+        }
+        if (!design->top_module()) {
+            log_cmd_error("No top module selected\n");
+        }
+
+        // Wall time of every step, in seconds
+        std::vector<std::pair<std::string, double>> step_times;
+        auto run_step = [&](const std::string &name, const std::function<void()> &step) {
+            instrumentation::ScopedTimer step_timer("sdc.process_constraints." + name);
+            auto start = std::chrono::steady_clock::now();
+            step();
+            const std::chrono::duration<double> wall_time = std::chrono::steady_clock::now() - start;
+            step_times.emplace_back(name, wall_time.count());
+        };
+
+        run_step("read_xdc", [&]() {
+            for (auto &file : xdc_files) {
+                Pass::call(design, std::vector<std::string>{"read_xdc", "-part_json", part_json, file});
+            }
+        });
+        run_step("read_sdc", [&]() {
+            for (auto &file : sdc_files) {
+                Pass::call(design, std::vector<std::string>{"read_sdc", "-quiet", file});
+            }
+        });
+        run_step("propagate_clocks", [&]() { propagate_clocks_cmd_.Propagate(design, false, hierarchical); });
+        if (!filename.empty()) {
+            run_step("write_sdc", [&]() {
+                std::ofstream file(filename);
+                if (!file) {
+                    log_cmd_error("Can't open output file `%s' for writing: %s\n", filename.c_str(), strerror(errno));
+                }
+                log("\nWriting out clock constraints file(SDC)\n");
+                // The propagation keeps the clock table of the top module in
+                // sync, there is nothing to collect again since the last step
+                sdc_writer_.WriteSdc(design, file, include_propagated);
+            });
+        }
+
+        double total(0);
+        log("\nConstraint flow steps:\n");
+        for (auto &step : step_times) {
+            log("  %-20s %10.3f s\n", step.first.c_str(), step.second);
+            total += step.second;
+        }
+        log("  %-20s %10.3f s\n", "total", total);
+    }
+
+    PropagateClocksCmd &propagate_clocks_cmd_;
+    SdcWriter &sdc_writer_;
 };
 
 class SdcPlugin
 {
   public:
-    SdcPlugin() : write_sdc_cmd_(sdc_writer_), set_false_path_cmd_(sdc_writer_), set_max_delay_cmd_(sdc_writer_), set_clock_groups_cmd_(sdc_writer_)
+    SdcPlugin()
+        : read_sdc_cmd_(create_clock_cmd_, set_false_path_cmd_, set_max_delay_cmd_, set_clock_groups_cmd_), write_sdc_cmd_(sdc_writer_),
+          set_false_path_cmd_(sdc_writer_), set_max_delay_cmd_(sdc_writer_), set_clock_groups_cmd_(sdc_writer_),
+          process_constraints_cmd_(propagate_clocks_cmd_, sdc_writer_)
     {
         log("Loaded SDC plugin\n");
     }
@@ -355,6 +737,7 @@ class SdcPlugin
     SetFalsePath set_false_path_cmd_;
     SetMaxDelay set_max_delay_cmd_;
     SetClockGroups set_clock_groups_cmd_;
+    ProcessConstraintsCmd process_constraints_cmd_;
 
   private:
     SdcWriter sdc_writer_;
@@ -16,15 +16,26 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include "sdc_writer.h"
+#include <sstream>
 
 USING_YOSYS_NAMESPACE
 
 const std::map<ClockGroups::ClockGroupRelation, std::string> ClockGroups::relation_name_map = {
   {NONE, ""}, {ASYNCHRONOUS, "asynchronous"}, {PHYSICALLY_EXCLUSIVE, "physically_exclusive"}, {LOGICALLY_EXCLUSIVE, "logically_exclusive"}};
 
-void SdcWriter::AddFalsePath(FalsePath false_path) { false_paths_.push_back(false_path); }
+void SdcWriter::AddFalsePath(FalsePath false_path)
+{
+    if (unique_false_paths_.insert(false_path).second) {
+        false_paths_.push_back(std::move(false_path));
+    }
+}
 
-void SdcWriter::SetMaxDelay(TimingPath timing_path) { timing_paths_.push_back(timing_path); }
+void SdcWriter::SetMaxDelay(TimingPath timing_path)
+{
+    if (unique_timing_paths_.insert(timing_path).second) {
+        timing_paths_.push_back(std::move(timing_path));
+    }
+}
 
 void SdcWriter::AddClockGroup(ClockGroups::ClockGroup clock_group, ClockGroups::ClockGroupRelation relation)
 {
@@ -33,10 +44,14 @@ void SdcWriter::AddClockGroup(ClockGroups::ClockGroup clock_group, ClockGroups::
 
 void SdcWriter::WriteSdc(RTLIL::Design *design, std::ostream &file, bool include_propagated)
 {
-    WriteClocks(design, file, include_propagated);
-    WriteFalsePaths(file);
-    WriteMaxDelay(file);
-    WriteClockGroups(file);
+    // Format everything in memory and write it out at once
+    std::ostringstream buffer;
+    WriteClocks(design, buffer, include_propagated);
+    WriteFalsePaths(buffer);
+    WriteMaxDelay(buffer);
+    WriteClockGroups(buffer);
+    file << buffer.str();
+    file.flush();
 }
 
 void SdcWriter::WriteClocks(RTLIL::Design *design, std::ostream &file, bool include_propagated)
@@ -54,13 +69,13 @@ void SdcWriter::WriteClocks(RTLIL::Design *design, std::ostream &file, bool incl
         file << "create_clock -period " << Clock::Period(clock_wire);
         file << " -waveform {" << Clock::RisingEdge(clock_wire) << " " << Clock::FallingEdge(clock_wire) << "}";
         file << " " << Clock::SourceWireName(clock_wire);
-        file << std::endl;
+        file << '\n';
     }
 }
 
 void SdcWriter::WriteFalsePaths(std::ostream &file)
 {
-    for (auto path : false_paths_) {
+    for (auto &path : false_paths_) {
         file << "set_false_path";
         if (!path.from_pin.empty()) {
             file << " -from " << path.from_pin;
@@ -71,13 +86,13 @@ void SdcWriter::WriteFalsePaths(std::ostream &file)
         if (!path.to_pin.empty()) {
             file << " -to " << path.to_pin;
         }
-        file << std::endl;
+        file << '\n';
     }
 }
 
 void SdcWriter::WriteMaxDelay(std::ostream &file)
 {
-    for (auto path : timing_paths_) {
+    for (auto &path : timing_paths_) {
         file << "set_max_delay " << path.max_delay;
         if (!path.from_pin.empty()) {
             file << " -from " << path.from_pin;
@@ -85,7 +100,7 @@ void SdcWriter::WriteMaxDelay(std::ostream &file)
         if (!path.to_pin.empty()) {
             file << " -to " << path.to_pin;
         }
-        file << std::endl;
+        file << '\n';
     }
 }
 
@@ -106,6 +121,6 @@ void SdcWriter::WriteClockGroups(std::ostream &file)
         if (relation != ClockGroups::ClockGroupRelation::NONE) {
             file << "-" + ClockGroups::relation_name_map.at(static_cast<ClockGroups::ClockGroupRelation>(relation));
         }
-        file << std::endl;
+        file << '\n';
     }
 }
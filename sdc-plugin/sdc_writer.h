@@ -26,12 +26,32 @@ struct FalsePath {
     std::string from_pin;
     std::string to_pin;
     std::string through_pin;
+
+    bool operator==(const FalsePath &other) const
+    {
+        return from_pin == other.from_pin && to_pin == other.to_pin && through_pin == other.through_pin;
+    }
+    unsigned int hash() const
+    {
+        unsigned int h = mkhash_init;
+        h = mkhash(h, hash_ops<std::string>::hash(from_pin));
+        h = mkhash(h, hash_ops<std::string>::hash(to_pin));
+        return mkhash(h, hash_ops<std::string>::hash(through_pin));
+    }
 };
 
 struct TimingPath {
     std::string from_pin;
     std::string to_pin;
     float max_delay;
+
+    bool operator==(const TimingPath &other) const { return from_pin == other.from_pin && to_pin == other.to_pin && max_delay == other.max_delay; }
+    unsigned int hash() const
+    {
+        unsigned int h = mkhash_init;
+        h = mkhash(h, hash_ops<std::string>::hash(from_pin));
+        return mkhash(h, hash_ops<std::string>::hash(to_pin));
+    }
 };
 
 struct ClockGroups {
@@ -39,7 +59,13 @@ struct ClockGroups {
     using ClockGroup = std::vector<std::string>;
     static const std::map<ClockGroupRelation, std::string> relation_name_map;
 
-    void Add(ClockGroup &group, ClockGroupRelation relation) { groups_[relation].push_back(group); }
+    void Add(ClockGroup &group, ClockGroupRelation relation)
+    {
+        // The same group with the same relation is written out only once
+        if (unique_groups_.insert(std::make_pair(static_cast<int>(relation), group)).second) {
+            groups_[relation].push_back(group);
+        }
+    }
     std::vector<ClockGroup> GetGroups(ClockGroupRelation relation)
     {
         if (groups_.count(relation)) {
@@ -51,6 +77,7 @@ struct ClockGroups {
 
   private:
     std::map<ClockGroupRelation, std::vector<ClockGroup>> groups_;
+    pool<std::pair<int, ClockGroup>> unique_groups_;
 };
 
 class SdcWriter
@@ -67,8 +94,11 @@ class SdcWriter
     void WriteMaxDelay(std::ostream &file);
     void WriteClockGroups(std::ostream &file);
 
+    // Constraints in the order of their first insertion, duplicates are dropped
     std::vector<FalsePath> false_paths_;
+    pool<FalsePath> unique_false_paths_;
     std::vector<TimingPath> timing_paths_;
+    pool<TimingPath> unique_timing_paths_;
     ClockGroups clock_groups_;
 };
 
@@ -16,6 +16,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include "set_clock_groups.h"
+#include "../common/tcl_commands.h"
 #include "kernel/log.h"
 #include <regex>
 
@@ -43,21 +44,18 @@ void SetClockGroups::help()
     log("\n");
 }
 
-void SetClockGroups::execute(std::vector<std::string> args, RTLIL::Design *design)
+// Parses the command arguments, returns the error message on failure
+template <typename Args>
+static std::string ParseClockGroups(const Args &args, std::vector<ClockGroups::ClockGroup> &clock_groups,
+                                    ClockGroups::ClockGroupRelation &clock_groups_relation, bool &is_quiet)
 {
-    RTLIL::Module *top_module = design->top_module();
-    if (top_module == nullptr) {
-        log_cmd_error("No top module detected\n");
-    }
-
     size_t argidx;
-    bool is_quiet = false;
-    std::vector<ClockGroups::ClockGroup> clock_groups;
-    auto clock_groups_relation = ClockGroups::NONE;
+    is_quiet = false;
+    clock_groups_relation = ClockGroups::NONE;
 
     // Parse command arguments
     for (argidx = 1; argidx < args.size(); argidx++) {
-        std::string arg = args[argidx];
+        auto arg = args[argidx];
         if (arg == "-quiet") {
             is_quiet = true;
             continue;
@@ -79,19 +77,56 @@ void SetClockGroups::execute(std::vector<std::string> args, RTLIL::Design *desig
         if (arg == "-group" and argidx + 1 < args.size()) {
             ClockGroups::ClockGroup clock_group;
             while (argidx + 1 < args.size() and args[argidx + 1][0] != '-') {
-                clock_group.push_back(args[++argidx]);
+                clock_group.push_back(std::string(args[++argidx]));
             }
             clock_groups.push_back(clock_group);
             continue;
         }
 
         if (arg.size() > 0 and arg[0] == '-') {
-            log_cmd_error("Unknown option %s.\n", arg.c_str());
+            return "Unknown option " + std::string(arg) + ".\n";
         }
 
         break;
     }
+    return std::string();
+}
+
+void SetClockGroups::execute(std::vector<std::string> args, RTLIL::Design *design)
+{
+    RTLIL::Module *top_module = design->top_module();
+    if (top_module == nullptr) {
+        log_cmd_error("No top module detected\n");
+    }
 
+    bool is_quiet;
+    std::vector<ClockGroups::ClockGroup> clock_groups;
+    ClockGroups::ClockGroupRelation clock_groups_relation;
+    std::string error = ParseClockGroups(args, clock_groups, clock_groups_relation, is_quiet);
+    if (!error.empty()) {
+        log_cmd_error("%s", error.c_str());
+    }
+    Add(clock_groups, clock_groups_relation, is_quiet);
+}
+
+int SetClockGroups::TclCommand(ClientData data, Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
+{
+    if (yosys_get_design()->top_module() == nullptr) {
+        return tcl_commands::error(interp, "No top module detected");
+    }
+    bool is_quiet;
+    std::vector<ClockGroups::ClockGroup> clock_groups;
+    ClockGroups::ClockGroupRelation clock_groups_relation;
+    std::string error = ParseClockGroups(tcl_commands::Args(objc, objv), clock_groups, clock_groups_relation, is_quiet);
+    if (!error.empty()) {
+        return tcl_commands::error(interp, error);
+    }
+    static_cast<SetClockGroups *>(data)->Add(clock_groups, clock_groups_relation, is_quiet);
+    return TCL_OK;
+}
+
+void SetClockGroups::Add(const std::vector<ClockGroups::ClockGroup> &clock_groups, ClockGroups::ClockGroupRelation clock_groups_relation, bool is_quiet)
+{
     if (clock_groups.size()) {
         if (!is_quiet) {
             std::string msg = ClockGroups::relation_name_map.at(clock_groups_relation);
@@ -31,6 +31,11 @@ struct SetClockGroups : public Pass {
 
     void execute(std::vector<std::string> args, RTLIL::Design *design) override;
 
+    // Native Tcl implementation of the command, bypassing the Yosys pass invocation
+    static int TclCommand(ClientData data, Tcl_Interp *interp, int objc, Tcl_Obj *const objv[]);
+
+    void Add(const std::vector<ClockGroups::ClockGroup> &clock_groups, ClockGroups::ClockGroupRelation relation, bool is_quiet);
+
     SdcWriter &sdc_writer_;
 };
 
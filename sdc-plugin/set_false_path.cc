@@ -16,6 +16,7 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include "set_false_path.h"
+#include "../common/tcl_commands.h"
 #include "kernel/log.h"
 #include "sdc_writer.h"
 #include <regex>
@@ -47,53 +48,82 @@ void SetFalsePath::help()
     log("\n");
 }
 
-void SetFalsePath::execute(std::vector<std::string> args, RTLIL::Design *design)
+// Parses the command arguments, returns the error message on failure
+template <typename Args> static std::string ParseFalsePath(const Args &args, FalsePath &false_path, bool &is_quiet)
 {
-    RTLIL::Module *top_module = design->top_module();
-    if (top_module == nullptr) {
-        log_cmd_error("No top module detected\n");
-    }
-
     size_t argidx;
-    bool is_quiet = false;
-    std::string from_pin;
-    std::string to_pin;
-    std::string through_pin;
+    is_quiet = false;
 
     // Parse command arguments
     for (argidx = 1; argidx < args.size(); argidx++) {
-        std::string arg = args[argidx];
+        auto arg = args[argidx];
         if (arg == "-quiet") {
             is_quiet = true;
             continue;
         }
 
         if (arg == "-from" and argidx + 1 < args.size()) {
-            from_pin = args[++argidx];
+            false_path.from_pin = std::string(args[++argidx]);
             continue;
         }
 
         if (arg == "-to" and argidx + 1 < args.size()) {
-            to_pin = args[++argidx];
+            false_path.to_pin = std::string(args[++argidx]);
             continue;
         }
 
         if (arg == "-through" and argidx + 1 < args.size()) {
-            through_pin = args[++argidx];
+            false_path.through_pin = std::string(args[++argidx]);
             continue;
         }
 
         if (arg.size() > 0 and arg[0] == '-') {
-            log_cmd_error("Unknown option %s.\n", arg.c_str());
+            return "Unknown option " + std::string(arg) + ".\n";
         }
 
         break;
     }
+    return std::string();
+}
+
+void SetFalsePath::execute(std::vector<std::string> args, RTLIL::Design *design)
+{
+    RTLIL::Module *top_module = design->top_module();
+    if (top_module == nullptr) {
+        log_cmd_error("No top module detected\n");
+    }
+
+    bool is_quiet;
+    FalsePath false_path;
+    std::string error = ParseFalsePath(args, false_path, is_quiet);
+    if (!error.empty()) {
+        log_cmd_error("%s", error.c_str());
+    }
+    Add(false_path, is_quiet);
+}
+
+int SetFalsePath::TclCommand(ClientData data, Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
+{
+    if (yosys_get_design()->top_module() == nullptr) {
+        return tcl_commands::error(interp, "No top module detected");
+    }
+    bool is_quiet;
+    FalsePath false_path;
+    std::string error = ParseFalsePath(tcl_commands::Args(objc, objv), false_path, is_quiet);
+    if (!error.empty()) {
+        return tcl_commands::error(interp, error);
+    }
+    static_cast<SetFalsePath *>(data)->Add(false_path, is_quiet);
+    return TCL_OK;
+}
+
+void SetFalsePath::Add(const FalsePath &false_path, bool is_quiet)
+{
     if (!is_quiet) {
-        std::string msg = (from_pin.empty()) ? "" : "-from " + from_pin;
-        msg += (through_pin.empty()) ? "" : " -through " + through_pin;
-        msg += (to_pin.empty()) ? "" : " -to " + to_pin;
+        std::string msg = (false_path.from_pin.empty()) ? "" : "-from " + false_path.from_pin;
+        msg += (false_path.through_pin.empty()) ? "" : " -through " + false_path.through_pin;
+        msg += (false_path.to_pin.empty()) ? "" : " -to " + false_path.to_pin;
         log("Adding false path %s\n", msg.c_str());
     }
-    sdc_writer_.AddFalsePath(FalsePath{.from_pin = from_pin, .to_pin = to_pin, .through_pin = through_pin});
+    sdc_writer_.AddFalsePath(false_path);
 }
@@ -16,8 +16,10 @@
  * SPDX-License-Identifier: Apache-2.0
  */
 #include "set_max_delay.h"
+#include "../common/tcl_commands.h"
 #include "kernel/log.h"
 #include "sdc_writer.h"
+#include <stdexcept>
 
 USING_YOSYS_NAMESPACE
 
@@ -43,50 +45,83 @@ void SetMaxDelay::help()
     log("\n");
 }
 
-void SetMaxDelay::execute(std::vector<std::string> args, RTLIL::Design *design)
+// Parses the command arguments, returns the error message on failure
+template <typename Args> static std::string ParseMaxDelay(const Args &args, TimingPath &timing_path, bool &is_quiet)
 {
-    RTLIL::Module *top_module = design->top_module();
-    if (top_module == nullptr) {
-        log_cmd_error("No top module detected\n");
-    }
-
     size_t argidx;
-    bool is_quiet = false;
-    std::string from_pin;
-    std::string to_pin;
-    float max_delay(0.0);
+    is_quiet = false;
+    timing_path.max_delay = 0.0;
 
     // Parse command arguments
     for (argidx = 1; argidx < args.size(); argidx++) {
-        std::string arg = args[argidx];
+        auto arg = args[argidx];
         if (arg == "-quiet") {
             is_quiet = true;
             continue;
         }
 
         if (arg == "-from" and argidx + 1 < args.size()) {
-            from_pin = args[++argidx];
-            log("From: %s\n", from_pin.c_str());
+            timing_path.from_pin = std::string(args[++argidx]);
+            log("From: %s\n", timing_path.from_pin.c_str());
             continue;
         }
 
         if (arg == "-to" and argidx + 1 < args.size()) {
-            to_pin = args[++argidx];
-            log("To: %s\n", to_pin.c_str());
+            timing_path.to_pin = std::string(args[++argidx]);
+            log("To: %s\n", timing_path.to_pin.c_str());
             continue;
         }
 
         if (arg.size() > 0 and arg[0] == '-') {
-            log_cmd_error("Unknown option %s.\n", arg.c_str());
+            return "Unknown option " + std::string(arg) + ".\n";
         }
 
-        max_delay = std::stof(args[argidx]);
+        try {
+            timing_path.max_delay = std::stof(std::string(arg));
+        } catch (const std::logic_error &e) {
+            return "Incorrect max delay value " + std::string(arg) + ".\n";
+        }
+    }
+    return std::string();
+}
+
+void SetMaxDelay::execute(std::vector<std::string> args, RTLIL::Design *design)
+{
+    RTLIL::Module *top_module = design->top_module();
+    if (top_module == nullptr) {
+        log_cmd_error("No top module detected\n");
+    }
+
+    bool is_quiet;
+    TimingPath timing_path;
+    std::string error = ParseMaxDelay(args, timing_path, is_quiet);
+    if (!error.empty()) {
+        log_cmd_error("%s", error.c_str());
+    }
+    Add(timing_path, is_quiet);
+}
+
+int SetMaxDelay::TclCommand(ClientData data, Tcl_Interp *interp, int objc, Tcl_Obj *const objv[])
+{
+    if (yosys_get_design()->top_module() == nullptr) {
+        return tcl_commands::error(interp, "No top module detected");
     }
+    bool is_quiet;
+    TimingPath timing_path;
+    std::string error = ParseMaxDelay(tcl_commands::Args(objc, objv), timing_path, is_quiet);
+    if (!error.empty()) {
+        return tcl_commands::error(interp, error);
+    }
+    static_cast<SetMaxDelay *>(data)->Add(timing_path, is_quiet);
+    return TCL_OK;
+}
 
+void SetMaxDelay::Add(const TimingPath &timing_path, bool is_quiet)
+{
     if (!is_quiet) {
-        std::string msg = (from_pin.empty()) ? "" : "-from " + from_pin;
-        msg += (to_pin.empty()) ? "" : " -to " + to_pin;
-        log("Adding max path delay of %f on path %s\n", max_delay, msg.c_str());
+        std::string msg = (timing_path.from_pin.empty()) ? "" : "-from " + timing_path.from_pin;
+        msg += (timing_path.to_pin.empty()) ? "" : " -to " + timing_path.to_pin;
+        log("Adding max path delay of %f on path %s\n", timing_path.max_delay, msg.c_str());
     }
-    sdc_writer_.SetMaxDelay(TimingPath{.from_pin = from_pin, .to_pin = to_pin, .max_delay = max_delay});
+    sdc_writer_.SetMaxDelay(timing_path);
 }
@@ -10,3 +10,13 @@ read_sdc $::env(DESIGN_TOP).input.sdc
 
 # check that abc9.D was set to half the fastest clock period in the design
 scratchpad -assert abc9.D 5000
+
+# the stats report the clock domain that sets the target
+set log_file [test_output_path "abc9_stats.log"]
+tee -q -o $log_file get_clocks -stats
+set fh [open $log_file r]
+set log [read $fh]
+close $fh
+if { [string first "ABC9 delay target: 5000 ps" $log] < 0 } {
+    error "get_clocks -stats doesn't report the ABC9 delay target"
+}
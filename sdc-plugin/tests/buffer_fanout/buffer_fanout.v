@@ -0,0 +1,47 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module top (
+    input clk,
+    input [1:0] in,
+    output [1:0] out
+);
+
+  reg [1:0] cnt = 0;
+  wire clk_ibuf, clk_bufg_1, clk_bufg_2;
+  IBUF ibuf_inst (
+      .I(clk),
+      .O(clk_ibuf)
+  );
+  BUFG bufg_inst_1 (
+      .I(clk_ibuf),
+      .O(clk_bufg_1)
+  );
+  BUFG bufg_inst_2 (
+      .I(clk_ibuf),
+      .O(clk_bufg_2)
+  );
+
+  always @(posedge clk_bufg_1) begin
+    cnt[0] <= in[0];
+  end
+
+  always @(posedge clk_bufg_2) begin
+    cnt[1] <= in[1];
+  end
+
+  assign out = cnt;
+endmodule
@@ -0,0 +1,23 @@
+yosys -import
+if { [info procs read_sdc] == {} } { plugin -i sdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+read_verilog -specify -lib -D_EXPLICIT_CARRY +/xilinx/cells_sim.v
+read_verilog -lib +/xilinx/cells_xtra.v
+hierarchy -check -auto-top
+# Start flow after library reading
+synth_xilinx -flatten -abc9 -nosrl -nodsp -noclkbuf -run prepare:check
+
+# Read the design's timing constraints
+read_sdc $::env(DESIGN_TOP).input.sdc
+
+# Propagate the clocks
+propagate_clocks
+
+# The clock passes the chain of the global and horizontal buffers unchanged
+select -assert-count 1 w:clk_bufh a:PERIOD=10.000000 %i
+# The regional buffer divides the clock by 4
+select -assert-count 1 w:clk_bufr a:PERIOD=40.000000 %i
+# The MMCM output is multiplied by 2 and passed through the global buffer
+select -assert-count 1 w:clk_mmcm_bufg a:PERIOD=5.000000 %i
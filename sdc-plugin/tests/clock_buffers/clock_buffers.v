@@ -0,0 +1,75 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module top (
+    input clk,
+    input [2:0] in,
+    output [2:0] out
+);
+
+  reg [2:0] cnt = 0;
+  wire clk_ibuf, clk_bufgce, clk_bufh, clk_bufr, clk_mmcm, clk_mmcm_fb, clk_mmcm_bufg;
+  IBUF ibuf_inst (
+      .I(clk),
+      .O(clk_ibuf)
+  );
+  BUFGCE bufgce_inst (
+      .I (clk_ibuf),
+      .CE(1'b1),
+      .O (clk_bufgce)
+  );
+  BUFH bufh_inst (
+      .I(clk_bufgce),
+      .O(clk_bufh)
+  );
+  BUFR #(
+      .BUFR_DIVIDE("4")
+  ) bufr_inst (
+      .I  (clk_ibuf),
+      .CE (1'b1),
+      .CLR(1'b0),
+      .O  (clk_bufr)
+  );
+  MMCME2_ADV #(
+      .CLKFBOUT_MULT_F(10.0),
+      .CLKIN1_PERIOD(10.0),
+      .CLKOUT0_DIVIDE_F(5.0),
+      .DIVCLK_DIVIDE(1)
+  ) mmcm_inst (
+      .CLKIN1  (clk_ibuf),
+      .CLKFBIN (clk_mmcm_fb),
+      .CLKFBOUT(clk_mmcm_fb),
+      .CLKOUT0 (clk_mmcm)
+  );
+  BUFG bufg_inst (
+      .I(clk_mmcm),
+      .O(clk_mmcm_bufg)
+  );
+
+  always @(posedge clk_bufh) begin
+    cnt[0] <= in[0];
+  end
+
+  always @(posedge clk_bufr) begin
+    cnt[1] <= in[1];
+  end
+
+  always @(posedge clk_mmcm_bufg) begin
+    cnt[2] <= in[2];
+  end
+
+  assign out = cnt;
+endmodule
@@ -0,0 +1,13 @@
+yosys -import
+if { [info procs read_sdc] == {} } { plugin -i sdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+# Some of F4PGA expects eblifs with only one module.
+synth_xilinx -flatten -abc9 -nosrl -noclkbuf -nodsp
+
+# Reading the same constraints repeatedly must not duplicate them in the output
+read_sdc $::env(DESIGN_TOP).input.sdc
+read_sdc $::env(DESIGN_TOP).input.sdc
+
+write_sdc [test_output_path "constraints_dedup.sdc"]
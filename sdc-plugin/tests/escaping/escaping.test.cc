@@ -8,4 +8,8 @@ TEST(ClockTest, EscapeDollarSign)
     EXPECT_EQ(Clock::AddEscaping("wire_name"), "wire_name");
     // convert $wire_name to \$wire_name
     EXPECT_EQ(Clock::AddEscaping("$wire_name"), "\\$wire_name");
+    // convert every occurrence, e.g. in the names of flattened wires
+    EXPECT_EQ(Clock::AddEscaping("inst.$auto$wire$1"), "inst.\\$auto\\$wire\\$1");
+    EXPECT_EQ(Clock::AddEscaping("$"), "\\$");
+    EXPECT_EQ(Clock::AddEscaping(""), "");
 }
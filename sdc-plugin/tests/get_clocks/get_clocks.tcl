@@ -33,3 +33,26 @@ puts $fh [get_clocks -of [get_nets]]
 puts $fh [get_clocks -of [concat [get_nets clk2] [get_nets clk_int_1 clk]]]
 
 close $fh
+
+# The batch query returns the same clocks with their properties
+set clocks [get_clocks -dict -include_generated_clocks]
+if { [lsort [dict keys $clocks]] != [lsort [get_clocks -include_generated_clocks]] } {
+    error "get_clocks -dict returned different clocks: [dict keys $clocks]"
+}
+set clk_int_1 [dict get $clocks clk_int_1]
+if { [dict get $clk_int_1 period] != 10.0 || [dict get $clk_int_1 waveform] != {0.0 5.0} || [dict get $clk_int_1 type] != "explicit" } {
+    error "Wrong properties of clk_int_1: $clk_int_1"
+}
+if { [dict get $clocks main_clkout0 type] != "generated" } {
+    error "main_clkout0 is not a generated clock"
+}
+
+# Queries see the attributes set by the constraint commands run after them
+set filter {NAME == clk_slow}
+if { [get_nets -quiet -filter $filter] != {} } {
+    error "clk_slow exists before it is created"
+}
+create_clock -period 20.0 -name clk_slow clk2
+if { [llength [get_nets -quiet -filter $filter]] != 1 } {
+    error "get_nets doesn't return the net of clk_slow"
+}
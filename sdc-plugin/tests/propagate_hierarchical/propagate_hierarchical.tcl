@@ -0,0 +1,25 @@
+yosys -import
+if { [info procs read_sdc] == {} } { plugin -i sdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+read_verilog -specify -lib -D_EXPLICIT_CARRY +/xilinx/cells_sim.v
+read_verilog -lib +/xilinx/cells_xtra.v
+hierarchy -check -top top
+# Start flow after library reading, keeping the hierarchy
+synth_xilinx -nosrl -nodsp -noclkbuf -run prepare:check
+
+# Read the design's timing constraints
+read_sdc $::env(DESIGN_TOP).input.sdc
+
+# Propagate the clocks through the module boundaries
+propagate_clocks -hierarchical
+
+# The clock enters the submodule port and passes the buffer inside the submodule
+select -assert-count 1 top/w:clk_bufg top/a:PERIOD=10.000000 %i
+select -assert-count 1 sub/w:clk sub/a:PERIOD=10.000000 %i
+select -assert-count 1 sub/w:clk_local sub/a:PERIOD=10.000000 %i
+
+# The clocks are kept on the flattened wires of both instances
+flatten
+select -assert-count 2 top/w:sub_0.clk_local top/w:sub_1.clk_local %u top/a:CLOCK_SIGNAL=yes %i
@@ -0,0 +1,60 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module sub (
+    input clk,
+    input in,
+    output reg out
+);
+
+  wire clk_local;
+  BUFH bufh_inst (
+      .I(clk),
+      .O(clk_local)
+  );
+
+  always @(posedge clk_local) begin
+    out <= in;
+  end
+endmodule
+
+module top (
+    input clk,
+    input [1:0] in,
+    output [1:0] out
+);
+
+  wire clk_ibuf, clk_bufg;
+  IBUF ibuf_inst (
+      .I(clk),
+      .O(clk_ibuf)
+  );
+  BUFG bufg_inst (
+      .I(clk_ibuf),
+      .O(clk_bufg)
+  );
+
+  sub sub_0 (
+      .clk(clk_bufg),
+      .in (in[0]),
+      .out(out[0])
+  );
+  sub sub_1 (
+      .clk(clk_bufg),
+      .in (in[1]),
+      .out(out[1])
+  );
+endmodule
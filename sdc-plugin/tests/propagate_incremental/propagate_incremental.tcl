@@ -0,0 +1,32 @@
+yosys -import
+if { [info procs read_sdc] == {} } { plugin -i sdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+read_verilog -specify -lib -D_EXPLICIT_CARRY +/xilinx/cells_sim.v
+read_verilog -lib +/xilinx/cells_xtra.v
+hierarchy -check -auto-top
+# Start flow after library reading
+synth_xilinx -flatten -abc9 -nosrl -nodsp -noclkbuf -run prepare:check
+
+# Read the design's timing constraints
+read_sdc $::env(DESIGN_TOP).input.sdc
+
+# The first run propagates all clocks
+propagate_clocks -incremental
+select -assert-count 2 w:clk_bufg_1 w:clk_bufg_2 %u a:PERIOD=10.000000 %i
+
+# Nothing changed since the previous run
+set log_file [test_output_path "propagate_incremental.log"]
+tee -q -o $log_file propagate_clocks -incremental
+set fh [open $log_file r]
+set log [read $fh]
+close $fh
+if { [string first "Clocks are up to date" $log] < 0 } {
+    error "Clocks were propagated again although nothing changed"
+}
+
+# Changed parameters of the source clock need to be propagated
+create_clock -period 5.0 clk
+propagate_clocks -incremental
+select -assert-count 2 w:clk_bufg_1 w:clk_bufg_2 %u a:PERIOD=5.000000 %i
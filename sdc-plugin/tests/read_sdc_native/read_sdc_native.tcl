@@ -0,0 +1,12 @@
+yosys -import
+if { [info procs read_sdc] == {} } { plugin -i sdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(DESIGN_TOP).v
+# Some of F4PGA expects eblifs with only one module.
+synth_xilinx -flatten -abc9 -nosrl -noclkbuf -nodsp
+
+# The constraints are evaluated by the native Tcl commands
+read_sdc -quiet $::env(DESIGN_TOP).input.sdc
+
+write_sdc [test_output_path "read_sdc_native.sdc"]
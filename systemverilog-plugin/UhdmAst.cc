@@ -2,14 +2,17 @@
 #include <cstdlib>
 #include <cstring>
 #include <functional>
+#include <initializer_list>
 #include <iostream>
 #include <limits>
 #include <regex>
 #include <string>
+#include <string_view>
 #include <utility>
 #include <vector>
 
 #include "UhdmAst.h"
+#include "uhdmaststructlayout.h"
 #include "frontends/ast/ast.h"
 #include "libs/sha1/sha1.h"
 
@@ -112,6 +115,59 @@ void attr_id_cleanup()
     attr_id::already_initialized = false;
 }
 
+// AST nodes allocated by the conversion. All nodes are allocated through the
+// helpers below so that the count reported with -debug and -stats is complete.
+// Counting the nodes of a copied subtree walks it, so it's only done when the
+// count is reported. The conversion is serial, so a plain counter is enough.
+static struct {
+    bool count_copies = false;
+    size_t count = 0;
+} ast_nodes;
+
+static size_t count_ast_nodes(const AST::AstNode *node)
+{
+    size_t count = 1;
+    for (const auto *child : node->children)
+        count += count_ast_nodes(child);
+    for (const auto &attr : node->attributes)
+        count += count_ast_nodes(attr.second);
+    return count;
+}
+
+// Counts the nodes of a subtree allocated outside of the helpers
+static AST::AstNode *counted_ast_nodes(AST::AstNode *node)
+{
+    if (node && ast_nodes.count_copies)
+        ast_nodes.count += count_ast_nodes(node);
+    return node;
+}
+
+template <typename... Args> static AST::AstNode *new_ast_node(Args &&... args)
+{
+    ast_nodes.count++;
+    return new AST::AstNode(std::forward<Args>(args)...);
+}
+
+static AST::AstNode *clone_ast_node(const AST::AstNode *node) { return counted_ast_nodes(node->clone()); }
+
+static AST::AstNode *mkconst_int(uint32_t v, bool is_signed, int width = 32)
+{
+    ast_nodes.count++;
+    return AST::AstNode::mkconst_int(v, is_signed, width);
+}
+
+static AST::AstNode *mkconst_str(const std::string &str)
+{
+    ast_nodes.count++;
+    return AST::AstNode::mkconst_str(str);
+}
+
+static AST::AstNode *mkconst_str(const std::vector<RTLIL::State> &v)
+{
+    ast_nodes.count++;
+    return AST::AstNode::mkconst_str(v);
+}
+
 static AST::AstNode *get_attribute(AST::AstNode *node, const IdString &attribute)
 {
     log_assert(node);
@@ -137,9 +193,10 @@ static void delete_attribute(AST::AstNode *node, const IdString &attribute)
     if (!node)
         return;
 
-    if (node->attributes.count(attribute)) {
-        delete node->attributes[attribute];
-        node->attributes.erase(attribute);
+    auto it = node->attributes.find(attribute);
+    if (it != node->attributes.end()) {
+        delete it->second;
+        node->attributes.erase(it);
     }
 }
 
@@ -147,7 +204,8 @@ static void delete_attribute(AST::AstNode *node, const IdString &attribute)
 // The attributes beloning to Yosys are *not* deleted here.
 static void delete_internal_attributes(AST::AstNode *node)
 {
-    if (!node)
+    // Most of the nodes don't have any attributes
+    if (!node || node->attributes.empty())
         return;
 
     for (auto &attr : {UhdmAst::partial(), UhdmAst::packed_ranges(), UhdmAst::unpacked_ranges(), UhdmAst::force_convert(), UhdmAst::is_imported(),
@@ -197,27 +255,35 @@ static void delete_children(AST::AstNode *node)
 
 static void simplify_sv(AST::AstNode *current_node, AST::AstNode *parent_node);
 
+// Strip the hierarchical prefix (up to the last '@') from the name in place.
+// Symbol names must begin with '\', which replaces the stripped prefix.
 static void sanitize_symbol_name(std::string &name)
 {
     if (!name.empty()) {
         auto pos = name.find_last_of('@');
-        name = name.substr(pos + 1);
-        // symbol names must begin with '\'
-        name.insert(0, "\\");
+        name.replace(0, pos == std::string::npos ? 0 : pos + 1, 1, '\\');
     }
 }
 
-static std::string get_object_name(vpiHandle obj_h, const std::vector<int> &name_fields = {vpiName})
+static std::string get_object_name(vpiHandle obj_h, std::initializer_list<int> name_fields = {vpiName})
 {
-    std::string objectName;
     for (auto name : name_fields) {
         if (auto s = vpi_get_str(name, obj_h)) {
-            objectName = s;
-            sanitize_symbol_name(objectName);
-            break;
+            std::string_view raw_name(s);
+            if (raw_name.empty())
+                return std::string();
+            // Build the sanitized name directly, without intermediate copies
+            auto pos = raw_name.find_last_of('@');
+            if (pos != std::string_view::npos)
+                raw_name.remove_prefix(pos + 1);
+            std::string objectName;
+            objectName.reserve(raw_name.size() + 1);
+            objectName += '\\';
+            objectName += raw_name;
+            return objectName;
         }
     }
-    return objectName;
+    return std::string();
 }
 
 static std::string get_name(vpiHandle obj_h) { return get_object_name(obj_h, {vpiName, vpiDefName}); }
@@ -226,15 +292,15 @@ static std::string strip_package_name(std::string name)
 {
     auto sep_index = name.find("::");
     if (sep_index != string::npos) {
-        name = name.substr(sep_index + 1);
-        name[0] = '\\';
+        // Replace "package::" with the leading '\' in place
+        name.replace(0, sep_index + 2, 1, '\\');
     }
     return name;
 }
 
 static AST::AstNode *mkconst_real(double d)
 {
-    AST::AstNode *node = new AST::AstNode(AST::AST_REALVALUE);
+    AST::AstNode *node = new_ast_node(AST::AST_REALVALUE);
     node->realvalue = d;
     return node;
 }
@@ -242,12 +308,12 @@ static AST::AstNode *mkconst_real(double d)
 static AST::AstNode *make_range(int left, int right, bool is_signed = false)
 {
     // generate a pre-validated range node for a fixed signal range.
-    auto range = new AST::AstNode(AST::AST_RANGE);
+    auto range = new_ast_node(AST::AST_RANGE);
     range->range_left = left;
     range->range_right = right;
     range->range_valid = true;
-    range->children.push_back(AST::AstNode::mkconst_int(left, true));
-    range->children.push_back(AST::AstNode::mkconst_int(right, true));
+    range->children.push_back(mkconst_int(left, true));
+    range->children.push_back(mkconst_int(right, true));
     range->is_signed = is_signed;
     return range;
 }
@@ -255,17 +321,17 @@ static AST::AstNode *make_range(int left, int right, bool is_signed = false)
 static void copy_packed_unpacked_attribute(AST::AstNode *from, AST::AstNode *to)
 {
     if (!to->attributes.count(UhdmAst::packed_ranges()))
-        to->attributes[UhdmAst::packed_ranges()] = AST::AstNode::mkconst_int(1, false, 1);
+        to->attributes[UhdmAst::packed_ranges()] = mkconst_int(1, false, 1);
     if (!to->attributes.count(UhdmAst::unpacked_ranges()))
-        to->attributes[UhdmAst::unpacked_ranges()] = AST::AstNode::mkconst_int(1, false, 1);
+        to->attributes[UhdmAst::unpacked_ranges()] = mkconst_int(1, false, 1);
     if (from->attributes.count(UhdmAst::packed_ranges())) {
         for (auto r : from->attributes[UhdmAst::packed_ranges()]->children) {
-            to->attributes[UhdmAst::packed_ranges()]->children.push_back(r->clone());
+            to->attributes[UhdmAst::packed_ranges()]->children.push_back(clone_ast_node(r));
         }
     }
     if (from->attributes.count(UhdmAst::unpacked_ranges())) {
         for (auto r : from->attributes[UhdmAst::unpacked_ranges()]->children) {
-            to->attributes[UhdmAst::unpacked_ranges()]->children.push_back(r->clone());
+            to->attributes[UhdmAst::unpacked_ranges()]->children.push_back(clone_ast_node(r));
         }
     }
 }
@@ -281,11 +347,18 @@ static int get_max_offset_struct(AST::AstNode *node)
     return node->range_left;
 }
 
-static void visitEachDescendant(AST::AstNode *node, const std::function<void(AST::AstNode *)> &f)
+// Call `f` on every descendant of `node` in pre-order.
+// Uses an explicit stack, so deep trees don't exhaust the call stack.
+// Children added to a node by `f` are visited too.
+template <typename F> static void visitEachDescendant(AST::AstNode *node, F &&f)
 {
-    for (auto child : node->children) {
+    std::vector<AST::AstNode *> stack(node->children.rbegin(), node->children.rend());
+    while (!stack.empty()) {
+        AST::AstNode *child = stack.back();
+        stack.pop_back();
         f(child);
-        visitEachDescendant(child, f);
+        if (child)
+            stack.insert(stack.end(), child->children.rbegin(), child->children.rend());
     }
 }
 
@@ -293,7 +366,7 @@ static void add_multirange_wire(AST::AstNode *node, std::vector<AST::AstNode *>
                                 bool reverse = true)
 {
     delete_attribute(node, UhdmAst::packed_ranges());
-    node->attributes[UhdmAst::packed_ranges()] = AST::AstNode::mkconst_int(1, false, 1);
+    node->attributes[UhdmAst::packed_ranges()] = mkconst_int(1, false, 1);
     if (!packed_ranges.empty()) {
         if (reverse)
             std::reverse(packed_ranges.begin(), packed_ranges.end());
@@ -301,7 +374,7 @@ static void add_multirange_wire(AST::AstNode *node, std::vector<AST::AstNode *>
     }
 
     delete_attribute(node, UhdmAst::unpacked_ranges());
-    node->attributes[UhdmAst::unpacked_ranges()] = AST::AstNode::mkconst_int(1, false, 1);
+    node->attributes[UhdmAst::unpacked_ranges()] = mkconst_int(1, false, 1);
     if (!unpacked_ranges.empty()) {
         if (reverse)
             std::reverse(unpacked_ranges.begin(), unpacked_ranges.end());
@@ -320,7 +393,7 @@ static size_t add_multirange_attribute(AST::AstNode *wire_node, const std::vecto
     for (size_t i = 0; i < ranges.size(); i++) {
         log_assert(AST_INTERNAL::current_ast_mod);
         if (ranges[i]->children.size() == 1) {
-            ranges[i]->children.push_back(ranges[i]->children[0]->clone());
+            ranges[i]->children.push_back(clone_ast_node(ranges[i]->children[0]));
         }
         simplify_sv(ranges[i], wire_node);
         while (simplify(ranges[i], true, false, false, 1, -1, false, false)) {
@@ -356,14 +429,112 @@ static size_t add_multirange_attribute(AST::AstNode *wire_node, const std::vecto
     return size;
 }
 
-static AST::AstNode *convert_range(AST::AstNode *id, int packed_ranges_size, int unpacked_ranges_size, int i)
+// Returns true and sets `value` when `node` is a small, fully defined, non-negative constant
+static bool get_const_index(const AST::AstNode *node, int &value)
+{
+    if (node->type != AST::AST_CONSTANT || node->bits.size() > 32)
+        return false;
+    for (auto bit : node->bits) {
+        if (bit != RTLIL::State::S0 && bit != RTLIL::State::S1)
+            return false;
+    }
+    value = node->asInt(node->is_signed);
+    return value >= 0;
+}
+
+// Builds `lhs op rhs`, folding it into a single constant when both operands are constant indices.
+// Accesses to large memories with constant addresses then map to a range of two constants
+// instead of a tree of arithmetic nodes per selected dimension.
+static AST::AstNode *make_index_op(AST::AstNodeType type, AST::AstNode *lhs, AST::AstNode *rhs)
+{
+    int lhs_value, rhs_value;
+    if (get_const_index(lhs, lhs_value) && get_const_index(rhs, rhs_value)) {
+        int64_t value = 0;
+        switch (type) {
+        case AST::AST_ADD:
+            value = int64_t(lhs_value) + rhs_value;
+            break;
+        case AST::AST_SUB:
+            value = int64_t(lhs_value) - rhs_value;
+            break;
+        case AST::AST_MUL:
+            value = int64_t(lhs_value) * rhs_value;
+            break;
+        default:
+            log_abort();
+        }
+        if (value >= 0 && value <= std::numeric_limits<int>::max()) {
+            delete lhs;
+            delete rhs;
+            return mkconst_int(value, false);
+        }
+    }
+    return new_ast_node(type, lhs, rhs);
+}
+
+static AST::AstNode *convert_range(AST::AstNode *id, const AST::AstNode *wire_node, const std::vector<int> &single_elem_size, int i)
+{
+    AST::AstNode *result = nullptr;
+    // we want to start converting from the end
+    if (i < static_cast<int>(id->children.size()) - 1) {
+        result = convert_range(id, wire_node, single_elem_size, i + 1);
+    }
+    // special case, we want to select whole wire
+    if (id->children.size() == 0 && i == 0) {
+        return make_range(single_elem_size[i] - 1, 0);
+    }
+    AST::AstNode *range_left = clone_ast_node(id->children[i]->children[0]);
+    AST::AstNode *range_right =
+      id->children[i]->children.size() == 2 ? clone_ast_node(id->children[i]->children[1]) : clone_ast_node(range_left);
+    if (!wire_node->multirange_swapped.empty()) {
+        bool is_swapped = wire_node->multirange_swapped[wire_node->multirange_swapped.size() - i - 1];
+        auto right_idx = wire_node->multirange_dimensions.size() - (i * 2) - 2;
+        if (is_swapped) {
+            auto left_idx = wire_node->multirange_dimensions.size() - (i * 2) - 1;
+            auto elem_size = wire_node->multirange_dimensions[left_idx] - wire_node->multirange_dimensions[right_idx];
+            range_left = make_index_op(AST::AST_SUB, mkconst_int(elem_size - 1, false), range_left);
+            range_right = make_index_op(AST::AST_SUB, mkconst_int(elem_size - 1, false), range_right);
+        } else if (wire_node->multirange_dimensions[right_idx] != 0) {
+            range_left = make_index_op(AST::AST_SUB, range_left, mkconst_int(wire_node->multirange_dimensions[right_idx], false));
+            range_right = make_index_op(AST::AST_SUB, range_right, mkconst_int(wire_node->multirange_dimensions[right_idx], false));
+        }
+    }
+    range_right = make_index_op(AST::AST_MUL, range_right, mkconst_int(single_elem_size[i + 1], false));
+    if (result) {
+        // Reuse the inner range bounds instead of cloning them
+        AST::AstNode *inner_left = result->children[0];
+        AST::AstNode *inner_right = result->children[1];
+        result->children.clear();
+        delete result;
+        delete range_left;
+        // make_index_op deletes its operands when it folds them, clone before the first use
+        AST::AstNode *inner_right_copy = clone_ast_node(inner_right);
+        range_right = make_index_op(AST::AST_ADD, range_right, inner_right);
+        range_left = make_index_op(AST::AST_SUB, make_index_op(AST::AST_ADD, clone_ast_node(range_right), inner_left), inner_right_copy);
+    } else {
+        range_left = make_index_op(
+          AST::AST_SUB,
+          make_index_op(AST::AST_MUL, make_index_op(AST::AST_ADD, range_left, mkconst_int(1, false)),
+                        mkconst_int(single_elem_size[i + 1], false)),
+          mkconst_int(1, false));
+    }
+    // return range from *current* selected range
+    // in the end, it results in whole selected range
+    return new_ast_node(AST::AST_RANGE, range_left, range_right);
+}
+
+static AST::AstNode *convert_range(AST::AstNode *id, int packed_ranges_size, int unpacked_ranges_size)
 {
     log_assert(AST_INTERNAL::current_ast_mod);
     log_assert(AST_INTERNAL::current_scope.count(id->str));
     AST::AstNode *wire_node = AST_INTERNAL::current_scope[id->str];
     log_assert(!wire_node->multirange_dimensions.empty());
-    int elem_size = 1;
+    log_assert(static_cast<int>(id->children.size()) <= (unpacked_ranges_size + packed_ranges_size));
+    log_assert(!id->children.empty());
+    // Element sizes of all dimensions are computed once per identifier, not per converted dimension
     std::vector<int> single_elem_size;
+    single_elem_size.reserve(wire_node->multirange_dimensions.size() / 2 + 1);
+    int elem_size = 1;
     single_elem_size.push_back(elem_size);
     for (size_t j = 0; (j + 1) < wire_node->multirange_dimensions.size(); j = j + 2) {
         // The ranges' widths are placed on odd indices of multirange_dimensions.
@@ -371,61 +542,7 @@ static AST::AstNode *convert_range(AST::AstNode *id, int packed_ranges_size, int
         single_elem_size.push_back(elem_size);
     }
     std::reverse(single_elem_size.begin(), single_elem_size.end());
-    log_assert(i < (unpacked_ranges_size + packed_ranges_size));
-    log_assert(!id->children.empty());
-    AST::AstNode *result = nullptr;
-    // we want to start converting from the end
-    if (i < static_cast<int>(id->children.size()) - 1) {
-        result = convert_range(id, packed_ranges_size, unpacked_ranges_size, i + 1);
-    }
-    // special case, we want to select whole wire
-    if (id->children.size() == 0 && i == 0) {
-        result = make_range(single_elem_size[i] - 1, 0);
-    } else {
-        AST::AstNode *range_left = nullptr;
-        AST::AstNode *range_right = nullptr;
-        if (id->children[i]->children.size() == 2) {
-            range_left = id->children[i]->children[0]->clone();
-            range_right = id->children[i]->children[1]->clone();
-        } else {
-            range_left = id->children[i]->children[0]->clone();
-            range_right = id->children[i]->children[0]->clone();
-        }
-        if (!wire_node->multirange_swapped.empty()) {
-            bool is_swapped = wire_node->multirange_swapped[wire_node->multirange_swapped.size() - i - 1];
-            auto right_idx = wire_node->multirange_dimensions.size() - (i * 2) - 2;
-            if (is_swapped) {
-                auto left_idx = wire_node->multirange_dimensions.size() - (i * 2) - 1;
-                auto elem_size = wire_node->multirange_dimensions[left_idx] - wire_node->multirange_dimensions[right_idx];
-                range_left = new AST::AstNode(AST::AST_SUB, AST::AstNode::mkconst_int(elem_size - 1, false), range_left);
-                range_right = new AST::AstNode(AST::AST_SUB, AST::AstNode::mkconst_int(elem_size - 1, false), range_right);
-            } else if (wire_node->multirange_dimensions[right_idx] != 0) {
-                range_left =
-                  new AST::AstNode(AST::AST_SUB, range_left, AST::AstNode::mkconst_int(wire_node->multirange_dimensions[right_idx], false));
-                range_right =
-                  new AST::AstNode(AST::AST_SUB, range_right, AST::AstNode::mkconst_int(wire_node->multirange_dimensions[right_idx], false));
-            }
-        }
-        if (!result) {
-            range_left =
-              new AST::AstNode(AST::AST_SUB,
-                               new AST::AstNode(AST::AST_MUL, new AST::AstNode(AST::AST_ADD, range_left, AST::AstNode::mkconst_int(1, false)),
-                                                AST::AstNode::mkconst_int(single_elem_size[i + 1], false)),
-                               AST::AstNode::mkconst_int(1, false));
-        }
-        range_right = new AST::AstNode(AST::AST_MUL, range_right, AST::AstNode::mkconst_int(single_elem_size[i + 1], false));
-        if (result) {
-            range_right = new AST::AstNode(AST::AST_ADD, range_right, result->children[1]->clone());
-            delete range_left;
-            range_left = new AST::AstNode(AST::AST_SUB, new AST::AstNode(AST::AST_ADD, range_right->clone(), result->children[0]->clone()),
-                                          result->children[1]->clone());
-            delete result;
-            result = nullptr;
-        }
-        result = new AST::AstNode(AST::AST_RANGE, range_left, range_right);
-    }
-    // return range from *current* selected range
-    // in the end, it results in whole selected range
+    AST::AstNode *result = convert_range(id, wire_node, single_elem_size, 0);
     id->basic_prep = true;
     return result;
 }
@@ -486,16 +603,16 @@ static void resolve_wiretype(AST::AstNode *wire_node)
         if (wiretype_ast && !wiretype_ast->children.empty() && wiretype_ast->children[0]->attributes.count(UhdmAst::packed_ranges()) &&
             wiretype_ast->children[0]->attributes.count(UhdmAst::unpacked_ranges())) {
             for (auto r : wiretype_ast->children[0]->attributes[UhdmAst::packed_ranges()]->children) {
-                packed_ranges_wiretype.push_back(r->clone());
+                packed_ranges_wiretype.push_back(clone_ast_node(r));
             }
             for (auto r : wiretype_ast->children[0]->attributes[UhdmAst::unpacked_ranges()]->children) {
-                unpacked_ranges_wiretype.push_back(r->clone());
+                unpacked_ranges_wiretype.push_back(clone_ast_node(r));
             }
         } else {
             if (wire_node->children[0]->type == AST::AST_RANGE)
-                packed_ranges_wiretype.push_back(wire_node->children[0]->clone());
+                packed_ranges_wiretype.push_back(clone_ast_node(wire_node->children[0]));
             else if (wire_node->children[1]->type == AST::AST_RANGE)
-                packed_ranges_wiretype.push_back(wire_node->children[1]->clone());
+                packed_ranges_wiretype.push_back(clone_ast_node(wire_node->children[1]));
             else
                 log_error("Unhandled case in resolve_wiretype!\n");
         }
@@ -508,7 +625,7 @@ static void resolve_wiretype(AST::AstNode *wire_node)
         unpacked_ranges->insert(unpacked_ranges->begin(), unpacked_ranges_wiretype.begin(), unpacked_ranges_wiretype.end());
         AST::AstNode *value = nullptr;
         if (wire_node->children[0]->type != AST::AST_RANGE) {
-            value = wire_node->children[0]->clone();
+            value = clone_ast_node(wire_node->children[0]);
         }
         delete_children(wire_node);
         if (value)
@@ -521,16 +638,23 @@ static void add_force_convert_attribute(AST::AstNode *wire_node, uint32_t val =
 {
     AST::AstNode *&attr = wire_node->attributes[UhdmAst::force_convert()];
     if (!attr) {
-        attr = AST::AstNode::mkconst_int(val, true);
+        attr = mkconst_int(val, true);
     } else if (attr->integer != val) {
         attr->integer = val;
     }
 }
 
-static void check_memories(AST::AstNode *node, std::string scope, std::map<std::string, AST::AstNode *> &memories)
+static void check_memories(AST::AstNode *node, const std::string &scope, std::unordered_map<std::string, AST::AstNode *> &memories)
 {
-    for (auto *child : node->children) {
-        check_memories(child, node->type == AST::AST_GENBLOCK ? scope + "." + node->str : scope, memories);
+    if (node->type == AST::AST_GENBLOCK) {
+        const std::string child_scope = scope + "." + node->str;
+        for (auto *child : node->children) {
+            check_memories(child, child_scope, memories);
+        }
+    } else {
+        for (auto *child : node->children) {
+            check_memories(child, scope, memories);
+        }
     }
 
     if (node->str == "\\$readmemh") {
@@ -560,12 +684,16 @@ static void check_memories(AST::AstNode *node, std::string scope, std::map<std::
         return;
     }
 
-    if (node->type == AST::AST_IDENTIFIER) {
-        std::string full_id = scope;
+    // Nothing to look up until the first memory candidate is found
+    if (node->type == AST::AST_IDENTIFIER && !memories.empty()) {
+        std::string full_id;
+        full_id.reserve(scope.size() + node->str.size() + 1);
+        full_id = scope;
         std::size_t scope_end_pos = scope.size();
 
         for (;;) {
-            full_id += "." + node->str;
+            full_id += '.';
+            full_id += node->str;
             const auto iter = memories.find(full_id);
             if (iter != memories.end()) {
                 // Memory node found!
@@ -610,7 +738,7 @@ static void check_memories(AST::AstNode *node, std::string scope, std::map<std::
 
 static void check_memories(AST::AstNode *node)
 {
-    std::map<std::string, AST::AstNode *> memories;
+    std::unordered_map<std::string, AST::AstNode *> memories;
     check_memories(node, "", memories);
 }
 
@@ -672,9 +800,9 @@ static void convert_packed_unpacked_range(AST::AstNode *wire_node)
             const size_t packed_size = add_multirange_attribute(wire_node, packed_ranges);
             const size_t unpacked_size = add_multirange_attribute(wire_node, unpacked_ranges);
             if (packed_ranges.size() == 1 && unpacked_ranges.empty()) {
-                ranges.push_back(packed_ranges[0]->clone());
+                ranges.push_back(clone_ast_node(packed_ranges[0]));
             } else if (unpacked_ranges.size() == 1 && packed_ranges.empty()) {
-                ranges.push_back(unpacked_ranges[0]->clone());
+                ranges.push_back(clone_ast_node(unpacked_ranges[0]));
             } else {
                 // currently we have limited support
                 // for multirange wires that doesn't start from 0
@@ -687,10 +815,10 @@ static void convert_packed_unpacked_range(AST::AstNode *wire_node)
         }
     } else {
         for (auto r : packed_ranges) {
-            ranges.push_back(r->clone());
+            ranges.push_back(clone_ast_node(r));
         }
         for (auto r : unpacked_ranges) {
-            ranges.push_back(r->clone());
+            ranges.push_back(clone_ast_node(r));
         }
         // if there is only one packed and one unpacked range,
         // and wire is not port wire, change type to AST_MEMORY
@@ -752,15 +880,12 @@ void UhdmAst::uhdmast_assert_log(const char *expr_str, const char *func, const c
 
 static AST::AstNode *expand_dot(const AST::AstNode *current_struct, const AST::AstNode *search_node)
 {
-    AST::AstNode *current_struct_elem = nullptr;
     auto search_str = search_node->str.find("\\") == 0 ? search_node->str.substr(1) : search_node->str;
-    auto struct_elem_it =
-      std::find_if(current_struct->children.begin(), current_struct->children.end(), [&](AST::AstNode *node) { return node->str == search_str; });
-    if (struct_elem_it == current_struct->children.end()) {
+    AST::AstNode *current_struct_elem = StructLayout::find_member(current_struct, search_str);
+    if (!current_struct_elem) {
         current_struct->dumpAst(NULL, "struct >");
         log_error("Couldn't find search elem: %s in struct\n", search_str.c_str());
     }
-    current_struct_elem = *struct_elem_it;
 
     AST::AstNode *sub_dot = nullptr;
     std::vector<AST::AstNode *> struct_ranges;
@@ -778,8 +903,8 @@ static AST::AstNode *expand_dot(const AST::AstNode *current_struct, const AST::A
     AST::AstNode *left = nullptr, *right = nullptr;
     switch (current_struct_elem->type) {
     case AST::AST_STRUCT_ITEM:
-        left = AST::AstNode::mkconst_int(current_struct_elem->range_left, true);
-        right = AST::AstNode::mkconst_int(current_struct_elem->range_right, true);
+        left = mkconst_int(current_struct_elem->range_left, true);
+        right = mkconst_int(current_struct_elem->range_right, true);
         break;
     case AST::AST_STRUCT:
     case AST::AST_UNION:
@@ -791,12 +916,12 @@ static AST::AstNode *expand_dot(const AST::AstNode *current_struct, const AST::A
         if (!struct_ranges.empty() && (current_struct_elem->multirange_dimensions.size() / 2) == 2) {
             // get element size in number of bits
             const int single_elem_size = current_struct_elem->children.front()->range_left + 1;
-            left = AST::AstNode::mkconst_int(single_elem_size * current_struct_elem->multirange_dimensions.back(), true);
+            left = mkconst_int(single_elem_size * current_struct_elem->multirange_dimensions.back(), true);
             right =
-              AST::AstNode::mkconst_int(current_struct_elem->children.back()->range_right * current_struct_elem->multirange_dimensions.back(), true);
+              mkconst_int(current_struct_elem->children.back()->range_right * current_struct_elem->multirange_dimensions.back(), true);
         } else {
-            left = AST::AstNode::mkconst_int(current_struct_elem->children.front()->range_left, true);
-            right = AST::AstNode::mkconst_int(current_struct_elem->children.back()->range_right, true);
+            left = mkconst_int(current_struct_elem->children.front()->range_left, true);
+            right = mkconst_int(current_struct_elem->children.back()->range_right, true);
         }
         break;
     default:
@@ -806,7 +931,7 @@ static AST::AstNode *expand_dot(const AST::AstNode *current_struct, const AST::A
     };
 
     auto elem_size =
-      new AST::AstNode(AST::AST_ADD, new AST::AstNode(AST::AST_SUB, left->clone(), right->clone()), AST::AstNode::mkconst_int(1, true));
+      new_ast_node(AST::AST_ADD, new_ast_node(AST::AST_SUB, clone_ast_node(left), clone_ast_node(right)), mkconst_int(1, true));
 
     if (sub_dot) {
         // First select correct element in first struct
@@ -844,26 +969,27 @@ static AST::AstNode *expand_dot(const AST::AstNode *current_struct, const AST::A
                 log_error("Selecting a range of positions from a multirange is not supported in the dot notation.\n");
             }
             if (struct_range->children.size() == 2) {
-                auto range_size = new AST::AstNode(
-                  AST::AST_ADD, new AST::AstNode(AST::AST_SUB, struct_range->children[0]->clone(), struct_range->children[1]->clone()),
-                  AST::AstNode::mkconst_int(1, true));
-                right = new AST::AstNode(AST::AST_ADD, right, struct_range->children[1]->clone());
+                auto range_size = new_ast_node(
+                  AST::AST_ADD,
+                  new_ast_node(AST::AST_SUB, clone_ast_node(struct_range->children[0]), clone_ast_node(struct_range->children[1])),
+                  mkconst_int(1, true));
+                right = new_ast_node(AST::AST_ADD, right, clone_ast_node(struct_range->children[1]));
                 delete left;
-                left = new AST::AstNode(AST::AST_ADD, right->clone(), new AST::AstNode(AST::AST_SUB, range_size, AST::AstNode::mkconst_int(1, true)));
+                left = new_ast_node(AST::AST_ADD, clone_ast_node(right), new_ast_node(AST::AST_SUB, range_size, mkconst_int(1, true)));
 
             } else if (struct_range->children.size() == 1) {
                 // Selected a single position, as in `foo.bar[i]`.
                 if (range_width > 1 && current_struct_elem->multirange_dimensions.size() > range_width_idx + 2) {
                     // if it's not the last dimension.
-                    right = new AST::AstNode(
+                    right = new_ast_node(
                       AST::AST_ADD, right,
-                      new AST::AstNode(AST::AST_MUL, struct_range->children[0]->clone(), AST::AstNode::mkconst_int(range_width, true)));
+                      new_ast_node(AST::AST_MUL, clone_ast_node(struct_range->children[0]), mkconst_int(range_width, true)));
                     delete left;
-                    left = new AST::AstNode(AST::AST_ADD, right->clone(), AST::AstNode::mkconst_int(range_width - 1, true));
+                    left = new_ast_node(AST::AST_ADD, clone_ast_node(right), mkconst_int(range_width - 1, true));
                 } else {
-                    right = new AST::AstNode(AST::AST_ADD, right, struct_range->children[0]->clone());
+                    right = new_ast_node(AST::AST_ADD, right, clone_ast_node(struct_range->children[0]));
                     delete left;
-                    left = right->clone();
+                    left = clone_ast_node(right);
                 }
             } else {
                 struct_range->dumpAst(NULL, "range >");
@@ -871,16 +997,17 @@ static AST::AstNode *expand_dot(const AST::AstNode *current_struct, const AST::A
             }
         } else if (current_struct_elem->type == AST::AST_STRUCT) {
             if (struct_range->children.size() == 2) {
-                right = new AST::AstNode(AST::AST_ADD, right, struct_range->children[1]->clone());
-                auto range_size = new AST::AstNode(
-                  AST::AST_ADD, new AST::AstNode(AST::AST_SUB, struct_range->children[0]->clone(), struct_range->children[1]->clone()),
-                  AST::AstNode::mkconst_int(1, true));
-                left = new AST::AstNode(AST::AST_ADD, left, new AST::AstNode(AST::AST_SUB, range_size, elem_size->clone()));
+                right = new_ast_node(AST::AST_ADD, right, clone_ast_node(struct_range->children[1]));
+                auto range_size = new_ast_node(
+                  AST::AST_ADD,
+                  new_ast_node(AST::AST_SUB, clone_ast_node(struct_range->children[0]), clone_ast_node(struct_range->children[1])),
+                  mkconst_int(1, true));
+                left = new_ast_node(AST::AST_ADD, left, new_ast_node(AST::AST_SUB, range_size, clone_ast_node(elem_size)));
             } else if (struct_range->children.size() == 1) {
-                AST::AstNode *mul = new AST::AstNode(AST::AST_MUL, elem_size->clone(), struct_range->children[0]->clone());
+                AST::AstNode *mul = new_ast_node(AST::AST_MUL, clone_ast_node(elem_size), clone_ast_node(struct_range->children[0]));
 
-                left = new AST::AstNode(AST::AST_ADD, left, mul);
-                right = new AST::AstNode(AST::AST_ADD, right, mul->clone());
+                left = new_ast_node(AST::AST_ADD, left, mul);
+                right = new_ast_node(AST::AST_ADD, right, clone_ast_node(mul));
             } else {
                 struct_range->dumpAst(NULL, "range >");
                 log_error("Unhandled range select (AST_STRUCT) in AST_DOT!\n");
@@ -894,7 +1021,7 @@ static AST::AstNode *expand_dot(const AST::AstNode *current_struct, const AST::A
     // Return range from the begining of *current* struct
     // When all AST_DOT are expanded it will return range
     // from original wire
-    return new AST::AstNode(AST::AST_RANGE, left, right);
+    return new_ast_node(AST::AST_RANGE, left, right);
 }
 
 static AST::AstNode *convert_dot(AST::AstNode *wire_node, AST::AstNode *node, AST::AstNode *dot)
@@ -941,13 +1068,13 @@ static AST::AstNode *convert_dot(AST::AstNode *wire_node, AST::AstNode *node, AS
         bool is_unpacked_range = range_id < wire_node_unpacked_ranges_size;
         // if unpacked range, select from back
         auto elem = is_unpacked_range
-                      ? new AST::AstNode(AST::AST_SUB, AST::AstNode::mkconst_int(*wire_dimension_size_it - 1, true, 32), (*it)->children[0]->clone())
-                      : (*it)->children[0]->clone();
+                      ? new_ast_node(AST::AST_SUB, mkconst_int(*wire_dimension_size_it - 1, true, 32), clone_ast_node((*it)->children[0]))
+                      : clone_ast_node((*it)->children[0]);
         // calculate which struct we selected
-        auto move_offset = new AST::AstNode(AST::AST_MUL, AST::AstNode::mkconst_int(struct_size_int, true, 32), elem);
+        auto move_offset = new_ast_node(AST::AST_MUL, mkconst_int(struct_size_int, true, 32), elem);
         // move our expanded dot to currently selected struct
-        expanded->children[0] = new AST::AstNode(AST::AST_ADD, move_offset->clone(), expanded->children[0]);
-        expanded->children[1] = new AST::AstNode(AST::AST_ADD, move_offset, expanded->children[1]);
+        expanded->children[0] = new_ast_node(AST::AST_ADD, clone_ast_node(move_offset), expanded->children[0]);
+        expanded->children[1] = new_ast_node(AST::AST_ADD, move_offset, expanded->children[1]);
         struct_size_int *= *wire_dimension_size_it;
         // wire_dimension_size stores interleaved offset and size. Move to next dimension's size
         wire_dimension_size_it += 2;
@@ -956,27 +1083,45 @@ static AST::AstNode *convert_dot(AST::AstNode *wire_node, AST::AstNode *node, AS
     return expanded;
 }
 
-static void setup_current_scope(std::unordered_map<std::string, AST::AstNode *> top_nodes, AST::AstNode *current_top_node)
-{
-    for (auto it = top_nodes.begin(); it != top_nodes.end(); it++) {
-        if (!it->second)
-            continue;
-        if (it->second->type == AST::AST_PACKAGE) {
-            for (auto &o : it->second->children) {
-                // import only parameters
-                if (o->type == AST::AST_TYPEDEF || o->type == AST::AST_PARAMETER || o->type == AST::AST_LOCALPARAM) {
-                    // add imported nodes to current scope
-                    AST_INTERNAL::current_scope[it->second->str + std::string("::") + o->str.substr(1)] = o;
-                    AST_INTERNAL::current_scope[o->str] = o;
-                } else if (o->type == AST::AST_ENUM) {
-                    AST_INTERNAL::current_scope[o->str] = o;
-                    for (auto c : o->children) {
-                        AST_INTERNAL::current_scope[c->str] = c;
-                    }
+// Returns the scope entries of all packages. Packages are visited in the order
+// of their names, so the entries don't depend on the iteration order of top_nodes.
+static const std::map<std::string, AST::AstNode *> &get_package_scope(UhdmAstShared &shared)
+{
+    size_t children = 0;
+    for (auto *package : shared.packages)
+        children += package->children.size();
+    if (shared.package_scope_valid && shared.package_scope_children == children)
+        return shared.package_scope;
+
+    std::vector<AST::AstNode *> packages = shared.packages;
+    std::sort(packages.begin(), packages.end(), [](const AST::AstNode *a, const AST::AstNode *b) { return a->str < b->str; });
+    shared.package_scope.clear();
+    for (auto *package : packages) {
+        for (auto &o : package->children) {
+            // import only parameters
+            if (o->type == AST::AST_TYPEDEF || o->type == AST::AST_PARAMETER || o->type == AST::AST_LOCALPARAM) {
+                // add imported nodes to current scope
+                shared.package_scope[package->str + std::string("::") + o->str.substr(1)] = o;
+                shared.package_scope[o->str] = o;
+            } else if (o->type == AST::AST_ENUM) {
+                shared.package_scope[o->str] = o;
+                for (auto c : o->children) {
+                    shared.package_scope[c->str] = c;
                 }
             }
         }
     }
+    shared.package_scope_valid = true;
+    shared.package_scope_children = children;
+    return shared.package_scope;
+}
+
+static void setup_current_scope(UhdmAstShared &shared, AST::AstNode *current_top_node)
+{
+    // Both maps are ordered by name, so every entry is inserted next to the previous one
+    auto hint = AST_INTERNAL::current_scope.begin();
+    for (const auto &entry : get_package_scope(shared))
+        hint = std::next(AST_INTERNAL::current_scope.insert_or_assign(hint, entry.first, entry.second));
     for (auto &o : current_top_node->children) {
         if (o->type == AST::AST_TYPEDEF || o->type == AST::AST_PARAMETER || o->type == AST::AST_LOCALPARAM) {
             AST_INTERNAL::current_scope[o->str] = o;
@@ -1128,7 +1273,7 @@ static int simplify_struct(AST::AstNode *snode, int base_offset, AST::AstNode *p
     }
     if (!snode->str.empty() && parent_node && parent_node->type != AST::AST_TYPEDEF && parent_node->type != AST::AST_STRUCT &&
         AST_INTERNAL::current_scope.count(snode->str) != 0) {
-        AST_INTERNAL::current_scope[snode->str]->attributes[ID::wiretype] = AST::AstNode::mkconst_str(snode->str);
+        AST_INTERNAL::current_scope[snode->str]->attributes[ID::wiretype] = mkconst_str(snode->str);
         AST_INTERNAL::current_scope[snode->str]->attributes[ID::wiretype]->id2ast = snode;
     }
     return (is_union ? packed_width : offset);
@@ -1152,7 +1297,7 @@ static void add_members_to_scope_local(AST::AstNode *snode, std::string name)
 static AST::AstNode *make_packed_struct_local(AST::AstNode *template_node, std::string &name)
 {
     // create a wire for the packed struct
-    auto wnode = new AST::AstNode(AST::AST_WIRE);
+    auto wnode = new_ast_node(AST::AST_WIRE);
     wnode->str = name;
     wnode->is_logic = true;
     wnode->range_valid = true;
@@ -1199,7 +1344,7 @@ static void simplify_format_string(AST::AstNode *current_node)
         }
     }
     delete current_node->children[0];
-    current_node->children[0] = AST::AstNode::mkconst_str(preformatted_string);
+    current_node->children[0] = mkconst_str(preformatted_string);
 }
 
 // A wrapper for Yosys simplify function.
@@ -1227,7 +1372,7 @@ static void simplify_sv(AST::AstNode *current_node, AST::AstNode *parent_node)
                     dot->type = AST::AST_IDENTIFIER;
                     simplify_sv(dot, nullptr);
                     AST::AstNode *range_const = parent_node->children[0]->children[0];
-                    prefix_node = new AST::AstNode(AST::AST_PREFIX, range_const->clone(), dot->clone());
+                    prefix_node = new_ast_node(AST::AST_PREFIX, clone_ast_node(range_const), clone_ast_node(dot));
                     break;
                 } else {
                     current_node->str += "." + dot->str.substr(1);
@@ -1254,7 +1399,7 @@ static void simplify_sv(AST::AstNode *current_node, AST::AstNode *parent_node)
     }
     if (expanded) {
         delete_children(current_node);
-        current_node->children.push_back(expanded->clone());
+        current_node->children.push_back(clone_ast_node(expanded));
         current_node->basic_prep = true;
         delete expanded;
         expanded = nullptr;
@@ -1273,7 +1418,7 @@ static void simplify_sv(AST::AstNode *current_node, AST::AstNode *parent_node)
     case AST::AST_PARAMETER:
     case AST::AST_LOCALPARAM:
         if (!current_node->attributes.count(UhdmAst::is_simplified_wire())) {
-            current_node->attributes[UhdmAst::is_simplified_wire()] = AST::AstNode::mkconst_int(1, true);
+            current_node->attributes[UhdmAst::is_simplified_wire()] = mkconst_int(1, true);
             AST_INTERNAL::current_scope[current_node->str] = current_node;
             convert_packed_unpacked_range(current_node);
         }
@@ -1296,7 +1441,7 @@ static void simplify_sv(AST::AstNode *current_node, AST::AstNode *parent_node)
               wire_node->attributes.count(UhdmAst::unpacked_ranges()) ? wire_node->attributes[UhdmAst::unpacked_ranges()]->children.size() : 0;
             if ((wire_node->type == AST::AST_WIRE || wire_node->type == AST::AST_PARAMETER || wire_node->type == AST::AST_LOCALPARAM) &&
                 (packed_ranges_size + unpacked_ranges_size > 1)) {
-                auto *result = convert_range(current_node, packed_ranges_size, unpacked_ranges_size, 0);
+                auto *result = convert_range(current_node, packed_ranges_size, unpacked_ranges_size);
                 delete_children(current_node);
                 current_node->children.push_back(result);
             }
@@ -1305,7 +1450,7 @@ static void simplify_sv(AST::AstNode *current_node, AST::AstNode *parent_node)
     case AST::AST_STRUCT:
     case AST::AST_UNION:
         if (!current_node->attributes.count(UhdmAst::is_simplified_wire())) {
-            current_node->attributes[UhdmAst::is_simplified_wire()] = AST::AstNode::mkconst_int(1, true);
+            current_node->attributes[UhdmAst::is_simplified_wire()] = mkconst_int(1, true);
             simplify_struct(current_node, 0, parent_node);
             // instance rather than just a type in a typedef or outer struct?
             if (!current_node->str.empty() && current_node->str[0] == '\\') {
@@ -1314,7 +1459,7 @@ static void simplify_sv(AST::AstNode *current_node, AST::AstNode *parent_node)
                 convert_packed_unpacked_range(wnode);
                 log_assert(AST_INTERNAL::current_ast_mod);
                 AST_INTERNAL::current_ast_mod->children.push_back(wnode);
-                AST_INTERNAL::current_scope[wnode->str]->attributes[ID::wiretype] = AST::AstNode::mkconst_str(current_node->str);
+                AST_INTERNAL::current_scope[wnode->str]->attributes[ID::wiretype] = mkconst_str(current_node->str);
                 AST_INTERNAL::current_scope[wnode->str]->attributes[ID::wiretype]->id2ast = current_node;
             }
 
@@ -1323,7 +1468,7 @@ static void simplify_sv(AST::AstNode *current_node, AST::AstNode *parent_node)
         break;
     case AST::AST_STRUCT_ITEM:
         if (!current_node->attributes.count(UhdmAst::is_simplified_wire())) {
-            current_node->attributes[UhdmAst::is_simplified_wire()] = AST::AstNode::mkconst_int(1, true);
+            current_node->attributes[UhdmAst::is_simplified_wire()] = mkconst_int(1, true);
             AST_INTERNAL::current_scope[current_node->str] = current_node;
             convert_packed_unpacked_range(current_node);
             while (simplify(current_node, true, false, false, 1, -1, false, false)) {
@@ -1367,7 +1512,7 @@ static void simplify_sv(AST::AstNode *current_node, AST::AstNode *parent_node)
             // If the bound to the left of the colon is greater than the
             // bound to the right, the range is empty and contains no values.
             for (int i = low; i >= low && i <= high; i++) {
-                current_node->children.push_back(AST::AstNode::mkconst_int(i, false, range));
+                current_node->children.push_back(mkconst_int(i, false, range));
             }
             current_node->children.push_back(result);
             delete_attribute(current_node, UhdmAst::low_high_bound());
@@ -1386,12 +1531,15 @@ static void clear_current_scope()
     AST_INTERNAL::current_ast_mod = nullptr;
 }
 
-void UhdmAst::visit_one_to_many(const std::vector<int> child_node_types, vpiHandle parent_handle, const std::function<void(AST::AstNode *)> &f)
+void UhdmAst::visit_one_to_many(const std::vector<int> &child_node_types, vpiHandle parent_handle, const std::function<void(AST::AstNode *)> &f)
 {
+    // A single visitor is reused for all children, it only needs its current node reset.
+    // This avoids copying node_renames and the indentation for every child.
+    UhdmAst uhdm_ast(this, shared, indent + "  ");
     for (auto child : child_node_types) {
         vpiHandle itr = vpi_iterate(child, parent_handle);
         while (vpiHandle vpi_child_obj = vpi_scan(itr)) {
-            UhdmAst uhdm_ast(this, shared, indent + "  ");
+            uhdm_ast.current_node = nullptr;
             auto *child_node = uhdm_ast.process_object(vpi_child_obj);
             f(child_node);
             vpi_release_handle(vpi_child_obj);
@@ -1400,12 +1548,13 @@ void UhdmAst::visit_one_to_many(const std::vector<int> child_node_types, vpiHand
     }
 }
 
-void UhdmAst::visit_one_to_one(const std::vector<int> child_node_types, vpiHandle parent_handle, const std::function<void(AST::AstNode *)> &f)
+void UhdmAst::visit_one_to_one(const std::vector<int> &child_node_types, vpiHandle parent_handle, const std::function<void(AST::AstNode *)> &f)
 {
+    UhdmAst uhdm_ast(this, shared, indent + "  ");
     for (auto child : child_node_types) {
         vpiHandle itr = vpi_handle(child, parent_handle);
         if (itr) {
-            UhdmAst uhdm_ast(this, shared, indent + "  ");
+            uhdm_ast.current_node = nullptr;
             auto *child_node = uhdm_ast.process_object(itr);
             f(child_node);
         }
@@ -1418,7 +1567,7 @@ void UhdmAst::visit_range(vpiHandle obj_h, const std::function<void(AST::AstNode
     std::vector<AST::AstNode *> range_nodes;
     visit_one_to_many({vpiRange}, obj_h, [&](AST::AstNode *node) { range_nodes.push_back(node); });
     if (range_nodes.size() > 1) {
-        auto multirange_node = new AST::AstNode(AST::AST_MULTIRANGE);
+        auto multirange_node = new_ast_node(AST::AST_MULTIRANGE);
         multirange_node->children = range_nodes;
         f(multirange_node);
     } else if (!range_nodes.empty()) {
@@ -1434,8 +1583,8 @@ void UhdmAst::visit_default_expr(vpiHandle obj_h)
         auto mod = find_ancestor({AST::AST_MODULE});
         AST::AstNode *initial_node = nullptr;
         AST::AstNode *block_node = nullptr;
-        auto assign_node = new AST::AstNode(AST::AST_ASSIGN_EQ);
-        auto id_node = new AST::AstNode(AST::AST_IDENTIFIER);
+        auto assign_node = new_ast_node(AST::AST_ASSIGN_EQ);
+        auto id_node = new_ast_node(AST::AST_IDENTIFIER);
         id_node->str = current_node->str;
 
         for (auto child : mod->children) {
@@ -1447,7 +1596,7 @@ void UhdmAst::visit_default_expr(vpiHandle obj_h)
         // Ensure single AST_INITIAL node is located in AST_MODULE
         // before any AST_ALWAYS
         if (initial_node == nullptr) {
-            initial_node = new AST::AstNode(AST::AST_INITIAL);
+            initial_node = new_ast_node(AST::AST_INITIAL);
             auto insert_it = find_if(mod->children.begin(), mod->children.end(), [](AST::AstNode *node) { return (node->type == AST::AST_ALWAYS); });
             mod->children.insert(insert_it, initial_node);
         }
@@ -1455,7 +1604,7 @@ void UhdmAst::visit_default_expr(vpiHandle obj_h)
         if (!initial_node->children.empty() && initial_node->children[0]) {
             block_node = initial_node->children[0];
         } else {
-            block_node = new AST::AstNode(AST::AST_BLOCK);
+            block_node = new_ast_node(AST::AST_BLOCK);
             initial_node->children.push_back(block_node);
         }
         auto block_child =
@@ -1471,6 +1620,23 @@ void UhdmAst::visit_default_expr(vpiHandle obj_h)
     });
 }
 
+// Parse a Verilog literal with const2ast, reusing the result for literals that were already parsed.
+// const2ast is a pure function of the literal and the case type, so returning a clone is equivalent.
+static AST::AstNode *const2ast_cached(UhdmAstShared &shared, std::string code, char case_type)
+{
+    std::string key = code;
+    key += case_type;
+    auto it = shared.const_cache.find(key);
+    if (it != shared.const_cache.end()) {
+        shared.const_cache_hits++;
+        return clone_ast_node(it->second);
+    }
+    AST::AstNode *node = counted_ast_nodes(::systemverilog_plugin::const2ast(std::move(code), case_type, false));
+    if (node)
+        shared.const_cache.emplace(std::move(key), clone_ast_node(node));
+    return node;
+}
+
 AST::AstNode *UhdmAst::process_value(vpiHandle obj_h)
 {
     s_vpi_value val;
@@ -1488,7 +1654,7 @@ AST::AstNode *UhdmAst::process_value(vpiHandle obj_h)
     if (val.format) { // Needed to handle parameter nodes without typespecs and constants
         switch (val.format) {
         case vpiScalarVal:
-            return AST::AstNode::mkconst_int(val.value.scalar, false, 1);
+            return mkconst_int(val.value.scalar, false, 1);
         case vpiBinStrVal: {
             strValType += "b";
             val_str = val.value.str;
@@ -1535,7 +1701,7 @@ AST::AstNode *UhdmAst::process_value(vpiHandle obj_h)
                 size = 32;
                 is_signed = true;
             }
-            auto c = AST::AstNode::mkconst_int(val.format == vpiUIntVal ? val.value.uint : val.value.integer, is_signed, size > 0 ? size : 32);
+            auto c = mkconst_int(val.format == vpiUIntVal ? val.value.uint : val.value.integer, is_signed, size > 0 ? size : 32);
             if (size == 0 || size == -1)
                 c->is_unsized = true;
             return c;
@@ -1543,7 +1709,7 @@ AST::AstNode *UhdmAst::process_value(vpiHandle obj_h)
         case vpiRealVal:
             return mkconst_real(val.value.real);
         case vpiStringVal:
-            return AST::AstNode::mkconst_str(val.value.str);
+            return mkconst_str(val.value.str);
         default: {
             const uhdm_handle *const handle = (const uhdm_handle *)obj_h;
             const UHDM::BaseClass *const object = (const UHDM::BaseClass *)handle->object;
@@ -1577,7 +1743,7 @@ AST::AstNode *UhdmAst::process_value(vpiHandle obj_h)
         }
         // handle vpiBinStrVal, vpiDecStrVal and vpiHexStrVal
         if (val_str.find('\'') != std::string::npos) {
-            return ::systemverilog_plugin::const2ast(std::move(val_str), caseType, false);
+            return const2ast_cached(shared, std::move(val_str), caseType);
         } else {
             auto size = vpi_get(vpiSize, obj_h);
             std::string size_str;
@@ -1593,7 +1759,7 @@ AST::AstNode *UhdmAst::process_value(vpiHandle obj_h)
                     size_str = "1";
                 }
             }
-            auto c = ::systemverilog_plugin::const2ast(size_str + strValType + val_str, caseType, false);
+            auto c = const2ast_cached(shared, size_str + strValType + val_str, caseType);
             if (size <= 0) {
                 // unsized unbased const
                 c->is_unsized = true;
@@ -1611,8 +1777,8 @@ void UhdmAst::transform_breaks_continues(AST::AstNode *loop, AST::AstNode *decl_
     // Creates a 1-bit wire with the given name
     const auto make_cond_var = [this](const std::string &var_name) {
         auto cond_var =
-          make_ast_node(AST::AST_WIRE, {make_ast_node(AST::AST_RANGE, {AST::AstNode::mkconst_int(0, false), AST::AstNode::mkconst_int(0, false)}),
-                                        AST::AstNode::mkconst_int(0, false)});
+          make_ast_node(AST::AST_WIRE, {make_ast_node(AST::AST_RANGE, {mkconst_int(0, false), mkconst_int(0, false)}),
+                                        mkconst_int(0, false)});
         cond_var->str = var_name;
         cond_var->is_reg = true;
         return cond_var;
@@ -1622,7 +1788,7 @@ void UhdmAst::transform_breaks_continues(AST::AstNode *loop, AST::AstNode *decl_
         auto *case_node = make_ast_node(AST::AST_CASE);
         auto *id = make_identifier(casevar_name);
         case_node->children.push_back(id);
-        auto *constant = AST::AstNode::mkconst_int(0, false, 1);
+        auto *constant = mkconst_int(0, false, 1);
         auto *cond_node = make_ast_node(AST::AST_COND);
         cond_node->children.push_back(constant);
         cond_node->children.push_back(block);
@@ -1674,12 +1840,12 @@ void UhdmAst::transform_breaks_continues(AST::AstNode *loop, AST::AstNode *decl_
                 if (!continue_wire)
                     continue_wire = make_cond_var("$continue");
                 auto *continue_id = make_identifier(continue_wire->str);
-                block->children.push_back(make_ast_node(AST::AST_ASSIGN_EQ, {continue_id, AST::AstNode::mkconst_int(1, false)}));
+                block->children.push_back(make_ast_node(AST::AST_ASSIGN_EQ, {continue_id, mkconst_int(1, false)}));
                 if (type == AST::Extended::AST_BREAK) {
                     if (!break_wire)
                         break_wire = make_cond_var("$break");
                     auto *break_id = make_identifier(break_wire->str);
-                    block->children.push_back(make_ast_node(AST::AST_ASSIGN_EQ, {break_id, AST::AstNode::mkconst_int(1, false)}));
+                    block->children.push_back(make_ast_node(AST::AST_ASSIGN_EQ, {break_id, mkconst_int(1, false)}));
                 }
                 return true;
             }
@@ -1693,14 +1859,14 @@ void UhdmAst::transform_breaks_continues(AST::AstNode *loop, AST::AstNode *decl_
     if (continue_wire) {
         auto *continue_id = make_identifier(continue_wire->str);
         // Reset $continue each iteration
-        auto *continue_assign = make_ast_node(AST::AST_ASSIGN_EQ, {continue_id, AST::AstNode::mkconst_int(0, false)});
+        auto *continue_assign = make_ast_node(AST::AST_ASSIGN_EQ, {continue_id, mkconst_int(0, false)});
         decl_block->children.insert(decl_block->children.begin(), continue_wire);
         loop->children.back()->children.insert(loop->children.back()->children.begin(), continue_assign);
     }
     if (break_wire) {
         auto *break_id = make_identifier(break_wire->str);
         // Reset $break before the loop
-        auto *break_assign = make_ast_node(AST::AST_ASSIGN_EQ, {break_id, AST::AstNode::mkconst_int(0, false)});
+        auto *break_assign = make_ast_node(AST::AST_ASSIGN_EQ, {break_id, mkconst_int(0, false)});
         decl_block->children.insert(decl_block->children.begin(), break_assign);
         decl_block->children.insert(decl_block->children.begin(), break_wire);
         if (loop->type == AST::AST_REPEAT || loop->type == AST::AST_FOR) {
@@ -1756,14 +1922,14 @@ void UhdmAst::apply_name_from_current_obj(AST::AstNode &target_node) const
 
 AstNodeBuilder UhdmAst::make_node(AST::AstNodeType type) const
 {
-    auto node = std::make_unique<AST::AstNode>(type);
+    auto node = std::unique_ptr<AST::AstNode>(new_ast_node(type));
     apply_location_from_current_obj(*node);
     return AstNodeBuilder(std::move(node));
 };
 
 AstNodeBuilder UhdmAst::make_named_node(AST::AstNodeType type) const
 {
-    auto node = std::make_unique<AST::AstNode>(type);
+    auto node = std::unique_ptr<AST::AstNode>(new_ast_node(type));
     apply_location_from_current_obj(*node);
     apply_name_from_current_obj(*node);
     return AstNodeBuilder(std::move(node));
@@ -1787,10 +1953,10 @@ AstNodeBuilder UhdmAst::make_const(uint32_t value, uint8_t width) const
 
 AST::AstNode *UhdmAst::make_ast_node(AST::AstNodeType type, std::vector<AST::AstNode *> children)
 {
-    auto node = new AST::AstNode(type);
+    auto node = new_ast_node(type);
     apply_name_from_current_obj(*node);
     apply_location_from_current_obj(*node);
-    node->children = children;
+    node->children = std::move(children);
     return node;
 }
 
@@ -1854,7 +2020,7 @@ static void add_or_replace_child(AST::AstNode *parent, AST::AstNode *child)
                 // This is a bit ugly, but if the child we're replacing has children and
                 // our node doesn't, we copy its children to not lose any information
                 for (auto grandchild : (*it)->children) {
-                    child->children.push_back(grandchild->clone());
+                    child->children.push_back(clone_ast_node(grandchild));
                     if (child->type == AST::AST_WIRE && grandchild->type == AST::AST_WIRETYPE)
                         child->is_custom_type = true;
                 }
@@ -1864,7 +2030,7 @@ static void add_or_replace_child(AST::AstNode *parent, AST::AstNode *child)
                      child->attributes[UhdmAst::packed_ranges()]->children.empty())) {
 
                     delete_attribute(child, UhdmAst::packed_ranges());
-                    child->attributes[UhdmAst::packed_ranges()] = (*it)->attributes[UhdmAst::packed_ranges()]->clone();
+                    child->attributes[UhdmAst::packed_ranges()] = clone_ast_node((*it)->attributes[UhdmAst::packed_ranges()]);
                 }
             }
             if ((*it)->attributes.count(UhdmAst::unpacked_ranges()) && child->attributes.count(UhdmAst::unpacked_ranges())) {
@@ -1872,7 +2038,7 @@ static void add_or_replace_child(AST::AstNode *parent, AST::AstNode *child)
                      child->attributes[UhdmAst::unpacked_ranges()]->children.empty())) {
 
                     delete_attribute(child, UhdmAst::unpacked_ranges());
-                    child->attributes[UhdmAst::unpacked_ranges()] = (*it)->attributes[UhdmAst::unpacked_ranges()]->clone();
+                    child->attributes[UhdmAst::unpacked_ranges()] = clone_ast_node((*it)->attributes[UhdmAst::unpacked_ranges()]);
                 }
             }
             // Surelog doesn't report correct sign value for param_assign nodes
@@ -1899,7 +2065,7 @@ static void add_or_replace_child(AST::AstNode *parent, AST::AstNode *child)
             // simplify assumes that initial has a block under it
             // In case we don't have one (there were no statements under the initial), let's add it
             if (initial_node->children.empty()) {
-                initial_node->children.push_back(new AST::AstNode(AST::AST_BLOCK));
+                initial_node->children.push_back(new_ast_node(AST::AST_BLOCK));
             }
 
             log_assert(initial_node->children[0]->type == AST::AST_BLOCK);
@@ -1911,10 +2077,10 @@ static void add_or_replace_child(AST::AstNode *parent, AST::AstNode *child)
 
             // Place the contents of child block node inside parent block
             for (auto child_block_child : child_block_node->children)
-                block_node->children.push_back(child_block_child->clone());
+                block_node->children.push_back(clone_ast_node(child_block_child));
             // Place the remaining contents of child initial node inside the parent initial
             for (auto initial_child = child->children.begin() + 1; initial_child != child->children.end(); ++initial_child) {
-                initial_node->children.push_back((*initial_child)->clone());
+                initial_node->children.push_back(clone_ast_node(*initial_child));
             }
             delete child;
         } else {
@@ -1932,7 +2098,7 @@ static void add_or_replace_child(AST::AstNode *parent, AST::AstNode *child)
 void UhdmAst::make_cell(vpiHandle obj_h, AST::AstNode *cell_node, AST::AstNode *type_node)
 {
     if (cell_node->children.empty() || (!cell_node->children.empty() && cell_node->children[0]->type != AST::AST_CELLTYPE)) {
-        auto typeNode = new AST::AstNode(AST::AST_CELLTYPE);
+        auto typeNode = new_ast_node(AST::AST_CELLTYPE);
         typeNode->str = type_node->str;
         cell_node->children.insert(cell_node->children.begin(), typeNode);
     }
@@ -1944,7 +2110,7 @@ void UhdmAst::make_cell(vpiHandle obj_h, AST::AstNode *cell_node, AST::AstNode *
             arg_name = s;
             sanitize_symbol_name(arg_name);
         }
-        auto arg_node = new AST::AstNode(AST::AST_ARGUMENT);
+        auto arg_node = new_ast_node(AST::AST_ARGUMENT);
         arg_node->str = arg_name;
         arg_node->filename = cell_node->filename;
         arg_node->location = cell_node->location;
@@ -1965,7 +2131,8 @@ void UhdmAst::make_cell(vpiHandle obj_h, AST::AstNode *cell_node, AST::AstNode *
 
 void UhdmAst::move_type_to_new_typedef(AST::AstNode *current_node, AST::AstNode *type_node)
 {
-    auto typedef_node = new AST::AstNode(AST::AST_TYPEDEF);
+    shared.context_dependent_count++;
+    auto typedef_node = new_ast_node(AST::AST_TYPEDEF);
     typedef_node->location = type_node->location;
     typedef_node->filename = type_node->filename;
     typedef_node->str = strip_package_name(type_node->str);
@@ -1981,7 +2148,7 @@ void UhdmAst::move_type_to_new_typedef(AST::AstNode *current_node, AST::AstNode
     } else if (type_node->type == AST::AST_ENUM) {
         if (type_node->attributes.count("\\enum_base_type")) {
             auto base_type = type_node->attributes["\\enum_base_type"];
-            auto wire_node = new AST::AstNode(AST::AST_WIRE);
+            auto wire_node = new_ast_node(AST::AST_WIRE);
             wire_node->is_reg = true;
             for (auto c : base_type->children) {
                 std::string enum_item_str = "\\enum_value_";
@@ -1994,7 +2161,7 @@ void UhdmAst::move_type_to_new_typedef(AST::AstNode *current_node, AST::AstNode
                 }
                 RTLIL::Const val = c->children[0]->bitsAsConst(width, is_signed);
                 enum_item_str.append(val.as_string());
-                wire_node->attributes[enum_item_str.c_str()] = AST::AstNode::mkconst_str(c->str);
+                wire_node->attributes[enum_item_str.c_str()] = mkconst_str(c->str);
             }
             typedef_node->children.push_back(wire_node);
             current_node->children.push_back(typedef_node);
@@ -2002,11 +2169,11 @@ void UhdmAst::move_type_to_new_typedef(AST::AstNode *current_node, AST::AstNode
         } else {
             type_node->str = "$enum" + std::to_string(shared.next_enum_id());
             std::vector<AST::AstNode *> packed_ranges;
-            auto wire_node = new AST::AstNode(AST::AST_WIRE);
+            auto wire_node = new_ast_node(AST::AST_WIRE);
             wire_node->is_reg = true;
-            wire_node->attributes["\\enum_type"] = AST::AstNode::mkconst_str(type_node->str);
+            wire_node->attributes["\\enum_type"] = mkconst_str(type_node->str);
             if (!type_node->children.empty() && type_node->children[0]->children.size() > 1) {
-                packed_ranges.push_back(type_node->children[0]->children[1]->clone());
+                packed_ranges.push_back(clone_ast_node(type_node->children[0]->children[1]));
             } else {
                 // Add default range
                 packed_ranges.push_back(make_range(31, 0));
@@ -2025,6 +2192,7 @@ void UhdmAst::move_type_to_new_typedef(AST::AstNode *current_node, AST::AstNode
 
 AST::AstNode *UhdmAst::find_ancestor(const std::unordered_set<AST::AstNodeType> &types)
 {
+    shared.context_dependent_count++;
     auto searched_node = this;
     while (searched_node) {
         if (searched_node->current_node) {
@@ -2043,7 +2211,7 @@ void UhdmAst::process_design()
     visit_one_to_many({UHDM::uhdmallInterfaces, UHDM::uhdmtopPackages, UHDM::uhdmallModules, UHDM::uhdmtopModules, vpiTaskFunc}, obj_h,
                       [&](AST::AstNode *node) {
                           if (node) {
-                              shared.top_nodes[node->str] = node;
+                              shared.add_top_node(node);
                           }
                       });
     visit_one_to_many({vpiParameter, vpiParamAssign}, obj_h, [&](AST::AstNode *node) {
@@ -2059,20 +2227,24 @@ void UhdmAst::process_design()
             move_type_to_new_typedef(current_node, node);
     });
     // Add top level typedefs and params to scope
-    setup_current_scope(shared.top_nodes, current_node);
-    for (auto pair : shared.top_nodes) {
+    setup_current_scope(shared, current_node);
+    for (const auto &pair : shared.top_nodes) {
         if (!pair.second)
             continue;
         if (pair.second->type == AST::AST_PACKAGE) {
             check_memories(pair.second);
             clear_current_scope();
-            setup_current_scope(shared.top_nodes, pair.second);
+            setup_current_scope(shared, pair.second);
+            const UhdmAstStats::ScopedPhase simplify_stats(shared.stats, shared.stats_flag, "simplify_sv");
             simplify_sv(pair.second, nullptr);
             clear_current_scope();
         }
     }
-    setup_current_scope(shared.top_nodes, current_node);
-    // Once we walked everything, unroll that as children of this node
+    setup_current_scope(shared, current_node);
+    // Once we walked everything, unroll that as children of this node.
+    // Modules are simplified one after another: simplify_sv() resolves identifiers through
+    // AST_INTERNAL::current_scope and creates IdStrings and AST nodes, which are all global,
+    // unsynchronized Yosys state. It can't be run for several modules concurrently.
     for (auto &pair : shared.top_nodes) {
         if (!pair.second)
             continue;
@@ -2081,7 +2253,8 @@ void UhdmAst::process_design()
                 current_node->children.insert(current_node->children.begin(), pair.second);
             else {
                 check_memories(pair.second);
-                setup_current_scope(shared.top_nodes, pair.second);
+                setup_current_scope(shared, pair.second);
+                const UhdmAstStats::ScopedPhase simplify_stats(shared.stats, shared.stats_flag, "simplify_sv");
                 simplify_sv(pair.second, nullptr);
                 clear_current_scope();
                 current_node->children.push_back(pair.second);
@@ -2098,7 +2271,7 @@ void UhdmAst::process_design()
 
 void UhdmAst::simplify_parameter(AST::AstNode *parameter, AST::AstNode *module_node)
 {
-    setup_current_scope(shared.top_nodes, shared.current_top_node);
+    setup_current_scope(shared, shared.current_top_node);
     visitEachDescendant(shared.current_top_node, [&](AST::AstNode *current_scope_node) {
         if (current_scope_node->type == AST::AST_TYPEDEF || current_scope_node->type == AST::AST_PARAMETER ||
             current_scope_node->type == AST::AST_LOCALPARAM) {
@@ -2190,9 +2363,9 @@ void UhdmAst::process_module()
             // processing nodes belonging to 'uhdmallModules'
             current_node = make_ast_node(AST::AST_MODULE);
             current_node->str = type;
-            shared.top_nodes[current_node->str] = current_node;
+            shared.add_top_node(current_node);
             shared.current_top_node = current_node;
-            current_node->attributes[UhdmAst::partial()] = AST::AstNode::mkconst_int(1, false, 1);
+            current_node->attributes[UhdmAst::partial()] = mkconst_int(1, false, 1);
             visit_one_to_many({vpiTypedef}, obj_h, [&](AST::AstNode *node) {
                 if (node) {
                     move_type_to_new_typedef(current_node, node);
@@ -2253,7 +2426,7 @@ void UhdmAst::process_module()
 
                 if (child->type == AST::AST_TYPEDEF || child->type == AST::AST_ENUM) {
                     // Copy definition of the type provided as parameter.
-                    parameter_typedefs->push_back(child->clone());
+                    parameter_typedefs->push_back(clone_ast_node(child));
                 }
             }
             delete node;
@@ -2284,14 +2457,14 @@ void UhdmAst::process_module()
         if (!module_node) {
             module_node = shared.top_nodes[type];
             if (!module_node) {
-                module_node = new AST::AstNode(AST::AST_MODULE);
+                module_node = new_ast_node(AST::AST_MODULE);
                 module_node->str = type;
-                module_node->attributes[UhdmAst::partial()] = AST::AstNode::mkconst_int(2, false, 1);
-                module_node->attributes[ID::whitebox] = AST::AstNode::mkconst_int(1, false, 1);
+                module_node->attributes[UhdmAst::partial()] = mkconst_int(2, false, 1);
+                module_node->attributes[ID::whitebox] = mkconst_int(1, false, 1);
             }
             isPrimitive = module_node->attributes.count(UhdmAst::partial()) && module_node->attributes[UhdmAst::partial()]->integer == 2;
             if (!parameters.empty() && !isPrimitive) {
-                module_node = module_node->clone();
+                module_node = clone_ast_node(module_node);
                 module_node->str = module_name;
             }
         } else if (auto attribute = get_attribute(module_node, attr_id::is_elaborated_module); attribute && attribute->integer == 1) {
@@ -2299,7 +2472,7 @@ void UhdmAst::process_module()
             make_cell(obj_h, current_node, module_node);
             return;
         }
-        shared.top_nodes[module_node->str] = module_node;
+        shared.add_top_node(module_node);
         visit_one_to_many({vpiParamAssign}, obj_h, [&](AST::AstNode *node) {
             if (node) {
                 if (node->children[0]->type != AST::AST_CONSTANT) {
@@ -2329,7 +2502,7 @@ void UhdmAst::process_module()
                     delete_attribute(module_node, UhdmAst::partial());
                 }
         }
-        auto typeNode = new AST::AstNode(AST::AST_CELLTYPE);
+        auto typeNode = new_ast_node(AST::AST_CELLTYPE);
         typeNode->str = module_node->str;
         current_node->children.insert(current_node->children.begin(), typeNode);
         auto old_top = shared.current_top_node;
@@ -2342,7 +2515,7 @@ void UhdmAst::process_module()
                           });
         make_cell(obj_h, current_node, module_node);
         shared.current_top_node = old_top;
-        set_attribute(module_node, attr_id::is_elaborated_module, AST::AstNode::mkconst_int(1, true));
+        set_attribute(module_node, attr_id::is_elaborated_module, mkconst_int(1, true));
     }
 }
 
@@ -2358,7 +2531,7 @@ void UhdmAst::process_struct_typespec()
             AST::AstNode *range = nullptr;
             // check if single enum element is larger than 1 bit
             if (node->children[0]->children[0]->children.size() == 2) {
-                range = node->children[0]->children[0]->children[1]->clone();
+                range = clone_ast_node(node->children[0]->children[0]->children[1]);
             } else {
                 range = make_range(0, 0);
             }
@@ -2381,7 +2554,7 @@ void UhdmAst::process_union_typespec()
             AST::AstNode *range = nullptr;
             // check if single enum element is larger than 1 bit
             if (node->children[0]->children[0]->children.size() == 2) {
-                range = node->children[0]->children[0]->children[1]->clone();
+                range = clone_ast_node(node->children[0]->children[0]->children[1]);
             } else {
                 range = make_range(0, 0);
             }
@@ -2480,14 +2653,14 @@ void UhdmAst::process_typespec_member()
                 auto str = current_node->str;
                 if (node->attributes.count(UhdmAst::packed_ranges())) {
                     for (auto r : node->attributes[UhdmAst::packed_ranges()]->children) {
-                        packed_ranges.push_back(r->clone());
+                        packed_ranges.push_back(clone_ast_node(r));
                     }
                     std::reverse(packed_ranges.begin(), packed_ranges.end());
                     delete_attribute(node, UhdmAst::packed_ranges());
                 }
                 if (node->attributes.count(UhdmAst::unpacked_ranges())) {
                     for (auto r : node->attributes[UhdmAst::unpacked_ranges()]->children) {
-                        unpacked_ranges.push_back(r->clone());
+                        unpacked_ranges.push_back(clone_ast_node(r));
                     }
                     delete_attribute(node, UhdmAst::unpacked_ranges());
                 }
@@ -2500,14 +2673,14 @@ void UhdmAst::process_typespec_member()
                 auto str = current_node->str;
                 if (node->attributes.count(UhdmAst::packed_ranges())) {
                     for (auto r : node->attributes[UhdmAst::packed_ranges()]->children) {
-                        packed_ranges.push_back(r->clone());
+                        packed_ranges.push_back(clone_ast_node(r));
                     }
                     std::reverse(packed_ranges.begin(), packed_ranges.end());
                     delete_attribute(node, UhdmAst::packed_ranges());
                 }
                 if (node->attributes.count(UhdmAst::unpacked_ranges())) {
                     for (auto r : node->attributes[UhdmAst::unpacked_ranges()]->children) {
-                        unpacked_ranges.push_back(r->clone());
+                        unpacked_ranges.push_back(clone_ast_node(r));
                     }
                     delete_attribute(node, UhdmAst::unpacked_ranges());
                 }
@@ -2554,6 +2727,8 @@ static UHDM::expr *reduce_expression(const UHDM::any *expr, const UHDM::any *ins
 
 void UhdmAst::process_enum_typespec()
 {
+    // Anonymous enums are registered per top module
+    shared.context_dependent_count++;
     // BaseTypespec specifies underlying type of the enum.
     // The BaseTypespec has at most one explicit packed dimension (range).
     // When base type is not specified in SystemVerilog code, it is assumed to be an int.
@@ -2679,7 +2854,7 @@ void UhdmAst::process_enum_typespec()
         node->is_logic = current_node->is_logic;
         node->is_signed = current_node->is_signed;
         if (range) {
-            node->children.push_back(range->clone());
+            node->children.push_back(clone_ast_node(range));
             node->range_valid = true;
         } else {
             node->range_left = range_left;
@@ -2725,7 +2900,7 @@ void UhdmAst::process_custom_var()
             copy_packed_unpacked_attribute(node, current_node);
             current_node->children = std::move(node->children);
         } else {
-            auto wiretype_node = new AST::AstNode(AST::AST_WIRETYPE);
+            auto wiretype_node = new_ast_node(AST::AST_WIRETYPE);
             wiretype_node->str = node->str;
             current_node->children.push_back(wiretype_node);
         }
@@ -2741,9 +2916,9 @@ void UhdmAst::process_custom_var()
 void UhdmAst::process_int_var()
 {
     current_node = make_ast_node(AST::AST_WIRE);
-    auto left_const = AST::AstNode::mkconst_int(31, true);
-    auto right_const = AST::AstNode::mkconst_int(0, true);
-    auto range = new AST::AstNode(AST::AST_RANGE, left_const, right_const);
+    auto left_const = mkconst_int(31, true);
+    auto right_const = mkconst_int(0, true);
+    auto range = new_ast_node(AST::AST_RANGE, left_const, right_const);
     current_node->children.push_back(range);
     current_node->is_signed = vpi_get(vpiSigned, obj_h);
     visit_default_expr(obj_h);
@@ -2753,9 +2928,9 @@ void UhdmAst::process_real_var()
 {
     auto module_node = find_ancestor({AST::AST_MODULE});
     auto wire_node = make_ast_node(AST::AST_WIRE);
-    auto left_const = AST::AstNode::mkconst_int(63, true);
-    auto right_const = AST::AstNode::mkconst_int(0, true);
-    auto range = new AST::AstNode(AST::AST_RANGE, left_const, right_const);
+    auto left_const = mkconst_int(63, true);
+    auto right_const = mkconst_int(0, true);
+    auto range = new_ast_node(AST::AST_RANGE, left_const, right_const);
     wire_node->children.push_back(range);
     wire_node->is_signed = true;
     module_node->children.push_back(wire_node);
@@ -2774,7 +2949,7 @@ void UhdmAst::process_array_var()
             current_node->type = node->type;
             current_node->children = std::move(node->children);
         } else {
-            auto wiretype_node = new AST::AstNode(AST::AST_WIRETYPE);
+            auto wiretype_node = new_ast_node(AST::AST_WIRETYPE);
             wiretype_node->str = node->str;
             current_node->children.push_back(wiretype_node);
             current_node->is_custom_type = true;
@@ -2790,7 +2965,7 @@ void UhdmAst::process_array_var()
                     current_node->type = node->type;
                     current_node->children = std::move(node->children);
                 } else {
-                    auto wiretype_node = new AST::AstNode(AST::AST_WIRETYPE);
+                    auto wiretype_node = new_ast_node(AST::AST_WIRETYPE);
                     wiretype_node->str = node->str;
                     current_node->children.push_back(wiretype_node);
                     current_node->is_custom_type = true;
@@ -2805,7 +2980,7 @@ void UhdmAst::process_array_var()
                     current_node->type = node->type;
                     current_node->children = std::move(node->children);
                 } else {
-                    auto wiretype_node = new AST::AstNode(AST::AST_WIRETYPE);
+                    auto wiretype_node = new_ast_node(AST::AST_WIRETYPE);
                     wiretype_node->str = node->str;
                     current_node->children.push_back(wiretype_node);
                     current_node->is_custom_type = true;
@@ -2836,7 +3011,7 @@ void UhdmAst::process_packed_array_var()
             current_node->type = node->type;
             current_node->children = std::move(node->children);
         } else {
-            auto wiretype_node = new AST::AstNode(AST::AST_WIRETYPE);
+            auto wiretype_node = new_ast_node(AST::AST_WIRETYPE);
             wiretype_node->str = node->str;
             current_node->children.push_back(wiretype_node);
             current_node->is_custom_type = true;
@@ -2852,7 +3027,7 @@ void UhdmAst::process_packed_array_var()
                     current_node->type = node->type;
                     current_node->children = std::move(node->children);
                 } else {
-                    auto wiretype_node = new AST::AstNode(AST::AST_WIRETYPE);
+                    auto wiretype_node = new_ast_node(AST::AST_WIRETYPE);
                     wiretype_node->str = node->str;
                     current_node->children.push_back(wiretype_node);
                     current_node->is_custom_type = true;
@@ -2867,7 +3042,7 @@ void UhdmAst::process_packed_array_var()
                     current_node->type = node->type;
                     current_node->children = std::move(node->children);
                 } else {
-                    auto wiretype_node = new AST::AstNode(AST::AST_WIRETYPE);
+                    auto wiretype_node = new_ast_node(AST::AST_WIRETYPE);
                     wiretype_node->str = node->str;
                     current_node->children.push_back(wiretype_node);
                     current_node->is_custom_type = true;
@@ -2898,7 +3073,7 @@ void UhdmAst::process_param_assign()
             // but we want to skip actual value, as it is set in rhs
             for (auto *c : node->children) {
                 if (c->type != AST::AST_CONSTANT) {
-                    current_node->children.push_back(c->clone());
+                    current_node->children.push_back(clone_ast_node(c));
                 }
             }
             delete_children(node);
@@ -2931,7 +3106,7 @@ void UhdmAst::process_cont_assign_var_init()
     visit_one_to_one({vpiLhs, vpiRhs}, obj_h, [&](AST::AstNode *node) {
         if (node) {
             if (node->type == AST::AST_WIRE || node->type == AST::AST_PARAMETER || node->type == AST::AST_LOCALPARAM) {
-                assign_node->children.push_back(new AST::AstNode(AST::AST_IDENTIFIER));
+                assign_node->children.push_back(new_ast_node(AST::AST_IDENTIFIER));
                 assign_node->children.back()->str = node->str;
                 delete node;
             } else {
@@ -2948,10 +3123,10 @@ void UhdmAst::process_cont_assign_net()
     visit_one_to_one({vpiLhs, vpiRhs}, obj_h, [&](AST::AstNode *node) {
         if (node) {
             if (node->type == AST::AST_WIRE || node->type == AST::AST_PARAMETER || node->type == AST::AST_LOCALPARAM) {
-                current_node->children.push_back(new AST::AstNode(AST::AST_IDENTIFIER));
+                current_node->children.push_back(new_ast_node(AST::AST_IDENTIFIER));
                 current_node->children.back()->str = node->str;
             } else {
-                current_node->children.push_back(node->clone());
+                current_node->children.push_back(clone_ast_node(node));
             }
             delete node;
         }
@@ -3062,11 +3237,11 @@ void UhdmAst::process_assignment(const UHDM::BaseClass *object)
             return;
         }
         log_assert(current_node->children.size() == 2);
-        auto child_node = new AST::AstNode(node_type, current_node->children[0]->clone(), current_node->children[1]);
+        auto child_node = new_ast_node(node_type, clone_ast_node(current_node->children[0]), current_node->children[1]);
         current_node->children[1] = child_node;
         if (shift_unsigned) {
             log_assert(current_node->children[1]->children.size() == 2);
-            auto unsigned_node = new AST::AstNode(AST::AST_TO_UNSIGNED, current_node->children[1]->children[1]);
+            auto unsigned_node = new_ast_node(AST::AST_TO_UNSIGNED, current_node->children[1]->children[1]);
             current_node->children[1]->children[1] = unsigned_node;
         }
     }
@@ -3087,7 +3262,7 @@ void UhdmAst::process_packed_array_net()
     current_node = make_ast_node(AST::AST_WIRE);
     visit_one_to_many({vpiElement}, obj_h, [&](AST::AstNode *node) {
         if (node && GetSize(node->children) == 1)
-            current_node->children.push_back(node->children[0]->clone());
+            current_node->children.push_back(clone_ast_node(node->children[0]));
         current_node->is_custom_type = node->is_custom_type;
         delete node;
     });
@@ -3124,7 +3299,7 @@ void UhdmAst::process_array_net(const UHDM::BaseClass *object)
                     current_node->type = node->type;
                     current_node->children = std::move(node->children);
                 } else {
-                    auto wiretype_node = new AST::AstNode(AST::AST_WIRETYPE);
+                    auto wiretype_node = new_ast_node(AST::AST_WIRETYPE);
                     wiretype_node->str = node->str;
                     current_node->children.push_back(wiretype_node);
                     current_node->is_custom_type = true;
@@ -3187,7 +3362,7 @@ void UhdmAst::process_interface()
         });
     } else {
         // Encountered for the first time
-        elaboratedInterface = new AST::AstNode(AST::AST_INTERFACE);
+        elaboratedInterface = new_ast_node(AST::AST_INTERFACE);
         elaboratedInterface->str = name;
         visit_one_to_many({vpiNet, vpiPort, vpiModport}, obj_h, [&](AST::AstNode *node) {
             if (node) {
@@ -3195,7 +3370,7 @@ void UhdmAst::process_interface()
             }
         });
     }
-    shared.top_nodes[elaboratedInterface->str] = elaboratedInterface;
+    shared.add_top_node(elaboratedInterface);
     if (name != type) {
         // Not a top module, create instance
         current_node = make_ast_node(AST::AST_CELL);
@@ -3230,7 +3405,7 @@ void UhdmAst::process_io_decl()
     visit_one_to_one({vpiTypedef}, obj_h, [&](AST::AstNode *node) {
         if (node) {
             if (!node->str.empty()) {
-                auto wiretype_node = new AST::AstNode(AST::AST_WIRETYPE);
+                auto wiretype_node = new_ast_node(AST::AST_WIRETYPE);
                 wiretype_node->str = node->str;
                 // wiretype needs to be 1st node (if port have also another range nodes)
                 current_node->children.insert(current_node->children.begin(), wiretype_node);
@@ -3238,16 +3413,16 @@ void UhdmAst::process_io_decl()
             } else {
                 // anonymous typedef, just move children
                 for (auto child : node->children) {
-                    current_node->children.push_back(child->clone());
+                    current_node->children.push_back(clone_ast_node(child));
                 }
                 if (node->attributes.count(UhdmAst::packed_ranges())) {
                     for (auto r : node->attributes[UhdmAst::packed_ranges()]->children) {
-                        packed_ranges.push_back(r->clone());
+                        packed_ranges.push_back(clone_ast_node(r));
                     }
                 }
                 if (node->attributes.count(UhdmAst::unpacked_ranges())) {
                     for (auto r : node->attributes[UhdmAst::unpacked_ranges()]->children) {
-                        unpacked_ranges.push_back(r->clone());
+                        unpacked_ranges.push_back(clone_ast_node(r));
                     }
                 }
                 current_node->is_logic = node->is_logic;
@@ -3302,13 +3477,13 @@ void UhdmAst::process_always()
     });
     switch (vpi_get(vpiAlwaysType, obj_h)) {
     case vpiAlwaysComb:
-        current_node->attributes[ID::always_comb] = AST::AstNode::mkconst_int(1, false);
+        current_node->attributes[ID::always_comb] = mkconst_int(1, false);
         break;
     case vpiAlwaysFF:
-        current_node->attributes[ID::always_ff] = AST::AstNode::mkconst_int(1, false);
+        current_node->attributes[ID::always_ff] = mkconst_int(1, false);
         break;
     case vpiAlwaysLatch:
-        current_node->attributes[ID::always_latch] = AST::AstNode::mkconst_int(1, false);
+        current_node->attributes[ID::always_latch] = mkconst_int(1, false);
         break;
     default:
         break;
@@ -3401,7 +3576,7 @@ void UhdmAst::process_begin(bool is_named)
                     delete node;
                     return;
                 }
-                auto wire_node = new AST::AstNode(AST::AST_WIRE);
+                auto wire_node = new_ast_node(AST::AST_WIRE);
                 wire_node->type = AST::AST_WIRE;
                 wire_node->str = node->children[0]->str;
                 func_node->children.push_back(wire_node);
@@ -3477,7 +3652,7 @@ void UhdmAst::process_operation(const UHDM::BaseClass *object)
             current_node->type = AST::AST_REDUCE_XNOR;
             break;
         case vpiUnaryNandOp: {
-            auto not_node = new AST::AstNode(AST::AST_NONE, current_node);
+            auto not_node = new_ast_node(AST::AST_NONE, current_node);
             if (current_node->children.size() == 2) {
                 current_node->type = AST::AST_BIT_AND;
                 not_node->type = AST::AST_BIT_NOT;
@@ -3489,7 +3664,7 @@ void UhdmAst::process_operation(const UHDM::BaseClass *object)
             break;
         }
         case vpiUnaryNorOp: {
-            auto not_node = new AST::AstNode(AST::AST_NONE, current_node);
+            auto not_node = new_ast_node(AST::AST_NONE, current_node);
             if (current_node->children.size() == 2) {
                 current_node->type = AST::AST_BIT_OR;
                 not_node->type = AST::AST_BIT_NOT;
@@ -3518,14 +3693,14 @@ void UhdmAst::process_operation(const UHDM::BaseClass *object)
         case vpiLShiftOp: {
             current_node->type = AST::AST_SHIFT_LEFT;
             log_assert(current_node->children.size() == 2);
-            auto unsigned_node = new AST::AstNode(AST::AST_TO_UNSIGNED, current_node->children[1]);
+            auto unsigned_node = new_ast_node(AST::AST_TO_UNSIGNED, current_node->children[1]);
             current_node->children[1] = unsigned_node;
             break;
         }
         case vpiRShiftOp: {
             current_node->type = AST::AST_SHIFT_RIGHT;
             log_assert(current_node->children.size() == 2);
-            auto unsigned_node = new AST::AstNode(AST::AST_TO_UNSIGNED, current_node->children[1]);
+            auto unsigned_node = new_ast_node(AST::AST_TO_UNSIGNED, current_node->children[1]);
             current_node->children[1] = unsigned_node;
             break;
         }
@@ -3583,14 +3758,14 @@ void UhdmAst::process_operation(const UHDM::BaseClass *object)
         case vpiArithLShiftOp: {
             current_node->type = AST::AST_SHIFT_SLEFT;
             log_assert(current_node->children.size() == 2);
-            auto unsigned_node = new AST::AstNode(AST::AST_TO_UNSIGNED, current_node->children[1]);
+            auto unsigned_node = new_ast_node(AST::AST_TO_UNSIGNED, current_node->children[1]);
             current_node->children[1] = unsigned_node;
             break;
         }
         case vpiArithRShiftOp: {
             current_node->type = AST::AST_SHIFT_SRIGHT;
             log_assert(current_node->children.size() == 2);
-            auto unsigned_node = new AST::AstNode(AST::AST_TO_UNSIGNED, current_node->children[1]);
+            auto unsigned_node = new_ast_node(AST::AST_TO_UNSIGNED, current_node->children[1]);
             current_node->children[1] = unsigned_node;
             break;
         }
@@ -3605,8 +3780,8 @@ void UhdmAst::process_operation(const UHDM::BaseClass *object)
         }
         case vpiPreIncOp: {
             current_node->type = AST::AST_ASSIGN_EQ;
-            auto id = current_node->children[0]->clone();
-            auto add_node = new AST::AstNode(AST::AST_ADD, id, AST::AstNode::mkconst_int(1, true));
+            auto id = clone_ast_node(current_node->children[0]);
+            auto add_node = new_ast_node(AST::AST_ADD, id, mkconst_int(1, true));
             add_node->filename = current_node->filename;
             add_node->location = current_node->location;
             current_node->children.push_back(add_node);
@@ -3620,8 +3795,8 @@ void UhdmAst::process_operation(const UHDM::BaseClass *object)
         }
         case vpiPreDecOp: {
             current_node->type = AST::AST_ASSIGN_EQ;
-            auto id = current_node->children[0]->clone();
-            auto add_node = new AST::AstNode(AST::AST_SUB, id, AST::AstNode::mkconst_int(1, true));
+            auto id = clone_ast_node(current_node->children[0]);
+            auto add_node = new_ast_node(AST::AST_SUB, id, mkconst_int(1, true));
             add_node->filename = current_node->filename;
             add_node->location = current_node->location;
             current_node->children.push_back(add_node);
@@ -3657,7 +3832,7 @@ void UhdmAst::process_operation(const UHDM::BaseClass *object)
         case vpiMinTypMaxOp: {
             // ignore min and max and set only typ
             log_assert(current_node->children.size() == 3);
-            auto tmp = current_node->children[1]->clone();
+            auto tmp = clone_ast_node(current_node->children[1]);
             delete current_node;
             current_node = tmp;
             break;
@@ -3729,7 +3904,7 @@ void UhdmAst::process_stream_op()
     AST::AstNode *const stream_concat_width_lp = //
       (make_node(AST::AST_LOCALPARAM).str(make_id_str("width")))({
         (make_node(AST::AST_FCALL).str("\\$bits"))({
-          (stream_concat_arg->clone()),
+          (clone_ast_node(stream_concat_arg)),
         }),
         (make_range(31, 0, true)),
       });
@@ -3785,7 +3960,7 @@ void UhdmAst::process_stream_op()
           (make_ident(loop_counter->str)),
           (make_node(Yosys::AST::AST_ADD))({
             (make_ident(loop_counter->str)),
-            (slice_size_arg->clone()),
+            (clone_ast_node(slice_size_arg)),
           }),
         }),
         // loop body
@@ -3798,7 +3973,7 @@ void UhdmAst::process_stream_op()
                     (make_node(Yosys::AST::AST_SELFSZ))({
                       (make_ident(loop_counter->str)),
                     }),
-                    (slice_size_arg->clone()),
+                    (clone_ast_node(slice_size_arg)),
                   }),
                   (make_const(1)),
                 }),
@@ -3885,15 +4060,15 @@ void UhdmAst::process_inside_op()
         if (current_node->children.size() < 2) {
             current_node->children.push_back(node);
         } else {
-            auto or_node = new AST::AstNode(AST::AST_LOGIC_OR);
+            auto or_node = new_ast_node(AST::AST_LOGIC_OR);
             or_node->filename = current_node->filename;
             or_node->location = current_node->location;
-            auto eq_node = new AST::AstNode(AST::AST_EQ);
+            auto eq_node = new_ast_node(AST::AST_EQ);
             eq_node->filename = current_node->filename;
             eq_node->location = current_node->location;
             or_node->children.push_back(current_node);
             or_node->children.push_back(eq_node);
-            eq_node->children.push_back(lhs->clone());
+            eq_node->children.push_back(clone_ast_node(lhs));
             eq_node->children.push_back(node);
             current_node = or_node;
         }
@@ -3923,10 +4098,8 @@ void UhdmAst::process_assignment_pattern_op()
                 }
                 // Place the child node holding the value assigned in the pattern, in the right order,
                 // so the overall value of the param_node is correct.
-                size_t pos =
-                  std::find_if(param_type->children.begin(), param_type->children.end(), [key](AST::AstNode *child) { return child->str == key; }) -
-                  param_type->children.begin();
-                ordered_children.insert(std::make_pair(pos, node->children[1]->clone()));
+                size_t pos = StructLayout::find_member_index(param_type, key);
+                ordered_children.insert(std::make_pair(pos, clone_ast_node(node->children[1])));
                 delete node;
             } else {
                 current_node->children.push_back(node);
@@ -3992,11 +4165,11 @@ void UhdmAst::process_indexed_part_select()
     visit_one_to_one({vpiBaseExpr}, obj_h, [&](AST::AstNode *node) { range_node->children.push_back(node); });
     visit_one_to_one({vpiWidthExpr}, obj_h, [&](AST::AstNode *node) {
         AST::AstNode *right_range_node = make_node(indexed_part_select_type);
-        right_range_node->children.push_back(range_node->children[0]->clone());
+        right_range_node->children.push_back(clone_ast_node(range_node->children[0]));
         right_range_node->children.push_back(node);
         AST::AstNode *sub = make_node(indexed_part_select_type == AST::AST_ADD ? AST::AST_SUB : AST::AST_ADD);
         sub->children.push_back(right_range_node);
-        sub->children.push_back(AST::AstNode::mkconst_int(1, false, 1));
+        sub->children.push_back(mkconst_int(1, false, 1));
         range_node->children.push_back(sub);
     });
     if (indexed_part_select_type == AST::AST_ADD) {
@@ -4012,15 +4185,15 @@ void UhdmAst::process_if_else()
         if (!node) {
             log_error("Couldn't find node in if stmt. This can happend if unsupported '$value$plusargs' function is used inside if.\n");
         }
-        auto reduce_node = new AST::AstNode(AST::AST_REDUCE_BOOL, node);
+        auto reduce_node = new_ast_node(AST::AST_REDUCE_BOOL, node);
         current_node->children.push_back(reduce_node);
     });
     // If true:
-    auto *condition = new AST::AstNode(AST::AST_COND);
-    auto *constant = AST::AstNode::mkconst_int(1, false, 1);
+    auto *condition = new_ast_node(AST::AST_COND);
+    auto *constant = mkconst_int(1, false, 1);
     condition->children.push_back(constant);
     visit_one_to_one({vpiStmt}, obj_h, [&](AST::AstNode *node) {
-        auto *statements = new AST::AstNode(AST::AST_BLOCK);
+        auto *statements = new_ast_node(AST::AST_BLOCK);
         if (node)
             statements->children.push_back(node);
         condition->children.push_back(statements);
@@ -4028,11 +4201,11 @@ void UhdmAst::process_if_else()
     current_node->children.push_back(condition);
     // Else:
     if (vpi_get(vpiType, obj_h) == vpiIfElse) {
-        auto *condition = new AST::AstNode(AST::AST_COND);
-        auto *elseBlock = new AST::AstNode(AST::AST_DEFAULT);
+        auto *condition = new_ast_node(AST::AST_COND);
+        auto *elseBlock = new_ast_node(AST::AST_DEFAULT);
         condition->children.push_back(elseBlock);
         visit_one_to_one({vpiElseStmt}, obj_h, [&](AST::AstNode *node) {
-            auto *statements = new AST::AstNode(AST::AST_BLOCK);
+            auto *statements = new_ast_node(AST::AST_BLOCK);
             if (node)
                 statements->children.push_back(node);
             condition->children.push_back(statements);
@@ -4053,7 +4226,7 @@ void UhdmAst::process_for()
             node->type = AST::AST_ASSIGN_EQ;
         auto lhs = node->children[0];
         if (lhs->type == AST::AST_WIRE) {
-            auto *wire = lhs->clone();
+            auto *wire = clone_ast_node(lhs);
             wire->is_logic = true;
             current_node->children.push_back(wire);
             lhs->type = AST::AST_IDENTIFIER;
@@ -4161,7 +4334,7 @@ void UhdmAst::process_case_item()
                 block->children = std::move(current_node->children);
                 current_node->children.clear();
                 current_node->children.push_back(block);
-                current_node->attributes[UhdmAst::low_high_bound()] = AST::AstNode::mkconst_int(1, false, 1);
+                current_node->attributes[UhdmAst::low_high_bound()] = mkconst_int(1, false, 1);
             }
         } else {
             UhdmAst uhdm_ast(this, shared, indent + "  ");
@@ -4174,12 +4347,12 @@ void UhdmAst::process_case_item()
     }
     vpi_release_handle(itr);
     if (current_node->children.empty()) {
-        current_node->children.push_back(new AST::AstNode(AST::AST_DEFAULT));
+        current_node->children.push_back(new_ast_node(AST::AST_DEFAULT));
     }
     visit_one_to_one({vpiStmt}, obj_h, [&](AST::AstNode *node) {
         if (node) {
             if (node->type != AST::AST_BLOCK) {
-                auto block_node = new AST::AstNode(AST::AST_BLOCK);
+                auto block_node = new_ast_node(AST::AST_BLOCK);
                 block_node->children.push_back(node);
                 node = block_node;
             }
@@ -4211,7 +4384,7 @@ void UhdmAst::process_return()
     current_node = make_ast_node(AST::AST_ASSIGN_EQ);
     auto func_node = find_ancestor({AST::AST_FUNCTION, AST::AST_TASK});
     if (!func_node->children.empty()) {
-        auto lhs = new AST::AstNode(AST::AST_IDENTIFIER);
+        auto lhs = new_ast_node(AST::AST_IDENTIFIER);
         lhs->str = func_node->children[0]->str;
         current_node->children.push_back(lhs);
     }
@@ -4290,12 +4463,12 @@ void UhdmAst::process_gen_scope_array()
                     auto pos = node->str.find(array_str);
                     if (pos != std::string::npos) {
                         node->type = AST::AST_PREFIX;
-                        auto *param = new AST::AstNode(AST::AST_IDENTIFIER);
+                        auto *param = new_ast_node(AST::AST_IDENTIFIER);
                         param->str = child->str;
                         node->children.push_back(param);
                         auto bracket = node->str.rfind(']');
                         if (bracket + 2 <= node->str.size()) {
-                            auto *field = new AST::AstNode(AST::AST_IDENTIFIER);
+                            auto *field = new_ast_node(AST::AST_IDENTIFIER);
                             field->str = "\\" + node->str.substr(bracket + 2);
                             node->children.push_back(field);
                         }
@@ -4317,9 +4490,9 @@ void UhdmAst::process_tagged_pattern()
     AST::AstNode *lhs_node = nullptr;
     if (assign_node) {
         assign_type = assign_node->type;
-        lhs_node = assign_node->children[0]->clone();
+        lhs_node = clone_ast_node(assign_node->children[0]);
     } else {
-        lhs_node = new AST::AstNode(AST::AST_IDENTIFIER);
+        lhs_node = new_ast_node(AST::AST_IDENTIFIER);
         auto ancestor = find_ancestor({AST::AST_WIRE, AST::AST_MEMORY, AST::AST_PARAMETER, AST::AST_LOCALPARAM});
         if (!ancestor) {
             const uhdm_handle *const handle = (const uhdm_handle *)obj_h;
@@ -4329,21 +4502,21 @@ void UhdmAst::process_tagged_pattern()
         }
         lhs_node->str = ancestor->str;
     }
-    current_node = new AST::AstNode(assign_type);
+    current_node = new_ast_node(assign_type);
     current_node->children.push_back(lhs_node);
     auto typespec_h = vpi_handle(vpiTypespec, obj_h);
     if (vpi_get(vpiType, typespec_h) == vpiStringTypespec) {
         std::string field_name = vpi_get_str(vpiName, typespec_h);
         if (field_name != "default") { // TODO: better support of the default keyword
-            auto field = new AST::AstNode(static_cast<AST::AstNodeType>(AST::Extended::AST_DOT));
+            auto field = new_ast_node(static_cast<AST::AstNodeType>(AST::Extended::AST_DOT));
             field->str = field_name;
             current_node->children[0]->children.push_back(field);
         }
     } else if (vpi_get(vpiType, typespec_h) == vpiIntegerTypespec) {
         s_vpi_value val;
         vpi_get_value(typespec_h, &val);
-        auto range = new AST::AstNode(AST::AST_RANGE);
-        auto index = AST::AstNode::mkconst_int(val.value.integer, false);
+        auto range = new_ast_node(AST::AST_RANGE);
+        auto index = mkconst_int(val.value.integer, false);
         range->children.push_back(index);
         current_node->children[0]->children.push_back(range);
     }
@@ -4366,7 +4539,7 @@ void UhdmAst::process_logic_var()
             current_node->type = node->type;
             current_node->children = std::move(node->children);
         } else {
-            auto wiretype_node = new AST::AstNode(AST::AST_WIRETYPE);
+            auto wiretype_node = new_ast_node(AST::AST_WIRETYPE);
             wiretype_node->str = node->str;
             current_node->children.push_back(wiretype_node);
             current_node->is_custom_type = true;
@@ -4409,7 +4582,7 @@ void UhdmAst::process_sys_func_call()
         // According to standard, %h and %x mean the same, but %h is currently unsupported by mainline yosys
         std::string replaced_string = std::regex_replace(current_node->children[0]->str, std::regex("%[h|H]"), "%x");
         delete current_node->children[0];
-        current_node->children[0] = AST::AstNode::mkconst_str(replaced_string);
+        current_node->children[0] = mkconst_str(replaced_string);
     }
 
     std::string remove_backslash[] = {"\\$display", "\\$strobe",   "\\$write",    "\\$monitor", "\\$time",    "\\$finish",
@@ -4547,15 +4720,15 @@ void UhdmAst::process_string_var()
     // if it is not available, we are setting size to explicite 64 bits
     visit_one_to_one({vpiExpr}, obj_h, [&](AST::AstNode *expr_node) {
         if (expr_node->type == AST::AST_CONSTANT) {
-            auto left_const = AST::AstNode::mkconst_int(expr_node->range_left, true);
-            auto right_const = AST::AstNode::mkconst_int(expr_node->range_right, true);
+            auto left_const = mkconst_int(expr_node->range_left, true);
+            auto right_const = mkconst_int(expr_node->range_right, true);
             auto range = make_ast_node(AST::AST_RANGE, {left_const, right_const});
             current_node->children.push_back(range);
         }
     });
     if (current_node->children.empty()) {
-        auto left_const = AST::AstNode::mkconst_int(64, true);
-        auto right_const = AST::AstNode::mkconst_int(0, true);
+        auto left_const = mkconst_int(64, true);
+        auto right_const = mkconst_int(0, true);
         auto range = make_ast_node(AST::AST_RANGE, {left_const, right_const});
         current_node->children.push_back(range);
     }
@@ -4571,8 +4744,8 @@ void UhdmAst::process_string_typespec()
     // currently yosys doesn't support dynamic resize of wire
     // based on string size
     // here, we are setting size to explicite 64 bits
-    auto left_const = AST::AstNode::mkconst_int(64, true);
-    auto right_const = AST::AstNode::mkconst_int(0, true);
+    auto left_const = mkconst_int(64, true);
+    auto right_const = mkconst_int(0, true);
     auto range = make_ast_node(AST::AST_RANGE, {left_const, right_const});
     current_node->children.push_back(range);
 }
@@ -4599,7 +4772,7 @@ void UhdmAst::process_repeat()
     visit_one_to_one({vpiCondition}, obj_h, [&](AST::AstNode *node) { loop->children.push_back(node); });
     visit_one_to_one({vpiStmt}, obj_h, [&](AST::AstNode *node) {
         if (node->type != AST::AST_BLOCK) {
-            node = new AST::AstNode(AST::AST_BLOCK, node);
+            node = new_ast_node(AST::AST_BLOCK, node);
         }
         if (node->str.empty()) {
             node->str = loop->str; // Needed in simplify step
@@ -4620,7 +4793,7 @@ void UhdmAst::process_var_select()
             node->children.clear();
             delete node;
         } else {
-            auto range_node = new AST::AstNode(AST::AST_RANGE);
+            auto range_node = new_ast_node(AST::AST_RANGE);
             range_node->filename = current_node->filename;
             range_node->location = current_node->location;
             range_node->children.push_back(node);
@@ -4653,7 +4826,7 @@ void UhdmAst::process_port()
                     sanitize_symbol_name(ifaceName);
                 }
                 current_node->type = AST::AST_INTERFACEPORT;
-                auto typeNode = new AST::AstNode(AST::AST_INTERFACEPORTTYPE);
+                auto typeNode = new_ast_node(AST::AST_INTERFACEPORTTYPE);
                 // Skip '\' in cellName
                 typeNode->str = ifaceName + '.' + cellName.substr(1, cellName.length());
                 current_node->children.push_back(typeNode);
@@ -4664,7 +4837,7 @@ void UhdmAst::process_port()
             break;
         }
         case vpiInterface: {
-            auto typeNode = new AST::AstNode(AST::AST_INTERFACEPORTTYPE);
+            auto typeNode = new_ast_node(AST::AST_INTERFACEPORTTYPE);
             if (auto s = vpi_get_str(vpiDefName, actual_h)) {
                 typeNode->str = s;
                 sanitize_symbol_name(typeNode->str);
@@ -4685,7 +4858,7 @@ void UhdmAst::process_port()
         case vpiPackedArrayVar:
             visit_one_to_many({vpiElement}, actual_h, [&](AST::AstNode *node) {
                 if (node && GetSize(node->children) == 1) {
-                    current_node->children.push_back(node->children[0]->clone());
+                    current_node->children.push_back(clone_ast_node(node->children[0]));
                     if (node->children[0]->type == AST::AST_WIRETYPE) {
                         current_node->is_custom_type = true;
                     }
@@ -4732,7 +4905,7 @@ void UhdmAst::process_port()
         if (node) {
             if (current_node->children.empty() || current_node->children[0]->type != AST::AST_WIRETYPE) {
                 if (!node->str.empty()) {
-                    auto wiretype_node = new AST::AstNode(AST::AST_WIRETYPE);
+                    auto wiretype_node = new_ast_node(AST::AST_WIRETYPE);
                     wiretype_node->str = node->str;
                     // wiretype needs to be 1st node (if port have also another range nodes)
                     current_node->children.insert(current_node->children.begin(), wiretype_node);
@@ -4771,7 +4944,7 @@ void UhdmAst::process_net()
     current_node->is_signed = vpi_get(vpiSigned, obj_h);
     visit_one_to_one({vpiTypespec}, obj_h, [&](AST::AstNode *node) {
         if (node && !node->str.empty()) {
-            auto wiretype_node = new AST::AstNode(AST::AST_WIRETYPE);
+            auto wiretype_node = new_ast_node(AST::AST_WIRETYPE);
             wiretype_node->str = node->str;
             // wiretype needs to be 1st node
             current_node->children.insert(current_node->children.begin(), wiretype_node);
@@ -4863,11 +5036,11 @@ void UhdmAst::process_parameter()
                     current_node->is_custom_type = true;
                     auto it = shared.param_types.find(current_node->str);
                     if (it == shared.param_types.end())
-                        shared.param_types.insert(std::make_pair(current_node->str, node->clone()));
+                        shared.param_types.insert(std::make_pair(current_node->str, clone_ast_node(node)));
                 }
                 if (node && node->attributes.count(UhdmAst::packed_ranges())) {
                     for (auto r : node->attributes[UhdmAst::packed_ranges()]->children) {
-                        packed_ranges.push_back(r->clone());
+                        packed_ranges.push_back(clone_ast_node(r));
                     }
                 }
                 delete node;
@@ -5002,7 +5175,7 @@ void UhdmAst::process_type_parameter()
     current_node = make_ast_node(AST::AST_PARAMETER);
 
     // Use an attribute to distinguish "type parameters" from other parameters
-    set_attribute(current_node, attr_id::is_type_parameter, AST::AstNode::mkconst_int(1, false, 1));
+    set_attribute(current_node, attr_id::is_type_parameter, mkconst_int(1, false, 1));
     std::string renamed_enum;
 
     visit_one_to_one({vpiTypespec}, obj_h, [&](AST::AstNode *node) {
@@ -5023,7 +5196,7 @@ void UhdmAst::process_type_parameter()
             renamed_enum = node->str + "$enum" + std::to_string(shared.next_enum_id());
         }
 
-        current_node->children.push_back(node->clone());
+        current_node->children.push_back(clone_ast_node(node));
 
         // The child stores information about the type assigned to the parameter
         //   this information will be used to rename the module
@@ -5035,7 +5208,7 @@ void UhdmAst::process_type_parameter()
             for (auto child : shared.current_top_node->children) {
                 // name of the type we're looking for
                 if (child->str == node->str && child->type == AST::AST_TYPEDEF) {
-                    current_node->children.push_back(child->clone());
+                    current_node->children.push_back(clone_ast_node(child));
                     break;
                 }
             }
@@ -5047,7 +5220,7 @@ void UhdmAst::process_type_parameter()
         for (auto child : current_node->children) {
             if (child->type == AST::AST_TYPEDEF) {
                 log_assert(child->children.size() > 0);
-                set_attribute(child->children[0], ID::enum_type, AST::AstNode::mkconst_str(renamed_enum));
+                set_attribute(child->children[0], ID::enum_type, mkconst_str(renamed_enum));
             }
             if (child->type == AST::AST_ENUM) {
                 child->str = renamed_enum;
@@ -5066,19 +5239,34 @@ AST::AstNode *UhdmAst::process_object(vpiHandle obj_handle)
     const unsigned object_type = vpi_get(vpiType, obj_h);
     const uhdm_handle *const handle = (const uhdm_handle *)obj_h;
     const UHDM::BaseClass *const object = (const UHDM::BaseClass *)handle->object;
-    for (auto *obj : shared.nonSynthesizableObjects) {
-        UHDM::CompareContext ctx;
-        if (!object->Compare(obj, &ctx)) {
-            log_warning("%.*s:%d: Skipping non-synthesizable object of type '%s'\n", (int)object->VpiFile().length(), object->VpiFile().data(),
-                        object->VpiLineNo(), UHDM::VpiTypeName(obj_h).c_str());
-            return nullptr;
-        }
+    if (shared.is_non_synthesizable(object)) {
+        log_warning("%.*s:%d: Skipping non-synthesizable object of type '%s'\n", (int)object->VpiFile().length(), object->VpiFile().data(),
+                    object->VpiLineNo(), UHDM::VpiTypeName(obj_h).c_str());
+        shared.skipped_non_synthesizable_count++;
+        return nullptr;
     }
 
     if (shared.debug_flag) {
         std::cout << indent << "Object '" << object->VpiName() << "' of type '" << UHDM::VpiTypeName(obj_h) << '\'' << std::endl;
     }
 
+    if (shared.stats_flag && shared.stats.needs_type_name(object_type)) {
+        shared.stats.set_type_name(object_type, UHDM::VpiTypeName(obj_h));
+    }
+    const UhdmAstStats::ScopedObject object_stats(shared.stats, shared.stats_flag, object_type);
+
+    const bool cacheable_typespec = object_type == vpiStructTypespec || object_type == vpiUnionTypespec || object_type == vpiPackedArrayTypespec;
+    if (cacheable_typespec) {
+        auto it = shared.typespec_cache.find(object);
+        if (it != shared.typespec_cache.end()) {
+            shared.typespec_cache_hits++;
+            shared.report.mark_handled(object);
+            current_node = clone_ast_node(it->second);
+            return current_node;
+        }
+    }
+    const unsigned context_dependent_count = shared.context_dependent_count;
+
     switch (object_type) {
     case vpiDesign:
         process_design();
@@ -5346,6 +5534,11 @@ AST::AstNode *UhdmAst::process_object(vpiHandle obj_handle)
     if (current_node) {
         if (current_node->type != AST::AST_NONE) {
             shared.report.mark_handled(object);
+            if (cacheable_typespec) {
+                shared.typespec_cache_misses++;
+                if (context_dependent_count == shared.context_dependent_count)
+                    shared.typespec_cache[object] = clone_ast_node(current_node);
+            }
             return current_node;
         }
     }
@@ -5356,7 +5549,18 @@ AST::AstNode *UhdmAst::visit_designs(const std::vector<vpiHandle> &designs)
 {
     attr_id_init();
 
-    current_node = new AST::AstNode(AST::AST_DESIGN);
+    if (shared.threads > 1) {
+        log("UHDM to AST conversion is performed on a single thread.\n");
+    }
+
+    shared.index_non_synthesizable_objects();
+    ast_nodes.count = 0;
+    ast_nodes.count_copies = shared.debug_flag || shared.stats_flag;
+    shared.typespec_cache_hits = 0;
+    shared.typespec_cache_misses = 0;
+    shared.const_cache_hits = 0;
+
+    current_node = new_ast_node(AST::AST_DESIGN);
     for (auto design : designs) {
         UhdmAst ast(this, shared, indent);
         auto *processed_design_node = ast.process_object(design);
@@ -5370,6 +5574,24 @@ AST::AstNode *UhdmAst::visit_designs(const std::vector<vpiHandle> &designs)
     }
     shared.param_types.clear();
 
+    if (shared.debug_flag) {
+        log("Skipped %u non-synthesizable objects.\n", shared.skipped_non_synthesizable_count);
+        log("Created %zu AST nodes.\n", ast_nodes.count);
+        const unsigned typespec_lookups = shared.typespec_cache_hits + shared.typespec_cache_misses;
+        log("Typespec cache: %u hits, %u misses (%.1f%% hit rate).\n", shared.typespec_cache_hits, shared.typespec_cache_misses,
+            typespec_lookups ? 100.0 * shared.typespec_cache_hits / typespec_lookups : 0.0);
+        log("Constant cache: %u hits, %zu distinct literals.\n", shared.const_cache_hits, shared.const_cache.size());
+    }
+    if (shared.stats_flag) {
+        shared.stats.set_count("AST nodes created", ast_nodes.count);
+        shared.stats.set_count("non-synthesizable objects skipped", shared.skipped_non_synthesizable_count);
+        shared.stats.set_count("typespec cache hits", shared.typespec_cache_hits);
+        shared.stats.set_count("typespec cache misses", shared.typespec_cache_misses);
+        shared.stats.set_count("constant cache hits", shared.const_cache_hits);
+    }
+    shared.clear_typespec_cache();
+    shared.clear_const_cache();
+
     // Remove all internal attributes from the AST.
     visitEachDescendant(current_node, delete_internal_attributes);
 
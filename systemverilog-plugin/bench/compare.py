@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright 2020-2022 F4PGA Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# SPDX-License-Identifier: Apache-2.0
+"""
+
+This script collects frontend statistics written by `read_systemverilog
+-stats_json` for every benchmark into a single results file and compares
+them against a baseline.
+The return code is non-zero if any metric regressed by more than the
+given threshold.
+"""
+
+import argparse
+import json
+import os
+import sys
+
+# Phases that don't overlap each other, their sum covers the whole frontend
+TOP_LEVEL_PHASES = ["parse", "AST::process"]
+
+
+def summarize(stats):
+    """ Reduces frontend statistics of a single run to the compared metrics """
+    phases = {phase["name"]: phase for phase in stats["phases"]}
+    top_level = [phases[name] for name in TOP_LEVEL_PHASES if name in phases]
+    return {
+        "wall_time": sum(phase["wall_time"] for phase in top_level),
+        "peak_rss_delta": sum(phase["peak_rss_delta"] for phase in top_level),
+        "ast_nodes": stats["counts"].get("AST nodes created", 0),
+        "phases": {name: phase["wall_time"] for name, phase in phases.items()},
+    }
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--baseline", help="Baseline results file")
+    parser.add_argument("--threshold", type=float, default=20.0, help="Allowed regression in percent")
+    parser.add_argument("--output", required=True, help="Results file to write")
+    parser.add_argument("stats", nargs="+", help="Statistics files, named <benchmark>.json")
+    args = parser.parse_args()
+
+    results = {}
+    for stats_file in args.stats:
+        with open(stats_file) as fp:
+            results[os.path.splitext(os.path.basename(stats_file))[0]] = summarize(json.load(fp))
+    with open(args.output, "w") as fp:
+        json.dump(results, fp, indent=2, sort_keys=True)
+
+    print("{:<20} {:>12} {:>14} {:>12}".format("benchmark", "wall [s]", "peak rss [KiB]", "AST nodes"))
+    for name, result in sorted(results.items()):
+        print("{:<20} {:>12.3f} {:>14} {:>12}".format(name, result["wall_time"], result["peak_rss_delta"], result["ast_nodes"]))
+
+    if not args.baseline or not os.path.exists(args.baseline):
+        print("No baseline found, skipping comparison")
+        return 0
+
+    with open(args.baseline) as fp:
+        baseline = json.load(fp)
+
+    failed = False
+    for name, result in sorted(results.items()):
+        if name not in baseline:
+            continue
+        for metric in ["wall_time", "peak_rss_delta", "ast_nodes"]:
+            reference = baseline[name][metric]
+            limit = reference * (1 + args.threshold / 100)
+            if reference > 0 and result[metric] > limit:
+                print("{}: {} regressed from {} to {} (threshold {}%)".format(name, metric, reference, result[metric], args.threshold))
+                failed = True
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
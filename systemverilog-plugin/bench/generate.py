@@ -0,0 +1,118 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright 2020-2022 F4PGA Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# SPDX-License-Identifier: Apache-2.0
+"""
+
+This script generates synthetic SystemVerilog designs stressing specific
+parts of the systemverilog plugin frontend.
+Each design is written to the standard output.
+"""
+
+import argparse
+
+
+def struct_nesting(size):
+    """ Deeply nested packed structs, accessed through long member chains """
+    lines = ["package bench_pkg;", "  typedef struct packed { logic [7:0] a; logic [7:0] b; } level0_t;"]
+    for level in range(1, size + 1):
+        lines.append(
+            "  typedef struct packed {{ level{}_t inner; logic [3:0] tag; }} level{}_t;".format(level - 1, level)
+        )
+    lines.append("endpackage")
+    member = ".".join(["inner"] * size)
+    lines += [
+        "module top(input clk, input bench_pkg::level{}_t in, output logic [7:0] out);".format(size),
+        "  always_ff @(posedge clk) out <= in.{}.a ^ in.{}.b;".format(member, member),
+        "endmodule",
+    ]
+    return lines
+
+
+def packed_arrays(size):
+    """ Wide multi-dimensional packed and unpacked arrays """
+    lines = ["module top(input clk, input [7:0] addr, input [31:0] data, output logic [31:0] out);"]
+    for i in range(size):
+        lines.append("  logic [3:0][7:0] mem{}[0:255];".format(i))
+        lines.append("  always_ff @(posedge clk) begin mem{0}[addr] <= data; end".format(i))
+    lines.append("  always_comb begin out = '0;")
+    for i in range(size):
+        lines.append("    out = out ^ mem{}[addr];".format(i))
+    lines += ["  end", "endmodule"]
+    return lines
+
+
+def generate_loops(size):
+    """ Large generate loops with nested blocks """
+    return [
+        "module top(input clk, input [{0}:0] in, output logic [{0}:0] out);".format(size - 1),
+        "  for (genvar i = 0; i < {}; i++) begin : gen_outer".format(size),
+        "    logic stage;",
+        "    always_ff @(posedge clk) stage <= in[i] ^ in[({} - 1) - i];".format(size),
+        "    assign out[i] = stage;",
+        "  end",
+        "endmodule",
+    ]
+
+
+def enums(size):
+    """ Thousands of enum types and items """
+    lines = ["package bench_pkg;"]
+    for i in range(size):
+        items = ", ".join("E{}_{}".format(i, j) for j in range(8))
+        lines.append("  typedef enum logic [2:0] {{ {} }} enum{}_t;".format(items, i))
+    lines += ["endpackage", "module top(input clk, input [2:0] in, output logic [2:0] out);"]
+    for i in range(size):
+        lines.append("  bench_pkg::enum{0}_t state{0};".format(i))
+        lines.append("  always_ff @(posedge clk) state{0} <= bench_pkg::enum{0}_t'(in);".format(i))
+    lines.append("  always_comb begin out = '0;")
+    for i in range(size):
+        lines.append("    if (state{0} == bench_pkg::E{0}_7) out = out + 1;".format(i))
+    lines += ["  end", "endmodule"]
+    return lines
+
+
+def literals(size):
+    """ Huge tables of repeated and distinct literals """
+    lines = ["module top(input [15:0] addr, output logic [31:0] out);", "  always_comb begin", "    case (addr)"]
+    for i in range(size):
+        lines.append("      16'd{}: out = 32'h{:08x};".format(i, (i * 2654435761) & 0xFFFF))
+    lines += ["      default: out = 32'h0;", "    endcase", "  end", "endmodule"]
+    return lines
+
+
+GENERATORS = {
+    "struct_nesting": (struct_nesting, 64),
+    "packed_arrays": (packed_arrays, 64),
+    "generate_loops": (generate_loops, 4096),
+    "enums": (enums, 1024),
+    "literals": (literals, 16384),
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("benchmark", choices=sorted(GENERATORS.keys()))
+    parser.add_argument("--size", type=int, help="Override the default size of the design")
+    args = parser.parse_args()
+
+    generator, default_size = GENERATORS[args.benchmark]
+    print("\n".join(generator(args.size or default_size)))
+
+
+if __name__ == "__main__":
+    main()
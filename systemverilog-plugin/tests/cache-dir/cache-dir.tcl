@@ -0,0 +1,45 @@
+yosys -import
+if { [info procs read_uhdm] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+set CACHE_DIR $TMP_DIR/cache
+file delete -force $CACHE_DIR
+file mkdir $TMP_DIR
+
+# First run compiles the design and populates the cache
+read_systemverilog -o $TMP_DIR -cache_dir $CACHE_DIR $::env(DESIGN_TOP).v
+if { [llength [glob -nocomplain $CACHE_DIR/*.uhdm]] != 1 } {
+    error "Elaborated design was not stored in the cache"
+}
+design -reset
+
+# Second run restores the design from the cache
+read_systemverilog -o $TMP_DIR -cache_dir $CACHE_DIR $::env(DESIGN_TOP).v
+if { [llength [glob -nocomplain $CACHE_DIR/*.uhdm]] != 1 } {
+    error "Unexpected cache entries"
+}
+hierarchy -top top
+select -assert-count 1 t:$dff
+design -reset
+
+# Headers included relative to the source file are part of the key
+file delete -force $CACHE_DIR
+set fp [open $TMP_DIR/width.vh w]
+puts $fp {`define WIDTH 4}
+close $fp
+set fp [open $TMP_DIR/include.v w]
+puts $fp {`include "width.vh"}
+puts $fp {module top(input clk, input [`WIDTH-1:0] in, output reg [`WIDTH-1:0] out);}
+puts $fp {  always @(posedge clk) out <= in;}
+puts $fp {endmodule}
+close $fp
+read_systemverilog -o $TMP_DIR -cache_dir $CACHE_DIR $TMP_DIR/include.v
+design -reset
+set fp [open $TMP_DIR/width.vh w]
+puts $fp {`define WIDTH 8}
+close $fp
+read_systemverilog -o $TMP_DIR -cache_dir $CACHE_DIR $TMP_DIR/include.v
+if { [llength [glob -nocomplain $CACHE_DIR/*.uhdm]] != 2 } {
+    error "Changed header did not invalidate the cache entry"
+}
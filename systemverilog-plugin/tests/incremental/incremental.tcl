@@ -0,0 +1,25 @@
+yosys -import
+if { [info procs read_uhdm] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+set CACHE_DIR $TMP_DIR/cache
+file delete -force $CACHE_DIR
+file mkdir $TMP_DIR
+
+# First run converts all modules and stores their RTLIL
+read_systemverilog -o $TMP_DIR -cache_dir $CACHE_DIR -incremental $::env(DESIGN_TOP).v
+set stored [llength [glob -nocomplain $CACHE_DIR/modules/*.il]]
+if { $stored == 0 } {
+    error "No modules were stored in the cache"
+}
+design -reset
+
+# Second run reuses the cached modules
+read_systemverilog -o $TMP_DIR -cache_dir $CACHE_DIR -incremental $::env(DESIGN_TOP).v
+if { [llength [glob -nocomplain $CACHE_DIR/modules/*.il]] != $stored } {
+    error "Unexpected cache entries"
+}
+hierarchy -top top
+select -assert-count 1 t:$dff
+select -assert-count 1 top/u_inv
@@ -0,0 +1,34 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+module inverter #(
+  parameter WIDTH = 2
+) (
+  input [WIDTH-1:0] in,
+  output [WIDTH-1:0] out
+);
+  assign out = ~in;
+endmodule
+
+module top (
+  input clk,
+  input [3:0] in,
+  output reg [3:0] out
+);
+  wire [3:0] inv;
+  inverter #(.WIDTH(4)) u_inv (.in(in), .out(inv));
+  always @(posedge clk) out <= inv;
+endmodule
@@ -0,0 +1,13 @@
+yosys -import
+if { [info procs read_uhdm] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+file mkdir $TMP_DIR
+
+read_systemverilog -o $TMP_DIR -lazy_specialize $::env(DESIGN_TOP).v
+# Specializations are only converted when hierarchy reaches them
+select -assert-none t:$not
+hierarchy -top top
+select -assert-count 1 top/t:$dff
+select -assert-count 1 t:$not
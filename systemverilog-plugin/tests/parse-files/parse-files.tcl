@@ -0,0 +1,11 @@
+yosys -import
+if { [info procs read_uhdm] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+file mkdir $TMP_DIR
+
+read_systemverilog -o $TMP_DIR -parse-files -stats_json $TMP_DIR/stats.json $::env(DESIGN_TOP).v
+# Nothing is loaded into the design
+select -assert-none *
+if { ![file exists $TMP_DIR/stats.json] } { error "Statistics were not written" }
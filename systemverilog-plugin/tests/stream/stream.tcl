@@ -0,0 +1,11 @@
+yosys -import
+if { [info procs read_uhdm] == {} } { plugin -i systemverilog }
+yosys -import  ;# ingest plugin commands
+
+set TMP_DIR $::env(TEST_OUTPUT_PREFIX)/tmp
+file mkdir $TMP_DIR
+
+read_systemverilog -o $TMP_DIR -stream $::env(DESIGN_TOP).v
+hierarchy -top top
+select -assert-count 1 top/w:out
+select -assert-count 1 top/t:$dff
@@ -0,0 +1,37 @@
+// Copyright 2020-2022 F4PGA Authors
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//     http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// SPDX-License-Identifier: Apache-2.0
+
+package pkg;
+  parameter WIDTH = 4;
+  typedef logic [WIDTH-1:0] data_t;
+endpackage
+
+module inverter (
+  input pkg::data_t in,
+  output pkg::data_t out
+);
+  assign out = ~in;
+endmodule
+
+module top (
+  input clk,
+  input pkg::data_t in,
+  output pkg::data_t out
+);
+  pkg::data_t inv;
+  inverter u_inv (.in(in), .out(inv));
+  always @(posedge clk) out <= inv;
+endmodule
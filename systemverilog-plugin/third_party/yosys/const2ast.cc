@@ -42,8 +42,10 @@
 #include "frontends/ast/ast.h"
 #include "kernel/log.h"
 
+#include <algorithm>
 #include <string>
 #include <cmath>
+#include <cstring>
 #include <vector>
 
 using namespace Yosys;
@@ -76,49 +78,77 @@ static int my_ilog2(int x)
 	return ret;
 }
 
-// parse a binary, decimal, hexadecimal or octal number with support for special bits ('x', 'z' and '?')
-static void my_strtobin(std::vector<RTLIL::State> &data, const char *str, int len_in_bits, int base, char case_type, bool is_unsized)
+// parse a binary, octal or hexadecimal number with support for special bits ('x', 'z' and '?')
+// the digits are expanded from a table holding the bits of every digit value, so
+// all bits of a digit are copied at once into the preallocated data
+static void my_strtobin_pow2(std::vector<RTLIL::State> &data, const char *str, int base, char case_type)
 {
-	// all digits in string (MSB at index 0)
-	std::vector<uint8_t> digits;
-
-	while (*str) {
-		if ('0' <= *str && *str <= '9')
-			digits.push_back(*str - '0');
-		else if ('a' <= *str && *str <= 'f')
-			digits.push_back(10 + *str - 'a');
-		else if ('A' <= *str && *str <= 'F')
-			digits.push_back(10 + *str - 'A');
-		else if (*str == 'x' || *str == 'X')
-			digits.push_back(0xf0);
-		else if (*str == 'z' || *str == 'Z' || *str == '?')
-			digits.push_back(0xf1);
-		str++;
-	}
+	static_assert(sizeof(RTLIL::State) == 1, "RTLIL::State is expected to be a single byte");
+	int bits_per_digit = my_ilog2(base-1);
 
-	if (base == 10 && GetSize(digits) == 1 && digits.front() >= 0xf0)
-		base = 2;
+	// rows 0 to 15 hold the digit values, LSB first, row 16 is 'x' and row 17 is 'z'
+	RTLIL::State table[18][4];
+	for (int value = 0; value < 16; value++)
+		for (int i = 0; i < 4; i++)
+			table[value][i] = (value >> i) & 1 ? State::S1 : State::S0;
+	std::fill_n(table[16], 4, case_type == 'x' ? RTLIL::Sa : RTLIL::Sx);
+	std::fill_n(table[17], 4, case_type == 'x' || case_type == 'z' ? RTLIL::Sa : RTLIL::Sz);
 
+	size_t len = strlen(str);
+	data.resize(len * bits_per_digit);
+	RTLIL::State *out = data.data();
+	for (const char *it = str + len; it-- != str;) {
+		int value;
+		if ('0' <= *it && *it <= '9')
+			value = *it - '0';
+		else if ('a' <= *it && *it <= 'f')
+			value = 10 + *it - 'a';
+		else if ('A' <= *it && *it <= 'F')
+			value = 10 + *it - 'A';
+		else if (*it == 'x' || *it == 'X')
+			value = 16;
+		else if (*it == 'z' || *it == 'Z' || *it == '?')
+			value = 17;
+		else
+			continue;
+		if (value > (base-1) && value < 16)
+			log_file_error(current_filename, get_line_num(), "Digit larger than %d used in in base-%d constant.\n",
+				       base-1, base);
+		out = std::copy_n(table[value], bits_per_digit, out);
+	}
+	data.resize(out - data.data());
+}
+
+// parse a binary, decimal, hexadecimal or octal number with support for special bits ('x', 'z' and '?')
+static void my_strtobin(std::vector<RTLIL::State> &data, const char *str, int len_in_bits, int base, char case_type, bool is_unsized)
+{
 	data.clear();
 
-	if (base == 10) {
-		while (!digits.empty())
-			data.push_back(my_decimal_div_by_two(digits) ? State::S1 : State::S0);
+	if (base != 10) {
+		my_strtobin_pow2(data, str, base, case_type);
 	} else {
-		int bits_per_digit = my_ilog2(base-1);
-		for (auto it = digits.rbegin(), e = digits.rend(); it != e; it++) {
-			if (*it > (base-1) && *it < 0xf0)
-				log_file_error(current_filename, get_line_num(), "Digit larger than %d used in in base-%d constant.\n",
-					       base-1, base);
-			for (int i = 0; i < bits_per_digit; i++) {
-				int bitmask = 1 << i;
-				if (*it == 0xf0)
-					data.push_back(case_type == 'x' ? RTLIL::Sa : RTLIL::Sx);
-				else if (*it == 0xf1)
-					data.push_back(case_type == 'x' || case_type == 'z' ? RTLIL::Sa : RTLIL::Sz);
-				else
-					data.push_back((*it & bitmask) ? State::S1 : State::S0);
-			}
+		// all digits in string (MSB at index 0)
+		std::vector<uint8_t> digits;
+
+		for (const char *it = str; *it; it++) {
+			if ('0' <= *it && *it <= '9')
+				digits.push_back(*it - '0');
+			else if ('a' <= *it && *it <= 'f')
+				digits.push_back(10 + *it - 'a');
+			else if ('A' <= *it && *it <= 'F')
+				digits.push_back(10 + *it - 'A');
+			else if (*it == 'x' || *it == 'X')
+				digits.push_back(0xf0);
+			else if (*it == 'z' || *it == 'Z' || *it == '?')
+				digits.push_back(0xf1);
+		}
+
+		if (GetSize(digits) == 1 && digits.front() >= 0xf0) {
+			// a single special digit, e.g. 'dx, is a single special bit
+			my_strtobin_pow2(data, str, 2, case_type);
+		} else {
+			while (!digits.empty())
+				data.push_back(my_decimal_div_by_two(digits) ? State::S1 : State::S0);
 		}
 	}
 
@@ -183,9 +213,9 @@ AstNode *systemverilog_plugin::const2ast(std::string code, char case_type, bool
 		return ast;
 	}
 
-	for (size_t i = 0; i < code.size(); i++)
-		if (code[i] == '_' || code[i] == ' ' || code[i] == '\t' || code[i] == '\r' || code[i] == '\n')
-			code.erase(code.begin()+(i--));
+	code.erase(std::remove_if(code.begin(), code.end(), [](char c) {
+		return c == '_' || c == ' ' || c == '\t' || c == '\r' || c == '\n';
+	}), code.end());
 	str = code.c_str();
 
 	char *endptr;
@@ -306,17 +306,24 @@ Yosys::AST::AstNode *get_struct_member(const Yosys::AST::AstNode *node)
 	return NULL;
 }
 
-static void add_members_to_scope(Yosys::AST::AstNode *snode, std::string name)
+static void add_members_to_scope(Yosys::AST::AstNode *snode, const std::string &name)
 {
 	// add all the members in a struct or union to local scope
 	// in case later referenced in assignments
 	log_assert(snode->type==Yosys::AST::AST_STRUCT || snode->type==Yosys::AST::AST_UNION);
-	for (auto *node : snode->children) {
-		auto member_name = name + "." + node->str;
-		current_scope[member_name] = node;
-		if (node->type != Yosys::AST::AST_STRUCT_ITEM) {
-			// embedded struct or union
-			add_members_to_scope(node, name + "." + node->str);
+	// embedded structs and unions are visited with an explicit stack,
+	// together with the dotted name of the struct they are members of
+	std::vector<std::pair<Yosys::AST::AstNode *, std::string>> stack = {{snode, name}};
+	while (!stack.empty()) {
+		auto current = std::move(stack.back());
+		stack.pop_back();
+		for (auto *node : current.first->children) {
+			auto member_name = current.second + "." + node->str;
+			current_scope[member_name] = node;
+			if (node->type != Yosys::AST::AST_STRUCT_ITEM) {
+				// embedded struct or union
+				stack.emplace_back(node, std::move(member_name));
+			}
 		}
 	}
 }
@@ -1111,7 +1118,10 @@ bool simplify(Yosys::AST::AstNode *ast_node, bool const_fold, bool at_zero, bool
 			auto item_node = current_scope[ast_node->children[0]->str];
 			if (item_node->type == Yosys::AST::AST_STRUCT || item_node->type == Yosys::AST::AST_UNION) {
 				ast_node->attributes[ID::wiretype] = item_node->clone();
-				size_packed_struct(ast_node->attributes[ID::wiretype], 0);
+				// a prepared struct is already laid out from offset 0 and the clone
+				// carries its offsets, widths and dimensions
+				if (!item_node->basic_prep)
+					size_packed_struct(ast_node->attributes[ID::wiretype], 0);
 				add_members_to_scope(ast_node->attributes[ID::wiretype], ast_node->str);
 			}
 		}
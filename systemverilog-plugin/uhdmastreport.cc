@@ -1,9 +1,9 @@
 #include "uhdmastreport.h"
 #include "frontends/ast/ast.h"
+#include <algorithm>
 #include <fstream>
 #include <sys/stat.h>
 #include <uhdm/BaseClass.h>
-#include <unordered_set>
 
 namespace systemverilog_plugin
 {
@@ -37,54 +37,152 @@ static std::string replace_in_string(std::string str, const std::string &to_find
     return str;
 }
 
-void UhdmAstReport::write(const std::string &directory)
+// Share of handled objects in percent. Nothing to handle counts as full coverage.
+static float coverage_percent(size_t handled, size_t unhandled)
 {
-    std::unordered_map<std::string, std::unordered_set<unsigned>> unhandled_per_file;
-    for (auto object : unhandled) {
-        if (!object->VpiFile().empty() && object->VpiFile() != AST::current_filename) {
-            unhandled_per_file.insert(std::make_pair(object->VpiFile(), std::unordered_set<unsigned>()));
-            unhandled_per_file.at(std::string(object->VpiFile())).insert(object->VpiLineNo());
-            handled_count_per_file.insert(std::make_pair(object->VpiFile(), 0));
-        }
-    }
-    unsigned total_handled = 0;
-    for (auto &hc : handled_count_per_file) {
-        if (!hc.first.empty() && hc.first != AST::current_filename) {
-            unhandled_per_file.insert(std::make_pair(hc.first, std::unordered_set<unsigned>()));
-            total_handled += hc.second;
+    if (handled + unhandled == 0)
+        return 100.f;
+    return handled * 100.f / (handled + unhandled);
+}
+
+namespace
+{
+// Coverage of a single source file
+struct FileCoverage {
+    unsigned handled_count = 0;
+    // Sorted line numbers with at least one unhandled object
+    std::vector<unsigned> unhandled_lines;
+
+    float coverage() const { return coverage_percent(handled_count, unhandled_lines.size()); }
+};
+} // namespace
+
+static std::string escape_json(const std::string &str)
+{
+    std::string escaped;
+    escaped.reserve(str.size());
+    for (char c : str) {
+        if (c == '"' || c == '\\') {
+            escaped += '\\';
+            escaped += c;
+        } else if ((unsigned char)c < 0x20) {
+            escaped += stringf("\\u%04x", c);
+        } else {
+            escaped += c;
         }
     }
-    float coverage = total_handled * 100.f / (total_handled + unhandled.size());
-    mkdir(directory.c_str(), 0777);
+    return escaped;
+}
+
+// Quote a CSV field if it contains a separator, a quote or a line break
+static std::string escape_csv(const std::string &str)
+{
+    if (str.find_first_of(",\"\r\n") == std::string::npos)
+        return str;
+    return '"' + replace_in_string(str, "\"", "\"\"") + '"';
+}
+
+static void write_html(const std::string &directory, float coverage, const std::map<std::string, FileCoverage> &coverage_per_file)
+{
     std::ofstream index_file(directory + "/index.html");
-    index_file << "<!DOCTYPE html>\n<html>\n<head>\n<style>h3{margin:0;padding:10}</style>\n</head><body>" << std::endl;
-    index_file << "<h2>Overall coverage: " << coverage << "%</h2>" << std::endl;
-    for (auto &unhandled_in_file : unhandled_per_file) {
-        // Calculate coverage in file
-        unsigned handled_count = handled_count_per_file.at(unhandled_in_file.first);
-        unsigned unhandled_count = unhandled_in_file.second.size();
-        float coverage = handled_count * 100.f / (handled_count + unhandled_count);
+    index_file << "<!DOCTYPE html>\n<html>\n<head>\n<style>h3{margin:0;padding:10}</style>\n</head><body>\n";
+    index_file << "<h2>Overall coverage: " << coverage << "%</h2>\n";
+    std::string line;
+    for (auto &file_coverage : coverage_per_file) {
+        const float coverage = file_coverage.second.coverage();
         // Add to the index file
-        std::string report_filename = replace_in_string(unhandled_in_file.first, "/", ".") + ".html";
-        index_file << "<h3>Cov: " << coverage << "%<a href=\"" << report_filename << "\">" << unhandled_in_file.first << "</a></h3><br>" << std::endl;
+        std::string report_filename = replace_in_string(file_coverage.first, "/", ".") + ".html";
+        index_file << "<h3>Cov: " << coverage << "%<a href=\"" << report_filename << "\">" << file_coverage.first << "</a></h3><br>\n";
         // Write the report file
         std::ofstream report_file(directory + '/' + report_filename);
-        report_file << "<!DOCTYPE html>\n<html>\n<head>\n<style>\nbody{font-size:12px;}pre{display:inline}</style>\n</head><body>" << std::endl;
-        report_file << "<h2>" << unhandled_in_file.first << " | Coverage: " << coverage << "%</h2>" << std::endl;
-        std::ifstream source_file(unhandled_in_file.first); // Read the source code
+        report_file << "<!DOCTYPE html>\n<html>\n<head>\n<style>\nbody{font-size:12px;}pre{display:inline}</style>\n</head><body>\n";
+        report_file << "<h2>" << file_coverage.first << " | Coverage: " << coverage << "%</h2>\n";
+        std::ifstream source_file(file_coverage.first); // Read the source code
+        const auto &unhandled_lines = file_coverage.second.unhandled_lines;
+        auto unhandled_it = unhandled_lines.begin();
         unsigned line_number = 1;
-        std::string line;
         while (std::getline(source_file, line)) {
-            if (unhandled_in_file.second.find(line_number) == unhandled_in_file.second.end()) {
-                report_file << line_number << "<pre> " << line << "</pre><br>" << std::endl;
+            while (unhandled_it != unhandled_lines.end() && *unhandled_it < line_number)
+                ++unhandled_it;
+            if (unhandled_it == unhandled_lines.end() || *unhandled_it != line_number) {
+                report_file << line_number << "<pre> " << line << "</pre><br>\n";
             } else {
-                report_file << line_number << "<pre style=\"background-color: #FFB6C1;\"> " << line << "</pre><br>" << std::endl;
+                report_file << line_number << "<pre style=\"background-color: #FFB6C1;\"> " << line << "</pre><br>\n";
             }
             ++line_number;
         }
-        report_file << "</body>\n</html>" << std::endl;
+        report_file << "</body>\n</html>\n";
+    }
+    index_file << "</body>\n</html>\n";
+}
+
+static void write_json(const std::string &directory, float coverage, const std::map<std::string, FileCoverage> &coverage_per_file)
+{
+    std::ofstream json_file(directory + "/coverage.json");
+    json_file << "{\n  \"coverage\": " << coverage << ",\n  \"files\": [";
+    bool first = true;
+    for (auto &file_coverage : coverage_per_file) {
+        json_file << (first ? "\n" : ",\n") << "    {\"file\": \"" << escape_json(file_coverage.first)
+                  << "\", \"handled\": " << file_coverage.second.handled_count << ", \"unhandled_lines\": " << file_coverage.second.unhandled_lines.size()
+                  << ", \"coverage\": " << file_coverage.second.coverage() << "}";
+        first = false;
+    }
+    json_file << "\n  ]\n}\n";
+}
+
+static void write_csv(const std::string &directory, const std::map<std::string, FileCoverage> &coverage_per_file)
+{
+    std::ofstream csv_file(directory + "/coverage.csv");
+    csv_file << "file,handled,unhandled_lines,coverage\n";
+    for (auto &file_coverage : coverage_per_file) {
+        csv_file << escape_csv(file_coverage.first) << ',' << file_coverage.second.handled_count << ',' << file_coverage.second.unhandled_lines.size()
+                 << ',' << file_coverage.second.coverage() << '\n';
+    }
+}
+
+void UhdmAstReport::write(const std::string &directory, Format format)
+{
+    wait();
+    std::map<std::string, FileCoverage> coverage_per_file;
+    for (auto object : unhandled) {
+        if (!object->VpiFile().empty() && object->VpiFile() != AST::current_filename) {
+            coverage_per_file[std::string(object->VpiFile())].unhandled_lines.push_back(object->VpiLineNo());
+            handled_count_per_file.insert(std::make_pair(object->VpiFile(), 0));
+        }
     }
-    index_file << "</body>\n</html>" << std::endl;
+    unsigned total_handled = 0;
+    for (auto &hc : handled_count_per_file) {
+        if (!hc.first.empty() && hc.first != AST::current_filename) {
+            coverage_per_file[hc.first].handled_count = hc.second;
+            total_handled += hc.second;
+        }
+    }
+    for (auto &file_coverage : coverage_per_file) {
+        auto &lines = file_coverage.second.unhandled_lines;
+        std::sort(lines.begin(), lines.end());
+        lines.erase(std::unique(lines.begin(), lines.end()), lines.end());
+    }
+    float coverage = coverage_percent(total_handled, unhandled.size());
+    mkdir(directory.c_str(), 0777);
+    writer = std::thread([directory, format, coverage, coverage_per_file = std::move(coverage_per_file)]() {
+        switch (format) {
+        case Format::Html:
+            write_html(directory, coverage, coverage_per_file);
+            break;
+        case Format::Json:
+            write_json(directory, coverage, coverage_per_file);
+            break;
+        case Format::Csv:
+            write_csv(directory, coverage_per_file);
+            break;
+        }
+    });
+}
+
+void UhdmAstReport::wait()
+{
+    if (writer.joinable())
+        writer.join();
 }
 
 } // namespace systemverilog_plugin
@@ -4,7 +4,9 @@
 #include "kernel/yosys.h"
 #include <map>
 #include <string>
+#include <thread>
 #include <unordered_map>
+#include <vector>
 #undef cover
 #include <uhdm/uhdm.h>
 
@@ -17,7 +19,14 @@ class UhdmAstReport
     // Maps a filename to the number of objects being handled by the frontend
     std::unordered_map<std::string, unsigned> handled_count_per_file;
 
+    // Writes report files in the background
+    std::thread writer;
+
   public:
+    enum class Format { Html, Json, Csv };
+
+    ~UhdmAstReport() { wait(); }
+
     // Objects not being handled by the frontend
     std::set<const UHDM::BaseClass *> unhandled;
 
@@ -27,8 +36,13 @@ class UhdmAstReport
     // Marks the object referenced by the specified handle as being handled by the frontend
     void mark_handled(vpiHandle obj_h);
 
-    // Write the coverage report to the specified path
-    void write(const std::string &directory);
+    // Write the coverage report to the specified path.
+    // Coverage data is extracted from the UHDM objects before returning, so they can be released right away.
+    // Report files are written by a background thread, call wait() to make sure they are complete.
+    void write(const std::string &directory, Format format = Format::Html);
+
+    // Wait until writing of the report files is finished
+    void wait();
 };
 
 } // namespace systemverilog_plugin
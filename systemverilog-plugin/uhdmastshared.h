@@ -4,8 +4,14 @@
 #include "frontends/ast/ast.h"
 
 #include "uhdmastreport.h"
+#include "uhdmaststats.h"
+#include <algorithm>
+#include <map>
 #include <string>
+#include <string_view>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 namespace systemverilog_plugin
 {
@@ -34,22 +40,80 @@ class UhdmAstShared
         for (const auto &param : param_types)
             delete param.second;
         param_types.clear();
+        clear_typespec_cache();
+        clear_const_cache();
+    }
+
+    // Delete all cached typespec conversions
+    void clear_typespec_cache()
+    {
+        for (const auto &typespec : typespec_cache)
+            delete typespec.second;
+        typespec_cache.clear();
+    }
+
+    // Incremented every time the conversion depends on, or modifies, state outside of
+    // the object being converted (ancestors, ID counters, typedefs moved to the top node).
+    // Objects converted while this changes can't be cached.
+    unsigned context_dependent_count = 0;
+
+    // Converted struct, union and packed array typespecs, keyed by UHDM object.
+    // The cache owns the nodes, users get clones.
+    std::unordered_map<const UHDM::BaseClass *, ::Yosys::AST::AstNode *> typespec_cache;
+
+    // Typespec cache statistics, printed with -debug
+    unsigned typespec_cache_hits = 0;
+    unsigned typespec_cache_misses = 0;
+
+    // Parsed literals, keyed by the literal followed by the case type.
+    // The cache owns the nodes, users get clones.
+    std::unordered_map<std::string, ::Yosys::AST::AstNode *> const_cache;
+
+    // Number of literals served from const_cache, printed with -debug
+    unsigned const_cache_hits = 0;
+
+    // Delete all cached literals
+    void clear_const_cache()
+    {
+        for (const auto &constant : const_cache)
+            delete constant.second;
+        const_cache.clear();
     }
 
     // Generate the next enum ID (starting with 0)
-    unsigned next_enum_id() { return enum_count++; }
+    unsigned next_enum_id()
+    {
+        context_dependent_count++;
+        return enum_count++;
+    }
 
     // Generate the next port ID (starting with 1)
-    unsigned next_port_id() { return ++port_count; }
+    unsigned next_port_id()
+    {
+        context_dependent_count++;
+        return ++port_count;
+    }
 
     // Generate the next loop ID (starting with 0)
-    unsigned next_loop_id() { return loop_count++; }
+    unsigned next_loop_id()
+    {
+        context_dependent_count++;
+        return loop_count++;
+    }
 
     // Generate the next anonymous type ID (starting with 0).
-    unsigned next_anonymous_type_id() { return anonymous_type_count++; }
+    unsigned next_anonymous_type_id()
+    {
+        context_dependent_count++;
+        return anonymous_type_count++;
+    }
 
     // Generate the next anonymous enum typedef ID (starting with 0).
-    unsigned next_anonymous_enum_typedef_id() { return anonymous_enum_typedef_count++; }
+    unsigned next_anonymous_enum_typedef_id()
+    {
+        context_dependent_count++;
+        return anonymous_enum_typedef_count++;
+    }
 
     // Flag that determines whether debug info should be printed
     bool debug_flag = false;
@@ -64,6 +128,10 @@ class UhdmAstShared
     // applies only to read_systemverilog command
     bool parse_only = false;
 
+    // Flag that determines whether every file should be parsed on its own, without elaboration
+    // applies only to read_systemverilog command, implies parse_only
+    bool parse_files = false;
+
     // Flag that determines whether we should defer the elaboration
     // applies only to read_systemverilog command
     bool defer = false;
@@ -77,12 +145,57 @@ class UhdmAstShared
     // Allows verification constructs in Surelog
     bool formal = false;
 
+    // Flag that determines whether modules should be handed off to AST::process one at a time
+    bool stream = false;
+
+    // Number of worker threads requested with -threads
+    // Conversion of UHDM to AST is currently always performed on a single thread
+    unsigned threads = 1;
+
     // Top nodes of the design (modules, interfaces)
     std::unordered_map<std::string, ::Yosys::AST::AstNode *> top_nodes;
 
+    // Packages in top_nodes, in the order they were added
+    std::vector<::Yosys::AST::AstNode *> packages;
+
+    // Scope entries of all packages, built on first use by UhdmAst.
+    // Rebuilt when packages were added or the number of their children changed.
+    std::map<std::string, ::Yosys::AST::AstNode *> package_scope;
+    bool package_scope_valid = false;
+    size_t package_scope_children = 0;
+
+    // Add the node to top_nodes, keeping track of packages
+    void add_top_node(::Yosys::AST::AstNode *node)
+    {
+        auto &top_node = top_nodes[node->str];
+        if (top_node && top_node->type == ::Yosys::AST::AST_PACKAGE) {
+            packages.erase(std::remove(packages.begin(), packages.end(), top_node), packages.end());
+            package_scope_valid = false;
+        }
+        top_node = node;
+        if (node->type == ::Yosys::AST::AST_PACKAGE) {
+            packages.push_back(node);
+            package_scope_valid = false;
+        }
+    }
+
+    void clear_top_nodes()
+    {
+        top_nodes.clear();
+        packages.clear();
+        package_scope.clear();
+        package_scope_valid = false;
+    }
+
     // UHDM node coverage report
     UhdmAstReport report;
 
+    // Flag that determines whether frontend statistics should be collected
+    bool stats_flag = false;
+
+    // Frontend statistics
+    UhdmAstStats stats;
+
     // Map from AST param nodes to their types (used for params with struct types)
     std::unordered_map<std::string, ::Yosys::AST::AstNode *> param_types;
 
@@ -93,7 +206,45 @@ class UhdmAstShared
     const UHDM::any *current_instance = nullptr;
 
     // Set of non-synthesizable objects to skip in current design;
-    std::set<const UHDM::BaseClass *> nonSynthesizableObjects;
+    std::unordered_set<const UHDM::BaseClass *> nonSynthesizableObjects;
+
+    // Non-synthesizable objects grouped by VPI type and name.
+    // Objects can only compare equal when both of these match, so only a single bucket
+    // has to be searched for every visited object.
+    std::unordered_map<unsigned, std::unordered_map<std::string_view, std::vector<const UHDM::BaseClass *>>> nonSynthesizableIndex;
+
+    // Number of objects skipped as non-synthesizable in current design
+    unsigned skipped_non_synthesizable_count = 0;
+
+    // Build nonSynthesizableIndex from nonSynthesizableObjects
+    void index_non_synthesizable_objects()
+    {
+        nonSynthesizableIndex.clear();
+        skipped_non_synthesizable_count = 0;
+        for (auto *obj : nonSynthesizableObjects)
+            nonSynthesizableIndex[obj->VpiType()][obj->VpiName()].push_back(obj);
+    }
+
+    // Check whether the object is equal to any of the non-synthesizable objects
+    bool is_non_synthesizable(const UHDM::BaseClass *object) const
+    {
+        if (nonSynthesizableObjects.empty())
+            return false;
+        if (nonSynthesizableObjects.count(object))
+            return true;
+        auto type_it = nonSynthesizableIndex.find(object->VpiType());
+        if (type_it == nonSynthesizableIndex.end())
+            return false;
+        auto name_it = type_it->second.find(object->VpiName());
+        if (name_it == type_it->second.end())
+            return false;
+        for (auto *obj : name_it->second) {
+            UHDM::CompareContext ctx;
+            if (!object->Compare(obj, &ctx))
+                return true;
+        }
+        return false;
+    }
 
     // Map of anonymous enum types to generated typedefs
     std::unordered_map<std::string, std::unordered_map<const UHDM::enum_typespec *, std::string>> anonymous_enums;
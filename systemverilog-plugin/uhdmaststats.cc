@@ -0,0 +1,170 @@
+#include "uhdmaststats.h"
+#include "../common/instrumentation.h"
+#include "kernel/yosys.h"
+#include <algorithm>
+#include <fstream>
+
+#if !defined(_WIN32)
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+namespace systemverilog_plugin
+{
+
+using namespace ::Yosys;
+
+// Returns user and system CPU time of the process, in seconds
+static double get_cpu_time()
+{
+#if !defined(_WIN32)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        return usage.ru_utime.tv_sec + usage.ru_utime.tv_usec * 1e-6 + usage.ru_stime.tv_sec + usage.ru_stime.tv_usec * 1e-6;
+#endif
+    return 0;
+}
+
+// Returns peak resident set size of the process, in KiB
+static long get_peak_rss()
+{
+#if defined(__APPLE__)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        return usage.ru_maxrss / 1024;
+#elif !defined(_WIN32)
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+        return usage.ru_maxrss;
+#endif
+    return 0;
+}
+
+long UhdmAstStats::current_rss()
+{
+#if defined(__linux__)
+    long pages = 0, resident = 0;
+    std::ifstream statm("/proc/self/statm");
+    if (statm >> pages >> resident)
+        return resident * (sysconf(_SC_PAGESIZE) / 1024);
+#endif
+    return 0;
+}
+
+UhdmAstStats::ScopedPhase::ScopedPhase(UhdmAstStats &stats, bool enabled, const std::string &name)
+    : stats(enabled ? &stats : nullptr), instrumented(instrumentation::registry().enabled())
+{
+    if (!this->stats && !instrumented)
+        return;
+    this->name = name;
+    wall_start = std::chrono::steady_clock::now();
+    cpu_start = get_cpu_time();
+    peak_rss_start = get_peak_rss();
+}
+
+UhdmAstStats::ScopedPhase::~ScopedPhase()
+{
+    if (!stats && !instrumented)
+        return;
+    const std::chrono::duration<double> wall_time = std::chrono::steady_clock::now() - wall_start;
+    if (stats)
+        stats->add_phase(name, wall_time.count(), get_cpu_time() - cpu_start, get_peak_rss() - peak_rss_start);
+    if (instrumented)
+        instrumentation::registry().add_time("systemverilog." + name, wall_time.count(), get_peak_rss() - peak_rss_start);
+}
+
+UhdmAstStats::ScopedObject::ScopedObject(UhdmAstStats &stats, bool enabled, unsigned type) : stats(enabled ? &stats : nullptr), type(type)
+{
+    if (this->stats)
+        start = std::chrono::steady_clock::now();
+}
+
+UhdmAstStats::ScopedObject::~ScopedObject()
+{
+    if (!stats)
+        return;
+    const std::chrono::duration<double> time = std::chrono::steady_clock::now() - start;
+    auto &object = stats->objects[type];
+    object.count++;
+    object.time += time.count();
+}
+
+void UhdmAstStats::clear()
+{
+    phases.clear();
+    counts.clear();
+    objects.clear();
+}
+
+void UhdmAstStats::add_phase(const std::string &name, double wall_time, double cpu_time, long peak_rss_delta)
+{
+    auto it = std::find_if(phases.begin(), phases.end(), [&](const Phase &phase) { return phase.name == name; });
+    if (it == phases.end()) {
+        phases.emplace_back();
+        it = std::prev(phases.end());
+        it->name = name;
+    }
+    it->count++;
+    it->wall_time += wall_time;
+    it->cpu_time += cpu_time;
+    it->peak_rss_delta += peak_rss_delta;
+}
+
+void UhdmAstStats::log_stats() const
+{
+    log("\n");
+    log("Frontend statistics:\n");
+    log("  %-32s %8s %10s %10s %12s\n", "phase", "count", "wall [s]", "cpu [s]", "rss [KiB]");
+    for (const auto &phase : phases) {
+        log("  %-32s %8u %10.3f %10.3f %12ld\n", phase.name.c_str(), phase.count, phase.wall_time, phase.cpu_time, phase.peak_rss_delta);
+    }
+    log("\n");
+    for (const auto &count : counts) {
+        log("  %-32s %8zu\n", count.first.c_str(), count.second);
+    }
+    if (objects.empty())
+        return;
+
+    // Sort object types by cumulative time, so the most expensive ones are on top
+    std::vector<const ObjectStats *> sorted_objects;
+    for (const auto &object : objects)
+        sorted_objects.push_back(&object.second);
+    std::sort(sorted_objects.begin(), sorted_objects.end(), [](const ObjectStats *a, const ObjectStats *b) { return a->time > b->time; });
+
+    log("\n");
+    log("  %-32s %8s %10s\n", "object type", "count", "time [s]");
+    for (const auto *object : sorted_objects) {
+        log("  %-32s %8u %10.3f\n", object->type_name.c_str(), object->count, object->time);
+    }
+    log("\n");
+}
+
+void UhdmAstStats::write_json(const std::string &filename) const
+{
+    std::ofstream json_file(filename);
+    if (!json_file.good()) {
+        log_error("Can't open statistics file %s for writing.\n", filename.c_str());
+    }
+    json_file << "{\n  \"phases\": [";
+    for (size_t i = 0; i < phases.size(); i++) {
+        const auto &phase = phases[i];
+        json_file << (i ? ",\n" : "\n") << stringf("    {\"name\": \"%s\", \"count\": %u, \"wall_time\": %.6f, \"cpu_time\": %.6f, \"peak_rss_delta\": %ld}",
+                                                  phase.name.c_str(), phase.count, phase.wall_time, phase.cpu_time, phase.peak_rss_delta);
+    }
+    json_file << "\n  ],\n  \"counts\": {";
+    bool first = true;
+    for (const auto &count : counts) {
+        json_file << (first ? "\n" : ",\n") << stringf("    \"%s\": %zu", count.first.c_str(), count.second);
+        first = false;
+    }
+    json_file << "\n  },\n  \"objects\": {";
+    first = true;
+    for (const auto &object : objects) {
+        json_file << (first ? "\n" : ",\n")
+                  << stringf("    \"%s\": {\"count\": %u, \"time\": %.6f}", object.second.type_name.c_str(), object.second.count, object.second.time);
+        first = false;
+    }
+    json_file << "\n  }\n}\n";
+}
+
+} // namespace systemverilog_plugin
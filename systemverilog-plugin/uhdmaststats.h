@@ -0,0 +1,96 @@
+#ifndef _UHDM_AST_STATS_H_
+#define _UHDM_AST_STATS_H_ 1
+
+#include <chrono>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace systemverilog_plugin
+{
+
+// Per-phase and per-object-type statistics of the frontend, collected with -stats
+class UhdmAstStats
+{
+  public:
+    struct Phase {
+        std::string name;
+        // Number of times the phase was entered
+        unsigned count = 0;
+        // Cumulative wall and CPU time, in seconds
+        double wall_time = 0;
+        double cpu_time = 0;
+        // Cumulative growth of the peak resident set size, in KiB
+        long peak_rss_delta = 0;
+    };
+
+    struct ObjectStats {
+        std::string type_name;
+        unsigned count = 0;
+        // Cumulative time spent in process_object, including children, in seconds
+        double time = 0;
+    };
+
+    // Measures the phase `name` for the lifetime of the object
+    class ScopedPhase
+    {
+      public:
+        ScopedPhase(UhdmAstStats &stats, bool enabled, const std::string &name);
+        ~ScopedPhase();
+
+      private:
+        UhdmAstStats *stats;
+        // Also reported to the instrumentation shared by the plugins
+        bool instrumented;
+        std::string name;
+        std::chrono::steady_clock::time_point wall_start;
+        double cpu_start = 0;
+        long peak_rss_start = 0;
+    };
+
+    // Measures processing of a single UHDM object for the lifetime of the object
+    class ScopedObject
+    {
+      public:
+        ScopedObject(UhdmAstStats &stats, bool enabled, unsigned type);
+        ~ScopedObject();
+
+      private:
+        UhdmAstStats *stats;
+        unsigned type;
+        std::chrono::steady_clock::time_point start;
+    };
+
+    // Phases in the order they were first entered
+    std::vector<Phase> phases;
+
+    // Named object counters (designs, AST nodes, modules, ...)
+    std::map<std::string, size_t> counts;
+
+    // Statistics of process_object, keyed by VPI object type
+    std::map<unsigned, ObjectStats> objects;
+
+    // Returns current resident set size of the process in KiB, or 0 if not available
+    static long current_rss();
+
+    void clear();
+
+    void add_phase(const std::string &name, double wall_time, double cpu_time, long peak_rss_delta);
+
+    void set_count(const std::string &name, size_t count) { counts[name] = count; }
+
+    // Returns true if the name of the given object type is not known yet
+    bool needs_type_name(unsigned type) const { return !objects.count(type); }
+
+    void set_type_name(unsigned type, const std::string &name) { objects[type].type_name = name; }
+
+    // Print statistics to the log
+    void log_stats() const;
+
+    // Write statistics as JSON
+    void write_json(const std::string &filename) const;
+};
+
+} // namespace systemverilog_plugin
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef _UHDM_AST_STRUCT_LAYOUT_H_
+#define _UHDM_AST_STRUCT_LAYOUT_H_ 1
+
+#include "frontends/ast/ast.h"
+
+#include <string>
+#include <unordered_map>
+
+namespace systemverilog_plugin
+{
+
+// Member lookup tables of packed structs and unions, shared by the UHDM
+// frontend and the vendored simplify. A table maps the member names of one
+// struct node to their positions and is built the first time a member of the
+// struct is looked up. Offsets, widths and dimensions are read from the
+// member nodes, which size_packed_struct fills in once per struct.
+//
+// Every hit is checked against the children of the struct, so tables of
+// nodes that were modified, or freed and reallocated, are rebuilt instead of
+// returning stale members.
+class StructLayout
+{
+  public:
+    // Returns the position of the member of the struct or union with the given
+    // name, without the leading backslash, or the number of members if there
+    // is no such member
+    static size_t find_member_index(const Yosys::AST::AstNode *struct_node, const std::string &name)
+    {
+        auto &table = tables()[struct_node];
+        if (is_valid(struct_node, table, name))
+            return table.at(name);
+        // Missing or stale entry, the struct may have changed since the table was built
+        table.clear();
+        for (size_t i = 0; i < struct_node->children.size(); i++)
+            table.emplace(struct_node->children[i]->str, i);
+        return is_valid(struct_node, table, name) ? table.at(name) : struct_node->children.size();
+    }
+
+    // Returns the member of the struct or union with the given name, without
+    // the leading backslash, or nullptr if there is no such member
+    static Yosys::AST::AstNode *find_member(const Yosys::AST::AstNode *struct_node, const std::string &name)
+    {
+        const size_t index = find_member_index(struct_node, name);
+        return index < struct_node->children.size() ? struct_node->children[index] : nullptr;
+    }
+
+    // Drops all tables, to be called once the AST they were built for is deleted
+    static void clear() { tables().clear(); }
+
+  private:
+    using Table = std::unordered_map<std::string, size_t>;
+
+    static bool is_valid(const Yosys::AST::AstNode *struct_node, const Table &table, const std::string &name)
+    {
+        auto it = table.find(name);
+        return it != table.end() && it->second < struct_node->children.size() && struct_node->children[it->second]->str == name;
+    }
+
+    static std::unordered_map<const Yosys::AST::AstNode *, Table> &tables()
+    {
+        static std::unordered_map<const Yosys::AST::AstNode *, Table> instance;
+        return instance;
+    }
+};
+
+} // namespace systemverilog_plugin
+
+#endif // _UHDM_AST_STRUCT_LAYOUT_H_
@@ -18,6 +18,19 @@
  */
 
 #include "uhdmcommonfrontend.h"
+#include "uhdmaststructlayout.h"
+#include "../common/instrumentation.h"
+#include "libs/sha1/sha1.h"
+#include "uhdm/uhdm-version.h" // UHDM_VERSION define
+#include "uhdm/vpi_visitor.h"  // visit_object
+#include <algorithm>
+#include <cstdio>
+#include <filesystem>
+#ifndef _WIN32
+#include <dlfcn.h>
+#endif
+#include <fstream>
+#include <set>
 
 namespace systemverilog_plugin
 {
@@ -59,6 +72,11 @@ void UhdmCommonFrontend::print_read_options()
     log("    -report [directory]\n");
     log("        write a coverage report for the UHDM file\n");
     log("\n");
+    log("    -report_format <html|json|csv>\n");
+    log("        format of the coverage report (default: html). json and csv only\n");
+    log("        write a per-file summary (coverage.json or coverage.csv) without\n");
+    log("        rendering the source files.\n");
+    log("\n");
     log("    -defer\n");
     log("        only read the abstract syntax tree and defer actual compilation\n");
     log("        to a later 'hierarchy' command. Useful in cases where the default\n");
@@ -74,17 +92,308 @@ void UhdmCommonFrontend::print_read_options()
     log("        it runs only Surelog to parse design, but doesn't load generated\n");
     log("        tree into Yosys.\n");
     log("\n");
+    log("    -parse-files\n");
+    log("        this parameter only applies to read_systemverilog command,\n");
+    log("        same as -parse-only, but every source file is parsed by a separate\n");
+    log("        Surelog run without compilation and elaboration. Diagnostics are\n");
+    log("        printed file by file and the state of a file is released before the\n");
+    log("        next one is parsed. Source files are recognized by their extension.\n");
+    log("        With -stats or -stats_json, parse time and memory are reported per\n");
+    log("        file.\n");
+    log("\n");
     log("    -formal\n");
     log("        enable support for SystemVerilog assertions and some Yosys extensions\n");
     log("        replace the implicit -D SYNTHESIS with -D FORMAL\n");
     log("\n");
+    log("    -stats\n");
+    log("        print wall time, CPU time and peak memory growth of every frontend\n");
+    log("        phase, object counts and the number of calls and cumulative time\n");
+    log("        for every processed UHDM object type.\n");
+    log("\n");
+    log("    -stats_json <file>\n");
+    log("        same as -stats, additionally write the statistics to the given\n");
+    log("        file in JSON format.\n");
+    log("\n");
+    log("    -stream\n");
+    log("        pass the converted design to the AST frontend one module at a time,\n");
+    log("        releasing the abstract syntax tree of every module as soon as it was\n");
+    log("        converted to RTLIL. Reduces peak memory usage on large designs.\n");
+    log("\n");
+    log("    -lazy_specialize\n");
+    log("        keep the specializations of parametrized modules as abstract syntax\n");
+    log("        trees and only convert them to RTLIL when a later 'hierarchy' command\n");
+    log("        finds an instance of them, like read_verilog -defer does. Variants\n");
+    log("        that are not reachable from the top module are never converted.\n");
+    log("\n");
+    log("    -cache_dir <directory>\n");
+    log("        this parameter only applies to read_systemverilog command,\n");
+    log("        store the elaborated design in the given directory, keyed by a hash\n");
+    log("        of the input files, include directories, defines and defaults.\n");
+    log("        When a matching entry exists, Surelog is not run and the design\n");
+    log("        is restored from the cache like with read_uhdm.\n");
+    log("\n");
+    log("    -incremental\n");
+    log("        requires -cache_dir. Fingerprint every elaborated module, including\n");
+    log("        its parameter values and the packages it can refer to, and keep\n");
+    log("        the RTLIL of converted modules in the cache directory. Modules with\n");
+    log("        an unchanged fingerprint are read from the cache instead of being\n");
+    log("        converted again. Modules using interfaces or having parameters are\n");
+    log("        always converted. Cached modules are invalidated by a different\n");
+    log("        Yosys, UHDM or plugin build.\n");
+    log("\n");
+    log("    -threads <N>\n");
+    log("        number of worker threads the frontend is allowed to use (default: 1).\n");
+    log("        read_systemverilog passes it to Surelog, which then preprocesses\n");
+    log("        and parses the given files in parallel. This also applies to\n");
+    log("        -defer, where every file is a separate compilation unit.\n");
+    log("        UHDM to AST conversion relies on Yosys global state (IdString\n");
+    log("        storage, AST scopes and logging) and is still performed serially.\n");
+    log("\n");
+}
+
+void UhdmCommonFrontend::annotate_synth_subset(UHDM::Serializer *serializer, const std::vector<vpiHandle> &designs)
+{
+    const UhdmAstStats::ScopedPhase phase_stats(this->shared.stats, this->shared.stats_flag, "SynthSubset");
+
+    // Objects created by the listener are owned by the serializer of the designs
+    std::set<const UHDM::any *> objects;
+    UHDM::SynthSubset *synthSubset = make_new_object_with_optional_extra_true_arg<UHDM::SynthSubset>(serializer, objects, false);
+    synthSubset->listenDesigns(designs);
+    delete synthSubset;
+    this->shared.nonSynthesizableObjects.insert(objects.begin(), objects.end());
+}
+
+AST::AstNode *UhdmCommonFrontend::restore_uhdm(const std::string &filename)
+{
+    // UHDM files are packed Cap'n Proto messages, which can't be accessed in place,
+    // and UHDM::Serializer only supports restoring the whole object graph at once.
+    // Check the file up front, so a wrong path is reported instead of yielding an empty design.
+    if (!std::ifstream(filename).good()) {
+        log_cmd_error("Can't open UHDM file `%s' for reading.\n", filename.c_str());
+    }
+
+    UHDM::Serializer serializer;
+
+    std::vector<vpiHandle> restoredDesigns;
+    {
+        const UhdmAstStats::ScopedPhase phase_stats(this->shared.stats, this->shared.stats_flag, "UHDM restore");
+        restoredDesigns = serializer.Restore(filename);
+    }
+    annotate_synth_subset(&serializer, restoredDesigns);
+    this->shared.stats.set_count("UHDM designs", restoredDesigns.size());
+    this->shared.stats.set_count("non-synthesizable objects", this->shared.nonSynthesizableObjects.size());
+    // With newer UHDM versions unhandled objects aren't collected while visiting,
+    // so the designs only have to be visited for the -debug dump
+#if UHDM_VERSION > 1057
+    const bool visit_designs = this->shared.debug_flag;
+#else
+    const bool visit_designs = this->shared.debug_flag || !this->report_directory.empty();
+#endif
+    if (visit_designs) {
+        for (auto design : restoredDesigns) {
+            std::ofstream null_stream;
+#if UHDM_VERSION > 1057
+            UHDM::visit_object(design, this->shared.debug_flag ? std::cout : null_stream);
+#else
+            UHDM::visit_object(design, 1, "", &this->shared.report.unhandled, this->shared.debug_flag ? std::cout : null_stream);
+#endif
+        }
+    }
+    AST::AstNode *current_ast = nullptr;
+    {
+        const UhdmAstStats::ScopedPhase phase_stats(this->shared.stats, this->shared.stats_flag, "UHDM to AST");
+        UhdmAst uhdm_ast(this->shared);
+        current_ast = uhdm_ast.visit_designs(restoredDesigns);
+    }
+    if (!this->report_directory.empty()) {
+        this->shared.report.write(this->report_directory, this->report_format);
+    }
+    {
+        const long rss_before = this->shared.stats_flag ? UhdmAstStats::current_rss() : 0;
+        const UhdmAstStats::ScopedPhase phase_stats(this->shared.stats, this->shared.stats_flag, "UHDM purge");
+        for (auto design : restoredDesigns)
+            vpi_release_handle(design);
+
+        serializer.Purge();
+        if (this->shared.stats_flag)
+            this->shared.stats.set_count("RSS released by UHDM purge [KiB]", std::max(0L, rss_before - UhdmAstStats::current_rss()));
+    }
+    this->shared.nonSynthesizableIndex.clear();
+    return current_ast;
+}
+
+// Feed every field of the AST subtree that affects the generated RTLIL into the hash.
+// Source locations are left out, so that edits which only move a module around in its
+// file (e.g. a comment added above it) don't invalidate it. The `src` attributes of a
+// reused module keep the locations of the run that cached it.
+static void hash_ast(SHA1 &sha1, const AST::AstNode *node)
+{
+    std::string data = stringf("(%d %s %s %d%d%d%d%d%d%d%d%d %d %d %d %lld %.17g ", node->type, node->str.c_str(), node->filename.c_str(),
+                               node->is_input, node->is_output, node->is_reg, node->is_logic, node->is_signed, node->is_string, node->range_valid,
+                               node->range_swapped, node->is_custom_type, node->port_id, node->range_left, node->range_right, (long long)node->integer,
+                               node->realvalue);
+    for (auto bit : node->bits)
+        data += '0' + (int)bit;
+    for (auto dimension : node->multirange_dimensions)
+        data += stringf(" %d", dimension);
+    sha1.update(data);
+    for (const auto &attr : node->attributes) {
+        sha1.update(" " + attr.first.str() + "=");
+        hash_ast(sha1, attr.second);
+    }
+    for (const auto *child : node->children)
+        hash_ast(sha1, child);
+    sha1.update(")");
+}
+
+// Identifies the tools that produced the cached RTLIL. The plugin has no version of its own,
+// so the size and modification time of its shared object stand in for it.
+static std::string converter_version()
+{
+    std::string version = stringf("%s UHDM_VERSION=%d", yosys_version_str, UHDM_VERSION);
+#ifndef _WIN32
+    Dl_info info;
+    if (dladdr(reinterpret_cast<void *>(&converter_version), &info) && info.dli_fname) {
+        std::error_code size_ec, time_ec;
+        const auto size = std::filesystem::file_size(info.dli_fname, size_ec);
+        const auto time = std::filesystem::last_write_time(info.dli_fname, time_ec);
+        if (!size_ec && !time_ec)
+            version += stringf(" %s %llu %lld", info.dli_fname, (unsigned long long)size, (long long)time.time_since_epoch().count());
+    }
+#endif
+    return version;
+}
+
+// Returns true if the RTLIL of the module is self-contained, and can be reused without its AST.
+// Modules using interfaces are reprocessed by `hierarchy` from their AST, so they can't be reused.
+// Neither can modules with parameters, as `hierarchy` needs the AST to derive them.
+static bool is_reusable_module(const AST::AstNode *module, const pool<std::string> &interfaces)
+{
+    if (module->type != AST::AST_MODULE)
+        return false;
+    std::vector<const AST::AstNode *> stack = {module};
+    while (!stack.empty()) {
+        const AST::AstNode *node = stack.back();
+        stack.pop_back();
+        if (node->type == AST::AST_INTERFACEPORT || node->type == AST::AST_PARAMETER ||
+            (node->type == AST::AST_CELLTYPE && interfaces.count(node->str)))
+            return false;
+        stack.insert(stack.end(), node->children.begin(), node->children.end());
+    }
+    return true;
+}
+
+// Remove modules with a known fingerprint from the AST and read their RTLIL from the
+// incremental cache instead. Returns fingerprints of modules that have to be converted.
+dict<std::string, std::string> UhdmCommonFrontend::reuse_cached_modules(AST::AstNode *current_ast, RTLIL::Design *design)
+{
+    const std::string modules_directory = this->cache_directory + "/modules";
+    const std::string manifest_file = this->cache_directory + "/modules.manifest";
+    std::error_code ec;
+    std::filesystem::create_directories(modules_directory, ec);
+    if (ec)
+        log_error("Could not create cache directory %s: %s.\n", modules_directory.c_str(), ec.message().c_str());
+
+    // Packages and global definitions are copied into every module by AST::process
+    SHA1 definitions_sha1;
+    definitions_sha1.update(converter_version());
+    pool<std::string> interfaces;
+    for (const auto *child : current_ast->children) {
+        if (child->type == AST::AST_INTERFACE)
+            interfaces.insert(child->str);
+        else if (child->type != AST::AST_MODULE)
+            hash_ast(definitions_sha1, child);
+    }
+    const std::string definitions_hash = definitions_sha1.final();
+
+    dict<std::string, std::string> previous_fingerprints;
+    std::ifstream manifest_in(manifest_file);
+    std::string module_name, fingerprint;
+    while (manifest_in >> module_name >> fingerprint)
+        previous_fingerprints[module_name] = fingerprint;
+    manifest_in.close();
+
+    dict<std::string, std::string> fingerprints;
+    std::vector<std::string> reused_files;
+    std::vector<AST::AstNode *> children;
+    unsigned changed_count = 0;
+    for (auto *child : current_ast->children) {
+        if (!is_reusable_module(child, interfaces)) {
+            children.push_back(child);
+            continue;
+        }
+        SHA1 sha1;
+        sha1.update(definitions_hash);
+        hash_ast(sha1, child);
+        fingerprint = sha1.final();
+        const std::string rtlil_file = modules_directory + "/" + fingerprint + ".il";
+        auto previous = previous_fingerprints.find(child->str);
+        if (previous != previous_fingerprints.end() && previous->second != fingerprint) {
+            // Module changed, remove the outdated entry
+            remove((modules_directory + "/" + previous->second + ".il").c_str());
+            previous_fingerprints.erase(previous);
+        }
+        fingerprints[child->str] = fingerprint;
+        std::ifstream rtlil_in(rtlil_file);
+        if (rtlil_in.good()) {
+            reused_files.push_back(rtlil_file);
+            delete child;
+        } else {
+            changed_count++;
+            children.push_back(child);
+        }
+    }
+    current_ast->children = std::move(children);
+    log("Reusing %zu unchanged modules, converting %u changed modules.\n", reused_files.size(), changed_count);
+
+    for (const auto &rtlil_file : reused_files)
+        run_frontend(rtlil_file, "rtlil", design);
+
+    // Fingerprints of modules that are not part of this design are kept
+    for (const auto &it : fingerprints)
+        previous_fingerprints[it.first] = it.second;
+    std::ofstream manifest_out(manifest_file);
+    for (const auto &it : previous_fingerprints)
+        manifest_out << it.first << " " << it.second << "\n";
+    return fingerprints;
+}
+
+// Store RTLIL of modules that were converted in this run in the incremental cache
+void UhdmCommonFrontend::store_cached_modules(const dict<std::string, std::string> &fingerprints, RTLIL::Design *design)
+{
+    const std::string modules_directory = this->cache_directory + "/modules";
+    for (const auto &it : fingerprints) {
+        const std::string rtlil_file = modules_directory + "/" + it.second + ".il";
+        std::ifstream rtlil_in(rtlil_file);
+        if (rtlil_in.good())
+            continue;
+        RTLIL::Module *module = design->module(it.first);
+        if (!module)
+            continue;
+        const std::string tmp_file = rtlil_file + ".tmp";
+        Pass::call_on_module(design, module, "write_rtlil -selected " + tmp_file);
+        std::rename(tmp_file.c_str(), rtlil_file.c_str());
+    }
 }
 
 void UhdmCommonFrontend::execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design)
 {
+    instrumentation::ScopedTimer timer(design, "systemverilog.read_" + this->frontend_name);
     this->call_log_header(design);
     this->args = args;
 
+    // The frontend is a static object, so options of an earlier read must not
+    // carry over to this one
+    this->cache_directory.clear();
+    this->incremental = false;
+    this->lazy_specialize = false;
+    this->stats_file.clear();
+    this->report_format = UhdmAstReport::Format::Html;
+    this->shared.stream = false;
+    this->shared.stats_flag = false;
+    this->shared.threads = 1;
+    this->shared.parse_files = false;
+
     bool defer = false;
     bool dump_ast1 = false;
     bool dump_ast2 = false;
@@ -104,6 +413,33 @@ void UhdmCommonFrontend::execute(std::istream *&f, std::string filename, std::ve
         } else if (args[i] == "-report" && ++i < args.size()) {
             this->report_directory = args[i];
             this->shared.stop_on_error = false;
+        } else if (args[i] == "-threads" && ++i < args.size()) {
+            int threads = atoi(args[i].c_str());
+            if (threads < 1)
+                log_cmd_error("Invalid number of threads: %s\n", args[i].c_str());
+            this->shared.threads = threads;
+        } else if (args[i] == "-incremental") {
+            this->incremental = true;
+        } else if (args[i] == "-stats") {
+            this->shared.stats_flag = true;
+        } else if (args[i] == "-stats_json" && ++i < args.size()) {
+            this->shared.stats_flag = true;
+            this->stats_file = args[i];
+        } else if (args[i] == "-stream") {
+            this->shared.stream = true;
+        } else if (args[i] == "-lazy_specialize") {
+            this->lazy_specialize = true;
+        } else if (args[i] == "-cache_dir" && ++i < args.size()) {
+            this->cache_directory = args[i];
+        } else if (args[i] == "-report_format" && ++i < args.size()) {
+            if (args[i] == "html")
+                this->report_format = UhdmAstReport::Format::Html;
+            else if (args[i] == "json")
+                this->report_format = UhdmAstReport::Format::Json;
+            else if (args[i] == "csv")
+                this->report_format = UhdmAstReport::Format::Csv;
+            else
+                log_cmd_error("Unknown report format: %s\n", args[i].c_str());
         } else if (args[i] == "-noassert") {
             this->shared.no_assert = true;
         } else if (args[i] == "-defer") {
@@ -122,6 +458,9 @@ void UhdmCommonFrontend::execute(std::istream *&f, std::string filename, std::ve
             dump_rtlil = true;
         } else if (args[i] == "-parse-only") {
             this->shared.parse_only = true;
+        } else if (args[i] == "-parse-files") {
+            this->shared.parse_only = true;
+            this->shared.parse_files = true;
         } else if (args[i] == "-link") {
             this->shared.link = true;
             // Surelog needs it in the command line to link correctly
@@ -134,6 +473,8 @@ void UhdmCommonFrontend::execute(std::istream *&f, std::string filename, std::ve
             unhandled_args.push_back(args[i]);
         }
     }
+    if (this->incremental && this->cache_directory.empty())
+        log_cmd_error("Option -incremental requires -cache_dir.\n");
     // Yosys gets confused when extra_args are passed with -link or no option
     // It's done fully by Surelog, so skip it in this case
     if (!this->shared.link)
@@ -151,12 +492,77 @@ void UhdmCommonFrontend::execute(std::istream *&f, std::string filename, std::ve
     bool dont_redefine = false;
     bool default_nettype_wire = true;
 
-    AST::AstNode *current_ast = parse(filename);
+    this->shared.stats.clear();
+    AST::AstNode *current_ast = nullptr;
+    {
+        const UhdmAstStats::ScopedPhase phase_stats(this->shared.stats, this->shared.stats_flag, "parse");
+        current_ast = parse(filename);
+    }
+
+    dict<std::string, std::string> module_fingerprints;
+    if (current_ast && this->incremental) {
+        const UhdmAstStats::ScopedPhase phase_stats(this->shared.stats, this->shared.stats_flag, "incremental cache lookup");
+        module_fingerprints = reuse_cached_modules(current_ast, design);
+    }
 
-    if (current_ast) {
-        AST::process(design, current_ast, dump_ast1, dump_ast2, no_dump_ptr, dump_vlog1, dump_vlog2, dump_rtlil, false, false, false, false, false,
-                     false, false, false, false, false, dont_redefine, false, defer, default_nettype_wire);
+    auto process_ast = [&](AST::AstNode *ast, bool defer_ast = false) {
+        const UhdmAstStats::ScopedPhase phase_stats(this->shared.stats, this->shared.stats_flag, "AST::process");
+        AST::process(design, ast, dump_ast1, dump_ast2, no_dump_ptr, dump_vlog1, dump_vlog2, dump_rtlil, false, false, false, false, false, false,
+                     false, false, false, false, dont_redefine, false, defer || defer_ast, default_nettype_wire);
+        delete ast;
+    };
+
+    // Specializations of parametrized modules are named by AST::derived_module_name.
+    // AST::process stores them as $abstract modules, which `hierarchy` derives
+    // once it finds a cell of the specialized type.
+    AST::AstNode *specializations = nullptr;
+    if (current_ast && this->lazy_specialize) {
+        auto it = std::stable_partition(current_ast->children.begin(), current_ast->children.end(), [](const AST::AstNode *node) {
+            return node->type != AST::AST_MODULE || node->str.compare(0, 8, "$paramod") != 0;
+        });
+        specializations = new AST::AstNode(AST::AST_DESIGN);
+        specializations->children.assign(it, current_ast->children.end());
+        current_ast->children.erase(it, current_ast->children.end());
+        log("Deferring conversion of %zu specialized module(s).\n", specializations->children.size());
+    }
+
+    if (current_ast && this->shared.stream) {
+        // Packages and global definitions are stored in design->verilog_packages
+        // and design->verilog_globals by AST::process, and modules processed later
+        // pick them up from there. Hand them off first, then lower modules one
+        // at a time, so every module subtree is released right after it was
+        // converted to RTLIL.
+        std::vector<AST::AstNode *> modules;
+        AST::AstNode *definitions = new AST::AstNode(AST::AST_DESIGN);
+        for (auto *child : current_ast->children) {
+            if (child->type == AST::AST_MODULE || child->type == AST::AST_INTERFACE)
+                modules.push_back(child);
+            else
+                definitions->children.push_back(child);
+        }
+        current_ast->children.clear();
         delete current_ast;
+        process_ast(definitions);
+        for (auto *module : modules)
+            process_ast(new AST::AstNode(AST::AST_DESIGN, module));
+    } else if (current_ast) {
+        process_ast(current_ast);
+    }
+    if (specializations)
+        process_ast(specializations, true);
+    StructLayout::clear();
+
+    if (!module_fingerprints.empty())
+        store_cached_modules(module_fingerprints, design);
+
+    // Report files are written in the background during AST::process
+    this->shared.report.wait();
+
+    if (this->shared.stats_flag) {
+        this->shared.stats.set_count("modules in design", design->modules().size());
+        this->shared.stats.log_stats();
+        if (!this->stats_file.empty())
+            this->shared.stats.write_json(this->stats_file);
     }
 }
 
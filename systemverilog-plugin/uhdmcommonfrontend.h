@@ -49,12 +49,24 @@ static inline ObjT *make_new_object_with_optional_extra_true_arg(ArgN &&... arg_
 struct UhdmCommonFrontend : public ::Yosys::Frontend {
     UhdmAstShared shared;
     std::string report_directory;
+    UhdmAstReport::Format report_format = UhdmAstReport::Format::Html;
+    std::string cache_directory;
+    std::string stats_file;
+    bool incremental = false;
+    bool lazy_specialize = false;
     std::vector<std::string> args;
     UhdmCommonFrontend(std::string name, std::string short_help) : Frontend(name, short_help) {}
     virtual void print_read_options();
     virtual void help() = 0;
     virtual ::Yosys::AST::AstNode *parse(std::string filename) = 0;
     virtual void call_log_header(::Yosys::RTLIL::Design *design) = 0;
+    // Collect the non-synthesizable objects of the designs in shared.nonSynthesizableObjects
+    void annotate_synth_subset(UHDM::Serializer *serializer, const std::vector<vpiHandle> &designs);
+    // Restore designs from a UHDM file and convert them to AST
+    ::Yosys::AST::AstNode *restore_uhdm(const std::string &filename);
+    // Incremental conversion with module fingerprints (-incremental)
+    ::Yosys::dict<std::string, std::string> reuse_cached_modules(::Yosys::AST::AstNode *current_ast, ::Yosys::RTLIL::Design *design);
+    void store_cached_modules(const ::Yosys::dict<std::string, std::string> &fingerprints, ::Yosys::RTLIL::Design *design);
     void execute(std::istream *&f, std::string filename, std::vector<std::string> args, ::Yosys::RTLIL::Design *design);
 };
 
@@ -20,6 +20,7 @@
 #include "UhdmAst.h"
 #include "frontends/ast/ast.h"
 #include "kernel/yosys.h"
+#include "libs/sha1/sha1.h"
 #include "uhdmcommonfrontend.h"
 
 #if defined(_MSC_VER)
@@ -29,7 +30,14 @@
 #include <sys/param.h>
 #include <unistd.h>
 #endif
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iterator>
 #include <memory>
+#include <set>
+#include <sstream>
 
 #include <list>
 
@@ -52,17 +60,179 @@ static std::list<std::vector<std::string>> systemverilog_defaults_stack;
 // Store global definitions for top-level defines
 static std::vector<std::string> systemverilog_defines;
 
+// Inputs of a Surelog invocation hashed into the key of an elaborated design cache entry
+class CacheKey
+{
+  public:
+    // The key covers all arguments passed to Surelog, the content of every argument that
+    // names an existing file, the files listed in -f filelists, the headers included by
+    // the sources and the content of the files found in include directories and their
+    // subdirectories. Thread counts don't change the elaborated design and are left out.
+    explicit CacheKey(const std::vector<const char *> &cstrings)
+    {
+        sha1.update(stringf("UHDM_VERSION=%d\n", UHDM_VERSION));
+        for (size_t i = 0; i < cstrings.size(); i++)
+            add_include_dir(cstrings[i]);
+        for (size_t i = 0; i < cstrings.size(); i++) {
+            std::string arg(cstrings[i]);
+            if (arg == "-mt" || arg == "-mp") {
+                i++;
+                continue;
+            }
+            sha1.update(arg + "\n");
+            if (arg == "-f" && i + 1 < cstrings.size()) {
+                sha1.update(std::string(cstrings[++i]) + "\n");
+                add_filelist(cstrings[i]);
+                continue;
+            }
+            std::error_code ec;
+            if (std::filesystem::is_regular_file(arg, ec)) {
+                add_file(arg);
+            } else if (arg.size() > 2 && arg.compare(0, 2, "-I") == 0 && std::filesystem::is_directory(arg.substr(2), ec)) {
+                add_directory(arg.substr(2));
+            }
+        }
+    }
+
+    std::string str() { return sha1.final(); }
+
+  private:
+    SHA1 sha1;
+    std::vector<std::string> include_dirs;
+    std::set<std::string> hashed_files;
+
+    void add_include_dir(const std::string &arg)
+    {
+        if (arg.size() > 2 && arg.compare(0, 2, "-I") == 0) {
+            include_dirs.push_back(arg.substr(2));
+        } else if (arg.compare(0, 8, "+incdir+") == 0) {
+            // +incdir+<dir>[+<dir>...]
+            std::stringstream dirs(arg.substr(8));
+            std::string dir;
+            while (std::getline(dirs, dir, '+')) {
+                if (!dir.empty())
+                    include_dirs.push_back(dir);
+            }
+        }
+    }
+
+    // Hashes the content of a file once, followed by the headers it includes. Headers are
+    // looked up relative to the including file, in the include directories and relative
+    // to the working directory.
+    void add_file(const std::string &path)
+    {
+        std::error_code ec;
+        std::string canonical = std::filesystem::weakly_canonical(path, ec).string();
+        if (!hashed_files.insert(ec ? path : canonical).second)
+            return;
+
+        std::ifstream file(path, std::ios::binary);
+        const std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+        sha1.update(path + "\n");
+        sha1.update(content);
+
+        const std::filesystem::path file_dir = std::filesystem::path(path).parent_path();
+        const std::string directive = "`include";
+        for (size_t pos = content.find(directive); pos != std::string::npos; pos = content.find(directive, pos + 1)) {
+            size_t open = content.find_first_not_of(" \t", pos + directive.size());
+            if (open == std::string::npos || content[open] != '"')
+                continue;
+            size_t close = content.find('"', open + 1);
+            if (close == std::string::npos)
+                break;
+            const std::string name = content.substr(open + 1, close - open - 1);
+            std::vector<std::filesystem::path> candidates = {file_dir / name};
+            for (const auto &dir : include_dirs)
+                candidates.push_back(std::filesystem::path(dir) / name);
+            candidates.push_back(name);
+            for (const auto &candidate : candidates) {
+                if (std::filesystem::is_regular_file(candidate, ec)) {
+                    add_file(candidate.string());
+                    break;
+                }
+            }
+        }
+    }
+
+    // Hashes a filelist and the files named in it. Paths are resolved relative to the
+    // working directory first and to the directory of the filelist second.
+    void add_filelist(const std::string &path)
+    {
+        std::error_code ec;
+        if (!std::filesystem::is_regular_file(path, ec))
+            return;
+        add_file(path);
+
+        const std::filesystem::path list_dir = std::filesystem::path(path).parent_path();
+        auto resolve = [&](const std::string &name) {
+            if (std::filesystem::exists(name, ec) || std::filesystem::path(name).is_absolute())
+                return name;
+            return (list_dir / name).string();
+        };
+
+        std::ifstream file(path);
+        std::vector<std::string> tokens;
+        std::string line;
+        while (std::getline(file, line)) {
+            line = line.substr(0, std::min(line.find("//"), line.find('#')));
+            std::stringstream words(line);
+            std::string word;
+            while (words >> word)
+                tokens.push_back(word);
+        }
+        for (const auto &token : tokens) {
+            if (token.size() > 2 && token.compare(0, 2, "-I") == 0)
+                include_dirs.push_back(resolve(token.substr(2)));
+            else if (token.compare(0, 8, "+incdir+") == 0)
+                add_include_dir(token);
+        }
+        for (size_t i = 0; i < tokens.size(); i++) {
+            if (tokens[i] == "-f" && i + 1 < tokens.size()) {
+                add_filelist(resolve(tokens[++i]));
+            } else if (tokens[i][0] != '-' && tokens[i][0] != '+') {
+                const std::string file_path = resolve(tokens[i]);
+                if (std::filesystem::is_regular_file(file_path, ec))
+                    add_file(file_path);
+            }
+        }
+    }
+
+    void add_directory(const std::string &dir)
+    {
+        std::error_code ec;
+        std::vector<std::string> include_files;
+        for (const auto &entry : std::filesystem::recursive_directory_iterator(dir, ec)) {
+            if (entry.is_regular_file(ec))
+                include_files.push_back(entry.path().string());
+        }
+        // Directory iteration order is unspecified
+        std::sort(include_files.begin(), include_files.end());
+        for (const auto &include_file : include_files) {
+            sha1.update(include_file + "\n");
+            std::ifstream file(include_file, std::ios::binary);
+            sha1.update(file);
+        }
+    }
+};
+
 // SURELOG::scompiler wrapper.
 // Owns UHDM/VPI resources used by designs returned from `execute`
 class Compiler
 {
   public:
     Compiler() = default;
-    ~Compiler()
+    ~Compiler() { release(); }
+
+    // Shuts the compiler down, releasing all UHDM designs returned from `execute`
+    void release()
     {
         if (this->scompiler) {
             SURELOG::shutdown_compiler(this->scompiler);
+            this->scompiler = nullptr;
         }
+        this->designs.clear();
+        this->clp.reset();
+        this->errors.reset();
     }
 
     const std::vector<vpiHandle> &execute(std::unique_ptr<SURELOG::ErrorContainer> errors, std::unique_ptr<SURELOG::CommandLineParser> clp)
@@ -113,6 +283,19 @@ class Compiler
     std::vector<vpiHandle> designs = {};
 };
 
+// Check whether the Surelog argument names a SystemVerilog source file
+static bool is_source_file(const std::string &arg)
+{
+    if (arg.empty() || arg[0] == '-' || arg[0] == '+')
+        return false;
+    for (const char *extension : {".v", ".sv", ".vh", ".svh"}) {
+        const size_t length = strlen(extension);
+        if (arg.size() > length && arg.compare(arg.size() - length, length, extension) == 0)
+            return true;
+    }
+    return false;
+}
+
 struct UhdmSurelogAstFrontend : public UhdmCommonFrontend {
     UhdmSurelogAstFrontend(std::string name, std::string short_help) : UhdmCommonFrontend(name, short_help) {}
     UhdmSurelogAstFrontend() : UhdmCommonFrontend("verilog_with_uhdm", "generate/read UHDM file") {}
@@ -132,16 +315,28 @@ struct UhdmSurelogAstFrontend : public UhdmCommonFrontend {
     {
         std::vector<const char *> cstrings;
         bool link = false;
+        // The mode define only applies to this invocation
+        std::vector<std::string> defines = systemverilog_defines;
         if (this->shared.formal) {
-            systemverilog_defines.push_back("-DFORMAL=1");
+            defines.push_back("-DFORMAL=1");
         } else {
-            systemverilog_defines.push_back("-DSYNTHESIS=1");
+            defines.push_back("-DSYNTHESIS=1");
         }
-        cstrings.reserve(this->args.size() + systemverilog_defaults.size() + systemverilog_defines.size());
+        cstrings.reserve(this->args.size() + systemverilog_defaults.size() + defines.size() + 2);
+        bool surelog_threads = false;
         for (size_t i = 0; i < this->args.size(); ++i) {
             cstrings.push_back(const_cast<char *>(this->args[i].c_str()));
             if (this->args[i] == "-link")
                 link = true;
+            if (this->args[i] == "-mt" || this->args[i] == "-mp")
+                surelog_threads = true;
+        }
+        // Let Surelog preprocess and parse files in parallel,
+        // unless its own parallelism options were given explicitly
+        const std::string threads = std::to_string(this->shared.threads);
+        if (this->shared.threads > 1 && !surelog_threads) {
+            cstrings.push_back("-mt");
+            cstrings.push_back(threads.c_str());
         }
 
         if (!link) {
@@ -156,8 +351,27 @@ struct UhdmSurelogAstFrontend : public UhdmCommonFrontend {
             }
 
             // Add systemverilog defines args
-            for (size_t i = 0; i < systemverilog_defines.size(); ++i)
-                cstrings.push_back(const_cast<char *>(systemverilog_defines[i].c_str()));
+            for (size_t i = 0; i < defines.size(); ++i)
+                cstrings.push_back(const_cast<char *>(defines[i].c_str()));
+        }
+
+        // Elaborated designs are only cached for the normal flow
+        std::string cache_file;
+        if (!this->cache_directory.empty() && !this->shared.defer && !this->shared.link && !this->shared.parse_only) {
+            cache_file = this->cache_directory + "/" + CacheKey(cstrings).str() + ".uhdm";
+            std::error_code ec;
+            if (std::filesystem::is_regular_file(cache_file, ec)) {
+                log("Restoring elaborated design from cache file %s.\n", cache_file.c_str());
+                AST::AstNode *current_ast = this->restore_uhdm(cache_file);
+                this->shared.clear_top_nodes();
+                this->shared.nonSynthesizableObjects.clear();
+                return current_ast;
+            }
+        }
+
+        if (this->shared.parse_files) {
+            parse_each_file(cstrings);
+            return nullptr;
         }
 
         auto symbolTable = std::make_unique<SURELOG::SymbolTable>();
@@ -187,9 +401,41 @@ struct UhdmSurelogAstFrontend : public UhdmCommonFrontend {
         }
 
         Compiler compiler;
-        const auto &uhdm_designs = compiler.execute(std::move(errors), std::move(clp));
+        std::vector<vpiHandle> uhdm_designs;
+        {
+            const UhdmAstStats::ScopedPhase phase_stats(this->shared.stats, this->shared.stats_flag, "Surelog parse and elaboration");
+            uhdm_designs = compiler.execute(std::move(errors), std::move(clp));
+        }
+        this->shared.stats.set_count("UHDM designs", uhdm_designs.size());
+
+        if (!cache_file.empty() && !uhdm_designs.empty()) {
+            // All designs share the serializer owned by the compiler
+            const uhdm_handle *const handle = (const uhdm_handle *)uhdm_designs.front();
+            const UHDM::BaseClass *const object = (const UHDM::BaseClass *)handle->object;
+            std::error_code ec;
+            std::filesystem::create_directories(this->cache_directory, ec);
+            if (ec) {
+                log_warning("Could not create cache directory %s: %s.\n", this->cache_directory.c_str(), ec.message().c_str());
+            } else {
+                // Write to a temporary file first, so interrupted runs don't leave a corrupted entry
+                const std::string tmp_file = cache_file + ".tmp";
+                object->GetSerializer()->Save(tmp_file);
+                if (std::rename(tmp_file.c_str(), cache_file.c_str()) != 0) {
+                    log_warning("Could not store elaborated design in cache file %s.\n", cache_file.c_str());
+                } else {
+                    log("Stored elaborated design in cache file %s.\n", cache_file.c_str());
+                }
+            }
+        }
 
-        if (this->shared.debug_flag || !this->report_directory.empty()) {
+        // With newer UHDM versions unhandled objects aren't collected while visiting,
+        // so the designs only have to be visited for the -debug dump
+#if UHDM_VERSION > 1057
+        const bool visit_designs = this->shared.debug_flag;
+#else
+        const bool visit_designs = this->shared.debug_flag || !this->report_directory.empty();
+#endif
+        if (visit_designs) {
             for (auto design : uhdm_designs) {
                 std::ofstream null_stream;
 #if UHDM_VERSION > 1057
@@ -211,25 +457,94 @@ struct UhdmSurelogAstFrontend : public UhdmCommonFrontend {
         // FIXME: SynthSubset annotation is incompatible with separate compilation
         // `-defer` turns elaboration off, so check for it
         // Should be called 1. for normal flow 2. after finishing with `-link`
-        if (!this->shared.defer) {
-            UHDM::Serializer serializer;
-            UHDM::SynthSubset *synthSubset =
-              make_new_object_with_optional_extra_true_arg<UHDM::SynthSubset>(&serializer, this->shared.nonSynthesizableObjects, false);
-            synthSubset->listenDesigns(uhdm_designs);
-            delete synthSubset;
+        if (!this->shared.defer && !uhdm_designs.empty()) {
+            // All designs share the serializer owned by the compiler
+            const uhdm_handle *const handle = (const uhdm_handle *)uhdm_designs.front();
+            annotate_synth_subset(((const UHDM::BaseClass *)handle->object)->GetSerializer(), uhdm_designs);
         }
+        this->shared.stats.set_count("non-synthesizable objects", this->shared.nonSynthesizableObjects.size());
 
-        UhdmAst uhdm_ast(this->shared);
-        AST::AstNode *current_ast = uhdm_ast.visit_designs(uhdm_designs);
+        AST::AstNode *current_ast = nullptr;
+        {
+            const UhdmAstStats::ScopedPhase phase_stats(this->shared.stats, this->shared.stats_flag, "UHDM to AST");
+            UhdmAst uhdm_ast(this->shared);
+            current_ast = uhdm_ast.visit_designs(uhdm_designs);
+        }
         if (!this->report_directory.empty()) {
-            this->shared.report.write(this->report_directory);
+            this->shared.report.write(this->report_directory, this->report_format);
+        }
+
+        // UHDM isn't needed anymore, release it before the AST is converted to RTLIL
+        {
+            const long rss_before = this->shared.stats_flag ? UhdmAstStats::current_rss() : 0;
+            const UhdmAstStats::ScopedPhase phase_stats(this->shared.stats, this->shared.stats_flag, "Surelog shutdown");
+            compiler.release();
+            if (this->shared.stats_flag)
+                this->shared.stats.set_count("RSS released by Surelog shutdown [KiB]", std::max(0L, rss_before - UhdmAstStats::current_rss()));
         }
+        this->shared.nonSynthesizableIndex.clear();
 
         // FIXME: Check and reset remaining shared data
-        this->shared.top_nodes.clear();
+        this->shared.clear_top_nodes();
         this->shared.nonSynthesizableObjects.clear();
         return current_ast;
     }
+
+    // -parse-files: parse every source file with its own Surelog run, sharing
+    // all other arguments. Nothing is compiled or elaborated and the compiler
+    // is shut down after every file, so only a single file is held in memory.
+    void parse_each_file(const std::vector<const char *> &cstrings)
+    {
+        // The first argument is the program name
+        std::vector<const char *> options = {cstrings.front()};
+        std::vector<const char *> files;
+        for (size_t i = 1; i < cstrings.size(); ++i)
+            (is_source_file(cstrings[i]) ? files : options).push_back(cstrings[i]);
+        if (files.empty())
+            log_warning("No source files found among the arguments.\n");
+
+        unsigned failed_files = 0;
+        for (const char *file : files) {
+            const UhdmAstStats::ScopedPhase phase_stats(this->shared.stats, this->shared.stats_flag, stringf("parse %s", file));
+            std::vector<const char *> file_cstrings = options;
+            file_cstrings.push_back(file);
+
+            auto symbolTable = std::make_unique<SURELOG::SymbolTable>();
+            auto errors = std::make_unique<SURELOG::ErrorContainer>(symbolTable.get());
+            auto clp = std::make_unique<SURELOG::CommandLineParser>(errors.get(), symbolTable.get(), false, false);
+            if (!clp->parseCommandLine(file_cstrings.size(), &file_cstrings[0])) {
+                log_error("Error parsing Surelog arguments!\n");
+            }
+            clp->setwritePpOutput(true);
+            clp->setParse(true);
+            clp->fullSVMode(true);
+            clp->setCacheAllowed(true);
+            clp->setCompile(false);
+            clp->setElaborate(false);
+            clp->setSepComp(true);
+            clp->setWriteUhdm(false);
+            errors->printMessages(clp->muteStdout());
+
+            SURELOG::scompiler *scompiler = SURELOG::start_compiler(clp.get());
+            SURELOG::ErrorContainer::Stats stats = errors->getErrorStats();
+            errors->printStats(stats, clp->muteStdout());
+            if (!scompiler || stats.nbFatal || stats.nbSyntax || stats.nbError)
+                failed_files++;
+            if (scompiler)
+                SURELOG::shutdown_compiler(scompiler);
+
+            this->shared.stats.set_count(stringf("errors in %s", file), stats.nbFatal + stats.nbSyntax + stats.nbError);
+            this->shared.stats.set_count(stringf("warnings in %s", file), stats.nbWarning);
+            if (this->shared.stats_flag)
+                this->shared.stats.set_count(stringf("RSS after %s [KiB]", file), UhdmAstStats::current_rss());
+        }
+        this->shared.stats.set_count("parsed files", files.size());
+
+        if (failed_files) {
+            log_error("Error when parsing %u of %zu file(s). Aborting!\n", failed_files, files.size());
+        }
+    }
+
     void call_log_header(RTLIL::Design *design) override { log_header(design, "Executing Verilog with UHDM frontend.\n"); }
 } UhdmSurelogAstFrontend;
 
@@ -250,6 +565,16 @@ struct UhdmSystemVerilogFrontend : public UhdmSurelogAstFrontend {
         log("    -Pparameter=value\n");
         log("        define parameter as value.\n");
         log("\n");
+        log("    -mt <N>\n");
+        log("        passed to Surelog, preprocess and parse the given files on N threads.\n");
+        log("        Set automatically from -threads, unless -mt or -mp is given.\n");
+        log("\n");
+        log("    -cache <directory>\n");
+        log("        passed to Surelog, keep the preprocessed and parsed files in the given\n");
+        log("        directory. Unchanged files and headers are then reused from the cache.\n");
+        log("        Use with systemverilog_defaults -add to share a single cache between\n");
+        log("        all read_systemverilog invocations of a session.\n");
+        log("\n");
     }
 } UhdmSystemVerilogFrontend;
 
@@ -0,0 +1,43 @@
+# Utility functions to be used in benchmarks.
+
+set ::bench_passes {}
+
+# Return the peak resident set size of the process in KiB, or 0 where it
+# isn't available.
+proc bench_peak_rss {} {
+    if { [catch {open "/proc/self/status" r} fh] } {
+        return 0
+    }
+    set peak_rss 0
+    while { [gets $fh line] >= 0 } {
+        if { [regexp {^VmHWM:\s+([0-9]+)} $line -> peak_rss] } {
+            break
+        }
+    }
+    close $fh
+    return $peak_rss
+}
+
+# Run a Yosys command and record its wall time and the peak resident set size
+# of the process after it.
+proc bench_pass { args } {
+    set start [clock microseconds]
+    yosys {*}$args
+    set wall_time [expr {([clock microseconds] - $start) / 1e6}]
+    lappend ::bench_passes [list [lindex $args 0] $wall_time [bench_peak_rss]]
+}
+
+# Write the recorded passes to the file given by the BENCH_OUTPUT environment
+# variable.
+proc bench_write_json {} {
+    set fh [open $::env(BENCH_OUTPUT) w]
+    puts $fh "\{\n  \"passes\": \["
+    set separator ""
+    foreach pass $::bench_passes {
+        lassign $pass name wall_time peak_rss
+        puts -nonewline $fh "$separator    \{\"name\": \"$name\", \"wall_time\": $wall_time, \"peak_rss\": $peak_rss\}"
+        set separator ",\n"
+    }
+    puts $fh "\n  \]\n\}"
+    close $fh
+}
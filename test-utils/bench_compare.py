@@ -0,0 +1,98 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright 2020-2022 F4PGA Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# SPDX-License-Identifier: Apache-2.0
+"""
+
+This script collects the pass timings written by `bench_write_json` (see
+bench-utils.tcl) for every benchmark into a single results file and compares
+them against a baseline.
+The return code is non-zero if the total wall time, the peak RSS or the wall
+time of any pass that takes at least --min-time seconds regressed by more than
+the given threshold.
+"""
+
+import argparse
+import json
+import os
+import sys
+
+
+def summarize(stats):
+    """ Reduces the pass timings of a single run to the compared metrics """
+    passes = {}
+    for entry in stats["passes"]:
+        passes[entry["name"]] = passes.get(entry["name"], 0) + entry["wall_time"]
+    return {
+        "wall_time": sum(entry["wall_time"] for entry in stats["passes"]),
+        "peak_rss": max([entry["peak_rss"] for entry in stats["passes"]] or [0]),
+        "passes": passes,
+    }
+
+
+def regressed(reference, value, threshold):
+    return reference > 0 and value > reference * (1 + threshold / 100)
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--baseline", help="Baseline results file")
+    parser.add_argument("--threshold", type=float, default=20.0, help="Allowed regression in percent")
+    parser.add_argument("--min-time", type=float, default=0.1, help="Shortest baseline pass time compared, in seconds")
+    parser.add_argument("--output", required=True, help="Results file to write")
+    parser.add_argument("stats", nargs="+", help="Pass timing files, named <benchmark>.json")
+    args = parser.parse_args()
+
+    results = {}
+    for stats_file in args.stats:
+        with open(stats_file) as fp:
+            results[os.path.splitext(os.path.basename(stats_file))[0]] = summarize(json.load(fp))
+    with open(args.output, "w") as fp:
+        json.dump(results, fp, indent=2, sort_keys=True)
+
+    print("{:<24} {:<24} {:>12} {:>14}".format("benchmark", "pass", "wall [s]", "peak rss [KiB]"))
+    for name, result in sorted(results.items()):
+        for pass_name, wall_time in sorted(result["passes"].items()):
+            print("{:<24} {:<24} {:>12.3f}".format(name, pass_name, wall_time))
+        print("{:<24} {:<24} {:>12.3f} {:>14}".format(name, "total", result["wall_time"], result["peak_rss"]))
+
+    if not args.baseline or not os.path.exists(args.baseline):
+        print("No baseline found, skipping comparison")
+        return 0
+
+    with open(args.baseline) as fp:
+        baseline = json.load(fp)
+
+    failed = False
+    for name, result in sorted(results.items()):
+        if name not in baseline:
+            continue
+        for metric in ["wall_time", "peak_rss"]:
+            reference = baseline[name][metric]
+            if regressed(reference, result[metric], args.threshold):
+                print("{}: {} regressed from {} to {} (threshold {}%)".format(name, metric, reference, result[metric], args.threshold))
+                failed = True
+        for pass_name, wall_time in sorted(result["passes"].items()):
+            reference = baseline[name]["passes"].get(pass_name, 0)
+            if reference >= args.min_time and regressed(reference, wall_time, args.threshold):
+                print("{}: {} regressed from {:.3f}s to {:.3f}s (threshold {}%)".format(name, pass_name, reference, wall_time, args.threshold))
+                failed = True
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
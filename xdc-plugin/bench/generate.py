@@ -0,0 +1,71 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+#
+# Copyright 2020-2022 F4PGA Authors
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#     http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+#
+# SPDX-License-Identifier: Apache-2.0
+"""
+
+This script generates synthetic designs with many IOs for the xdc plugin
+benchmarks. The design of a benchmark is written to <prefix>.v and its
+constraints to <prefix>.xdc.
+"""
+
+import argparse
+
+IOSTANDARDS = ["LVCMOS33", "LVCMOS25", "LVCMOS18", "SSTL135"]
+DRIVES = [4, 8, 12, 16]
+
+
+def many_ios(size):
+    """ Registered inputs and outputs, with IO properties on every port """
+    lines = [
+        "module top(input clk, input [{0}:0] in, output reg [{0}:0] out);".format(size - 1),
+        "  always @(posedge clk) out <= in;",
+        "endmodule",
+    ]
+    constraints = []
+    for i in range(size):
+        constraints += [
+            "set_property IOSTANDARD {} [get_ports {{in[{}]}}]".format(IOSTANDARDS[i % len(IOSTANDARDS)], i),
+            "set_property IOSTANDARD {} [get_ports {{out[{}]}}]".format(IOSTANDARDS[i % len(IOSTANDARDS)], i),
+            "set_property DRIVE {} [get_ports {{out[{}]}}]".format(DRIVES[i % len(DRIVES)], i),
+            "set_property SLEW {} [get_ports {{out[{}]}}]".format("FAST" if i % 2 else "SLOW", i),
+        ]
+    return lines, constraints
+
+
+BENCHMARKS = {
+    "many_ios": (many_ios, 2000),
+}
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("benchmark", choices=sorted(BENCHMARKS.keys()), help="Benchmark to generate")
+    parser.add_argument("prefix", help="Prefix of the written files")
+    parser.add_argument("--size", type=int, help="Size of the design (default depends on the benchmark)")
+    args = parser.parse_args()
+
+    generator, default_size = BENCHMARKS[args.benchmark]
+    lines, constraints = generator(args.size or default_size)
+    with open(args.prefix + ".v", "w") as fp:
+        fp.write("\n".join(lines) + "\n")
+    with open(args.prefix + ".xdc", "w") as fp:
+        fp.write("\n".join(constraints) + "\n")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,9 @@
+yosys -import
+if { [info procs get_ports] == {} } { plugin -i design_introspection }
+if { [info procs read_xdc] == {} } { plugin -i xdc }
+yosys -import  ;# ingest plugin commands
+
+read_verilog $::env(BENCH_DESIGN).v
+synth_xilinx -flatten -abc9 -nosrl -noclkbuf -nodsp
+
+bench_pass read_xdc -part_json ../tests/xc7a35tcsg324-1.json $::env(BENCH_DESIGN).xdc
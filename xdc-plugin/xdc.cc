@@ -26,12 +26,17 @@
  *   Tcl interpreter.
  */
 #include "../common/bank_tiles.h"
+#include "../common/instrumentation.h"
+#include "../common/tcl_commands.h"
 #include "../common/utils.h"
 #include "kernel/log.h"
 #include "kernel/register.h"
 #include "kernel/rtlil.h"
+#include "kernel/sigtools.h"
 #include "libs/json11/json11.hpp"
 #include <cassert>
+#include <map>
+#include <memory>
 
 USING_YOSYS_NAMESPACE
 
@@ -64,17 +69,44 @@ const std::unordered_map<std::string, std::vector<std::string>> supported_primit
   {"IBUFDS_GTE2", {"IO_LOC_PAIRS"}},
   {"GTPE2_CHANNEL", {"IO_LOC_PAIRS"}}};
 
-void register_in_tcl_interpreter(const std::string &command)
-{
-    Tcl_Interp *interp = yosys_get_tcl_interp();
-    std::string tcl_script = stringf("proc %s args { return [yosys %s {*}$args] }", command.c_str(), command.c_str());
-    Tcl_Eval(interp, tcl_script.c_str());
-}
+// Supported IO primitives of the top module connected to each top port bit
+struct PortCellIndex {
+    explicit PortCellIndex(RTLIL::Module *module) : module(module), sigmap(module)
+    {
+        for (auto cell : module->cells()) {
+            if (supported_primitive_parameters.count(RTLIL::unescape_id(cell->type)) == 0) {
+                continue;
+            }
+            for (auto &connection : cell->connections()) {
+                // The pads of the IO primitives are single bit ports
+                if (connection.second.size() != 1 || !connection.second[0].wire) {
+                    continue;
+                }
+                auto &cells = port_cells[sigmap(connection.second[0])];
+                if (cells.empty() || cells.back() != cell) {
+                    cells.push_back(cell);
+                }
+            }
+        }
+    }
+
+    // Returns the cells connected to the bit of the wire directly or through assignments
+    const std::vector<RTLIL::Cell *> &cells(RTLIL::Wire *wire, int bit) const
+    {
+        static const std::vector<RTLIL::Cell *> no_cells;
+        auto it = port_cells.find(sigmap(RTLIL::SigBit(wire, bit)));
+        return it == port_cells.end() ? no_cells : it->second;
+    }
+
+    RTLIL::Module *module;
+    SigMap sigmap;
+    dict<RTLIL::SigBit, std::vector<RTLIL::Cell *>> port_cells;
+};
 
 struct GetIOBanks : public Pass {
     GetIOBanks(std::function<const BankTilesMap &()> get_bank_tiles) : Pass("get_iobanks", "Set IO Bank number"), get_bank_tiles(get_bank_tiles)
     {
-        register_in_tcl_interpreter(pass_name);
+        tcl_commands::register_command(this);
     }
 
     void help() override
@@ -92,7 +124,7 @@ struct GetIOBanks : public Pass {
         if (args.size() < 2) {
             log_cmd_error("%s: Missing bank number.\n", pass_name.c_str());
         }
-        auto bank_tiles = get_bank_tiles();
+        const auto &bank_tiles = get_bank_tiles();
         if (bank_tiles.count(std::atoi(args[1].c_str())) == 0) {
             log_cmd_error("%s:Bank number %s is not present in the target device.\n", args[1].c_str(), pass_name.c_str());
         }
@@ -108,7 +140,7 @@ struct GetIOBanks : public Pass {
 struct SetProperty : public Pass {
     SetProperty(std::function<const BankTilesMap &()> get_bank_tiles) : Pass("set_property", "Set a given property"), get_bank_tiles(get_bank_tiles)
     {
-        register_in_tcl_interpreter(pass_name);
+        tcl_commands::register_command(this);
     }
 
     void help() override
@@ -125,6 +157,7 @@ struct SetProperty : public Pass {
 
     void execute(std::vector<std::string> args, RTLIL::Design *design) override
     {
+        instrumentation::ScopedTimer timer(design, "xdc.set_property");
         if (design->top_module() == nullptr) {
             log_cmd_error("No top module detected\n");
         }
@@ -190,7 +223,7 @@ struct SetProperty : public Pass {
             log_error("set_property INTERNAL_VREF: Incorrect number of arguments.\n");
         }
         int iobank = std::atoi(args[1].c_str());
-        auto bank_tiles = get_bank_tiles();
+        const auto &bank_tiles = get_bank_tiles();
         if (bank_tiles.count(iobank) == 0) {
             log_cmd_error("set_property INTERNAL_VREF: Invalid IO bank.\n");
         }
@@ -201,6 +234,15 @@ struct SetProperty : public Pass {
             return;
         }
 
+        if (batch) {
+            pending_vrefs[iobank] = internal_vref;
+        } else {
+            apply_vref(design, iobank, internal_vref);
+        }
+    }
+
+    void apply_vref(RTLIL::Design *design, int iobank, int internal_vref)
+    {
         // Create a new BANK module if it hasn't been created so far
         RTLIL::Module *top_module = design->top_module();
         if (!design->has(ID(BANK))) {
@@ -251,75 +293,101 @@ struct SetProperty : public Pass {
             log_error("Incorrect top port index %d in port %s\n", port_bit, port_name.c_str());
         }
 
-        // Traverse the port wire
-        traverse_wire(port_name, design->top_module());
+        // Outside of read_xdc the index is built for this call only
+        std::unique_ptr<PortCellIndex> local_index;
+        const PortCellIndex *index = port_index.get();
+        if (!index || index->module != design->top_module()) {
+            local_index.reset(new PortCellIndex(design->top_module()));
+            index = local_index.get();
+        }
 
         RTLIL::IdString parameter_id(RTLIL::escape_id(parameter));
-        for (auto cell_obj : design->top_module()->cells_) {
-            RTLIL::IdString cell_id = cell_obj.first;
-            RTLIL::Cell *cell = cell_obj.second;
-
-            // Check if the cell is of the type we are looking for
-            auto cell_type_str = RTLIL::unescape_id(cell->type.str());
-            auto primitive_parameters_iter = supported_primitive_parameters.find(cell_type_str);
-            if (primitive_parameters_iter == supported_primitive_parameters.end()) {
-                continue;
+        for (auto cell : index->cells(wire, port_bit - wire->start_offset)) {
+            // Check if the attribute is allowed for this module
+            auto &primitive_parameters = supported_primitive_parameters.at(RTLIL::unescape_id(cell->type));
+            if (std::find(primitive_parameters.begin(), primitive_parameters.end(), parameter) == primitive_parameters.end()) {
+                log_error("Cell %s of type %s doesn't support the %s attribute\n", cell->name.c_str(), cell->type.c_str(), parameter_id.c_str());
             }
+            record_param(cell, parameter_id, value);
+        }
+        if (!batch) {
+            apply_params();
+        }
+    }
 
-            // Set the parameter on the cell connected to the selected port
-            for (auto connection : cell->connections_) {
-                RTLIL::SigSpec cell_signal = connection.second;
-                if (is_signal_port(cell_signal, port_name)) {
-                    // Check if the attribute is allowed for this module
-                    auto primitive_parameters = primitive_parameters_iter->second;
-                    if (std::find(primitive_parameters.begin(), primitive_parameters.end(), parameter) == primitive_parameters.end()) {
-                        log_error("Cell %s of type %s doesn't support the %s attribute\n", cell->name.c_str(), cell->type.c_str(),
-                                  parameter_id.c_str());
-                    }
-                    if (parameter_id == ID(IO_LOC_PAIRS) and cell->hasParam(parameter_id)) {
-                        std::string cur_value(cell->getParam(parameter_id).decode_string());
-                        value = cur_value + "," + value;
-                    }
-                    cell->setParam(parameter_id, RTLIL::Const(value));
-                    log("Setting parameter %s to value %s on cell %s \n", parameter_id.c_str(), value.c_str(), cell_obj.first.c_str());
-                }
-            }
+    // Adds the value to the values of the parameter set on the cell so far
+    void record_param(RTLIL::Cell *cell, const RTLIL::IdString &parameter_id, const std::string &value)
+    {
+        auto it = pending_index.find(cell);
+        if (it == pending_index.end()) {
+            it = pending_index.insert(std::make_pair(cell, pending_cells.size())).first;
+            pending_cells.emplace_back(cell, PendingParams());
         }
-        log("\n");
+        auto &params = pending_cells[it->second].second;
+        auto param = std::find_if(params.begin(), params.end(), [&](const PendingParams::value_type &p) { return p.first == parameter_id; });
+        if (param == params.end()) {
+            params.emplace_back(parameter_id, std::vector<std::string>());
+            param = params.end() - 1;
+        }
+        param->second.push_back(value);
     }
 
-    // Search module's connections for the specified destination port
-    // and traverse from the specified destination wire to the source wire
-    void traverse_wire(std::string &port_name, RTLIL::Module *module)
+    // Sets the recorded parameters, each cell and parameter once. IO_LOC_PAIRS
+    // values are appended to the current ones, for other parameters the last value is used.
+    void apply_params()
     {
-        auto port_signal = extract_signal(port_name);
-        std::string signal_name(port_signal.first);
-        auto signal_name_idstr = RTLIL::IdString(RTLIL::escape_id(signal_name));
-        int port_bit = port_signal.second;
-        for (auto connection : module->connections_) {
-            auto dst_sig = connection.first;
-            auto src_sig = connection.second;
-            if (dst_sig.is_chunk()) {
-                auto chunk = dst_sig.as_chunk();
-                if (chunk.wire) {
-                    if (chunk.wire->name != signal_name_idstr) {
-                        continue;
-                    }
-                    if (port_bit < chunk.offset || port_bit >= (chunk.offset + chunk.width)) {
-                        continue;
+        for (auto &pending_cell : pending_cells) {
+            RTLIL::Cell *cell = pending_cell.first;
+            for (auto &param : pending_cell.second) {
+                std::string value;
+                if (param.first == ID(IO_LOC_PAIRS)) {
+                    if (cell->hasParam(param.first)) {
+                        value = cell->getParam(param.first).decode_string();
                     }
-                    auto src_wires = src_sig.to_sigbit_vector();
-                    auto src_wire_sigbit = src_wires.at(port_bit - chunk.offset);
-                    if (src_wire_sigbit.wire) {
-                        port_name = src_wires.at(port_bit - chunk.offset).wire->name.str();
-                        if (src_wire_sigbit.offset > 0) {
-                            port_name += "[" + std::to_string(src_wire_sigbit.offset) + "]";
+                    for (auto &pair : param.second) {
+                        if (!value.empty()) {
+                            value += ",";
                         }
-                        return;
+                        value += pair;
                     }
+                } else {
+                    value = param.second.back();
                 }
+                cell->setParam(param.first, RTLIL::Const(value));
+                log("Setting parameter %s to value %s on cell %s \n", param.first.c_str(), value.c_str(), cell->name.c_str());
             }
         }
+        log("\n");
+        pending_cells.clear();
+        pending_index.clear();
+    }
+
+    // Starts recording the properties instead of applying them and builds
+    // the port index shared by all set_property calls until end_batch
+    void begin_batch(RTLIL::Module *module)
+    {
+        port_index.reset(module ? new PortCellIndex(module) : nullptr);
+        batch = true;
+    }
+
+    // Applies all properties recorded since begin_batch in one pass over the cells
+    void apply_batch(RTLIL::Design *design)
+    {
+        for (auto &vref : pending_vrefs) {
+            apply_vref(design, vref.first, vref.second);
+        }
+        pending_vrefs.clear();
+        apply_params();
+    }
+
+    // Drops the port index and the properties not applied so far
+    void end_batch()
+    {
+        port_index.reset();
+        pending_cells.clear();
+        pending_index.clear();
+        pending_vrefs.clear();
+        batch = false;
     }
 
     // Extract signal name and port bit information from port name
@@ -332,26 +400,14 @@ struct SetProperty : public Pass {
         return std::make_pair(port_str, port_bit);
     }
 
-    // Check if the specified port name is part of the provided connection signal
-    bool is_signal_port(RTLIL::SigSpec signal, const std::string &port_name)
-    {
-        auto port_signal = extract_signal(port_name);
-        std::string port(port_signal.first);
-        int port_bit = port_signal.second;
-        if (signal.is_chunk()) {
-            auto chunk = signal.as_chunk();
-            if (chunk.wire) {
-                // chunk.offset is always indexed from 0. Because of that port_bit must be
-                // corrected with the chunk.wire->start_offset of the port wire in case it is not 0-indexed.
-                // Not doing this would cause lack of some properties (e.g. IO_LOC_PAIRS) for
-                // non-0-indexed ports in final eblif file
-                return (chunk.wire->name == RTLIL::IdString(RTLIL::escape_id(port))) && ((port_bit - chunk.wire->start_offset) == chunk.offset);
-            }
-        }
-        return false;
-    }
-
     std::function<const BankTilesMap &()> get_bank_tiles;
+    std::unique_ptr<PortCellIndex> port_index;
+    // Properties recorded by set_property while a batch is active
+    using PendingParams = std::vector<std::pair<RTLIL::IdString, std::vector<std::string>>>;
+    bool batch = false;
+    std::vector<std::pair<RTLIL::Cell *, PendingParams>> pending_cells;
+    dict<RTLIL::Cell *, size_t> pending_index;
+    std::map<int, int> pending_vrefs;
 };
 
 struct ReadXdc : public Frontend {
@@ -371,14 +427,16 @@ struct ReadXdc : public Frontend {
         log("\n");
     }
 
-    void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *) override
+    void execute(std::istream *&f, std::string filename, std::vector<std::string> args, RTLIL::Design *design) override
     {
+        instrumentation::ScopedTimer timer(design, "xdc.read_xdc");
         if (args.size() < 2) {
             log_cmd_error("Missing script file.\n");
         }
         size_t argidx = 1;
         bank_tiles.clear();
         if (args[argidx] == "-part_json" && argidx + 1 < args.size()) {
+            instrumentation::ScopedTimer part_json_timer("xdc.read_xdc.part_json");
             bank_tiles = ::get_bank_tiles(args[++argidx]);
             argidx++;
         }
@@ -410,9 +468,18 @@ struct ReadXdc : public Frontend {
         Tcl_Interp *interp = yosys_get_tcl_interp();
         Tcl_Eval(interp, "rename unknown _original_unknown");
         Tcl_Eval(interp, "proc unknown args { return \\[[lindex $args 0]\\] }");
+        // The properties are recorded while the file is evaluated and applied at
+        // the end, so the connections of the top module don't change in between
+        // and the port index is built once for the whole file
+        struct PortIndexScope {
+            PortIndexScope(struct SetProperty &set_property, RTLIL::Module *module) : set_property(set_property) { set_property.begin_batch(module); }
+            ~PortIndexScope() { set_property.end_batch(); }
+            struct SetProperty &set_property;
+        } port_index_scope(SetProperty, design->top_module());
         if (Tcl_EvalFile(interp, args[argidx].c_str()) != TCL_OK) {
             log_cmd_error("TCL interpreter returned an error: %s\n", Tcl_GetStringResult(interp));
         }
+        SetProperty.apply_batch(design);
         Tcl_Eval(interp, "rename unknown \"\"");
         Tcl_Eval(interp, "rename _original_unknown unknown");
     }
@@ -424,7 +491,7 @@ struct ReadXdc : public Frontend {
 } ReadXdc;
 
 struct GetBankTiles : public Pass {
-    GetBankTiles() : Pass("get_bank_tiles", "Inspect IO Bank tiles") { register_in_tcl_interpreter(pass_name); }
+    GetBankTiles() : Pass("get_bank_tiles", "Inspect IO Bank tiles") { tcl_commands::register_command(this); }
 
     void help() override
     {
@@ -442,7 +509,7 @@ struct GetBankTiles : public Pass {
             log_cmd_error("Missing JSON file.\n");
         }
         // Check if the part has the specified bank
-        auto bank_tiles = get_bank_tiles(args[1]);
+        const auto &bank_tiles = get_bank_tiles(args[1]);
         if (bank_tiles.size()) {
             log("Available bank tiles:\n");
             for (auto bank : bank_tiles) {